@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include <limits>
+#include "thread_pool.h"
+#include "heap_allocation_counter.h"
+#include "types.h"
+#include "timer.h"
+#include "logger.h"
+
+/**
+ * Compares the per-worker pinned queues (the path the MT command buffer
+ * benchmarks use) against the work stealing paths of the ThreadPool, with the
+ * mutex and condition variable pool the ThreadPool replaced as the baseline.
+ * Reports the per-task overhead for tiny tasks and the wall time and load
+ * balance for a skewed workload.
+ */
+
+constexpr size_t TASKS_PER_FRAME = 5000;
+constexpr int FRAME_COUNT = 200;
+
+struct Result {
+	std::string name;
+	f64 msPerFrame;
+	f64 nsPerTask;
+	size_t minTasksPerThread;
+	size_t maxTasksPerThread;
+	f64 heapAllocationsPerFrame;
+};
+
+// Per thread executed task counters. The last slot is used by the calling thread.
+static std::vector<std::atomic<size_t>> s_ExecutedTasks;
+
+// Index of the baseline worker running on this thread, -1 on other threads.
+static thread_local int s_MutexWorkerIndex{ -1 };
+
+// MutexWorkerThread ------------------------------------------------------------------------------
+
+/**
+ * \brief The worker of the thread pool before the work stealing scheduler.
+ * \details One std::queue of std::function per worker, guarded by a mutex and a
+ * condition variable. Kept here as the baseline of the benchmark.
+ */
+class MutexWorkerThread {
+private:
+	std::thread m_Worker;
+
+	std::queue<std::function<void()>> m_TaskQueue;
+
+	std::mutex m_TaskQueueMutex;
+
+	std::condition_variable m_ConditionVariable;
+
+	bool m_Terminating{ false };
+
+	void WaitAndExecute(int index) noexcept
+	{
+		s_MutexWorkerIndex = index;
+
+		while (true) {
+			std::function<void()> task;
+
+			{
+				std::unique_lock<std::mutex> lock{ m_TaskQueueMutex };
+
+				m_ConditionVariable.wait(lock, [this]() -> bool {
+					return !m_TaskQueue.empty() || m_Terminating;
+				});
+
+				if (m_Terminating) {
+					break;
+				}
+
+				task = m_TaskQueue.front();
+			}
+
+			task();
+
+			{
+				std::lock_guard<std::mutex> lock{ m_TaskQueueMutex };
+
+				m_TaskQueue.pop();
+
+				m_ConditionVariable.notify_one();
+			}
+		}
+	}
+
+public:
+	explicit MutexWorkerThread(const int index)
+	{
+		m_Worker = std::thread{ &MutexWorkerThread::WaitAndExecute, this, index };
+	}
+
+	MutexWorkerThread(const MutexWorkerThread& other) = delete;
+
+	MutexWorkerThread& operator=(const MutexWorkerThread& other) = delete;
+
+	~MutexWorkerThread()
+	{
+		if (m_Worker.joinable()) {
+			Wait();
+
+			{
+				std::lock_guard<std::mutex> lock{ m_TaskQueueMutex };
+				m_Terminating = true;
+				m_ConditionVariable.notify_one();
+			}
+
+			m_Worker.join();
+		}
+	}
+
+	void AddTask(std::function<void()> task) noexcept
+	{
+		std::lock_guard<std::mutex> lock{ m_TaskQueueMutex };
+		m_TaskQueue.push(std::move(task));
+		m_ConditionVariable.notify_one();
+	}
+
+	void Wait() noexcept
+	{
+		std::unique_lock<std::mutex> lock{ m_TaskQueueMutex };
+		m_ConditionVariable.wait(lock, [this]() -> bool {
+			return m_TaskQueue.empty();
+		});
+	}
+};
+
+// MutexThreadPool --------------------------------------------------------------------------------
+
+/**
+ * \brief The pinned task interface of the thread pool before the work stealing scheduler.
+ */
+class MutexThreadPool {
+private:
+	std::vector<std::unique_ptr<MutexWorkerThread>> m_Workers;
+
+public:
+	explicit MutexThreadPool(const size_t workerCount)
+	{
+		for (auto i = 0u; i < workerCount; ++i) {
+			m_Workers.push_back(std::make_unique<MutexWorkerThread>(static_cast<int>(i)));
+		}
+	}
+
+	void Wait() noexcept
+	{
+		for (auto& worker : m_Workers) {
+			worker->Wait();
+		}
+	}
+
+	void AddTask(const int workerIndex, std::function<void()> task) noexcept
+	{
+		m_Workers[workerIndex]->AddTask(std::move(task));
+	}
+};
+
+static void CountTask() noexcept
+{
+	const auto poolIndex = ThreadPool::GetCurrentWorkerIndex();
+	const auto index = poolIndex < 0 ? s_MutexWorkerIndex : poolIndex;
+	const auto slot = index < 0 ? s_ExecutedTasks.size() - 1 : static_cast<size_t>(index);
+	s_ExecutedTasks[slot].fetch_add(1, std::memory_order_relaxed);
+}
+
+// Simulates the cost of recording a draw. Items in the first eighth are 50 times more expensive.
+static void Work(const size_t item, const bool skewed) noexcept
+{
+	const auto iterations = skewed && item < TASKS_PER_FRAME / 8 ? 5000 : 100;
+
+	volatile f32 accumulator{ 0.0f };
+	for (auto i = 0; i < iterations; ++i) {
+		accumulator = accumulator + static_cast<f32>(i) * 0.5f;
+	}
+
+	CountTask();
+}
+
+template <typename Fn>
+static Result Measure(const std::string& name, Fn frame)
+{
+	// Warm up so that queue and arena growth is not attributed to the steady state.
+	frame();
+
+	for (auto& counter : s_ExecutedTasks) {
+		counter = 0;
+	}
+
+	const auto allocationsBefore = HeapAllocationCounter::GetAllocationCount();
+
+	Timer timer;
+	timer.Start();
+
+	for (auto i = 0; i < FRAME_COUNT; ++i) {
+		frame();
+	}
+
+	timer.Stop();
+
+	const auto allocations = HeapAllocationCounter::GetAllocationCount() - allocationsBefore;
+
+	const auto sec = timer.GetSec();
+
+	Result result;
+	result.name = name;
+	result.msPerFrame = sec * 1000.0 / FRAME_COUNT;
+	result.nsPerTask = sec * 1e9 / (static_cast<f64>(FRAME_COUNT) * TASKS_PER_FRAME);
+	result.minTasksPerThread = std::numeric_limits<size_t>::max();
+	result.maxTasksPerThread = 0;
+	result.heapAllocationsPerFrame = static_cast<f64>(allocations) / FRAME_COUNT;
+
+	// Ignore the calling thread slot, only the pinned paths leave it empty.
+	for (auto i = 0u; i < s_ExecutedTasks.size() - 1; ++i) {
+		const auto count = s_ExecutedTasks[i].load() / FRAME_COUNT;
+		result.minTasksPerThread = std::min(result.minTasksPerThread, count);
+		result.maxTasksPerThread = std::max(result.maxTasksPerThread, count);
+	}
+
+	LOG(name + ": " + std::to_string(result.msPerFrame) + " ms/frame, " + std::to_string(result.nsPerTask) +
+		" ns/task, tasks per worker min/max: " + std::to_string(result.minTasksPerThread) + "/" +
+		std::to_string(result.maxTasksPerThread) + ", heap allocations per frame: " +
+		std::to_string(result.heapAllocationsPerFrame));
+
+	return result;
+}
+
+static std::vector<Result> RunSuite(ThreadPool& threadPool, MutexThreadPool& mutexThreadPool, const bool skewed)
+{
+	const auto workerCount = threadPool.GetWorkerCount();
+
+	std::vector<Result> results;
+
+	// The round-robin path of the mutex and condition variable pool the ThreadPool replaced.
+	results.push_back(Measure("Mutex pool round-robin", [&]()
+	{
+		for (auto i = 0u; i < TASKS_PER_FRAME; ++i) {
+			mutexThreadPool.AddTask(static_cast<int>(i % workerCount), [=]() { Work(i, skewed); });
+		}
+
+		mutexThreadPool.Wait();
+	}));
+
+	// One pinned task per item, dealt round-robin. This is what MTSecondaryCommandBuffers1 does.
+	results.push_back(Measure("Pinned round-robin", [&]()
+	{
+		for (auto i = 0u; i < TASKS_PER_FRAME; ++i) {
+			threadPool.AddTask(static_cast<int>(i % workerCount), [=]() { Work(i, skewed); });
+		}
+
+		threadPool.Wait();
+	}));
+
+	// One pinned contiguous range per worker. This is what MTSecondaryCommandBuffers2 does.
+	results.push_back(Measure("Pinned ranges", [&]()
+	{
+		const auto itemsPerWorker = TASKS_PER_FRAME / workerCount;
+
+		for (auto w = 0u; w < workerCount; ++w) {
+			const auto begin = w * itemsPerWorker;
+			const auto end = w == workerCount - 1 ? TASKS_PER_FRAME : begin + itemsPerWorker;
+
+			threadPool.AddTask(static_cast<int>(w), [=]()
+			{
+				for (auto i = begin; i < end; ++i) {
+					Work(i, skewed);
+				}
+			});
+		}
+
+		threadPool.Wait();
+	}));
+
+	results.push_back(Measure("Stealable tasks", [&]()
+	{
+		std::vector<Task> tasks;
+		tasks.reserve(TASKS_PER_FRAME);
+
+		for (auto i = 0u; i < TASKS_PER_FRAME; ++i) {
+			tasks.emplace_back([=]() { Work(i, skewed); });
+		}
+
+		threadPool.AddTasks(std::move(tasks));
+		threadPool.Wait();
+	}));
+
+	// Same as above but waits on a task group instead of the whole pool.
+	results.push_back(Measure("Task group", [&]()
+	{
+		TaskGroup group;
+
+		for (auto i = 0u; i < TASKS_PER_FRAME; ++i) {
+			threadPool.Run(group, [=]() { Work(i, skewed); });
+		}
+
+		threadPool.Wait(group);
+	}));
+
+	for (const auto grain : { 1u, 16u, 64u }) {
+		results.push_back(Measure("ParallelFor grain " + std::to_string(grain), [&]()
+		{
+			threadPool.ParallelFor(0, TASKS_PER_FRAME, grain, [=](size_t begin, size_t end)
+			{
+				for (auto i = begin; i < end; ++i) {
+					Work(i, skewed);
+				}
+			});
+		}));
+	}
+
+	return results;
+}
+
+int main()
+{
+	ThreadPool threadPool;
+
+	if (!threadPool.Initialize()) {
+		return 1;
+	}
+
+	// Same worker count as the ThreadPool so that the results are comparable.
+	MutexThreadPool mutexThreadPool{ threadPool.GetWorkerCount() };
+
+	s_ExecutedTasks = std::vector<std::atomic<size_t>>(threadPool.GetWorkerCount() + 1);
+
+	LOG("Uniform workload, " + std::to_string(TASKS_PER_FRAME) + " tasks per frame.");
+	const auto uniformResults = RunSuite(threadPool, mutexThreadPool, false);
+
+	LOG("Skewed workload, " + std::to_string(TASKS_PER_FRAME) + " tasks per frame.");
+	const auto skewedResults = RunSuite(threadPool, mutexThreadPool, true);
+
+	std::ofstream stream{ "TaskScheduler_Metrics.csv" };
+
+	stream << "Workload,Scheduler,Time per frame (ms),Time per task (ns),Min tasks per worker,Max tasks per worker,Heap allocations per frame\n";
+
+	for (const auto& result : uniformResults) {
+		stream << "Uniform," << result.name << "," << result.msPerFrame << "," << result.nsPerTask << ","
+				<< result.minTasksPerThread << "," << result.maxTasksPerThread << "," << result.heapAllocationsPerFrame << "\n";
+	}
+
+	for (const auto& result : skewedResults) {
+		stream << "Skewed," << result.name << "," << result.msPerFrame << "," << result.nsPerTask << ","
+				<< result.minTasksPerThread << "," << result.maxTasksPerThread << "," << result.heapAllocationsPerFrame << "\n";
+	}
+
+	stream.close();
+
+	return 0;
+}
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "transform_kernels.h"
+#include "types.h"
+#include "timer.h"
+#include "logger.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+/**
+ * Checks the ComposeTransforms and MultiplyTransform kernels against glm and
+ * reports the matrices per second of glm and of every supported instruction
+ * set across a range of transform counts.
+ */
+
+// Each measurement composes roughly this many matrices in total.
+constexpr size_t MATRICES_PER_MEASUREMENT = 10000000;
+
+constexpr f32 TOLERANCE = 1e-5f;
+
+struct Inputs {
+	std::vector<Vec3f> positions;
+	std::vector<Quatf> orientations;
+	std::vector<Vec3f> scales;
+};
+
+static Inputs GenerateInputs(const size_t count)
+{
+	std::mt19937 generator{ 42 };
+	std::uniform_real_distribution<f32> position{ -20.0f, 20.0f };
+	std::uniform_real_distribution<f32> unit{ -1.0f, 1.0f };
+	std::uniform_real_distribution<f32> scale{ 0.1f, 4.0f };
+
+	Inputs inputs;
+	inputs.positions.reserve(count);
+	inputs.orientations.reserve(count);
+	inputs.scales.reserve(count);
+
+	for (auto i = 0u; i < count; ++i) {
+		inputs.positions.emplace_back(position(generator), position(generator), position(generator));
+		inputs.orientations.push_back(glm::normalize(Quatf{ unit(generator), unit(generator), unit(generator), unit(generator) }));
+		inputs.scales.emplace_back(scale(generator), scale(generator), scale(generator));
+	}
+
+	return inputs;
+}
+
+static void ComposeTransformsGlm(const Inputs& inputs, Mat4f* xforms) noexcept
+{
+	for (auto i = 0u; i < inputs.positions.size(); ++i) {
+		auto xform = glm::translate(Mat4f{ 1.0f }, inputs.positions[i]);
+		xform *= glm::toMat4(inputs.orientations[i]);
+		xforms[i] = glm::scale(xform, inputs.scales[i]);
+	}
+}
+
+// Largest element difference relative to the magnitude of the reference element.
+static f32 MaxError(const std::vector<Mat4f>& reference, const std::vector<Mat4f>& xforms) noexcept
+{
+	auto error = 0.0f;
+
+	for (auto i = 0u; i < reference.size(); ++i) {
+		for (auto c = 0; c < 4; ++c) {
+			for (auto r = 0; r < 4; ++r) {
+				const auto difference = std::abs(reference[i][c][r] - xforms[i][c][r]);
+				error = std::max(error, difference / std::max(1.0f, std::abs(reference[i][c][r])));
+			}
+		}
+	}
+
+	return error;
+}
+
+static bool Validate(const std::vector<SimdLevel>& levels)
+{
+	// An odd count exercises the scalar tails of the SIMD kernels.
+	const auto inputs = GenerateInputs(1037);
+
+	std::vector<Mat4f> reference(inputs.positions.size());
+	ComposeTransformsGlm(inputs, reference.data());
+
+	for (const auto level : levels) {
+		std::vector<Mat4f> xforms(inputs.positions.size());
+		ComposeTransforms(level, inputs.positions.data(), inputs.orientations.data(), inputs.scales.data(),
+		                  xforms.data(), xforms.size());
+
+		const auto error = MaxError(reference, xforms);
+
+		if (error > TOLERANCE) {
+			ERROR_LOG(std::string{ "ComposeTransforms (" } + GetSimdLevelName(level) + ") differs from glm by " +
+				std::to_string(error));
+			return false;
+		}
+
+		LOG(std::string{ "ComposeTransforms (" } + GetSimdLevelName(level) + ") matches glm, max error " +
+			std::to_string(error));
+	}
+
+	std::vector<Mat4f> products(reference.size());
+	std::vector<Mat4f> expected(reference.size());
+
+	for (auto i = 0u; i < reference.size(); ++i) {
+		const auto& parent = reference[(i * 7) % reference.size()];
+
+		products[i] = reference[i];
+		MultiplyTransform(parent, products[i]);
+
+		expected[i] = parent * reference[i];
+	}
+
+	const auto error = MaxError(expected, products);
+
+	if (error > TOLERANCE) {
+		ERROR_LOG("MultiplyTransform differs from glm by " + std::to_string(error));
+		return false;
+	}
+
+	LOG("MultiplyTransform matches glm, max error " + std::to_string(error));
+
+	return true;
+}
+
+template <typename Fn>
+static f64 MeasureMatricesPerSecond(const size_t count, Fn compose)
+{
+	const auto iterations = std::max<size_t>(1, MATRICES_PER_MEASUREMENT / count);
+
+	// Warm up the caches.
+	compose();
+
+	Timer timer;
+	timer.Start();
+
+	for (auto i = 0u; i < iterations; ++i) {
+		compose();
+	}
+
+	timer.Stop();
+
+	return static_cast<f64>(count * iterations) / timer.GetSec();
+}
+
+int main()
+{
+	std::vector<SimdLevel> levels{ SimdLevel::SCALAR };
+
+	if (GetSupportedSimdLevel() >= SimdLevel::SSE) {
+		levels.push_back(SimdLevel::SSE);
+	}
+
+	if (GetSupportedSimdLevel() >= SimdLevel::AVX2) {
+		levels.push_back(SimdLevel::AVX2);
+	}
+
+	LOG(std::string{ "Supported instruction set: " } + GetSimdLevelName(GetSupportedSimdLevel()));
+
+	if (!Validate(levels)) {
+		return 1;
+	}
+
+	std::ofstream stream{ "TransformKernels_Metrics.csv" };
+
+	stream << "Transform count,Implementation,Matrices per second\n";
+
+	for (const auto count : { 1000u, 10000u, 50000u, 200000u }) {
+		const auto inputs = GenerateInputs(count);
+
+		std::vector<Mat4f> xforms(count);
+
+		const auto glmRate = MeasureMatricesPerSecond(count, [&]()
+		{
+			ComposeTransformsGlm(inputs, xforms.data());
+		});
+
+		LOG(std::to_string(count) + " transforms, glm: " + std::to_string(glmRate / 1e6) + " M matrices/s");
+		stream << count << ",glm," << glmRate << "\n";
+
+		for (const auto level : levels) {
+			const auto rate = MeasureMatricesPerSecond(count, [&]()
+			{
+				ComposeTransforms(level, inputs.positions.data(), inputs.orientations.data(), inputs.scales.data(),
+				                  xforms.data(), count);
+			});
+
+			LOG(std::to_string(count) + " transforms, " + GetSimdLevelName(level) + ": " +
+				std::to_string(rate / 1e6) + " M matrices/s (" + std::to_string(rate / glmRate) + "x glm)");
+			stream << count << "," << GetSimdLevelName(level) << "," << rate << "\n";
+		}
+	}
+
+	stream.close();
+
+	return 0;
+}
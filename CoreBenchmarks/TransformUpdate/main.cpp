@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "entity.h"
+#include "transform_store.h"
+#include "thread_pool.h"
+#include "types.h"
+#include "timer.h"
+#include "logger.h"
+
+/**
+ * Compares the per-frame transform update of the Entity hierarchy (virtual
+ * Update recursing through child pointers) against the TransformStore batch
+ * update, serial and split across a ThreadPool, for a static scene, a scene
+ * where a tenth of the roots move every frame and a scene where everything
+ * moves every frame.
+ */
+
+constexpr size_t ROOT_COUNT = 5000;
+constexpr size_t CHILDREN_PER_ROOT = 3;
+constexpr int FRAME_COUNT = 200;
+
+class BenchmarkEntity final : public Entity {
+public:
+	bool Load(const std::string& /*fileName*/) noexcept override
+	{
+		return false;
+	}
+};
+
+struct Result {
+	std::string name;
+	f64 msPerFrame;
+	size_t updatedPerFrame;
+};
+
+static Vec3f RootPosition(const size_t root, const int frame) noexcept
+{
+	const auto t = static_cast<f32>(frame) * 0.01f;
+	return Vec3f{ static_cast<f32>(root % 100) + std::sin(t), static_cast<f32>(root / 100), std::cos(t) };
+}
+
+static Vec3f ChildPosition(const size_t child) noexcept
+{
+	return Vec3f{ 0.5f * static_cast<f32>(child + 1), 0.0f, 0.0f };
+}
+
+// Roots with index % movingStride == 0 move every frame. A stride of 0 means a static scene.
+static bool IsMoving(const size_t root, const size_t movingStride) noexcept
+{
+	return movingStride && root % movingStride == 0;
+}
+
+static Result MeasureEntities(const std::string& name, const size_t movingStride,
+                              std::vector<Mat4f>& xforms)
+{
+	std::vector<std::unique_ptr<BenchmarkEntity>> roots;
+	roots.reserve(ROOT_COUNT);
+
+	for (auto r = 0u; r < ROOT_COUNT; ++r) {
+		auto root = std::make_unique<BenchmarkEntity>();
+		root->SetPosition(RootPosition(r, 0));
+		root->SetOrientation(0.1f * static_cast<f32>(r), Vec3f{ 0.0f, 1.0f, 0.0f });
+
+		for (auto c = 0u; c < CHILDREN_PER_ROOT; ++c) {
+			const auto child = new BenchmarkEntity;
+			child->SetPosition(ChildPosition(c));
+			child->SetScale(Vec3f{ 0.5f });
+			root->AddChild(child);
+		}
+
+		roots.push_back(std::move(root));
+	}
+
+	Timer timer;
+	timer.Start();
+
+	for (auto frame = 1; frame <= FRAME_COUNT; ++frame) {
+		for (auto r = 0u; r < ROOT_COUNT; ++r) {
+			if (IsMoving(r, movingStride)) {
+				roots[r]->SetPosition(RootPosition(r, frame));
+			}
+		}
+
+		// The Entity path has no way to tell what changed so it always updates everything.
+		for (auto& root : roots) {
+			root->Update(0.0f);
+		}
+	}
+
+	timer.Stop();
+
+	xforms.clear();
+	for (const auto& root : roots) {
+		xforms.push_back(root->GetXform());
+
+		for (const auto child : root->GetChildren()) {
+			xforms.push_back(child->GetXform());
+		}
+	}
+
+	Result result;
+	result.name = name;
+	result.msPerFrame = timer.GetSec() * 1000.0 / FRAME_COUNT;
+	result.updatedPerFrame = ROOT_COUNT * (1 + CHILDREN_PER_ROOT);
+
+	return result;
+}
+
+// Updates serially if threadPool is null.
+static Result MeasureTransformStore(const std::string& name, const size_t movingStride,
+                                    ThreadPool* threadPool, std::vector<Mat4f>& xforms)
+{
+	TransformStore transforms;
+	transforms.Reserve(ROOT_COUNT * (1 + CHILDREN_PER_ROOT));
+
+	std::vector<TransformHandle> roots;
+	roots.reserve(ROOT_COUNT);
+
+	for (auto r = 0u; r < ROOT_COUNT; ++r) {
+		const auto root = transforms.Create();
+		transforms.SetPosition(root, RootPosition(r, 0));
+		transforms.SetOrientation(root, 0.1f * static_cast<f32>(r), Vec3f{ 0.0f, 1.0f, 0.0f });
+
+		for (auto c = 0u; c < CHILDREN_PER_ROOT; ++c) {
+			const auto child = transforms.Create(root);
+			transforms.SetPosition(child, ChildPosition(c));
+			transforms.SetScale(child, Vec3f{ 0.5f });
+		}
+
+		roots.push_back(root);
+	}
+
+	transforms.Update();
+
+	size_t updated{ 0 };
+
+	Timer timer;
+	timer.Start();
+
+	for (auto frame = 1; frame <= FRAME_COUNT; ++frame) {
+		for (auto r = 0u; r < ROOT_COUNT; ++r) {
+			if (IsMoving(r, movingStride)) {
+				transforms.SetPosition(roots[r], RootPosition(r, frame));
+			}
+		}
+
+		if (threadPool) {
+			transforms.Update(*threadPool);
+		} else {
+			transforms.Update();
+		}
+
+		updated += transforms.GetUpdatedCount();
+	}
+
+	timer.Stop();
+
+	xforms.assign(transforms.GetXforms(), transforms.GetXforms() + transforms.GetSize());
+
+	Result result;
+	result.name = name;
+	result.msPerFrame = timer.GetSec() * 1000.0 / FRAME_COUNT;
+	result.updatedPerFrame = updated / FRAME_COUNT;
+
+	return result;
+}
+
+static f32 MaxDifference(const std::vector<Mat4f>& a, const std::vector<Mat4f>& b) noexcept
+{
+	auto difference = 0.0f;
+
+	for (auto i = 0u; i < std::min(a.size(), b.size()); ++i) {
+		for (auto c = 0; c < 4; ++c) {
+			for (auto r = 0; r < 4; ++r) {
+				difference = std::max(difference, std::abs(a[i][c][r] - b[i][c][r]));
+			}
+		}
+	}
+
+	return difference;
+}
+
+int main()
+{
+	struct Scenario {
+		std::string name;
+		size_t movingStride;
+	};
+
+	ThreadPool threadPool;
+
+	if (!threadPool.Initialize()) {
+		return 1;
+	}
+
+	const std::vector<Scenario> scenarios{
+		{ "Static", 0 },
+		{ "10% moving", 10 },
+		{ "All moving", 1 }
+	};
+
+	LOG(std::to_string(ROOT_COUNT) + " roots with " + std::to_string(CHILDREN_PER_ROOT) + " children each.");
+
+	std::ofstream stream{ "TransformUpdate_Metrics.csv" };
+
+	stream << "Scenario,Path,Time per frame (ms),Transforms updated per frame\n";
+
+	for (const auto& scenario : scenarios) {
+		std::vector<Mat4f> entityXforms;
+		std::vector<Mat4f> storeXforms;
+		std::vector<Mat4f> parallelStoreXforms;
+
+		const auto entityResult = MeasureEntities("Entity", scenario.movingStride, entityXforms);
+		const auto storeResult = MeasureTransformStore("TransformStore", scenario.movingStride, nullptr, storeXforms);
+		const auto parallelStoreResult = MeasureTransformStore("TransformStore parallel", scenario.movingStride,
+		                                                       &threadPool, parallelStoreXforms);
+
+		const auto difference = MaxDifference(entityXforms, storeXforms);
+
+		if (entityXforms.size() != storeXforms.size() || difference > 1e-4f) {
+			ERROR_LOG(scenario.name + ": TransformStore results differ from Entity by " + std::to_string(difference));
+			return 1;
+		}
+
+		// The parallel update must be deterministic, so it has to match the serial one exactly.
+		if (parallelStoreXforms != storeXforms) {
+			ERROR_LOG(scenario.name + ": the parallel TransformStore update differs from the serial one.");
+			return 1;
+		}
+
+		for (const auto& result : { entityResult, storeResult, parallelStoreResult }) {
+			LOG(scenario.name + ", " + result.name + ": " + std::to_string(result.msPerFrame) + " ms/frame, " +
+				std::to_string(result.updatedPerFrame) + " transforms updated per frame");
+
+			stream << scenario.name << "," << result.name << "," << result.msPerFrame << ","
+					<< result.updatedPerFrame << "\n";
+		}
+	}
+
+	stream.close();
+
+	return 0;
+}
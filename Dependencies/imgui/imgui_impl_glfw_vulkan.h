@@ -8,7 +8,7 @@
 
 struct GLFWwindow;
 
-#define IMGUI_VK_QUEUED_FRAMES 2
+#define IMGUI_VK_QUEUED_FRAMES 3
 
 struct ImGui_ImplGlfwVulkan_Init_Data
 {
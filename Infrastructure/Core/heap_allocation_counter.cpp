@@ -0,0 +1,65 @@
+#include "heap_allocation_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<ui64> s_AllocationCount{ 0 };
+
+// Constant initialized, so reading it from operator new is safe on any thread.
+static thread_local bool t_Paused{ false };
+
+HeapAllocationCounter::ScopedPause::ScopedPause() noexcept
+	: m_WasPaused{ t_Paused }
+{
+	t_Paused = true;
+}
+
+HeapAllocationCounter::ScopedPause::~ScopedPause()
+{
+	t_Paused = m_WasPaused;
+}
+
+ui64 HeapAllocationCounter::GetAllocationCount() noexcept
+{
+	return s_AllocationCount.load(std::memory_order_relaxed);
+}
+
+// Replacements of the global allocation functions. The array and nothrow
+// forms of the standard library forward to these.
+void* operator new(const std::size_t size)
+{
+	if (!t_Paused) {
+		s_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (const auto memory = std::malloc(size ? size : 1)) {
+		return memory;
+	}
+
+	throw std::bad_alloc{};
+}
+
+void* operator new[](const std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
@@ -0,0 +1,36 @@
+#ifndef HEAP_ALLOCATION_COUNTER_H_
+#define HEAP_ALLOCATION_COUNTER_H_
+#include "types.h"
+
+/**
+ * \brief Counts the calls to the global operator new.
+ * \details The replacement operators live in heap_allocation_counter.cpp and
+ * are only linked into executables that reference this class. Take the count
+ * before and after a section to get the number of heap allocations it made
+ * on any thread.
+ */
+class HeapAllocationCounter {
+public:
+	/**
+	 * \brief Stops counting the allocations of the calling thread while it is alive.
+	 * \details Lets the main thread do unrelated work, like building the UI,
+	 * inside a section whose allocations are being counted on other threads.
+	 */
+	class ScopedPause {
+	private:
+		bool m_WasPaused;
+
+	public:
+		ScopedPause() noexcept;
+
+		ScopedPause(const ScopedPause& other) = delete;
+
+		ScopedPause& operator=(const ScopedPause& other) = delete;
+
+		~ScopedPause();
+	};
+
+	static ui64 GetAllocationCount() noexcept;
+};
+
+#endif //HEAP_ALLOCATION_COUNTER_H_
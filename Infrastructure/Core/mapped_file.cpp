@@ -0,0 +1,133 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& fileName) noexcept
+{
+	Close();
+
+#ifdef _WIN32
+	m_FileHandle = CreateFileA(fileName.c_str(),
+	                           GENERIC_READ,
+	                           FILE_SHARE_READ,
+	                           nullptr,
+	                           OPEN_EXISTING,
+	                           FILE_ATTRIBUTE_NORMAL,
+	                           nullptr);
+
+	if (m_FileHandle == INVALID_HANDLE_VALUE) {
+		m_FileHandle = nullptr;
+		return false;
+	}
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(m_FileHandle, &size) || !size.QuadPart) {
+		Close();
+		return false;
+	}
+
+	m_Size = static_cast<size_t>(size.QuadPart);
+
+	m_MappingHandle = CreateFileMappingA(m_FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (!m_MappingHandle) {
+		Close();
+		return false;
+	}
+
+	m_pData = MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+	if (!m_pData) {
+		Close();
+		return false;
+	}
+
+	return true;
+#else
+	const auto file = open(fileName.c_str(), O_RDONLY);
+
+	if (file == -1) {
+		return false;
+	}
+
+	struct stat status {};
+
+	if (fstat(file, &status) == -1 || !status.st_size) {
+		close(file);
+		return false;
+	}
+
+	const auto size = static_cast<size_t>(status.st_size);
+
+	const auto data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+	// The mapping keeps the file alive on its own.
+	close(file);
+
+	if (data == MAP_FAILED) {
+		return false;
+	}
+
+	m_pData = data;
+	m_Size = size;
+
+	return true;
+#endif
+}
+
+void MappedFile::Close() noexcept
+{
+#ifdef _WIN32
+	if (m_pData) {
+		UnmapViewOfFile(m_pData);
+	}
+
+	if (m_MappingHandle) {
+		CloseHandle(m_MappingHandle);
+	}
+
+	if (m_FileHandle) {
+		CloseHandle(m_FileHandle);
+	}
+
+	m_MappingHandle = nullptr;
+	m_FileHandle = nullptr;
+#else
+	if (m_pData) {
+		munmap(m_pData, m_Size);
+	}
+#endif
+
+	m_pData = nullptr;
+	m_Size = 0;
+}
+
+bool MappedFile::IsOpen() const noexcept
+{
+	return m_pData != nullptr;
+}
+
+const ui8* MappedFile::GetData() const noexcept
+{
+	return static_cast<const ui8*>(m_pData);
+}
+
+size_t MappedFile::GetSize() const noexcept
+{
+	return m_Size;
+}
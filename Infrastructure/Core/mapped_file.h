@@ -0,0 +1,49 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <string>
+#include "types.h"
+
+/**
+ * \brief A file mapped read only into memory.
+ * \details Pages are only read from disk once they are touched, so opening a
+ * large file is cheap and its data can be copied straight to where it is needed.
+ * The data stays valid until the file is closed.
+ */
+class MappedFile {
+private:
+	void* m_pData{ nullptr };
+
+	size_t m_Size{ 0 };
+
+#ifdef _WIN32
+	void* m_FileHandle{ nullptr };
+
+	void* m_MappingHandle{ nullptr };
+#endif
+
+public:
+	MappedFile() = default;
+
+	MappedFile(const MappedFile&) = delete;
+
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile();
+
+	/**
+	 * \brief Maps the whole file. Empty files cannot be mapped.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool Open(const std::string& fileName) noexcept;
+
+	void Close() noexcept;
+
+	bool IsOpen() const noexcept;
+
+	const ui8* GetData() const noexcept;
+
+	size_t GetSize() const noexcept;
+};
+
+#endif //MAPPED_FILE_H_
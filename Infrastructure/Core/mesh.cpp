@@ -21,6 +21,16 @@ void Mesh::AddIndices(const std::vector<ui32>& indices) noexcept
 	m_Indices.insert(m_Indices.cend(), indices.begin(), indices.end());
 }
 
+void Mesh::AddVertices(const Vertex* vertices, const size_t count) noexcept
+{
+	m_Vertices.insert(m_Vertices.cend(), vertices, vertices + count);
+}
+
+void Mesh::AddIndices(const ui32* indices, const size_t count) noexcept
+{
+	m_Indices.insert(m_Indices.cend(), indices, indices + count);
+}
+
 const std::vector<Vertex>& Mesh::GetVertices() const noexcept
 {
 	return m_Vertices;
@@ -76,3 +86,34 @@ void Mesh::GenerateIndices(VertexWinding vertexWinding) noexcept
 	}
 }
 
+MeshRange Mesh::Append(const Mesh& mesh) noexcept
+{
+	MeshRange range;
+	range.firstIndex = static_cast<ui32>(m_Indices.size());
+	range.vertexOffset = static_cast<i32>(m_Vertices.size());
+
+	m_Vertices.insert(m_Vertices.cend(), mesh.m_Vertices.begin(), mesh.m_Vertices.end());
+
+	if (mesh.m_Indices.empty()) {
+		for (auto i = 0u; i < mesh.m_Vertices.size(); ++i) {
+			m_Indices.push_back(i);
+		}
+	}
+	else {
+		m_Indices.insert(m_Indices.cend(), mesh.m_Indices.begin(), mesh.m_Indices.end());
+	}
+
+	range.indexCount = static_cast<ui32>(m_Indices.size()) - range.firstIndex;
+
+	return range;
+}
+
+void Mesh::SetVertexLayout(const VertexLayout& vertexLayout) noexcept
+{
+	m_VertexLayout = vertexLayout;
+}
+
+const VertexLayout& Mesh::GetVertexLayout() const noexcept
+{
+	return m_VertexLayout;
+}
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include "vertex.h"
+#include "vertex_layout.h"
 #include "resource.h"
 
 enum class VertexWinding {
@@ -10,12 +11,25 @@ enum class VertexWinding {
 	COUNTERCLOCKWISE
 };
 
+/**
+ * \brief Location of a mesh that was appended to another mesh.
+ * \details The indices of the range are relative to its first vertex, so a draw
+ * uses vertexOffset as the base vertex.
+ */
+struct MeshRange {
+	ui32 firstIndex{ 0 };
+	ui32 indexCount{ 0 };
+	i32 vertexOffset{ 0 };
+};
+
 class Mesh {
 private:
 	std::vector<Vertex> m_Vertices;
 
 	std::vector<ui32> m_Indices;
 
+	VertexLayout m_VertexLayout;
+
 public:
 	virtual ~Mesh() = default;
 
@@ -27,6 +41,10 @@ public:
 
 	void AddIndices(const std::vector<ui32>& indices) noexcept;
 
+	void AddVertices(const Vertex* vertices, size_t count) noexcept;
+
+	void AddIndices(const ui32* indices, size_t count) noexcept;
+
 	const std::vector<Vertex>& GetVertices() const noexcept;
 
 	const std::vector<ui32>& GetIndices() const noexcept;
@@ -39,6 +57,22 @@ public:
 
 	void GenerateIndices(VertexWinding vertexWinding) noexcept;
 
+	/**
+	 * \brief Appends the vertices and indices of mesh to this mesh.
+	 * \details Used to pack several meshes into one vertex and index buffer so
+	 * that they can be drawn with indirect draws. A mesh without indices gets
+	 * a sequential index range.
+	 * \return The range the appended mesh occupies.
+	 */
+	MeshRange Append(const Mesh& mesh) noexcept;
+
+	/**
+	 * \brief Sets the layout CreateBuffers() converts the vertices to. FULL by default.
+	 */
+	void SetVertexLayout(const VertexLayout& vertexLayout) noexcept;
+
+	const VertexLayout& GetVertexLayout() const noexcept;
+
 	virtual bool CreateBuffers() noexcept = 0;
 };
 
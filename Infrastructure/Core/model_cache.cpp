@@ -0,0 +1,352 @@
+#include "model_cache.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include "logger.h"
+
+// "MDLC", read as a little endian integer.
+static constexpr ui32 CACHE_MAGIC{ 0x434C444D };
+
+// Has to be bumped whenever the importer flags of the scenes or the layout of the file change.
+static constexpr ui32 CACHE_VERSION{ 1 };
+
+// Keeps the vertex and index data of every mesh aligned for the copies to staging memory.
+static constexpr size_t CACHE_DATA_ALIGNMENT{ 16 };
+
+struct CacheHeader {
+	ui32 magic;
+
+	ui32 version;
+
+	ui32 vertexSize;
+
+	ui32 meshCount;
+
+	ui64 sourceStamp;
+
+	/**
+	 * \brief Location of the materials and nodes, which are stored one field after the other.
+	 */
+	ui64 infoOffset;
+
+	ui64 infoSize;
+};
+
+struct CacheMesh {
+	ui64 vertexOffset;
+
+	ui64 indexOffset;
+
+	ui32 vertexCount;
+
+	ui32 indexCount;
+
+	ui32 materialIndex;
+
+	ui32 padding;
+};
+
+static size_t AlignUp(const size_t value, const size_t alignment) noexcept
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+template<typename T>
+static void WriteInfo(std::vector<ui8>& info, const T& value) noexcept
+{
+	const auto bytes = reinterpret_cast<const ui8*>(&value);
+
+	info.insert(info.cend(), bytes, bytes + sizeof(T));
+}
+
+static void WriteInfo(std::vector<ui8>& info, const std::string& value) noexcept
+{
+	WriteInfo(info, static_cast<ui32>(value.size()));
+
+	info.insert(info.cend(), value.cbegin(), value.cend());
+}
+
+template<typename T>
+static bool ReadInfo(const ui8* info, const size_t infoSize, size_t& offset, T& value) noexcept
+{
+	if (infoSize - offset < sizeof(T)) {
+		return false;
+	}
+
+	memcpy(&value, info + offset, sizeof(T));
+	offset += sizeof(T);
+
+	return true;
+}
+
+static bool ReadInfo(const ui8* info, const size_t infoSize, size_t& offset, std::string& value) noexcept
+{
+	ui32 size;
+
+	if (!ReadInfo(info, infoSize, offset, size) || infoSize - offset < size) {
+		return false;
+	}
+
+	value.assign(reinterpret_cast<const char*>(info + offset), size);
+	offset += size;
+
+	return true;
+}
+
+static bool ReadInfo(const ui8* info, const size_t infoSize, size_t& offset, Vec3f& value) noexcept
+{
+	return ReadInfo(info, infoSize, offset, value.x) &&
+		ReadInfo(info, infoSize, offset, value.y) &&
+		ReadInfo(info, infoSize, offset, value.z);
+}
+
+const std::string ModelCache::EXTENSION{ ".mcache" };
+
+ui64 ModelCache::GetSourceStamp(const std::string& sourceFileName) noexcept
+{
+	std::error_code error;
+
+	const auto size = std::filesystem::file_size(sourceFileName, error);
+
+	if (error) {
+		return 0;
+	}
+
+	const auto writeTime = std::filesystem::last_write_time(sourceFileName, error);
+
+	if (error) {
+		return 0;
+	}
+
+	// FNV-1a over the size and the write time.
+	ui64 stamp{ 14695981039346656037ull };
+
+	for (const auto value : { static_cast<ui64>(size), static_cast<ui64>(writeTime.time_since_epoch().count()) }) {
+		for (auto i = 0u; i < sizeof(ui64); ++i) {
+			stamp ^= (value >> (i * 8)) & 0xFF;
+			stamp *= 1099511628211ull;
+		}
+	}
+
+	return stamp ? stamp : 1;
+}
+
+bool ModelCache::Write(const std::string& fileName, const ui64 sourceStamp, const ModelView& model) noexcept
+{
+	std::vector<ui8> info;
+
+	WriteInfo(info, static_cast<ui32>(model.materials.size()));
+
+	for (const auto& material : model.materials) {
+		for (const auto& texture : material.textures) {
+			WriteInfo(info, texture);
+		}
+	}
+
+	WriteInfo(info, static_cast<ui32>(model.nodes.size()));
+
+	for (const auto& node : model.nodes) {
+		WriteInfo(info, node.name);
+		WriteInfo(info, node.meshIndex);
+
+		for (const auto value : { node.position.x, node.position.y, node.position.z,
+		                          node.orientation.w, node.orientation.x, node.orientation.y, node.orientation.z,
+		                          node.scale.x, node.scale.y, node.scale.z }) {
+			WriteInfo(info, value);
+		}
+
+		WriteInfo(info, node.childCount);
+	}
+
+	CacheHeader header{};
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.vertexSize = sizeof(Vertex);
+	header.meshCount = static_cast<ui32>(model.meshes.size());
+	header.sourceStamp = sourceStamp;
+	header.infoOffset = sizeof(CacheHeader) + sizeof(CacheMesh) * model.meshes.size();
+	header.infoSize = info.size();
+
+	std::vector<CacheMesh> meshes(model.meshes.size());
+
+	auto offset = static_cast<size_t>(header.infoOffset + header.infoSize);
+
+	for (auto i = 0u; i < meshes.size(); ++i) {
+		const auto& mesh = model.meshes[i];
+
+		meshes[i].vertexCount = mesh.vertexCount;
+		meshes[i].indexCount = mesh.indexCount;
+		meshes[i].materialIndex = mesh.materialIndex;
+
+		offset = AlignUp(offset, CACHE_DATA_ALIGNMENT);
+		meshes[i].vertexOffset = offset;
+		offset += sizeof(Vertex) * mesh.vertexCount;
+
+		offset = AlignUp(offset, CACHE_DATA_ALIGNMENT);
+		meshes[i].indexOffset = offset;
+		offset += sizeof(ui32) * mesh.indexCount;
+	}
+
+	std::ofstream stream{ fileName, std::ios::binary | std::ios::trunc };
+
+	if (!stream) {
+		ERROR_LOG("Failed to open model cache for writing: " + fileName);
+		return false;
+	}
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof header);
+	stream.write(reinterpret_cast<const char*>(meshes.data()), sizeof(CacheMesh) * meshes.size());
+	stream.write(reinterpret_cast<const char*>(info.data()), info.size());
+
+	static const char padding[CACHE_DATA_ALIGNMENT]{};
+
+	for (auto i = 0u; i < meshes.size(); ++i) {
+		const auto& mesh = model.meshes[i];
+
+		stream.write(padding, meshes[i].vertexOffset - static_cast<size_t>(stream.tellp()));
+		stream.write(reinterpret_cast<const char*>(mesh.vertices), sizeof(Vertex) * mesh.vertexCount);
+
+		stream.write(padding, meshes[i].indexOffset - static_cast<size_t>(stream.tellp()));
+		stream.write(reinterpret_cast<const char*>(mesh.indices), sizeof(ui32) * mesh.indexCount);
+	}
+
+	if (!stream) {
+		ERROR_LOG("Failed to write model cache: " + fileName);
+		return false;
+	}
+
+	return true;
+}
+
+bool ModelCache::Open(const std::string& fileName, const ui64 sourceStamp) noexcept
+{
+	Close();
+
+	// A missing cache is not an error, it is written after the first import.
+	if (!m_File.Open(fileName)) {
+		return false;
+	}
+
+	const auto data = m_File.GetData();
+	const auto dataSize = m_File.GetSize();
+
+	const auto header = reinterpret_cast<const CacheHeader*>(data);
+
+	if (dataSize < sizeof(CacheHeader) ||
+		header->magic != CACHE_MAGIC || header->version != CACHE_VERSION || header->vertexSize != sizeof(Vertex)) {
+		LOG("Model cache is of another version, ignoring it: " + fileName);
+		Close();
+		return false;
+	}
+
+	if (header->sourceStamp != sourceStamp) {
+		LOG("Model cache is stale, ignoring it: " + fileName);
+		Close();
+		return false;
+	}
+
+	if (header->infoOffset != sizeof(CacheHeader) + sizeof(CacheMesh) * static_cast<ui64>(header->meshCount) ||
+		header->infoOffset > dataSize || dataSize - header->infoOffset < header->infoSize) {
+		ERROR_LOG("Model cache has an invalid header: " + fileName);
+		Close();
+		return false;
+	}
+
+	const auto info = data + header->infoOffset;
+	const auto infoSize = static_cast<size_t>(header->infoSize);
+
+	size_t offset{ 0 };
+
+	ui32 materialCount;
+
+	auto valid = ReadInfo(info, infoSize, offset, materialCount) && materialCount <= infoSize;
+
+	if (valid) {
+		m_Model.materials.resize(materialCount);
+	}
+
+	for (auto i = 0u; valid && i < materialCount; ++i) {
+		for (auto& texture : m_Model.materials[i].textures) {
+			valid = valid && ReadInfo(info, infoSize, offset, texture);
+		}
+	}
+
+	ui32 nodeCount{ 0 };
+
+	valid = valid && ReadInfo(info, infoSize, offset, nodeCount) && nodeCount <= infoSize;
+
+	if (valid) {
+		m_Model.nodes.resize(nodeCount);
+	}
+
+	// Every node but the root is the child of exactly one other.
+	ui64 childCount{ 0 };
+
+	for (auto i = 0u; valid && i < nodeCount; ++i) {
+		auto& node = m_Model.nodes[i];
+
+		valid = ReadInfo(info, infoSize, offset, node.name) &&
+			ReadInfo(info, infoSize, offset, node.meshIndex) &&
+			ReadInfo(info, infoSize, offset, node.position) &&
+			ReadInfo(info, infoSize, offset, node.orientation.w) &&
+			ReadInfo(info, infoSize, offset, node.orientation.x) &&
+			ReadInfo(info, infoSize, offset, node.orientation.y) &&
+			ReadInfo(info, infoSize, offset, node.orientation.z) &&
+			ReadInfo(info, infoSize, offset, node.scale) &&
+			ReadInfo(info, infoSize, offset, node.childCount) &&
+			node.meshIndex >= -1 && node.meshIndex < static_cast<i64>(header->meshCount);
+
+		childCount += node.childCount;
+	}
+
+	if (!valid || !nodeCount || childCount != nodeCount - 1) {
+		ERROR_LOG("Model cache has invalid materials or nodes: " + fileName);
+		Close();
+		return false;
+	}
+
+	const auto meshes = reinterpret_cast<const CacheMesh*>(data + sizeof(CacheHeader));
+
+	m_Model.meshes.resize(header->meshCount);
+
+	for (auto i = 0u; i < header->meshCount; ++i) {
+		const auto& mesh = meshes[i];
+
+		const auto vertexBytes = sizeof(Vertex) * static_cast<ui64>(mesh.vertexCount);
+		const auto indexBytes = sizeof(ui32) * static_cast<ui64>(mesh.indexCount);
+
+		if (mesh.vertexOffset % CACHE_DATA_ALIGNMENT || mesh.indexOffset % CACHE_DATA_ALIGNMENT ||
+			mesh.vertexOffset > dataSize || dataSize - mesh.vertexOffset < vertexBytes ||
+			mesh.indexOffset > dataSize || dataSize - mesh.indexOffset < indexBytes ||
+			mesh.materialIndex >= materialCount) {
+			ERROR_LOG("Model cache has an invalid mesh " + std::to_string(i) + ": " + fileName);
+			Close();
+			return false;
+		}
+
+		m_Model.meshes[i].vertices = reinterpret_cast<const Vertex*>(data + mesh.vertexOffset);
+		m_Model.meshes[i].vertexCount = mesh.vertexCount;
+		m_Model.meshes[i].indices = reinterpret_cast<const ui32*>(data + mesh.indexOffset);
+		m_Model.meshes[i].indexCount = mesh.indexCount;
+		m_Model.meshes[i].materialIndex = mesh.materialIndex;
+	}
+
+	return true;
+}
+
+void ModelCache::Close() noexcept
+{
+	m_File.Close();
+
+	m_Model = ModelView{};
+}
+
+bool ModelCache::IsOpen() const noexcept
+{
+	return m_File.IsOpen();
+}
+
+const ModelView& ModelCache::GetModel() const noexcept
+{
+	return m_Model;
+}
@@ -0,0 +1,113 @@
+#ifndef MODEL_CACHE_H_
+#define MODEL_CACHE_H_
+
+#include <array>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+#include "texture.h"
+#include "vertex.h"
+
+/**
+ * \brief The vertices and indices of a mesh of a model, and the material it uses.
+ * \details The data is owned by whoever produced the view: an import or a mapped cache.
+ */
+struct ModelMesh {
+	const Vertex* vertices{ nullptr };
+
+	ui32 vertexCount{ 0 };
+
+	const ui32* indices{ nullptr };
+
+	ui32 indexCount{ 0 };
+
+	ui32 materialIndex{ 0 };
+};
+
+/**
+ * \brief The file names of the textures of a material, in TextureType order. Empty if it has none.
+ */
+struct ModelMaterial {
+	std::array<std::string, SUPPORTED_TEX_COUNT> textures;
+};
+
+struct ModelNode {
+	std::string name;
+
+	/**
+	 * \brief The first mesh of the node, -1 if it has none.
+	 */
+	i32 meshIndex{ -1 };
+
+	Vec3f position;
+
+	Quatf orientation;
+
+	Vec3f scale{ 1.0f };
+
+	/**
+	 * \brief The children directly follow their parent, each with its own children, in order.
+	 */
+	ui32 childCount{ 0 };
+};
+
+/**
+ * \brief Everything the scenes take from an imported model.
+ * \details nodes is the hierarchy flattened depth first, starting with the root.
+ */
+struct ModelView {
+	std::vector<ModelMesh> meshes;
+
+	std::vector<ModelMaterial> materials;
+
+	std::vector<ModelNode> nodes;
+};
+
+/**
+ * \brief An imported model saved as it is after post processing, so that later
+ * runs can skip the importer.
+ * \details The file is a header, a table with the counts and offsets of the
+ * vertices and indices of every mesh, the materials and nodes, and the vertex and
+ * index data of the meshes. Opening a cache maps the file, the meshes of its view
+ * point straight into the mapping and stay valid until the cache is closed.
+ * The header records a stamp of the source model and the layout of Vertex, a cache
+ * that does not match either is stale and fails to open.
+ */
+class ModelCache {
+private:
+	MappedFile m_File;
+
+	ModelView m_Model;
+
+public:
+	/**
+	 * \brief Appended to the file name of the source model to get the one of its cache.
+	 */
+	static const std::string EXTENSION;
+
+	/**
+	 * \brief Returns a stamp that changes whenever the source model is modified,
+	 * made from its size and last write time. 0 if it does not exist.
+	 */
+	static ui64 GetSourceStamp(const std::string& sourceFileName) noexcept;
+
+	/**
+	 * \brief Writes model to a cache of the source with sourceStamp.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	static bool Write(const std::string& fileName, ui64 sourceStamp, const ModelView& model) noexcept;
+
+	/**
+	 * \brief Maps the cache and reads its materials and nodes.
+	 * \return TRUE if successful, FALSE if it does not exist, is stale or invalid.
+	 */
+	bool Open(const std::string& fileName, ui64 sourceStamp) noexcept;
+
+	void Close() noexcept;
+
+	bool IsOpen() const noexcept;
+
+	const ModelView& GetModel() const noexcept;
+};
+
+#endif //MODEL_CACHE_H_
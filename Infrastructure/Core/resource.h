@@ -50,6 +50,27 @@ public:
 	 * \return TRUE if the loading has been successful, false otherwise.
 	 */
 	virtual bool Load(const std::string& fileName) noexcept = 0;
+
+	/**
+	 * \brief The part of Load() that may run on a worker thread, like reading and decoding the file.
+	 * \details Called by ResourceManager::LoadRequested() for many resources at once,
+	 * so it must not touch anything but the resource itself. Resources that do not
+	 * split their loading do all of it in Upload().
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	virtual bool Decode(const std::string& /*fileName*/) noexcept
+	{
+		return true;
+	}
+
+	/**
+	 * \brief The rest of Load(), on the thread that owns the graphics API, once Decode() succeeded.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	virtual bool Upload(const std::string& fileName) noexcept
+	{
+		return Load(fileName);
+	}
 };
 
 #endif //RESOURCE_H_
@@ -1,10 +1,15 @@
 #ifndef RESOURCE_MANAGER_H_
 #define RESOURCE_MANAGER_H_
 
+#include <chrono>
+#include <future>
 #include <map>
+#include <memory>
 #include <iostream>
+#include <vector>
 #include "resource.h"
 #include "logger.h"
+#include "thread_pool.h"
 
 static const std::string MODELS_PATH{ "data/models/" };
 static const std::string TEXTURE_PATH{ "data/textures/" };
@@ -13,6 +18,38 @@ static const std::string AUDIO_PATH{ "data/audio/" };
 
 static int s_Id{ 0 };
 
+/**
+ * \brief A resource requested through ResourceManager::Request().
+ * \details Resolves once ResourceManager::LoadRequested() has loaded the batch it
+ * was requested in, to nullptr if the resource failed to load.
+ */
+template<typename T>
+class ResourceHandle {
+private:
+	std::shared_future<Resource*> m_Future;
+
+public:
+	ResourceHandle() = default;
+
+	explicit ResourceHandle(std::shared_future<Resource*> future) : m_Future{ std::move(future) }
+	{
+	}
+
+	bool IsReady() const noexcept
+	{
+		return m_Future.valid() && m_Future.wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready;
+	}
+
+	/**
+	 * \brief Blocks until the resource is loaded. Never resolves before the batch is loaded.
+	 * \return the resource, nullptr if it failed to load.
+	 */
+	T* Get() const noexcept
+	{
+		return m_Future.valid() ? static_cast<T*>(m_Future.get()) : nullptr;
+	}
+};
+
 /**
  * \brief Resource manager class of the engine. Manages several types of resources: models, textures, configuration
  * and audio.
@@ -29,6 +66,37 @@ private:
 	 */
 	std::map<unsigned int, Resource*> m_ResourcesById;
 
+	struct PendingLoad {
+		std::string fileName;
+
+		std::unique_ptr<Resource> resource;
+
+		std::promise<Resource*> promise;
+
+		std::shared_future<Resource*> future;
+
+		/**
+		 * \brief Whether a resource is of the requested type, the handles cast to it.
+		 */
+		bool (*isRequestedType)(Resource* resource) noexcept{ nullptr };
+
+		bool decoded{ false };
+	};
+
+	/**
+	 * \brief Requested since the last LoadRequested(), in request order.
+	 */
+	std::vector<PendingLoad> m_PendingLoads;
+
+	template<typename T>
+	static ResourceHandle<T> MakeResolvedHandle(Resource* resource) noexcept
+	{
+		std::promise<Resource*> promise;
+		promise.set_value(resource);
+
+		return ResourceHandle<T>{ promise.get_future().share() };
+	}
+
 public:
 	~ResourceManager()
 	{
@@ -82,6 +150,99 @@ public:
 		return reinterpret_cast<T*>(resource);
 	}
 
+	/**
+	 * \brief Queues a resource to be loaded by the next LoadRequested().
+	 * \details A resource that is already loaded resolves right away, one that is
+	 * already queued shares the handle of the first request. If either is not a T,
+	 * the handle resolves to nullptr.
+	 */
+	template<typename T, typename... Args>
+	ResourceHandle<T> Request(const std::string& fileName, Args&&... args) noexcept
+	{
+		const auto it = m_ResourcesByName.find(fileName);
+
+		if (it != m_ResourcesByName.end() && it->second) {
+			if (!dynamic_cast<T*>(it->second)) {
+				ERROR_LOG("Resource \"" + fileName + "\" is already loaded as another type.");
+				return MakeResolvedHandle<T>(nullptr);
+			}
+
+			return MakeResolvedHandle<T>(it->second);
+		}
+
+		for (const auto& load : m_PendingLoads) {
+			if (load.fileName == fileName) {
+				if (!dynamic_cast<T*>(load.resource.get())) {
+					ERROR_LOG("Resource \"" + fileName + "\" is already requested as another type.");
+					return MakeResolvedHandle<T>(nullptr);
+				}
+
+				return ResourceHandle<T>{ load.future };
+			}
+		}
+
+		PendingLoad load;
+		load.fileName = fileName;
+		load.resource.reset(new T{ std::forward<Args>(args)... });
+		load.isRequestedType = [](Resource* resource) noexcept { return dynamic_cast<T*>(resource) != nullptr; };
+		load.future = load.promise.get_future().share();
+
+		m_PendingLoads.push_back(std::move(load));
+
+		return ResourceHandle<T>{ m_PendingLoads.back().future };
+	}
+
+	/**
+	 * \brief Loads every requested resource and resolves their handles.
+	 * \details The resources are decoded concurrently across the workers of
+	 * threadPool and the calling thread. They are then uploaded and registered on
+	 * the calling thread in request order, so the uploads of the whole batch end
+	 * up together, e.g. in one batch of the Vulkan uploader.
+	 */
+	void LoadRequested(ThreadPool& threadPool) noexcept
+	{
+		auto& loads = m_PendingLoads;
+
+		threadPool.ParallelFor(0, loads.size(), 1, [&loads](const size_t begin, const size_t end)
+		{
+			for (auto i = begin; i < end; ++i) {
+				loads[i].decoded = loads[i].resource->Decode(loads[i].fileName);
+			}
+		});
+
+		for (auto& load : loads) {
+			// Loaded through Load() or Get() since it was requested.
+			const auto registered = m_ResourcesByName.find(load.fileName);
+
+			if (registered != m_ResourcesByName.end() && registered->second) {
+				if (!load.isRequestedType(registered->second)) {
+					ERROR_LOG("Resource \"" + load.fileName + "\" was loaded as another type.");
+					load.promise.set_value(nullptr);
+					continue;
+				}
+
+				load.promise.set_value(registered->second);
+				continue;
+			}
+
+			if (!load.decoded || !load.resource->Upload(load.fileName)) {
+				ERROR_LOG("Failed to load resource \"" + load.fileName + "\".");
+				load.promise.set_value(nullptr);
+				continue;
+			}
+
+			const auto resource = load.resource.release();
+
+			resource->SetId(s_Id);
+			RegisterResource(resource, load.fileName);
+			LOG("Loaded ->  " + load.fileName);
+
+			load.promise.set_value(resource);
+		}
+
+		loads.clear();
+	}
+
 	/**
 	 * \brief Register a new resource by name
 	 * \param resource the resource to register
@@ -0,0 +1,201 @@
+#ifndef TASK_H_
+#define TASK_H_
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * \brief Size of the inline closure storage of a Task.
+ * \details Large enough for a lambda that captures a VkCommandBufferInheritanceInfo
+ * by value along with a few pointers and indices.
+ */
+constexpr size_t TASK_STORAGE_SIZE = 128;
+
+/**
+ * \brief Move-only void() callable with inline storage.
+ * \details Unlike std::function a Task never allocates. Closures that do not
+ * fit in TASK_STORAGE_SIZE bytes are rejected at compile time.
+ */
+class Task {
+private:
+	using InvokeFunction = void(*)(void* callable);
+
+	using MoveFunction = void(*)(void* destination, void* source);
+
+	using DestroyFunction = void(*)(void* callable);
+
+	alignas(std::max_align_t) unsigned char m_Storage[TASK_STORAGE_SIZE];
+
+	InvokeFunction m_Invoke{ nullptr };
+
+	MoveFunction m_Move{ nullptr };
+
+	DestroyFunction m_Destroy{ nullptr };
+
+	void MoveFrom(Task& other) noexcept
+	{
+		if (other.m_Move) {
+			other.m_Move(m_Storage, other.m_Storage);
+		}
+
+		m_Invoke = other.m_Invoke;
+		m_Move = other.m_Move;
+		m_Destroy = other.m_Destroy;
+
+		other.m_Invoke = nullptr;
+		other.m_Move = nullptr;
+		other.m_Destroy = nullptr;
+	}
+
+public:
+	Task() noexcept = default;
+
+	template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value>>
+	Task(F&& function) noexcept
+	{
+		using Callable = std::decay_t<F>;
+
+		static_assert(sizeof(Callable) <= TASK_STORAGE_SIZE,
+		              "Task closure does not fit in the inline storage. Capture less or capture by reference.");
+		static_assert(alignof(Callable) <= alignof(std::max_align_t),
+		              "Task closure is over-aligned.");
+		static_assert(std::is_nothrow_move_constructible<Callable>::value,
+		              "Task closure must be nothrow move constructible.");
+
+		new (m_Storage) Callable(std::forward<F>(function));
+
+		m_Invoke = [](void* callable)
+		{
+			(*static_cast<Callable*>(callable))();
+		};
+
+		m_Move = [](void* destination, void* source)
+		{
+			auto sourceCallable = static_cast<Callable*>(source);
+			new (destination) Callable(std::move(*sourceCallable));
+			sourceCallable->~Callable();
+		};
+
+		m_Destroy = [](void* callable)
+		{
+			static_cast<Callable*>(callable)->~Callable();
+		};
+	}
+
+	Task(Task&& other) noexcept
+	{
+		MoveFrom(other);
+	}
+
+	Task& operator=(Task&& other) noexcept
+	{
+		if (this != &other) {
+			Reset();
+			MoveFrom(other);
+		}
+
+		return *this;
+	}
+
+	Task(const Task& other) = delete;
+
+	Task& operator=(const Task& other) = delete;
+
+	~Task()
+	{
+		Reset();
+	}
+
+	void operator()()
+	{
+		m_Invoke(m_Storage);
+	}
+
+	explicit operator bool() const noexcept
+	{
+		return m_Invoke != nullptr;
+	}
+
+	void Reset() noexcept
+	{
+		if (m_Destroy) {
+			m_Destroy(m_Storage);
+		}
+
+		m_Invoke = nullptr;
+		m_Move = nullptr;
+		m_Destroy = nullptr;
+	}
+};
+
+/**
+ * \brief Completion counter for a batch of tasks.
+ * \details Submit tasks to a group with ThreadPool::Run and wait for only
+ * that batch with ThreadPool::Wait(group). The group must outlive its tasks.
+ */
+class TaskGroup {
+private:
+	friend class ThreadPool;
+
+	std::atomic<size_t> m_PendingTasks{ 0 };
+
+public:
+	TaskGroup() = default;
+
+	TaskGroup(const TaskGroup& other) = delete;
+
+	TaskGroup& operator=(const TaskGroup& other) = delete;
+
+	bool IsDone() const noexcept
+	{
+		return m_PendingTasks.load(std::memory_order_acquire) == 0;
+	}
+};
+
+/**
+ * \brief A task queued on a ThreadPool along with the group it belongs to, if any.
+ */
+struct ScheduledTask {
+	Task task;
+
+	TaskGroup* pGroup{ nullptr };
+
+	/**
+	 * \brief The task arena of the pool a stealable task was allocated from.
+	 */
+	size_t arena{ 0 };
+};
+
+/**
+ * \brief Non-owning reference to a void(size_t begin, size_t end) callable.
+ * \details Used by ThreadPool::ParallelFor, which does not return before
+ * every chunk has run, so the referenced callable always outlives it.
+ */
+class RangeTask {
+private:
+	using InvokeFunction = void(*)(const void* callable, size_t begin, size_t end);
+
+	const void* m_pCallable{ nullptr };
+
+	InvokeFunction m_Invoke{ nullptr };
+
+public:
+	template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, RangeTask>::value>>
+	RangeTask(const F& function) noexcept
+		: m_pCallable{ &function },
+		  m_Invoke{ [](const void* callable, const size_t begin, const size_t end)
+		  {
+			  (*static_cast<const F*>(callable))(begin, end);
+		  } }
+	{
+	}
+
+	void operator()(const size_t begin, const size_t end) const
+	{
+		m_Invoke(m_pCallable, begin, end);
+	}
+};
+
+#endif //TASK_H_
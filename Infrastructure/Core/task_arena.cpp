@@ -0,0 +1,40 @@
+#include "task_arena.h"
+#include <algorithm>
+
+TaskArena::TaskArena(const size_t blockSize)
+	: m_BlockSize{ blockSize }
+{
+}
+
+ScheduledTask* TaskArena::Allocate(const size_t count)
+{
+	// Skip blocks that cannot fit the request contiguously.
+	while (m_CurrentBlock < m_Blocks.size() && m_Offset + count > m_Blocks[m_CurrentBlock].capacity) {
+		++m_CurrentBlock;
+		m_Offset = 0;
+	}
+
+	if (m_CurrentBlock == m_Blocks.size()) {
+		Block block;
+		block.capacity = std::max(m_BlockSize, count);
+		block.slots = std::make_unique<Slot[]>(block.capacity);
+
+		m_Blocks.push_back(std::move(block));
+	}
+
+	auto task = reinterpret_cast<ScheduledTask*>(&m_Blocks[m_CurrentBlock].slots[m_Offset]);
+	m_Offset += count;
+
+	return task;
+}
+
+void TaskArena::Reset() noexcept
+{
+	m_CurrentBlock = 0;
+	m_Offset = 0;
+}
+
+size_t TaskArena::GetBlockCount() const noexcept
+{
+	return m_Blocks.size();
+}
@@ -0,0 +1,47 @@
+#ifndef TASK_ARENA_H_
+#define TASK_ARENA_H_
+#include <memory>
+#include <vector>
+#include <type_traits>
+#include "task.h"
+
+/**
+ * \brief Bump allocator for the tasks queued on a ThreadPool.
+ * \details Hands out contiguous, uninitialized Task storage and is rewound
+ * with Reset() once every task allocated from it has been destroyed.
+ * Blocks are kept across resets, so after the first few frames no further
+ * heap allocations take place. Not thread safe, the owner must serialize access.
+ */
+class TaskArena {
+private:
+	using Slot = std::aligned_storage_t<sizeof(ScheduledTask), alignof(ScheduledTask)>;
+
+	struct Block {
+		std::unique_ptr<Slot[]> slots;
+		size_t capacity{ 0 };
+	};
+
+	std::vector<Block> m_Blocks;
+
+	size_t m_CurrentBlock{ 0 };
+
+	size_t m_Offset{ 0 };
+
+	size_t m_BlockSize;
+
+public:
+	explicit TaskArena(size_t blockSize = 4096);
+
+	/**
+	 * \brief Returns storage for count contiguous tasks.
+	 * \details The caller constructs the tasks in place and is responsible
+	 * for destroying them before the next Reset().
+	 */
+	ScheduledTask* Allocate(size_t count);
+
+	void Reset() noexcept;
+
+	size_t GetBlockCount() const noexcept;
+};
+
+#endif //TASK_ARENA_H_
@@ -10,6 +10,31 @@ enum TextureType {
 	SUPPORTED_TEX_COUNT
 };
 
+/**
+ * \brief How much of the mip chain of a texture is built and kept resident.
+ */
+enum class TextureMipMode {
+	// Only the base level, as stored in the file.
+	NONE,
+	// The whole chain, built when the texture is loaded.
+	FULL,
+	// The whole chain is built, but only the smallest levels are resident at first.
+	// The larger ones are made resident one at a time by StreamNextLevel().
+	STREAMED
+};
+
+/**
+ * \brief How the pixels of a texture are laid out in memory, on disk and on the GPU.
+ */
+enum class TextureFormat {
+	// 4 bytes per pixel, what stb_image decodes to.
+	RGBA8,
+	// 8 bytes per 4x4 block, opaque color.
+	BC1,
+	// 16 bytes per 4x4 block, BC1 color and interpolated alpha.
+	BC3
+};
+
 class Texture : public Resource {
 private:
 	TextureType m_Type;
@@ -0,0 +1,206 @@
+#include "texture_container.h"
+#include <fstream>
+#include "logger.h"
+
+// "BTEX", read as a little endian integer.
+static constexpr ui32 CONTAINER_MAGIC{ 0x58455442 };
+
+static constexpr ui32 CONTAINER_VERSION{ 1 };
+
+// Every level starts at a multiple of the largest block size, which also keeps staging copies aligned.
+static constexpr size_t CONTAINER_LEVEL_ALIGNMENT{ 16 };
+
+struct ContainerHeader {
+	ui32 magic;
+
+	ui32 version;
+
+	ui32 format;
+
+	ui32 width;
+
+	ui32 height;
+
+	ui32 levelCount;
+};
+
+struct ContainerLevel {
+	ui64 offset;
+
+	ui64 size;
+};
+
+static size_t AlignUp(const size_t value, const size_t alignment) noexcept
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+const std::string TextureContainer::EXTENSION{ ".btex" };
+
+bool TextureContainer::IsContainer(const std::string& fileName) noexcept
+{
+	return fileName.size() > EXTENSION.size() &&
+		fileName.compare(fileName.size() - EXTENSION.size(), EXTENSION.size(), EXTENSION) == 0;
+}
+
+bool TextureContainer::Write(const std::string& fileName,
+                             const TextureFormat format,
+                             const std::vector<MipLevel>& chain) noexcept
+{
+	if (chain.empty()) {
+		ERROR_LOG("Cannot write a texture container without levels.");
+		return false;
+	}
+
+	std::vector<std::vector<ui8>> levelData;
+	levelData.reserve(chain.size());
+
+	for (const auto& level : chain) {
+		levelData.push_back(CompressLevel(format, level));
+	}
+
+	ContainerHeader header{};
+	header.magic = CONTAINER_MAGIC;
+	header.version = CONTAINER_VERSION;
+	header.format = static_cast<ui32>(format);
+	header.width = chain[0].size.x;
+	header.height = chain[0].size.y;
+	header.levelCount = static_cast<ui32>(chain.size());
+
+	std::vector<ContainerLevel> levels(chain.size());
+
+	auto offset = sizeof(ContainerHeader) + sizeof(ContainerLevel) * levels.size();
+
+	for (auto i = 0u; i < levels.size(); ++i) {
+		offset = AlignUp(offset, CONTAINER_LEVEL_ALIGNMENT);
+
+		levels[i].offset = offset;
+		levels[i].size = levelData[i].size();
+
+		offset += levelData[i].size();
+	}
+
+	std::ofstream stream{ fileName, std::ios::binary | std::ios::trunc };
+
+	if (!stream) {
+		ERROR_LOG("Failed to open texture container for writing: " + fileName);
+		return false;
+	}
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof header);
+	stream.write(reinterpret_cast<const char*>(levels.data()), sizeof(ContainerLevel) * levels.size());
+
+	static const char padding[CONTAINER_LEVEL_ALIGNMENT]{};
+
+	for (auto i = 0u; i < levels.size(); ++i) {
+		stream.write(padding, levels[i].offset - static_cast<size_t>(stream.tellp()));
+		stream.write(reinterpret_cast<const char*>(levelData[i].data()), levelData[i].size());
+	}
+
+	if (!stream) {
+		ERROR_LOG("Failed to write texture container: " + fileName);
+		return false;
+	}
+
+	return true;
+}
+
+bool TextureContainer::Open(const std::string& fileName) noexcept
+{
+	Close();
+
+	if (!m_File.Open(fileName)) {
+		ERROR_LOG("Failed to map texture container: " + fileName);
+		return false;
+	}
+
+	const auto data = m_File.GetData();
+	const auto dataSize = m_File.GetSize();
+
+	if (dataSize < sizeof(ContainerHeader)) {
+		ERROR_LOG("Texture container is too small: " + fileName);
+		Close();
+		return false;
+	}
+
+	const auto header = reinterpret_cast<const ContainerHeader*>(data);
+
+	if (header->magic != CONTAINER_MAGIC || header->version != CONTAINER_VERSION) {
+		ERROR_LOG("Not a texture container, or one of another version: " + fileName);
+		Close();
+		return false;
+	}
+
+	m_Format = static_cast<TextureFormat>(header->format);
+	m_Size = Vec2ui{ header->width, header->height };
+	m_LevelCount = header->levelCount;
+
+	if (header->format > static_cast<ui32>(TextureFormat::BC3) ||
+		!m_Size.x || !m_Size.y ||
+		!m_LevelCount || m_LevelCount > GetMipLevelCount(m_Size) ||
+		dataSize < sizeof(ContainerHeader) + sizeof(ContainerLevel) * m_LevelCount) {
+		ERROR_LOG("Texture container has an invalid header: " + fileName);
+		Close();
+		return false;
+	}
+
+	const auto levels = reinterpret_cast<const ContainerLevel*>(data + sizeof(ContainerHeader));
+
+	m_LevelData.resize(m_LevelCount);
+	m_LevelBytes.resize(m_LevelCount);
+
+	for (auto i = 0u; i < m_LevelCount; ++i) {
+		const auto expectedBytes = GetTextureLevelBytes(m_Format, GetMipLevelSize(m_Size, i));
+
+		if (levels[i].size != expectedBytes || levels[i].offset > dataSize || dataSize - levels[i].offset < expectedBytes) {
+			ERROR_LOG("Texture container has an invalid level " + std::to_string(i) + ": " + fileName);
+			Close();
+			return false;
+		}
+
+		m_LevelData[i] = data + levels[i].offset;
+		m_LevelBytes[i] = expectedBytes;
+	}
+
+	return true;
+}
+
+void TextureContainer::Close() noexcept
+{
+	m_File.Close();
+
+	m_LevelCount = 0;
+
+	m_LevelData.clear();
+	m_LevelBytes.clear();
+}
+
+bool TextureContainer::IsOpen() const noexcept
+{
+	return m_File.IsOpen();
+}
+
+TextureFormat TextureContainer::GetFormat() const noexcept
+{
+	return m_Format;
+}
+
+const Vec2ui& TextureContainer::GetSize() const noexcept
+{
+	return m_Size;
+}
+
+ui32 TextureContainer::GetLevelCount() const noexcept
+{
+	return m_LevelCount;
+}
+
+const ui8* TextureContainer::GetLevelData(const ui32 level) const noexcept
+{
+	return m_LevelData[level];
+}
+
+size_t TextureContainer::GetLevelBytes(const ui32 level) const noexcept
+{
+	return m_LevelBytes[level];
+}
@@ -0,0 +1,79 @@
+#ifndef TEXTURE_CONTAINER_H_
+#define TEXTURE_CONTAINER_H_
+
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+#include "texture.h"
+#include "texture_utilities.h"
+
+/**
+ * \brief A texture baked offline: its whole mip chain, already in the format it is sampled in.
+ * \details The file is a header with the format, the size and the level count,
+ * a table with the offset and size of every level, and the data of the levels,
+ * largest first. Opening a container maps the file into memory instead of
+ * reading it, so the data of a level can be copied straight into staging memory
+ * and nothing has to be decoded. The data stays valid until the container is closed.
+ */
+class TextureContainer {
+private:
+	MappedFile m_File;
+
+	TextureFormat m_Format{ TextureFormat::RGBA8 };
+
+	Vec2ui m_Size;
+
+	ui32 m_LevelCount{ 0 };
+
+	/**
+	 * \brief Points into the mapped file.
+	 */
+	std::vector<const ui8*> m_LevelData;
+
+	std::vector<size_t> m_LevelBytes;
+
+public:
+	/**
+	 * \brief Extension of the files written by Write().
+	 */
+	static const std::string EXTENSION;
+
+	TextureContainer() = default;
+
+	TextureContainer(const TextureContainer&) = delete;
+
+	TextureContainer& operator=(const TextureContainer&) = delete;
+
+	/**
+	 * \brief Returns TRUE if fileName has the extension of a container.
+	 */
+	static bool IsContainer(const std::string& fileName) noexcept;
+
+	/**
+	 * \brief Converts the levels of an RGBA8 mip chain to format and writes them to a container.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	static bool Write(const std::string& fileName, TextureFormat format, const std::vector<MipLevel>& chain) noexcept;
+
+	/**
+	 * \brief Maps the file and checks that its levels are where the header says.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool Open(const std::string& fileName) noexcept;
+
+	void Close() noexcept;
+
+	bool IsOpen() const noexcept;
+
+	TextureFormat GetFormat() const noexcept;
+
+	const Vec2ui& GetSize() const noexcept;
+
+	ui32 GetLevelCount() const noexcept;
+
+	const ui8* GetLevelData(ui32 level) const noexcept;
+
+	size_t GetLevelBytes(ui32 level) const noexcept;
+};
+
+#endif //TEXTURE_CONTAINER_H_
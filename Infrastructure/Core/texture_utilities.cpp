@@ -0,0 +1,272 @@
+#include "texture_utilities.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+ui32 GetMipLevelCount(const Vec2ui& size) noexcept
+{
+	auto levels = 1u;
+
+	for (auto largest = std::max(size.x, size.y); largest > 1; largest /= 2) {
+		++levels;
+	}
+
+	return levels;
+}
+
+Vec2ui GetMipLevelSize(const Vec2ui& size, const ui32 level) noexcept
+{
+	return Vec2ui{ std::max(1u, size.x >> level), std::max(1u, size.y >> level) };
+}
+
+std::vector<MipLevel> GenerateMipChain(const ui8* pixels, const Vec2ui& size) noexcept
+{
+	const auto levelCount = GetMipLevelCount(size);
+
+	std::vector<MipLevel> chain(levelCount);
+
+	chain[0].size = size;
+	chain[0].pixels.resize(static_cast<size_t>(size.x) * size.y * 4);
+	std::memcpy(chain[0].pixels.data(), pixels, chain[0].pixels.size());
+
+	for (auto level = 1u; level < levelCount; ++level) {
+		const auto& source = chain[level - 1];
+		auto& destination = chain[level];
+
+		destination.size = GetMipLevelSize(size, level);
+		destination.pixels.resize(static_cast<size_t>(destination.size.x) * destination.size.y * 4);
+
+		// A dimension that is already 1 is sampled twice instead of being halved.
+		const auto stepX = source.size.x > 1 ? 1u : 0u;
+		const auto stepY = source.size.y > 1 ? 1u : 0u;
+
+		for (auto y = 0u; y < destination.size.y; ++y) {
+			const auto row0 = source.pixels.data() + static_cast<size_t>(2 * y) * source.size.x * 4;
+			const auto row1 = source.pixels.data() + static_cast<size_t>(2 * y + stepY) * source.size.x * 4;
+
+			auto out = destination.pixels.data() + static_cast<size_t>(y) * destination.size.x * 4;
+
+			for (auto x = 0u; x < destination.size.x; ++x) {
+				const auto x0 = 2 * x * 4;
+				const auto x1 = (2 * x + stepX) * 4;
+
+				for (auto channel = 0u; channel < 4; ++channel) {
+					const auto sum = row0[x0 + channel] + row0[x1 + channel] + row1[x0 + channel] + row1[x1 + channel];
+
+					out[x * 4 + channel] = static_cast<ui8>((sum + 2) / 4);
+				}
+			}
+		}
+	}
+
+	return chain;
+}
+
+size_t GetTextureLevelBytes(const TextureFormat format, const Vec2ui& size) noexcept
+{
+	const auto blockCount = static_cast<size_t>((size.x + 3) / 4) * ((size.y + 3) / 4);
+
+	switch (format) {
+		case TextureFormat::BC1:
+			return blockCount * 8;
+		case TextureFormat::BC3:
+			return blockCount * 16;
+		default:
+			return static_cast<size_t>(size.x) * size.y * 4;
+	}
+}
+
+bool HasTransparency(const MipLevel& level) noexcept
+{
+	for (size_t i = 3; i < level.pixels.size(); i += 4) {
+		if (level.pixels[i] != 255) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Block compression -------------------------------------------------
+static ui16 ToRgb565(const ui8* color) noexcept
+{
+	return static_cast<ui16>(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+static void FromRgb565(const ui16 color, ui8* out) noexcept
+{
+	const auto r = (color >> 11) & 0x1f;
+	const auto g = (color >> 5) & 0x3f;
+	const auto b = color & 0x1f;
+
+	out[0] = static_cast<ui8>((r << 3) | (r >> 2));
+	out[1] = static_cast<ui8>((g << 2) | (g >> 4));
+	out[2] = static_cast<ui8>((b << 3) | (b >> 2));
+}
+
+// Copies the 4x4 block at x, y of the level, repeating the last row and column past the edges.
+static void FetchBlock(const MipLevel& level, const ui32 x, const ui32 y, ui8* block) noexcept
+{
+	for (auto row = 0u; row < 4; ++row) {
+		const auto sourceY = std::min(y + row, level.size.y - 1);
+
+		for (auto column = 0u; column < 4; ++column) {
+			const auto sourceX = std::min(x + column, level.size.x - 1);
+
+			std::memcpy(block + (row * 4 + column) * 4,
+			            level.pixels.data() + (static_cast<size_t>(sourceY) * level.size.x + sourceX) * 4,
+			            4);
+		}
+	}
+}
+
+static void EncodeColorBlock(const ui8* block, ui8* out) noexcept
+{
+	ui8 minColor[3]{ 255, 255, 255 };
+	ui8 maxColor[3]{ 0, 0, 0 };
+
+	for (auto i = 0u; i < 16; ++i) {
+		for (auto channel = 0u; channel < 3; ++channel) {
+			minColor[channel] = std::min(minColor[channel], block[i * 4 + channel]);
+			maxColor[channel] = std::max(maxColor[channel], block[i * 4 + channel]);
+		}
+	}
+
+	// Moving the end points inwards by 1/16 of the range lowers the error of the colors in between.
+	for (auto channel = 0u; channel < 3; ++channel) {
+		const auto inset = (maxColor[channel] - minColor[channel]) >> 4;
+
+		minColor[channel] = static_cast<ui8>(minColor[channel] + inset);
+		maxColor[channel] = static_cast<ui8>(maxColor[channel] - inset);
+	}
+
+	auto color0 = ToRgb565(maxColor);
+	auto color1 = ToRgb565(minColor);
+
+	// color0 > color1 selects the mode with two interpolated colors instead of one and black.
+	if (color0 < color1) {
+		std::swap(color0, color1);
+	}
+
+	ui32 indices{ 0 };
+
+	if (color0 != color1) {
+		ui8 palette[4][3];
+
+		FromRgb565(color0, palette[0]);
+		FromRgb565(color1, palette[1]);
+
+		for (auto channel = 0u; channel < 3; ++channel) {
+			palette[2][channel] = static_cast<ui8>((2 * palette[0][channel] + palette[1][channel]) / 3);
+			palette[3][channel] = static_cast<ui8>((palette[0][channel] + 2 * palette[1][channel]) / 3);
+		}
+
+		for (auto i = 0u; i < 16; ++i) {
+			auto bestIndex = 0u;
+			auto bestDistance = std::numeric_limits<i32>::max();
+
+			for (auto index = 0u; index < 4; ++index) {
+				auto distance = 0;
+
+				for (auto channel = 0u; channel < 3; ++channel) {
+					const auto difference = block[i * 4 + channel] - palette[index][channel];
+					distance += difference * difference;
+				}
+
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					bestIndex = index;
+				}
+			}
+
+			indices |= bestIndex << (i * 2);
+		}
+	}
+
+	out[0] = static_cast<ui8>(color0 & 0xff);
+	out[1] = static_cast<ui8>(color0 >> 8);
+	out[2] = static_cast<ui8>(color1 & 0xff);
+	out[3] = static_cast<ui8>(color1 >> 8);
+
+	for (auto i = 0u; i < 4; ++i) {
+		out[4 + i] = static_cast<ui8>(indices >> (i * 8));
+	}
+}
+
+static void EncodeAlphaBlock(const ui8* block, ui8* out) noexcept
+{
+	ui8 alpha0{ 0 };
+	ui8 alpha1{ 255 };
+
+	for (auto i = 0u; i < 16; ++i) {
+		alpha0 = std::max(alpha0, block[i * 4 + 3]);
+		alpha1 = std::min(alpha1, block[i * 4 + 3]);
+	}
+
+	ui64 indices{ 0 };
+
+	// alpha0 > alpha1 selects the mode with six values interpolated between the end points.
+	if (alpha0 != alpha1) {
+		ui8 palette[8]{ alpha0, alpha1 };
+
+		for (auto i = 1u; i < 7; ++i) {
+			palette[i + 1] = static_cast<ui8>(((7 - i) * alpha0 + i * alpha1) / 7);
+		}
+
+		for (auto i = 0u; i < 16; ++i) {
+			auto bestIndex = 0u;
+			auto bestDistance = std::numeric_limits<i32>::max();
+
+			for (auto index = 0u; index < 8; ++index) {
+				const auto distance = std::abs(block[i * 4 + 3] - palette[index]);
+
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					bestIndex = index;
+				}
+			}
+
+			indices |= static_cast<ui64>(bestIndex) << (i * 3);
+		}
+	}
+
+	out[0] = alpha0;
+	out[1] = alpha1;
+
+	for (auto i = 0u; i < 6; ++i) {
+		out[2 + i] = static_cast<ui8>(indices >> (i * 8));
+	}
+}
+
+// -------------------------------------------------------------------
+
+std::vector<ui8> CompressLevel(const TextureFormat format, const MipLevel& level) noexcept
+{
+	if (format == TextureFormat::RGBA8) {
+		return level.pixels;
+	}
+
+	std::vector<ui8> data(GetTextureLevelBytes(format, level.size));
+
+	auto out = data.data();
+
+	ui8 block[16 * 4];
+
+	for (auto y = 0u; y < level.size.y; y += 4) {
+		for (auto x = 0u; x < level.size.x; x += 4) {
+			FetchBlock(level, x, y, block);
+
+			// A BC3 block is an alpha block followed by a BC1 block.
+			if (format == TextureFormat::BC3) {
+				EncodeAlphaBlock(block, out);
+				out += 8;
+			}
+
+			EncodeColorBlock(block, out);
+			out += 8;
+		}
+	}
+
+	return data;
+}
@@ -0,0 +1,53 @@
+#ifndef TEXTURE_UTILITIES_H_
+#define TEXTURE_UTILITIES_H_
+
+#include <vector>
+#include "texture.h"
+#include "types.h"
+
+/**
+ * \brief One level of a mip chain, tightly packed RGBA8 pixels.
+ */
+struct MipLevel {
+	Vec2ui size;
+
+	std::vector<ui8> pixels;
+};
+
+/**
+ * \brief Returns the number of levels of a full mip chain, down to 1x1.
+ */
+ui32 GetMipLevelCount(const Vec2ui& size) noexcept;
+
+/**
+ * \brief Returns the size of level of a mip chain whose base level has the given size.
+ */
+Vec2ui GetMipLevelSize(const Vec2ui& size, ui32 level) noexcept;
+
+/**
+ * \brief Builds the full mip chain of an RGBA8 image with a 2x2 box filter.
+ * \details Level 0 is a copy of pixels. A dimension that is odd loses its last
+ * row or column in the next level, the same as a blit with linear filtering.
+ */
+std::vector<MipLevel> GenerateMipChain(const ui8* pixels, const Vec2ui& size) noexcept;
+
+/**
+ * \brief Returns the size of the data of one level of the given size in the given format.
+ */
+size_t GetTextureLevelBytes(TextureFormat format, const Vec2ui& size) noexcept;
+
+/**
+ * \brief Returns TRUE if any pixel of the level is not fully opaque.
+ */
+bool HasTransparency(const MipLevel& level) noexcept;
+
+/**
+ * \brief Converts an RGBA8 level to the given format.
+ * \details The block formats are encoded with the bounding box of the colors of
+ * each block as the end points, which is fast and good enough for baking offline
+ * textures that are mostly smooth. Blocks that cross the edge of the level repeat
+ * its last row and column.
+ */
+std::vector<ui8> CompressLevel(TextureFormat format, const MipLevel& level) noexcept;
+
+#endif //TEXTURE_UTILITIES_H_
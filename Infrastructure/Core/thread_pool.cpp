@@ -1,78 +1,467 @@
 #include "thread_pool.h"
 #include <string>
+#include <algorithm>
 #include "logger.h"
 
+/**
+ * The pool and worker index of the calling thread. Used to route
+ * stealable tasks submitted from inside a task to the worker's own deque.
+ */
+static thread_local ThreadPool* t_pCurrentPool{ nullptr };
+
+static thread_local int t_CurrentWorkerIndex{ -1 };
+
+// TaskQueue ------------------------------------------------------------------------------------
+void TaskQueue::Push(ScheduledTask task)
+{
+	if (m_Count == m_Tasks.size()) {
+		// Full. Grow and unwrap the ring so the oldest task is at the front.
+		std::vector<ScheduledTask> tasks(std::max<size_t>(16, m_Tasks.size() * 2));
+
+		for (auto i = 0u; i < m_Count; ++i) {
+			tasks[i] = std::move(m_Tasks[(m_Head + i) % m_Tasks.size()]);
+		}
+
+		m_Tasks = std::move(tasks);
+		m_Head = 0;
+	}
+
+	m_Tasks[(m_Head + m_Count) % m_Tasks.size()] = std::move(task);
+	++m_Count;
+}
+
+ScheduledTask TaskQueue::Pop() noexcept
+{
+	auto task = std::move(m_Tasks[m_Head]);
+
+	m_Head = (m_Head + 1) % m_Tasks.size();
+	--m_Count;
+
+	return task;
+}
+
+bool TaskQueue::Empty() const noexcept
+{
+	return m_Count == 0;
+}
+
+size_t TaskQueue::Size() const noexcept
+{
+	return m_Count;
+}
+
+// WorkStealingDeque ----------------------------------------------------------------------------
+WorkStealingDeque::Buffer::Buffer(const int64_t capacity)
+	: capacity{ capacity },
+	  slots{ std::make_unique<std::atomic<ScheduledTask*>[]>(static_cast<size_t>(capacity)) }
+{
+}
+
+ScheduledTask* WorkStealingDeque::Buffer::Get(const int64_t index) const noexcept
+{
+	return slots[index & (capacity - 1)].load(std::memory_order_relaxed);
+}
+
+void WorkStealingDeque::Buffer::Put(const int64_t index, ScheduledTask* task) noexcept
+{
+	slots[index & (capacity - 1)].store(task, std::memory_order_relaxed);
+}
+
+WorkStealingDeque::Buffer* WorkStealingDeque::Grow(Buffer* buffer, const int64_t top, const int64_t bottom)
+{
+	auto grown = std::make_unique<Buffer>(buffer->capacity * 2);
+
+	for (auto i = top; i < bottom; ++i) {
+		grown->Put(i, buffer->Get(i));
+	}
+
+	// The old buffer is retired, not freed. Thieves may still hold a pointer to it.
+	m_Buffers.push_back(std::move(grown));
+	m_Buffer.store(m_Buffers.back().get(), std::memory_order_release);
+
+	return m_Buffers.back().get();
+}
+
+WorkStealingDeque::WorkStealingDeque(const int64_t capacity)
+{
+	// Capacity must be a power of two for the index masking to work.
+	int64_t powerOfTwo{ 1 };
+	while (powerOfTwo < capacity) {
+		powerOfTwo <<= 1;
+	}
+
+	m_Buffers.push_back(std::make_unique<Buffer>(powerOfTwo));
+	m_Buffer.store(m_Buffers.back().get(), std::memory_order_relaxed);
+}
+
+void WorkStealingDeque::Push(ScheduledTask* task)
+{
+	const auto bottom = m_Bottom.load(std::memory_order_relaxed);
+	const auto top = m_Top.load(std::memory_order_acquire);
+	auto buffer = m_Buffer.load(std::memory_order_relaxed);
+
+	if (bottom - top > buffer->capacity - 1) {
+		buffer = Grow(buffer, top, bottom);
+	}
+
+	buffer->Put(bottom, task);
+
+	// Release the task to thieves acquiring m_Bottom.
+	m_Bottom.store(bottom + 1, std::memory_order_release);
+}
+
+ScheduledTask* WorkStealingDeque::Pop() noexcept
+{
+	const auto bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+	const auto buffer = m_Buffer.load(std::memory_order_relaxed);
+
+	m_Bottom.store(bottom, std::memory_order_relaxed);
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	auto top = m_Top.load(std::memory_order_relaxed);
+
+	if (top > bottom) {
+		// Empty.
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	auto task = buffer->Get(bottom);
+
+	if (top == bottom) {
+		// Last task. Race against the thieves for it.
+		if (!m_Top.compare_exchange_strong(top, top + 1,
+		                                   std::memory_order_seq_cst,
+		                                   std::memory_order_relaxed)) {
+			task = nullptr;
+		}
+
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	return task;
+}
+
+ScheduledTask* WorkStealingDeque::Steal() noexcept
+{
+	auto top = m_Top.load(std::memory_order_acquire);
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	const auto bottom = m_Bottom.load(std::memory_order_acquire);
+
+	if (top >= bottom) {
+		return nullptr;
+	}
+
+	const auto buffer = m_Buffer.load(std::memory_order_acquire);
+	const auto task = buffer->Get(top);
+
+	if (!m_Top.compare_exchange_strong(top, top + 1,
+	                                   std::memory_order_seq_cst,
+	                                   std::memory_order_relaxed)) {
+		// Lost the race to the owner or another thief.
+		return nullptr;
+	}
+
+	return task;
+}
+
+bool WorkStealingDeque::Empty() const noexcept
+{
+	return m_Bottom.load(std::memory_order_relaxed) <= m_Top.load(std::memory_order_relaxed);
+}
+
 // WorkerThread ---------------------------------------------------------------------------------
 void WorkerThread::WaitAndExecute() noexcept
 {
-	while (true) {
-		Task task;
+	t_pCurrentPool = m_pThreadPool;
+	t_CurrentWorkerIndex = static_cast<int>(m_Index);
 
-		{
-			std::unique_lock<std::mutex> lock{ m_TaskQueueMutex };
-
-			m_ConditionVariable.wait(lock, [this]() -> bool { 
-				return !m_TaskQueue.empty() || m_Terminating; 
-			});
+	while (true) {
+		ScheduledTask pinnedTask;
 
-			if (m_Terminating) {
-				break;
-			}
+		if (PopPinnedTask(pinnedTask)) {
+			m_pThreadPool->Execute(pinnedTask);
+			continue;
+		}
 
-			task = m_TaskQueue.front();
+		if (const auto task = m_pThreadPool->FindTask()) {
+			m_pThreadPool->Execute(task);
+			continue;
 		}
 
-		task();
+		std::unique_lock<std::mutex> lock{ m_TaskQueueMutex };
 
-		{
-			std::lock_guard<std::mutex> lock{ m_TaskQueueMutex };
+		// Publish the sleeping state before checking for work so that a
+		// concurrent submitter either sees us sleeping or we see its tasks.
+		m_Sleeping.store(true);
 
-			m_TaskQueue.pop();
+		m_ConditionVariable.wait(lock, [this]() -> bool {
+			return !m_TaskQueue.Empty() || m_Terminating || m_pThreadPool->m_QueuedTasks.load() > 0;
+		});
 
-			m_ConditionVariable.notify_one();
+		m_Sleeping.store(false);
+
+		if (m_Terminating) {
+			break;
 		}
 	}
 }
 
-WorkerThread::WorkerThread()
+bool WorkerThread::PopPinnedTask(ScheduledTask& task) noexcept
+{
+	if (!m_PinnedTaskCount.load(std::memory_order_acquire)) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock{ m_TaskQueueMutex };
+
+	if (m_TaskQueue.Empty()) {
+		return false;
+	}
+
+	task = m_TaskQueue.Pop();
+	m_PinnedTaskCount.fetch_sub(1, std::memory_order_relaxed);
+
+	return true;
+}
+
+WorkerThread::WorkerThread(ThreadPool* threadPool, const size_t index)
+	: m_pThreadPool{ threadPool },
+	  m_Index{ index }
 {
-	// Have to pass this as an argument because WaitAndExecute is a member function.
-	m_Worker = std::thread{ &WorkerThread::WaitAndExecute, this };
 }
 
 WorkerThread::~WorkerThread()
 {
-	if (m_Worker.joinable()) {
-		Wait();
+	Terminate();
+	Join();
+}
 
-		{
-			std::lock_guard<std::mutex> lock{ m_TaskQueueMutex };
-			m_Terminating = true;
-			m_ConditionVariable.notify_one();
-		}
+void WorkerThread::Start()
+{
+	// Have to pass this as an argument because WaitAndExecute is a member function.
+	m_Worker = std::thread{ &WorkerThread::WaitAndExecute, this };
+}
 
+void WorkerThread::Terminate() noexcept
+{
+	std::lock_guard<std::mutex> lock{ m_TaskQueueMutex };
+	m_Terminating = true;
+	m_ConditionVariable.notify_one();
+}
+
+void WorkerThread::Join() noexcept
+{
+	if (m_Worker.joinable()) {
 		m_Worker.join();
 	}
 }
 
-void WorkerThread::AddTask(Task task) noexcept
+void WorkerThread::AddTask(ScheduledTask task) noexcept
+{
+	std::lock_guard<std::mutex> lock{ m_TaskQueueMutex };
+	m_TaskQueue.Push(std::move(task));
+	m_PinnedTaskCount.fetch_add(1, std::memory_order_release);
+	m_ConditionVariable.notify_one();
+}
+
+void WorkerThread::Push(ScheduledTask* task)
+{
+	m_Deque.Push(task);
+}
+
+ScheduledTask* WorkerThread::Pop() noexcept
+{
+	return m_Deque.Pop();
+}
+
+ScheduledTask* WorkerThread::Steal() noexcept
+{
+	return m_Deque.Steal();
+}
+
+void WorkerThread::Wake() noexcept
 {
 	std::lock_guard<std::mutex> lock{ m_TaskQueueMutex };
-	m_TaskQueue.push(std::move(task));
 	m_ConditionVariable.notify_one();
 }
 
-void WorkerThread::Wait() noexcept
+bool WorkerThread::IsSleeping() const noexcept
 {
-	std::unique_lock<std::mutex> lock{ m_TaskQueueMutex };
-	m_ConditionVariable.wait(lock, [this]() -> bool {
-		return m_TaskQueue.empty(); 
-	});
+	return m_Sleeping.load();
 }
 
 // ThreadPool -----------------------------------------------------------------------------------------------
 
-static int workerIndex{ 0 };
+ScheduledTask* ThreadPool::AllocateTasks(const size_t count, size_t& arena)
+{
+	m_PendingTasks.fetch_add(count);
+
+	// The arena counts the tasks as pending under the lock, so a worker
+	// finishing its previous tasks does not rewind it underneath us.
+	std::lock_guard<std::mutex> lock{ m_TaskArenaMutex };
+
+	arena = m_CurrentArena;
+	m_ArenaPendingTasks[arena].fetch_add(count);
+
+	return m_TaskArenas[arena].Allocate(count);
+}
+
+void ThreadPool::ReleaseArenaTask(const size_t arena) noexcept
+{
+	if (m_ArenaPendingTasks[arena].fetch_sub(1) == 1) {
+		// Every task allocated from the arena has been destroyed. Rewind it
+		// unless a submitter has started allocating from it meanwhile.
+		std::lock_guard<std::mutex> lock{ m_TaskArenaMutex };
+
+		if (m_ArenaPendingTasks[arena].load() == 0) {
+			m_TaskArenas[arena].Reset();
+		}
+	}
+}
+
+void ThreadPool::Submit(ScheduledTask* tasks, const size_t count)
+{
+	if (t_pCurrentPool == this) {
+		// Submitted from inside a task. Keep the work local, idle workers will steal it.
+		auto& worker = m_Workers[t_CurrentWorkerIndex];
+		for (auto i = 0u; i < count; ++i) {
+			worker->Push(&tasks[i]);
+		}
+	} else {
+		std::lock_guard<std::mutex> lock{ m_InjectedTasksMutex };
+		for (auto i = 0u; i < count; ++i) {
+			m_InjectedTasks.push_back(&tasks[i]);
+		}
+	}
+
+	// Only publish the tasks once they are reachable.
+	m_QueuedTasks.fetch_add(count);
+
+	WakeWorkers(count);
+
+	if (m_GroupWaiters.load() > 0) {
+		std::lock_guard<std::mutex> lock{ m_WaitMutex };
+		m_WaitConditionVariable.notify_all();
+	}
+}
+
+ScheduledTask* ThreadPool::FindTask() noexcept
+{
+	ScheduledTask* task{ nullptr };
+
+	const auto isWorker = t_pCurrentPool == this;
+
+	if (isWorker) {
+		task = m_Workers[t_CurrentWorkerIndex]->Pop();
+	}
+
+	if (!task) {
+		std::lock_guard<std::mutex> lock{ m_InjectedTasksMutex };
+
+		if (m_InjectedTasksHead < m_InjectedTasks.size()) {
+			task = m_InjectedTasks[m_InjectedTasksHead++];
+
+			if (m_InjectedTasksHead == m_InjectedTasks.size()) {
+				m_InjectedTasks.clear();
+				m_InjectedTasksHead = 0;
+			}
+		}
+	}
+
+	if (!task) {
+		// Start stealing from the next worker to spread thieves across victims.
+		const auto workerCount = m_Workers.size();
+		const auto firstVictim = isWorker ? t_CurrentWorkerIndex + 1 : 0;
+
+		for (auto i = 0u; i < workerCount && !task; ++i) {
+			const auto victim = (firstVictim + i) % workerCount;
+
+			if (isWorker && victim == static_cast<size_t>(t_CurrentWorkerIndex)) {
+				continue;
+			}
+
+			task = m_Workers[victim]->Steal();
+		}
+	}
+
+	if (task) {
+		m_QueuedTasks.fetch_sub(1);
+	}
+
+	return task;
+}
+
+void ThreadPool::Execute(ScheduledTask* task) noexcept
+{
+	const auto group = task->pGroup;
+	const auto arena = task->arena;
+
+	task->task();
+	task->~ScheduledTask();
+
+	ReleaseArenaTask(arena);
+
+	OnTaskFinished(group);
+}
+
+void ThreadPool::Execute(ScheduledTask& task) noexcept
+{
+	task.task();
+	task.task.Reset();
+
+	OnTaskFinished(task.pGroup);
+}
+
+void ThreadPool::OnTaskFinished(TaskGroup* group) noexcept
+{
+	// The group is released first, its owner may return from Wait(group)
+	// and destroy it as soon as the counter reaches zero, so only pool
+	// members are touched afterwards.
+	if (group && group->m_PendingTasks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		std::lock_guard<std::mutex> lock{ m_WaitMutex };
+		m_WaitConditionVariable.notify_all();
+	}
+
+	if (m_PendingTasks.fetch_sub(1) == 1) {
+		std::lock_guard<std::mutex> lock{ m_WaitMutex };
+		m_WaitConditionVariable.notify_all();
+	}
+}
+
+void ThreadPool::WakeWorkers(size_t count) noexcept
+{
+	for (auto& worker : m_Workers) {
+		if (!count) {
+			break;
+		}
+
+		if (worker->IsSleeping()) {
+			worker->Wake();
+			--count;
+		}
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	Wait();
+
+	// Stop every worker before destroying any of them. A worker that is
+	// still running may be stealing from the deque of another one.
+	for (auto& worker : m_Workers) {
+		worker->Terminate();
+	}
+
+	for (auto& worker : m_Workers) {
+		worker->Join();
+	}
+
+	m_Workers.clear();
+}
 
 bool ThreadPool::Initialize()
 {
@@ -90,53 +479,190 @@ bool ThreadPool::Initialize()
 
 	LOG("Available system threads: " + std::to_string(thread_count));
 
+	return Initialize(thread_count);
+}
+
+bool ThreadPool::Initialize(const size_t threadCount)
+{
+	if (!threadCount) {
+		ERROR_LOG("Cannot create a thread pool without workers!");
+		return false;
+	}
+
 	LOG("Creating workers...");
 
 	/**
-	* Spawn the worker threads.
+	* Create all the workers before starting any of them since
+	* running workers steal from each other's deques.
 	*/
-	for (int i = 0; i < thread_count; i++) {
-		/**
-		* The workers will execute an infinite loop function
-		* and will wait for a job to enter the job queue. Once a job is in the the queue
-		* the threads will wake up to acquire and execute it.
-		*/
-		m_Workers.push_back(std::make_unique<WorkerThread>());
+	for (auto i = 0u; i < threadCount; i++) {
+		m_Workers.push_back(std::make_unique<WorkerThread>(this, i));
+	}
+
+	/**
+	* The workers will execute an infinite loop function
+	* and will wait for a job to enter one of the queues. Once a job is available
+	* the threads will wake up to acquire and execute it.
+	*/
+	for (auto& worker : m_Workers) {
+		worker->Start();
 	}
 
 	return true;
 }
 
+void ThreadPool::BeginEpoch() noexcept
+{
+	std::lock_guard<std::mutex> lock{ m_TaskArenaMutex };
+
+	const auto next = 1 - m_CurrentArena;
+
+	// An arena without pending tasks has been rewound already. If tasks of the
+	// previous epoch on it are still running, keep filling the current one.
+	if (m_ArenaPendingTasks[next].load() == 0) {
+		m_CurrentArena = next;
+	}
+}
 
 void ThreadPool::Wait() noexcept
 {
-	for (auto& worker : m_Workers) {
-		worker->Wait();
+	while (m_PendingTasks.load() > 0) {
+		// Help with the stealable work instead of just blocking.
+		if (const auto task = FindTask()) {
+			Execute(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock{ m_WaitMutex };
+		m_WaitConditionVariable.wait(lock, [this]() -> bool {
+			return m_PendingTasks.load() == 0;
+		});
 	}
 }
 
 void ThreadPool::AddTask(int workerIndex, Task task) noexcept
 {
-	m_Workers[workerIndex]->AddTask(task);
+	m_PendingTasks.fetch_add(1);
+	m_Workers[workerIndex]->AddTask(ScheduledTask{ std::move(task), nullptr });
 }
 
 void ThreadPool::AddTask(Task task) noexcept
 {
 	if (!m_Workers.empty()) {
-		AddTask(workerIndex++ % m_Workers.size(), std::move(task));
+		size_t arena;
+		const auto stealableTask = AllocateTasks(1, arena);
+		new (stealableTask) ScheduledTask{ std::move(task), nullptr, arena };
+
+		Submit(stealableTask, 1);
 	}
 }
 
 void ThreadPool::AddTasks(std::vector<Task> tasks) noexcept
 {
-	if (!m_Workers.empty()) {
-		for (int i = 0; i < tasks.size(); ++i) {
-			AddTask(workerIndex++ % m_Workers.size(), std::move(tasks[i]));
+	if (!m_Workers.empty() && !tasks.empty()) {
+		size_t arena;
+		const auto stealableTasks = AllocateTasks(tasks.size(), arena);
+
+		for (auto i = 0u; i < tasks.size(); ++i) {
+			new (&stealableTasks[i]) ScheduledTask{ std::move(tasks[i]), nullptr, arena };
+		}
+
+		Submit(stealableTasks, tasks.size());
+	}
+}
+
+void ThreadPool::Run(TaskGroup& group, Task task) noexcept
+{
+	if (m_Workers.empty()) {
+		task();
+		return;
+	}
+
+	group.m_PendingTasks.fetch_add(1, std::memory_order_relaxed);
+
+	size_t arena;
+	const auto stealableTask = AllocateTasks(1, arena);
+	new (stealableTask) ScheduledTask{ std::move(task), &group, arena };
+
+	Submit(stealableTask, 1);
+}
+
+void ThreadPool::Run(TaskGroup& group, const int workerIndex, Task task) noexcept
+{
+	group.m_PendingTasks.fetch_add(1, std::memory_order_relaxed);
+	m_PendingTasks.fetch_add(1);
+
+	m_Workers[workerIndex]->AddTask(ScheduledTask{ std::move(task), &group });
+}
+
+void ThreadPool::Wait(TaskGroup& group) noexcept
+{
+	while (!group.IsDone()) {
+		if (const auto task = FindTask()) {
+			Execute(task);
+			continue;
 		}
+
+		// The rest of the group is pinned or running elsewhere. Sleep until it
+		// finishes or Submit() queues work this thread can help with.
+		m_GroupWaiters.fetch_add(1);
+
+		{
+			std::unique_lock<std::mutex> lock{ m_WaitMutex };
+			m_WaitConditionVariable.wait(lock, [this, &group]() -> bool {
+				return group.IsDone() || m_QueuedTasks.load() > 0;
+			});
+		}
+
+		m_GroupWaiters.fetch_sub(1);
+	}
+}
+
+void ThreadPool::ParallelFor(const size_t begin, const size_t end, size_t grain, const RangeTask& fn) noexcept
+{
+	if (begin >= end) {
+		return;
+	}
+
+	if (!grain) {
+		grain = 1;
+	}
+
+	if (m_Workers.empty() || end - begin <= grain) {
+		fn(begin, end);
+		return;
 	}
+
+	const auto chunkCount = (end - begin + grain - 1) / grain;
+
+	TaskGroup group;
+	group.m_PendingTasks.store(chunkCount, std::memory_order_relaxed);
+
+	size_t arena;
+	const auto tasks = AllocateTasks(chunkCount, arena);
+
+	for (auto i = 0u; i < chunkCount; ++i) {
+		const auto chunkBegin = begin + i * grain;
+		const auto chunkEnd = std::min(chunkBegin + grain, end);
+
+		new (&tasks[i]) ScheduledTask{ [&fn, chunkBegin, chunkEnd]()
+		{
+			fn(chunkBegin, chunkEnd);
+		}, &group, arena };
+	}
+
+	Submit(tasks, chunkCount);
+
+	// The calling thread participates until every chunk is done.
+	Wait(group);
 }
 
 size_t ThreadPool::GetWorkerCount() const noexcept
 {
 	return m_Workers.size();
 }
+
+int ThreadPool::GetCurrentWorkerIndex() noexcept
+{
+	return t_CurrentWorkerIndex;
+}
@@ -1,33 +1,119 @@
 #ifndef THREAD_POOL_H
 #define THREAD_POOL_H
+#include <array>
 #include <thread>
 #include <vector>
-#include <queue>
 #include <mutex>
+#include <atomic>
 #include <memory>
-#include <functional>
 #include <condition_variable>
+#include "task.h"
+#include "task_arena.h"
 
-using Task = std::function<void()>;
+/**
+ * \brief FIFO ring buffer of tasks.
+ * \details Storage is reused as tasks are popped and only grows when more
+ * tasks are queued than ever before, so steady-state pushes do not allocate.
+ */
+class TaskQueue {
+private:
+	std::vector<ScheduledTask> m_Tasks;
+
+	size_t m_Head{ 0 };
+
+	size_t m_Count{ 0 };
+
+public:
+	void Push(ScheduledTask task);
+
+	ScheduledTask Pop() noexcept;
+
+	bool Empty() const noexcept;
+
+	size_t Size() const noexcept;
+};
+
+class ThreadPool;
+
+/**
+ * \brief Lock-free work stealing deque (Chase-Lev).
+ * \details Only the owning worker may Push() and Pop() from the bottom.
+ * Any thread may Steal() from the top. The circular buffer grows on demand
+ * and retired buffers are kept alive until the deque is destroyed since a
+ * concurrent thief might still be reading from them.
+ */
+class WorkStealingDeque {
+private:
+	struct Buffer {
+		int64_t capacity;
+		std::unique_ptr<std::atomic<ScheduledTask*>[]> slots;
+
+		explicit Buffer(int64_t capacity);
+
+		ScheduledTask* Get(int64_t index) const noexcept;
+
+		void Put(int64_t index, ScheduledTask* task) noexcept;
+	};
+
+	std::atomic<int64_t> m_Top{ 0 };
+
+	std::atomic<int64_t> m_Bottom{ 0 };
+
+	std::atomic<Buffer*> m_Buffer;
+
+	std::vector<std::unique_ptr<Buffer>> m_Buffers;
 
-using TaskQueue = std::queue<Task>;
+	Buffer* Grow(Buffer* buffer, int64_t top, int64_t bottom);
+
+public:
+	explicit WorkStealingDeque(int64_t capacity = 1024);
+
+	WorkStealingDeque(const WorkStealingDeque& other) = delete;
+
+	WorkStealingDeque& operator=(const WorkStealingDeque& other) = delete;
+
+	void Push(ScheduledTask* task);
+
+	ScheduledTask* Pop() noexcept;
+
+	ScheduledTask* Steal() noexcept;
+
+	bool Empty() const noexcept;
+};
 
 class WorkerThread {
 private:
 	std::thread m_Worker;
-	
+
+	/**
+	 * \brief Tasks pinned to this worker through ThreadPool::AddTask(workerIndex, task).
+	 * \details These are never stolen. Benchmarks rely on this when a task
+	 * records into a command buffer allocated from a per-worker command pool.
+	 */
 	TaskQueue m_TaskQueue;
 
+	std::atomic<size_t> m_PinnedTaskCount{ 0 };
+
 	std::mutex m_TaskQueueMutex;
 
 	std::condition_variable m_ConditionVariable;
 
+	WorkStealingDeque m_Deque;
+
+	ThreadPool* m_pThreadPool;
+
+	size_t m_Index;
+
 	bool m_Terminating{ false };
 
+	std::atomic<bool> m_Sleeping{ false };
+
 	void WaitAndExecute() noexcept;
 
+	bool PopPinnedTask(ScheduledTask& task) noexcept;
+
 public:
-	WorkerThread();
+	WorkerThread(ThreadPool* threadPool, size_t index);
 
 	WorkerThread(const WorkerThread& other) = delete;
 
@@ -35,18 +121,118 @@ public:
 
 	~WorkerThread();
 
-	void AddTask(Task task) noexcept;
+	void Start();
 
-	void Wait() noexcept;
+	void Terminate() noexcept;
+
+	void Join() noexcept;
+
+	void AddTask(ScheduledTask task) noexcept;
+
+	void Push(ScheduledTask* task);
+
+	ScheduledTask* Pop() noexcept;
+
+	ScheduledTask* Steal() noexcept;
+
+	void Wake() noexcept;
+
+	bool IsSleeping() const noexcept;
 };
 
 class ThreadPool {
 private:
+	friend class WorkerThread;
+
 	std::vector<std::unique_ptr<WorkerThread>> m_Workers;
 
+	/**
+	 * \brief Stealable tasks submitted from threads that are not workers of this pool.
+	 * \details Consumed from m_InjectedTasksHead and cleared once drained
+	 * so the capacity is reused.
+	 */
+	std::vector<ScheduledTask*> m_InjectedTasks;
+
+	size_t m_InjectedTasksHead{ 0 };
+
+	std::mutex m_InjectedTasksMutex;
+
+	/**
+	 * \brief Stealable tasks that have been submitted but not yet picked up.
+	 */
+	std::atomic<int64_t> m_QueuedTasks{ 0 };
+
+	/**
+	 * \brief Tasks (pinned and stealable) that have been submitted but not yet finished.
+	 */
+	std::atomic<size_t> m_PendingTasks{ 0 };
+
+	/**
+	 * \brief Threads blocked in Wait(group).
+	 * \details Submit() only wakes them when there is one, so they can help with the new work.
+	 */
+	std::atomic<size_t> m_GroupWaiters{ 0 };
+
+	std::mutex m_WaitMutex;
+
+	std::condition_variable m_WaitConditionVariable;
+
+	/**
+	 * \brief Storage of the stealable tasks, double buffered.
+	 * \details Tasks are allocated from the current arena. An arena is rewound
+	 * as soon as its last task finishes and BeginEpoch() switches to the other
+	 * one, so the storage stays bounded even if the pool never drains.
+	 */
+	std::array<TaskArena, 2> m_TaskArenas;
+
+	/**
+	 * \brief Tasks allocated from each arena that have not finished yet.
+	 */
+	std::array<std::atomic<size_t>, 2> m_ArenaPendingTasks{};
+
+	size_t m_CurrentArena{ 0 };
+
+	std::mutex m_TaskArenaMutex;
+
+	/**
+	 * \brief Returns storage for count tasks, which have to be constructed with the returned arena.
+	 */
+	ScheduledTask* AllocateTasks(size_t count, size_t& arena);
+
+	void ReleaseArenaTask(size_t arena) noexcept;
+
+	void Submit(ScheduledTask* tasks, size_t count);
+
+	ScheduledTask* FindTask() noexcept;
+
+	void Execute(ScheduledTask* task) noexcept;
+
+	void Execute(ScheduledTask& task) noexcept;
+
+	void OnTaskFinished(TaskGroup* group) noexcept;
+
+	void WakeWorkers(size_t count) noexcept;
+
 public:
+	ThreadPool() = default;
+
+	ThreadPool(const ThreadPool& other) = delete;
+
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+
+	~ThreadPool();
+
 	bool Initialize();
 
+	bool Initialize(size_t threadCount);
+
+	/**
+	 * \brief Marks a frame boundary for the storage of the stealable tasks.
+	 * \details Tasks queued from here on come from the other arena, once the
+	 * tasks queued from it an epoch earlier have finished. Call it once per frame.
+	 */
+	void BeginEpoch() noexcept;
+
 	void Wait() noexcept;
 
 	void AddTask(int workerIndex, Task task) noexcept;
@@ -55,7 +241,40 @@ public:
 
 	void AddTasks(std::vector<Task> tasks) noexcept;
 
+	/**
+	 * \brief Queues a stealable task that counts towards group.
+	 */
+	void Run(TaskGroup& group, Task task) noexcept;
+
+	/**
+	 * \brief Queues a task pinned to workerIndex that counts towards group.
+	 */
+	void Run(TaskGroup& group, int workerIndex, Task task) noexcept;
+
+	/**
+	 * \brief Returns once every task of group has finished.
+	 * \details Other tasks may still be queued or running. The calling thread
+	 * executes stealable tasks of any group while there are some to take and
+	 * blocks otherwise.
+	 */
+	void Wait(TaskGroup& group) noexcept;
+
+	/**
+	 * \brief Splits [begin, end) into chunks of at most grain indices and
+	 * runs fn on each of them across the pool.
+	 * \details The chunks are stealable so idle workers balance the load.
+	 * The calling thread executes chunks too and returns once every chunk
+	 * has finished.
+	 */
+	void ParallelFor(size_t begin, size_t end, size_t grain, const RangeTask& fn) noexcept;
+
 	size_t GetWorkerCount() const noexcept;
+
+	/**
+	 * \brief Returns the index of the pool worker executing the calling thread,
+	 * or -1 if the calling thread is not a worker of any pool.
+	 */
+	static int GetCurrentWorkerIndex() noexcept;
 };
 
 
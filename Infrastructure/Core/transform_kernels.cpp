@@ -0,0 +1,351 @@
+#include "transform_kernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSFORM_KERNELS_X86
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+static void ComposeTransformsScalar(const Vec3f* positions,
+                                    const Quatf* orientations,
+                                    const Vec3f* scales,
+                                    Mat4f* xforms,
+                                    const size_t count) noexcept
+{
+	for (auto i = 0u; i < count; ++i) {
+		const auto& q = orientations[i];
+		const auto& s = scales[i];
+
+		// Same operation order as the SIMD kernels so every path gives identical results.
+		const auto x2 = q.x * 2.0f;
+		const auto y2 = q.y * 2.0f;
+		const auto z2 = q.z * 2.0f;
+
+		const auto xx = q.x * x2;
+		const auto yy = q.y * y2;
+		const auto zz = q.z * z2;
+		const auto xy = q.x * y2;
+		const auto xz = q.x * z2;
+		const auto yz = q.y * z2;
+		const auto wx = q.w * x2;
+		const auto wy = q.w * y2;
+		const auto wz = q.w * z2;
+
+		auto& xform = xforms[i];
+
+		xform[0] = Vec4f{ (1.0f - (yy + zz)) * s.x, (xy + wz) * s.x, (xz - wy) * s.x, 0.0f };
+		xform[1] = Vec4f{ (xy - wz) * s.y, (1.0f - (xx + zz)) * s.y, (yz + wx) * s.y, 0.0f };
+		xform[2] = Vec4f{ (xz + wy) * s.z, (yz - wx) * s.z, (1.0f - (xx + yy)) * s.z, 0.0f };
+		xform[3] = Vec4f{ positions[i], 1.0f };
+	}
+}
+
+#ifdef TRANSFORM_KERNELS_X86
+
+// Loads x, y, z into the lower three lanes without reading past the end of the vector.
+static __m128 LoadVec3(const Vec3f& v) noexcept
+{
+	const auto xy = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(&v.x)));
+	return _mm_movelh_ps(xy, _mm_load_ss(&v.z));
+}
+
+// The kernels work on groups of transforms in SoA form: inputs are transposed
+// so that each register holds one component of 4 (SSE) or 8 (AVX2) transforms
+// and the resulting matrix elements are transposed back into columns.
+static void ComposeTransformsSse(const Vec3f* positions,
+                                 const Quatf* orientations,
+                                 const Vec3f* scales,
+                                 Mat4f* xforms,
+                                 const size_t count) noexcept
+{
+	const auto one = _mm_set1_ps(1.0f);
+	const auto two = _mm_set1_ps(2.0f);
+
+	size_t i{ 0 };
+
+	for (; i + 4 <= count; i += 4) {
+		auto qx = _mm_loadu_ps(&orientations[i].x);
+		auto qy = _mm_loadu_ps(&orientations[i + 1].x);
+		auto qz = _mm_loadu_ps(&orientations[i + 2].x);
+		auto qw = _mm_loadu_ps(&orientations[i + 3].x);
+		_MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+		auto px = LoadVec3(positions[i]);
+		auto py = LoadVec3(positions[i + 1]);
+		auto pz = LoadVec3(positions[i + 2]);
+		auto pw = LoadVec3(positions[i + 3]);
+		_MM_TRANSPOSE4_PS(px, py, pz, pw);
+
+		auto sx = LoadVec3(scales[i]);
+		auto sy = LoadVec3(scales[i + 1]);
+		auto sz = LoadVec3(scales[i + 2]);
+		auto sw = LoadVec3(scales[i + 3]);
+		_MM_TRANSPOSE4_PS(sx, sy, sz, sw);
+
+		const auto x2 = _mm_mul_ps(qx, two);
+		const auto y2 = _mm_mul_ps(qy, two);
+		const auto z2 = _mm_mul_ps(qz, two);
+
+		const auto xx = _mm_mul_ps(qx, x2);
+		const auto yy = _mm_mul_ps(qy, y2);
+		const auto zz = _mm_mul_ps(qz, z2);
+		const auto xy = _mm_mul_ps(qx, y2);
+		const auto xz = _mm_mul_ps(qx, z2);
+		const auto yz = _mm_mul_ps(qy, z2);
+		const auto wx = _mm_mul_ps(qw, x2);
+		const auto wy = _mm_mul_ps(qw, y2);
+		const auto wz = _mm_mul_ps(qw, z2);
+
+		auto m00 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx);
+		auto m01 = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+		auto m02 = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+		auto m03 = _mm_setzero_ps();
+
+		auto m10 = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+		auto m11 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy);
+		auto m12 = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+		auto m13 = _mm_setzero_ps();
+
+		auto m20 = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+		auto m21 = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+		auto m22 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz);
+		auto m23 = _mm_setzero_ps();
+
+		auto m33 = one;
+
+		_MM_TRANSPOSE4_PS(m00, m01, m02, m03);
+		_MM_TRANSPOSE4_PS(m10, m11, m12, m13);
+		_MM_TRANSPOSE4_PS(m20, m21, m22, m23);
+		_MM_TRANSPOSE4_PS(px, py, pz, m33);
+
+		const __m128 columns[4][4]{
+			{ m00, m10, m20, px },
+			{ m01, m11, m21, py },
+			{ m02, m12, m22, pz },
+			{ m03, m13, m23, m33 }
+		};
+
+		for (auto j = 0u; j < 4; ++j) {
+			for (auto c = 0; c < 4; ++c) {
+				_mm_storeu_ps(&xforms[i + j][c][0], columns[j][c]);
+			}
+		}
+	}
+
+	ComposeTransformsScalar(positions + i, orientations + i, scales + i, xforms + i, count - i);
+}
+
+// 4x4 transpose within each 128 bit lane.
+TARGET_AVX2 static void Transpose4Lanes(__m256& r0, __m256& r1, __m256& r2, __m256& r3) noexcept
+{
+	const auto t0 = _mm256_unpacklo_ps(r0, r1);
+	const auto t1 = _mm256_unpacklo_ps(r2, r3);
+	const auto t2 = _mm256_unpackhi_ps(r0, r1);
+	const auto t3 = _mm256_unpackhi_ps(r2, r3);
+
+	r0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+	r1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+	r2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	r3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+TARGET_AVX2 static __m256 LoadPair(const __m128 low, const __m128 high) noexcept
+{
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+}
+
+// Lane 0 of every register works on transforms i..i+3 and lane 1 on i+4..i+7.
+TARGET_AVX2 static void ComposeTransformsAvx2(const Vec3f* positions,
+                                              const Quatf* orientations,
+                                              const Vec3f* scales,
+                                              Mat4f* xforms,
+                                              const size_t count) noexcept
+{
+	const auto one = _mm256_set1_ps(1.0f);
+	const auto two = _mm256_set1_ps(2.0f);
+
+	size_t i{ 0 };
+
+	for (; i + 8 <= count; i += 8) {
+		__m256 q[4];
+		__m256 p[4];
+		__m256 s[4];
+
+		for (auto j = 0u; j < 4; ++j) {
+			q[j] = LoadPair(_mm_loadu_ps(&orientations[i + j].x), _mm_loadu_ps(&orientations[i + j + 4].x));
+			p[j] = LoadPair(LoadVec3(positions[i + j]), LoadVec3(positions[i + j + 4]));
+			s[j] = LoadPair(LoadVec3(scales[i + j]), LoadVec3(scales[i + j + 4]));
+		}
+
+		Transpose4Lanes(q[0], q[1], q[2], q[3]);
+		Transpose4Lanes(p[0], p[1], p[2], p[3]);
+		Transpose4Lanes(s[0], s[1], s[2], s[3]);
+
+		const auto x2 = _mm256_mul_ps(q[0], two);
+		const auto y2 = _mm256_mul_ps(q[1], two);
+		const auto z2 = _mm256_mul_ps(q[2], two);
+
+		const auto xx = _mm256_mul_ps(q[0], x2);
+		const auto yy = _mm256_mul_ps(q[1], y2);
+		const auto zz = _mm256_mul_ps(q[2], z2);
+		const auto xy = _mm256_mul_ps(q[0], y2);
+		const auto xz = _mm256_mul_ps(q[0], z2);
+		const auto yz = _mm256_mul_ps(q[1], z2);
+		const auto wx = _mm256_mul_ps(q[3], x2);
+		const auto wy = _mm256_mul_ps(q[3], y2);
+		const auto wz = _mm256_mul_ps(q[3], z2);
+
+		// m[c][r] holds element r of column c for all 8 transforms.
+		__m256 m[4][4];
+
+		m[0][0] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), s[0]);
+		m[0][1] = _mm256_mul_ps(_mm256_add_ps(xy, wz), s[0]);
+		m[0][2] = _mm256_mul_ps(_mm256_sub_ps(xz, wy), s[0]);
+		m[0][3] = _mm256_setzero_ps();
+
+		m[1][0] = _mm256_mul_ps(_mm256_sub_ps(xy, wz), s[1]);
+		m[1][1] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), s[1]);
+		m[1][2] = _mm256_mul_ps(_mm256_add_ps(yz, wx), s[1]);
+		m[1][3] = _mm256_setzero_ps();
+
+		m[2][0] = _mm256_mul_ps(_mm256_add_ps(xz, wy), s[2]);
+		m[2][1] = _mm256_mul_ps(_mm256_sub_ps(yz, wx), s[2]);
+		m[2][2] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), s[2]);
+		m[2][3] = _mm256_setzero_ps();
+
+		m[3][0] = p[0];
+		m[3][1] = p[1];
+		m[3][2] = p[2];
+		m[3][3] = one;
+
+		// After the transpose m[c][j] holds column c of transforms i + j and i + j + 4.
+		for (auto c = 0; c < 4; ++c) {
+			Transpose4Lanes(m[c][0], m[c][1], m[c][2], m[c][3]);
+
+			for (auto j = 0u; j < 4; ++j) {
+				_mm_storeu_ps(&xforms[i + j][c][0], _mm256_castps256_ps128(m[c][j]));
+				_mm_storeu_ps(&xforms[i + j + 4][c][0], _mm256_extractf128_ps(m[c][j], 1));
+			}
+		}
+	}
+
+	ComposeTransformsSse(positions + i, orientations + i, scales + i, xforms + i, count - i);
+}
+
+static SimdLevel DetectSimdLevel() noexcept
+{
+#if defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 0);
+	const auto maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	const auto osxsave = (info[2] & (1 << 27)) != 0;
+	const auto avx = (info[2] & (1 << 28)) != 0;
+
+	// The OS must also save the upper halves of the YMM registers.
+	if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+		__cpuidex(info, 7, 0);
+
+		if (info[1] & (1 << 5)) {
+			return SimdLevel::AVX2;
+		}
+	}
+
+	return SimdLevel::SSE;
+#else
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2")) {
+		return SimdLevel::AVX2;
+	}
+
+	return SimdLevel::SSE;
+#endif
+}
+
+#endif //TRANSFORM_KERNELS_X86
+
+SimdLevel GetSupportedSimdLevel() noexcept
+{
+#ifdef TRANSFORM_KERNELS_X86
+	static const auto level = DetectSimdLevel();
+	return level;
+#else
+	return SimdLevel::SCALAR;
+#endif
+}
+
+const char* GetSimdLevelName(const SimdLevel level) noexcept
+{
+	switch (level) {
+	case SimdLevel::SCALAR:
+		return "Scalar";
+	case SimdLevel::SSE:
+		return "SSE";
+	case SimdLevel::AVX2:
+		return "AVX2";
+	}
+
+	return "Unknown";
+}
+
+void ComposeTransforms(const Vec3f* positions,
+                       const Quatf* orientations,
+                       const Vec3f* scales,
+                       Mat4f* xforms,
+                       const size_t count) noexcept
+{
+	ComposeTransforms(GetSupportedSimdLevel(), positions, orientations, scales, xforms, count);
+}
+
+void ComposeTransforms(const SimdLevel level,
+                       const Vec3f* positions,
+                       const Quatf* orientations,
+                       const Vec3f* scales,
+                       Mat4f* xforms,
+                       const size_t count) noexcept
+{
+	switch (level) {
+#ifdef TRANSFORM_KERNELS_X86
+	case SimdLevel::AVX2:
+		ComposeTransformsAvx2(positions, orientations, scales, xforms, count);
+		break;
+	case SimdLevel::SSE:
+		ComposeTransformsSse(positions, orientations, scales, xforms, count);
+		break;
+#endif
+	default:
+		ComposeTransformsScalar(positions, orientations, scales, xforms, count);
+		break;
+	}
+}
+
+void MultiplyTransform(const Mat4f& parent, Mat4f& xform) noexcept
+{
+#ifdef TRANSFORM_KERNELS_X86
+	const auto c0 = _mm_loadu_ps(&parent[0][0]);
+	const auto c1 = _mm_loadu_ps(&parent[1][0]);
+	const auto c2 = _mm_loadu_ps(&parent[2][0]);
+	const auto c3 = _mm_loadu_ps(&parent[3][0]);
+
+	// Every column of the result only depends on the same column of xform, so it can be done in place.
+	for (auto c = 0; c < 4; ++c) {
+		auto column = _mm_mul_ps(c0, _mm_set1_ps(xform[c][0]));
+		column = _mm_add_ps(column, _mm_mul_ps(c1, _mm_set1_ps(xform[c][1])));
+		column = _mm_add_ps(column, _mm_mul_ps(c2, _mm_set1_ps(xform[c][2])));
+		column = _mm_add_ps(column, _mm_mul_ps(c3, _mm_set1_ps(xform[c][3])));
+
+		_mm_storeu_ps(&xform[c][0], column);
+	}
+#else
+	xform = parent * xform;
+#endif
+}
@@ -0,0 +1,48 @@
+#ifndef TRANSFORM_KERNELS_H_
+#define TRANSFORM_KERNELS_H_
+#include <cstddef>
+#include "types.h"
+
+enum class SimdLevel {
+	SCALAR,
+	SSE,
+	AVX2
+};
+
+/**
+ * \brief Returns the widest instruction set the kernels can use on this CPU.
+ * \details Detected once on first use.
+ */
+SimdLevel GetSupportedSimdLevel() noexcept;
+
+const char* GetSimdLevelName(SimdLevel level) noexcept;
+
+/**
+ * \brief Builds translate * rotate * scale matrices for count transforms.
+ * \details Produces the same matrices as glm::translate, glm::toMat4 and
+ * glm::scale chained together. Orientations are expected to be normalized.
+ * Uses the widest supported instruction set.
+ */
+void ComposeTransforms(const Vec3f* positions,
+                       const Quatf* orientations,
+                       const Vec3f* scales,
+                       Mat4f* xforms,
+                       size_t count) noexcept;
+
+/**
+ * \brief Same as above but with an explicit instruction set.
+ * \details level must not be wider than GetSupportedSimdLevel().
+ */
+void ComposeTransforms(SimdLevel level,
+                       const Vec3f* positions,
+                       const Quatf* orientations,
+                       const Vec3f* scales,
+                       Mat4f* xforms,
+                       size_t count) noexcept;
+
+/**
+ * \brief xform = parent * xform.
+ */
+void MultiplyTransform(const Mat4f& parent, Mat4f& xform) noexcept;
+
+#endif //TRANSFORM_KERNELS_H_
@@ -0,0 +1,229 @@
+#include "transform_store.h"
+#include <algorithm>
+#include "transform_kernels.h"
+#include "thread_pool.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+void TransformStore::MarkDirty(const TransformHandle handle) noexcept
+{
+	m_Dirty[handle] = 1;
+	m_FirstDirty = std::min<size_t>(m_FirstDirty, handle);
+}
+
+void TransformStore::Reserve(const size_t count)
+{
+	m_Positions.reserve(count);
+	m_Orientations.reserve(count);
+	m_Scales.reserve(count);
+	m_Xforms.reserve(count);
+	m_Parents.reserve(count);
+	m_Dirty.reserve(count);
+	m_Depths.reserve(count);
+}
+
+TransformHandle TransformStore::Create(const TransformHandle parent)
+{
+	const auto handle = static_cast<TransformHandle>(m_Positions.size());
+
+	m_Positions.emplace_back(0.0f);
+	m_Orientations.emplace_back();
+	m_Scales.emplace_back(1.0f);
+	m_Xforms.emplace_back(1.0f);
+	m_Parents.push_back(parent);
+	m_Dirty.push_back(0);
+	m_Depths.push_back(parent == INVALID_TRANSFORM ? 0 : m_Depths[parent] + 1);
+
+	m_MaxDepth = std::max(m_MaxDepth, m_Depths.back());
+
+	// A new child has to pick up the world matrix of its parent.
+	if (parent != INVALID_TRANSFORM) {
+		MarkDirty(handle);
+	}
+
+	return handle;
+}
+
+void TransformStore::SetPosition(const TransformHandle handle, const Vec3f& position) noexcept
+{
+	m_Positions[handle] = position;
+	MarkDirty(handle);
+}
+
+void TransformStore::SetOrientation(const TransformHandle handle, const Quatf& orientation) noexcept
+{
+	m_Orientations[handle] = orientation;
+	MarkDirty(handle);
+}
+
+void TransformStore::SetOrientation(const TransformHandle handle, const f32 angle, const Vec3f& axis) noexcept
+{
+	m_Orientations[handle] = glm::rotate(Quatf{}, angle, axis);
+	MarkDirty(handle);
+}
+
+void TransformStore::SetScale(const TransformHandle handle, const Vec3f& scale) noexcept
+{
+	m_Scales[handle] = scale;
+	MarkDirty(handle);
+}
+
+const Vec3f& TransformStore::GetPosition(const TransformHandle handle) const noexcept
+{
+	return m_Positions[handle];
+}
+
+const Quatf& TransformStore::GetOrientation(const TransformHandle handle) const noexcept
+{
+	return m_Orientations[handle];
+}
+
+const Vec3f& TransformStore::GetScale(const TransformHandle handle) const noexcept
+{
+	return m_Scales[handle];
+}
+
+TransformHandle TransformStore::GetParent(const TransformHandle handle) const noexcept
+{
+	return m_Parents[handle];
+}
+
+const Mat4f& TransformStore::GetXform(const TransformHandle handle) const noexcept
+{
+	return m_Xforms[handle];
+}
+
+const Mat4f* TransformStore::GetXforms() const noexcept
+{
+	return m_Xforms.data();
+}
+
+void TransformStore::PropagateDirtyFlags() noexcept
+{
+	// Parents precede their children, so by the time a node is visited its
+	// parent's dirty flag is final.
+	for (auto i = m_FirstDirty; i < m_Parents.size(); ++i) {
+		const auto parent = m_Parents[i];
+
+		if (parent != INVALID_TRANSFORM && m_Dirty[parent]) {
+			m_Dirty[i] = 1;
+		}
+	}
+}
+
+size_t TransformStore::ComposeDirty(const size_t begin, const size_t end) noexcept
+{
+	size_t composed{ 0 };
+
+	// Rebuild the local matrices of each run of dirty nodes in one batch.
+	auto i = begin;
+
+	while (i < end) {
+		if (!m_Dirty[i]) {
+			++i;
+			continue;
+		}
+
+		auto runEnd = i + 1;
+
+		while (runEnd < end && m_Dirty[runEnd]) {
+			++runEnd;
+		}
+
+		ComposeTransforms(&m_Positions[i], &m_Orientations[i], &m_Scales[i], &m_Xforms[i], runEnd - i);
+
+		composed += runEnd - i;
+		i = runEnd;
+	}
+
+	return composed;
+}
+
+void TransformStore::ConcatenateDirty(const size_t begin, const size_t end, const ui16 depth) noexcept
+{
+	for (auto i = begin; i < end; ++i) {
+		if (m_Dirty[i] && m_Depths[i] == depth) {
+			MultiplyTransform(m_Xforms[m_Parents[i]], m_Xforms[i]);
+		}
+	}
+}
+
+void TransformStore::ClearDirtyFlags() noexcept
+{
+	std::fill(m_Dirty.begin() + m_FirstDirty, m_Dirty.end(), 0);
+
+	m_FirstDirty = m_Dirty.size();
+}
+
+void TransformStore::Update() noexcept
+{
+	const auto size = m_Positions.size();
+
+	m_UpdatedCount = 0;
+
+	if (m_FirstDirty >= size) {
+		return;
+	}
+
+	if (m_MaxDepth) {
+		PropagateDirtyFlags();
+	}
+
+	m_UpdatedCount = ComposeDirty(m_FirstDirty, size);
+
+	// Concatenate with the parent world matrices in a single forward pass,
+	// parents are always final before their children are visited.
+	for (auto i = m_FirstDirty; i < size; ++i) {
+		const auto parent = m_Parents[i];
+
+		if (m_Dirty[i] && parent != INVALID_TRANSFORM) {
+			MultiplyTransform(m_Xforms[parent], m_Xforms[i]);
+		}
+	}
+
+	ClearDirtyFlags();
+}
+
+void TransformStore::Update(ThreadPool& threadPool, const size_t grain) noexcept
+{
+	const auto size = m_Positions.size();
+
+	m_UpdatedCount = 0;
+
+	if (m_FirstDirty >= size) {
+		return;
+	}
+
+	// Flag propagation only touches bytes and depends on the parents, keep it serial.
+	if (m_MaxDepth) {
+		PropagateDirtyFlags();
+	}
+
+	std::atomic<size_t> updatedCount{ 0 };
+
+	threadPool.ParallelFor(m_FirstDirty, size, grain, [this, &updatedCount](const size_t begin, const size_t end)
+	{
+		updatedCount.fetch_add(ComposeDirty(begin, end), std::memory_order_relaxed);
+	});
+
+	// Nodes of the same depth never depend on each other.
+	for (ui16 depth = 1; depth <= m_MaxDepth; ++depth) {
+		threadPool.ParallelFor(m_FirstDirty, size, grain, [this, depth](const size_t begin, const size_t end)
+		{
+			ConcatenateDirty(begin, end, depth);
+		});
+	}
+
+	m_UpdatedCount = updatedCount.load();
+
+	ClearDirtyFlags();
+}
+
+size_t TransformStore::GetSize() const noexcept
+{
+	return m_Positions.size();
+}
+
+size_t TransformStore::GetUpdatedCount() const noexcept
+{
+	return m_UpdatedCount;
+}
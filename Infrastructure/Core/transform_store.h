@@ -0,0 +1,117 @@
+#ifndef TRANSFORM_STORE_H_
+#define TRANSFORM_STORE_H_
+#include <vector>
+#include "types.h"
+
+class ThreadPool;
+
+/**
+ * \brief Handle of a transform in a TransformStore.
+ */
+using TransformHandle = ui32;
+
+constexpr TransformHandle INVALID_TRANSFORM = 0xFFFFFFFF;
+
+/**
+ * \brief Structure of arrays storage for node transforms.
+ * \details The hierarchy is kept as a flat array of parent indices. A node is
+ * always created after its parent, so a single forward pass over the arrays
+ * visits parents before their children. Setters only flag the node as dirty;
+ * Update() recomputes the world matrices of the dirty nodes and of their
+ * descendants and leaves every other node untouched.
+ */
+class TransformStore {
+private:
+	std::vector<Vec3f> m_Positions;
+
+	std::vector<Quatf> m_Orientations;
+
+	std::vector<Vec3f> m_Scales;
+
+	std::vector<Mat4f> m_Xforms;
+
+	std::vector<TransformHandle> m_Parents;
+
+	std::vector<ui8> m_Dirty;
+
+	/**
+	 * \brief Number of ancestors of each node.
+	 */
+	std::vector<ui16> m_Depths;
+
+	ui16 m_MaxDepth{ 0 };
+
+	/**
+	 * \brief Lowest dirty index. Nodes before it are up to date.
+	 */
+	size_t m_FirstDirty{ 0 };
+
+	size_t m_UpdatedCount{ 0 };
+
+	void MarkDirty(TransformHandle handle) noexcept;
+
+	void PropagateDirtyFlags() noexcept;
+
+	size_t ComposeDirty(size_t begin, size_t end) noexcept;
+
+	void ConcatenateDirty(size_t begin, size_t end, ui16 depth) noexcept;
+
+	void ClearDirtyFlags() noexcept;
+
+public:
+	/**
+	 * \brief Reserves storage for count transforms.
+	 */
+	void Reserve(size_t count);
+
+	/**
+	 * \brief Creates an identity transform.
+	 * \param parent Handle of the parent transform or INVALID_TRANSFORM for a root.
+	 */
+	TransformHandle Create(TransformHandle parent = INVALID_TRANSFORM);
+
+	void SetPosition(TransformHandle handle, const Vec3f& position) noexcept;
+
+	void SetOrientation(TransformHandle handle, const Quatf& orientation) noexcept;
+
+	void SetOrientation(TransformHandle handle, f32 angle, const Vec3f& axis) noexcept;
+
+	void SetScale(TransformHandle handle, const Vec3f& scale) noexcept;
+
+	const Vec3f& GetPosition(TransformHandle handle) const noexcept;
+
+	const Quatf& GetOrientation(TransformHandle handle) const noexcept;
+
+	const Vec3f& GetScale(TransformHandle handle) const noexcept;
+
+	TransformHandle GetParent(TransformHandle handle) const noexcept;
+
+	/**
+	 * \brief Returns the world matrix computed by the last Update().
+	 */
+	const Mat4f& GetXform(TransformHandle handle) const noexcept;
+
+	const Mat4f* GetXforms() const noexcept;
+
+	/**
+	 * \brief Recomputes the world matrices of the dirty nodes and their descendants.
+	 */
+	void Update() noexcept;
+
+	/**
+	 * \brief Same as Update() but split into chunks of grain nodes that run on threadPool.
+	 * \details Every node is written by exactly one chunk and parents are
+	 * concatenated one hierarchy level at a time, so the result is identical
+	 * to Update() regardless of the number of workers.
+	 */
+	void Update(ThreadPool& threadPool, size_t grain = 1024) noexcept;
+
+	size_t GetSize() const noexcept;
+
+	/**
+	 * \brief Returns the number of world matrices recomputed by the last Update().
+	 */
+	size_t GetUpdatedCount() const noexcept;
+};
+
+#endif //TRANSFORM_STORE_H_
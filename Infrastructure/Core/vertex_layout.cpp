@@ -0,0 +1,163 @@
+#include "vertex_layout.h"
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/packing.hpp>
+
+// The FULL layout is a straight copy of the vertices.
+static_assert(sizeof(Vertex) == 4 * 3 * sizeof(f32) + 2 * sizeof(f32), "Vertex has padding.");
+
+static Vec2f EncodeOctahedral(const Vec3f& vector) noexcept
+{
+	const auto length = std::abs(vector.x) + std::abs(vector.y) + std::abs(vector.z);
+
+	if (length == 0.0f) {
+		return Vec2f{ 0.0f };
+	}
+
+	const Vec2f folded{ vector.x / length, vector.y / length };
+
+	if (vector.z >= 0.0f) {
+		return folded;
+	}
+
+	// The lower half of the octahedron is folded over the diagonals onto the upper one.
+	return Vec2f{
+		(1.0f - std::abs(folded.y)) * (folded.x >= 0.0f ? 1.0f : -1.0f),
+		(1.0f - std::abs(folded.x)) * (folded.y >= 0.0f ? 1.0f : -1.0f)
+	};
+}
+
+template<typename T>
+static void Store(ui8* destination, const T& value) noexcept
+{
+	memcpy(destination, &value, sizeof(T));
+}
+
+static void PackAttribute(const VertexFormat format, const Vec3f& value, ui8* destination) noexcept
+{
+	switch (format) {
+		case VertexFormat::FLOAT2:
+			Store(destination, Vec2f{ value });
+			break;
+		case VertexFormat::FLOAT3:
+			Store(destination, value);
+			break;
+		case VertexFormat::HALF2:
+			Store(destination, glm::packHalf2x16(Vec2f{ value }));
+			break;
+		case VertexFormat::SNORM_10_10_10_2:
+			Store(destination, glm::packSnorm3x10_1x2(Vec4f{ value, 0.0f }));
+			break;
+		case VertexFormat::OCTAHEDRAL_SNORM8:
+			Store(destination, glm::packSnorm2x8(EncodeOctahedral(value)));
+			break;
+		case VertexFormat::UNORM8_4:
+			Store(destination, glm::packUnorm4x8(Vec4f{ value, 1.0f }));
+			break;
+		default:
+			break;
+	}
+}
+
+VertexLayout::VertexLayout() noexcept
+	: VertexLayout{ VertexLayoutType::FULL }
+{
+}
+
+VertexLayout::VertexLayout(const VertexLayoutType type, const bool withColor) noexcept
+	: m_Type{ type }
+{
+	switch (type) {
+		case VertexLayoutType::PACKED:
+			m_Attributes[VERTEX_POSITION].format = VertexFormat::FLOAT3;
+			m_Attributes[VERTEX_NORMAL].format = VertexFormat::SNORM_10_10_10_2;
+			m_Attributes[VERTEX_TANGENT].format = VertexFormat::SNORM_10_10_10_2;
+			m_Attributes[VERTEX_COLOR].format = withColor ? VertexFormat::UNORM8_4 : VertexFormat::NONE;
+			m_Attributes[VERTEX_TEXCOORD].format = VertexFormat::HALF2;
+			break;
+		case VertexLayoutType::OCTAHEDRAL:
+			m_Attributes[VERTEX_POSITION].format = VertexFormat::FLOAT3;
+			m_Attributes[VERTEX_NORMAL].format = VertexFormat::OCTAHEDRAL_SNORM8;
+			m_Attributes[VERTEX_TANGENT].format = VertexFormat::OCTAHEDRAL_SNORM8;
+			m_Attributes[VERTEX_COLOR].format = withColor ? VertexFormat::UNORM8_4 : VertexFormat::NONE;
+			m_Attributes[VERTEX_TEXCOORD].format = VertexFormat::HALF2;
+			break;
+		default:
+			m_Attributes[VERTEX_POSITION].format = VertexFormat::FLOAT3;
+			m_Attributes[VERTEX_NORMAL].format = VertexFormat::FLOAT3;
+			m_Attributes[VERTEX_TANGENT].format = VertexFormat::FLOAT3;
+			m_Attributes[VERTEX_COLOR].format = VertexFormat::FLOAT3;
+			m_Attributes[VERTEX_TEXCOORD].format = VertexFormat::FLOAT2;
+			break;
+	}
+
+	// The attributes are tightly packed in Vertex order, which for FULL gives the offsets of Vertex.
+	for (auto& attribute : m_Attributes) {
+		attribute.offset = m_Stride;
+		m_Stride += GetFormatSize(attribute.format);
+	}
+
+	// Keeps every vertex 4 byte aligned.
+	m_Stride = (m_Stride + 3) / 4 * 4;
+}
+
+ui32 VertexLayout::GetFormatSize(const VertexFormat format) noexcept
+{
+	switch (format) {
+		case VertexFormat::FLOAT2:
+			return 2 * sizeof(f32);
+		case VertexFormat::FLOAT3:
+			return 3 * sizeof(f32);
+		case VertexFormat::HALF2:
+		case VertexFormat::SNORM_10_10_10_2:
+		case VertexFormat::UNORM8_4:
+			return 4;
+		case VertexFormat::OCTAHEDRAL_SNORM8:
+			return 2;
+		default:
+			return 0;
+	}
+}
+
+VertexLayoutType VertexLayout::GetType() const noexcept
+{
+	return m_Type;
+}
+
+const VertexAttributeLayout& VertexLayout::GetAttribute(const VertexAttribute attribute) const noexcept
+{
+	return m_Attributes[attribute];
+}
+
+ui32 VertexLayout::GetStride() const noexcept
+{
+	return m_Stride;
+}
+
+bool VertexLayout::HasOctahedralVectors() const noexcept
+{
+	return m_Attributes[VERTEX_NORMAL].format == VertexFormat::OCTAHEDRAL_SNORM8;
+}
+
+std::vector<ui8> VertexLayout::Pack(const Vertex* vertices, const size_t count) const noexcept
+{
+	std::vector<ui8> packed(m_Stride * count);
+
+	if (m_Type == VertexLayoutType::FULL) {
+		memcpy(packed.data(), vertices, packed.size());
+		return packed;
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		const auto& vertex = vertices[i];
+		const auto destination = packed.data() + i * m_Stride;
+
+		PackAttribute(m_Attributes[VERTEX_POSITION].format, vertex.position, destination + m_Attributes[VERTEX_POSITION].offset);
+		PackAttribute(m_Attributes[VERTEX_NORMAL].format, vertex.normal, destination + m_Attributes[VERTEX_NORMAL].offset);
+		PackAttribute(m_Attributes[VERTEX_TANGENT].format, vertex.tangent, destination + m_Attributes[VERTEX_TANGENT].offset);
+		PackAttribute(m_Attributes[VERTEX_COLOR].format, vertex.color, destination + m_Attributes[VERTEX_COLOR].offset);
+		PackAttribute(m_Attributes[VERTEX_TEXCOORD].format, Vec3f{ vertex.texcoord, 0.0f }, destination + m_Attributes[VERTEX_TEXCOORD].offset);
+	}
+
+	return packed;
+}
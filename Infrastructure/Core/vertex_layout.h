@@ -0,0 +1,102 @@
+#ifndef VERTEX_LAYOUT_H_
+#define VERTEX_LAYOUT_H_
+
+#include <array>
+#include <vector>
+#include "vertex.h"
+
+/**
+ * \brief The attributes of a Vertex, their values are the attribute locations in the shaders.
+ */
+enum VertexAttribute {
+	VERTEX_POSITION,
+	VERTEX_NORMAL,
+	VERTEX_TANGENT,
+	VERTEX_COLOR,
+	VERTEX_TEXCOORD,
+	VERTEX_ATTRIBUTE_COUNT
+};
+
+/**
+ * \brief How an attribute is stored in a vertex buffer.
+ */
+enum class VertexFormat {
+	// The attribute is left out.
+	NONE,
+	// Two 32 bit floats.
+	FLOAT2,
+	// Three 32 bit floats.
+	FLOAT3,
+	// Two 16 bit floats.
+	HALF2,
+	// A unit vector in three signed normalized 10 bit components, the 2 bit w is 0.
+	SNORM_10_10_10_2,
+	// A unit vector folded onto an octahedron, in two signed normalized 8 bit components.
+	// The vertex shader unfolds it.
+	OCTAHEDRAL_SNORM8,
+	// A colour in four unsigned normalized 8 bit components.
+	UNORM8_4
+};
+
+/**
+ * \brief The vertex layouts of the deferred rendering benchmarks, selected with attributes.vertex_layout in config.cfg.
+ */
+enum class VertexLayoutType {
+	// Every attribute as a float vector, exactly like Vertex. 56 bytes.
+	FULL,
+	// 10:10:10:2 normal and tangent, half float texcoords. 24 bytes.
+	PACKED,
+	// Octahedral normal and tangent, half float texcoords. 20 bytes.
+	OCTAHEDRAL
+};
+
+struct VertexAttributeLayout {
+	VertexFormat format{ VertexFormat::NONE };
+
+	ui32 offset{ 0 };
+};
+
+/**
+ * \brief Where and in which format the attributes of a vertex are stored in a vertex buffer.
+ * \details The vertex input state of the Vulkan pipelines and the vertex array formats
+ * of GL are both generated from it, and Pack() converts vertices to it.
+ */
+class VertexLayout {
+private:
+	VertexLayoutType m_Type{ VertexLayoutType::FULL };
+
+	std::array<VertexAttributeLayout, VERTEX_ATTRIBUTE_COUNT> m_Attributes{};
+
+	ui32 m_Stride{ 0 };
+
+public:
+	/**
+	 * \brief The FULL layout.
+	 */
+	VertexLayout() noexcept;
+
+	/**
+	 * \param withColor Keeps the colour in the compact layouts. The FULL layout always has it.
+	 */
+	explicit VertexLayout(VertexLayoutType type, bool withColor = false) noexcept;
+
+	static ui32 GetFormatSize(VertexFormat format) noexcept;
+
+	VertexLayoutType GetType() const noexcept;
+
+	const VertexAttributeLayout& GetAttribute(VertexAttribute attribute) const noexcept;
+
+	ui32 GetStride() const noexcept;
+
+	/**
+	 * \brief Returns TRUE if the vertex shader has to unfold the normal and the tangent.
+	 */
+	bool HasOctahedralVectors() const noexcept;
+
+	/**
+	 * \brief Converts count vertices to this layout, GetStride() bytes each.
+	 */
+	std::vector<ui8> Pack(const Vertex* vertices, size_t count) const noexcept;
+};
+
+#endif //VERTEX_LAYOUT_H_
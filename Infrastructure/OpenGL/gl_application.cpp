@@ -67,12 +67,23 @@ i32 GLApplication::Run() noexcept
 
 		static auto prev = 0.0;
 
+		const auto updateStart = GetTimer().GetSec();
+
 		Update();
 
+		updateTime = (GetTimer().GetSec() - updateStart) * 1000.0;
+
 		glBeginQuery(GL_TIME_ELAPSED, m_Query);
 
 		PreDraw();
+
+		// PostDraw() swaps the buffers, keep it out of the recording time.
+		const auto drawStart = GetTimer().GetSec();
+
 		Draw();
+
+		recordTime = (GetTimer().GetSec() - drawStart) * 1000.0;
+
 		PostDraw();
 
 		glEndQuery(GL_TIME_ELAPSED);
@@ -101,6 +112,9 @@ i32 GLApplication::Run() noexcept
 			totalFrameTimeSamples.push_back(wholeFrameTime);
 			totalCpuTimeSamples.push_back(cpuTime);
 			totalGpuTimeSamples.push_back(gpuTime);
+			totalUpdateTimeSamples.push_back(updateTime);
+			totalRecordTimeSamples.push_back(recordTime);
+			totalSpawnTimeSamples.push_back(spawnTime);
 
 			if (accum > 1000.0f || calculateResults) {
 				const auto size = wholeFrameTimeSamples.size();
@@ -170,11 +184,15 @@ i32 GLApplication::Run() noexcept
 				avgTotalFrameTime += totalFrameTimeSamples[i];
 				avgTotalCpuTime += totalCpuTimeSamples[i];
 				avgTotalGpuTime += totalGpuTimeSamples[i];
+				avgTotalUpdateTime += totalUpdateTimeSamples[i];
+				avgTotalRecordTime += totalRecordTimeSamples[i];
 			}
 
 			avgTotalFrameTime /= static_cast<f32>(totalFrameTimeSamples.size());
 			avgTotalCpuTime /= static_cast<f32>(totalCpuTimeSamples.size());
 			avgTotalGpuTime /= static_cast<f32>(totalGpuTimeSamples.size());
+			avgTotalUpdateTime /= static_cast<f32>(totalUpdateTimeSamples.size());
+			avgTotalRecordTime /= static_cast<f32>(totalRecordTimeSamples.size());
 
 			auto frameTimeVecCopy = totalFrameTimeSamples;
 
@@ -238,10 +256,11 @@ void GLApplication::SaveToCsv(const std::string& fname)
 {
 	std::ofstream stream{ fname + ".csv" };
 
-	stream << "Whole Frame Time,CPU Time,GPU Time\n";
+	stream << "Whole Frame Time,CPU Time,GPU Time,Update Time,Record Time\n";
 
 	for (auto i = 0u; i < totalFrameTimeSamples.size(); ++i) {
-		stream << totalFrameTimeSamples[i] << "," << totalCpuTimeSamples[i] << "," << totalGpuTimeSamples[i] << "\n";
+		stream << totalFrameTimeSamples[i] << "," << totalCpuTimeSamples[i] << "," << totalGpuTimeSamples[i] << ","
+				<< totalUpdateTimeSamples[i] << "," << totalRecordTimeSamples[i] << "\n";
 	}
 
 	stream << "\nFPS,Whole Frame Time,CPU Time,GPU Time\n";
@@ -251,8 +270,9 @@ void GLApplication::SaveToCsv(const std::string& fname)
 				"\n";
 	}
 
-	stream << "\nAverage FPS,Average Frame Time,Average CPU Time,Average GPU Time\n";
-	stream << 1000.0f / avgTotalFrameTime << "," << avgTotalFrameTime << "," << avgTotalCpuTime << "," << avgTotalGpuTime;
+	stream << "\nAverage FPS,Average Frame Time,Average CPU Time,Average GPU Time,Average Update Time,Average Record Time\n";
+	stream << 1000.0f / avgTotalFrameTime << "," << avgTotalFrameTime << "," << avgTotalCpuTime << "," << avgTotalGpuTime << ","
+			<< avgTotalUpdateTime << "," << avgTotalRecordTime;
 
 	stream << "\n99th percentile\n";
 	stream << percentile99th;
@@ -27,6 +27,9 @@ public:
 	std::vector<f32> totalCpuTimeSamples;
 	std::vector<f32> totalGpuTimeSamples;
 	std::vector<f32> totalFpsSamples;
+	std::vector<f32> totalUpdateTimeSamples;
+	std::vector<f32> totalRecordTimeSamples;
+	std::vector<f32> totalSpawnTimeSamples;
 
 	f32 wholeFrameTime{ 0.0f };
 
@@ -34,6 +37,22 @@ public:
 
 	f32 gpuTime{ 0.0f };
 
+	/**
+	 * \brief CPU time spent in Update() during the last frame, in ms.
+	 */
+	f32 updateTime{ 0.0f };
+
+	/**
+	 * \brief CPU time spent issuing the draw commands of the last frame, in ms.
+	 */
+	f32 recordTime{ 0.0f };
+
+	/**
+	 * \brief CPU time the scene spent spawning entities during the last Update(), in ms.
+	 * \details Only set by scenes that spawn entities while the benchmark runs.
+	 */
+	f32 spawnTime{ 0.0f };
+
 	f32 totalAppDuration{ 0.0 };
 
 	i64 frameCount{ 0 };
@@ -45,6 +64,8 @@ public:
 	f32 avgTotalFrameTime{ 0.0f };
 	f32 avgTotalCpuTime{ 0.0f };
 	f32 avgTotalGpuTime{ 0.0f };
+	f32 avgTotalUpdateTime{ 0.0f };
+	f32 avgTotalRecordTime{ 0.0f };
 
 	f32 minTotalFrameTime{ std::numeric_limits<f32>::max() };
 	f32 minTotalCpuTime{ std::numeric_limits<f32>::max() };
@@ -1,8 +1,39 @@
 #include "gl_mesh.h"
 #include "logger.h"
 
+/**
+ * \brief Component count, type and normalization of a vertex attribute format.
+ */
+struct GLVertexFormat {
+	GLint size;
+
+	GLenum type;
+
+	GLboolean normalized;
+};
+
+static GLVertexFormat GetGLVertexFormat(const VertexFormat format) noexcept
+{
+	switch (format) {
+		case VertexFormat::FLOAT2:
+			return GLVertexFormat{ 2, GL_FLOAT, GL_FALSE };
+		case VertexFormat::HALF2:
+			return GLVertexFormat{ 2, GL_HALF_FLOAT, GL_FALSE };
+		case VertexFormat::SNORM_10_10_10_2:
+			return GLVertexFormat{ 4, GL_INT_2_10_10_10_REV, GL_TRUE };
+		case VertexFormat::OCTAHEDRAL_SNORM8:
+			return GLVertexFormat{ 2, GL_BYTE, GL_TRUE };
+		case VertexFormat::UNORM8_4:
+			return GLVertexFormat{ 4, GL_UNSIGNED_BYTE, GL_TRUE };
+		case VertexFormat::FLOAT3:
+		default:
+			return GLVertexFormat{ 3, GL_FLOAT, GL_FALSE };
+	}
+}
+
 GLMesh::~GLMesh()
 {
+	glDeleteVertexArrays(1, &m_Vao);
 	glDeleteBuffers(1, &m_Vbo);
 	glDeleteBuffers(1, &m_Ibo);
 }
@@ -15,70 +46,105 @@ bool GLMesh::CreateBuffers() noexcept
 		return false;
 	}
 
-	if (!m_Vbo) {
-		glGenBuffers(1, &m_Vbo);
-		assert(glGetError() == GL_NO_ERROR);
-		glBindBuffer(GL_ARRAY_BUFFER, m_Vbo);
-		assert(glGetError() == GL_NO_ERROR);
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-		assert(glGetError() == GL_NO_ERROR);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		assert(glGetError() == GL_NO_ERROR);
+	if (m_Vao) {
+		return true;
+	}
+
+	const auto& vertexLayout = GetVertexLayout();
+
+	glCreateBuffers(1, &m_Vbo);
+	assert(glGetError() == GL_NO_ERROR);
+
+	// The full layout is uploaded as it is, the others are converted first.
+	if (vertexLayout.GetType() == VertexLayoutType::FULL) {
+		glNamedBufferStorage(m_Vbo, vertices.size() * sizeof(Vertex), vertices.data(), 0);
 	}
+	else {
+		const auto packedVertices = vertexLayout.Pack(vertices.data(), vertices.size());
+		glNamedBufferStorage(m_Vbo, packedVertices.size(), packedVertices.data(), 0);
+	}
+	assert(glGetError() == GL_NO_ERROR);
+
+	m_VertexCount = static_cast<GLsizei>(vertices.size());
 
 	const auto& indices = GetIndices();
 	if (!indices.empty()) {
-		if (!m_Ibo) {
-			glGenBuffers(1, &m_Ibo);
-			assert(glGetError() == GL_NO_ERROR);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Ibo);
-			assert(glGetError() == GL_NO_ERROR);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-			assert(glGetError() == GL_NO_ERROR);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-			assert(glGetError() == GL_NO_ERROR);
-		}
+		glCreateBuffers(1, &m_Ibo);
+		assert(glGetError() == GL_NO_ERROR);
+		glNamedBufferStorage(m_Ibo, indices.size() * sizeof(unsigned int), indices.data(), 0);
+		assert(glGetError() == GL_NO_ERROR);
+
+		m_IndexCount = static_cast<GLsizei>(indices.size());
 	}
 
-	glGenVertexArrays(1, &m_Vao);
-	assert(glGetError() == GL_NO_ERROR);
-	glBindVertexArray(m_Vao);
-	assert(glGetError() == GL_NO_ERROR);
-	glBindBuffer(GL_ARRAY_BUFFER, m_Vbo);
+	glCreateVertexArrays(1, &m_Vao);
 	assert(glGetError() == GL_NO_ERROR);
 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, position)));
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, normal)));
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, tangent)));
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, color)));
-	glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, texcoord)));
+	// All the attributes are interleaved in a single vertex buffer at binding 0.
+	glVertexArrayVertexBuffer(m_Vao, 0, m_Vbo, 0, vertexLayout.GetStride());
 	assert(glGetError() == GL_NO_ERROR);
 
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-	glEnableVertexAttribArray(3);
-	glEnableVertexAttribArray(4);
-	assert(glGetError() == GL_NO_ERROR);
+	// The element buffer is part of the vertex array state, binding the vertex array is enough to draw.
+	if (m_Ibo) {
+		glVertexArrayElementBuffer(m_Vao, m_Ibo);
+		assert(glGetError() == GL_NO_ERROR);
+	}
 
-	glBindVertexArray(0);
+	// The location of every attribute the layout stores is its VertexAttribute.
+	for (GLuint attribute = 0; attribute < VERTEX_ATTRIBUTE_COUNT; ++attribute) {
+		const auto& attributeLayout = vertexLayout.GetAttribute(static_cast<VertexAttribute>(attribute));
+
+		if (attributeLayout.format == VertexFormat::NONE) {
+			continue;
+		}
+
+		const auto format = GetGLVertexFormat(attributeLayout.format);
+
+		glVertexArrayAttribFormat(m_Vao, attribute, format.size, format.type, format.normalized, attributeLayout.offset);
+		glVertexArrayAttribBinding(m_Vao, attribute, 0);
+		glEnableVertexArrayAttrib(m_Vao, attribute);
+	}
 	assert(glGetError() == GL_NO_ERROR);
 
 	return true;
 }
 
-void GLMesh::Draw() const noexcept
+void GLMesh::Draw(const GLsizei instanceCount) const noexcept
 {
 	glBindVertexArray(m_Vao);
 	assert(glGetError() == GL_NO_ERROR);
 
-	if (m_Ibo) {
-		glDrawElements(GL_TRIANGLES, GetIndices().size(), GL_UNSIGNED_INT, GetIndices().data());
+	if (instanceCount > 1) {
+		if (m_Ibo) {
+			glDrawElementsInstanced(GL_TRIANGLES, m_IndexCount, GL_UNSIGNED_INT, nullptr, instanceCount);
+			assert(glGetError() == GL_NO_ERROR);
+		} else {
+			glDrawArraysInstanced(GL_TRIANGLES, 0, m_VertexCount, instanceCount);
+			assert(glGetError() == GL_NO_ERROR);
+		}
+	} else if (m_Ibo) {
+		glDrawElements(GL_TRIANGLES, m_IndexCount, GL_UNSIGNED_INT, nullptr);
 		assert(glGetError() == GL_NO_ERROR);
 	} else {
-		glDrawArrays(GL_TRIANGLES, 0, GetVertices().size());
+		glDrawArrays(GL_TRIANGLES, 0, m_VertexCount);
 		assert(glGetError() == GL_NO_ERROR);
 	}
 
 	glBindVertexArray(0);
 }
+
+void GLMesh::DrawIndirect(const GLuint indirectBuffer, const GLintptr offset, const GLsizei drawCount) const noexcept
+{
+	glBindVertexArray(m_Vao);
+	assert(glGetError() == GL_NO_ERROR);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+	assert(glGetError() == GL_NO_ERROR);
+
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(offset), drawCount, 0);
+	assert(glGetError() == GL_NO_ERROR);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	glBindVertexArray(0);
+}
@@ -3,6 +3,17 @@
 #include "mesh.h"
 #include <GL/glew.h>
 
+/**
+ * \brief Layout of the records read by glMultiDrawElementsIndirect.
+ */
+struct DrawElementsIndirectCommand {
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
 class GLMesh final : public Mesh {
 private:
 	GLuint m_Vao{ 0 };
@@ -11,6 +22,13 @@ private:
 
 	GLuint m_Ibo{ 0 };
 
+	/**
+	 * \brief Vertex and index counts captured when the buffers are created, draws never read the client arrays.
+	 */
+	GLsizei m_VertexCount{ 0 };
+
+	GLsizei m_IndexCount{ 0 };
+
 	ui32 m_MaterialIndex{ 0 };
 
 public:
@@ -18,9 +36,20 @@ public:
 
 	~GLMesh();
 
+	/**
+	 * \brief Uploads the vertices, converted to the vertex layout, and indices once to
+	 * immutable buffers and records them, together with the vertex format, in the vertex array.
+	 */
 	bool CreateBuffers() noexcept override;
 
-	void Draw() const noexcept;
+	void Draw(GLsizei instanceCount = 1) const noexcept;
+
+	/**
+	 * \brief Draws drawCount DrawElementsIndirectCommand records stored in indirectBuffer at offset.
+	 * \details The commands index into this mesh's vertex and index buffers,
+	 * see Mesh::Append().
+	 */
+	void DrawIndirect(GLuint indirectBuffer, GLintptr offset, GLsizei drawCount) const noexcept;
 
 	void SetMaterialIndex(const ui32 materialIndex) noexcept
 	{
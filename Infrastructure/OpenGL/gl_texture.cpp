@@ -1,19 +1,23 @@
 #include "gl_texture.h"
+#include <algorithm>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include "logger.h"
 
-GLTexture::GLTexture() noexcept
+static GLenum GetInternalFormat(const TextureFormat format) noexcept
 {
-	glCreateTextures(GL_TEXTURE_2D, 1, &m_Id);
+	switch (format) {
+		case TextureFormat::BC1:
+			return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case TextureFormat::BC3:
+			return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		default:
+			return GL_RGBA8;
+	}
 }
 
-GLTexture::~GLTexture()
-{
-	glDeleteTextures(1, &m_Id);
-}
-
-bool GLTexture::Load(const std::string& fileName) noexcept
+// Private functions -------------------------------------------
+bool GLTexture::DecodeImage(const std::string& fileName) noexcept
 {
 	Vec2i size;
 	int colorChannels;
@@ -31,15 +35,141 @@ bool GLTexture::Load(const std::string& fileName) noexcept
 		return false;
 	}
 
+	m_Size = Vec2ui{ size.x, size.y };
+	m_Format = TextureFormat::RGBA8;
+	m_MipLevels = m_MipMode == TextureMipMode::NONE ? 1 : GetMipLevelCount(m_Size);
+
+	if (m_MipMode == TextureMipMode::STREAMED) {
+		// The driver cannot build the small levels without the large ones, so the chain is built here.
+		m_MipChain = GenerateMipChain(pixels, m_Size);
+	}
+	else {
+		// The driver builds the rest of a full chain once the base level is uploaded.
+		m_MipChain.resize(1);
+		m_MipChain[0].size = m_Size;
+		m_MipChain[0].pixels.assign(pixels, pixels + GetTextureLevelBytes(TextureFormat::RGBA8, m_Size));
+	}
+
+	stbi_image_free(pixels);
+
+	return true;
+}
+
+bool GLTexture::LoadContainer(const std::string& fileName) noexcept
+{
+	if (!m_Container.Open(fileName)) {
+		return false;
+	}
+
+	if (m_Container.GetFormat() != TextureFormat::RGBA8 && !GLEW_EXT_texture_compression_s3tc) {
+		ERROR_LOG("The driver cannot sample the format of " + fileName + ", bake it as rgba8 instead.");
+		m_Container.Close();
+		return false;
+	}
+
+	m_Size = m_Container.GetSize();
+	m_Format = m_Container.GetFormat();
+
+	// The baker always writes the whole chain, without mips only its base level is used.
+	m_MipLevels = m_MipMode == TextureMipMode::NONE ? 1 : m_Container.GetLevelCount();
+
+	return true;
+}
+
+void GLTexture::UploadLevel(const ui32 level) const noexcept
+{
+	const auto size = GetMipLevelSize(m_Size, level);
+
+	if (!m_Container.IsOpen()) {
+		glTextureSubImage2D(m_Id, level, 0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, m_MipChain[level].pixels.data());
+		return;
+	}
+
+	// Straight from the mapped file.
+	if (m_Format == TextureFormat::RGBA8) {
+		glTextureSubImage2D(m_Id, level, 0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, m_Container.GetLevelData(level));
+		return;
+	}
+
+	glCompressedTextureSubImage2D(m_Id,
+	                              level,
+	                              0,
+	                              0,
+	                              size.x,
+	                              size.y,
+	                              GetInternalFormat(m_Format),
+	                              static_cast<GLsizei>(m_Container.GetLevelBytes(level)),
+	                              m_Container.GetLevelData(level));
+}
+
+void GLTexture::ReleaseSourceLevels() noexcept
+{
+	if (m_ResidentLevel) {
+		return;
+	}
+
+	m_MipChain.clear();
+	m_MipChain.shrink_to_fit();
+
+	m_Container.Close();
+}
+
+// -------------------------------------------------------------
+
+GLTexture::GLTexture(const TextureMipMode mipMode) noexcept
+	: m_MipMode{ mipMode }
+{
+	glCreateTextures(GL_TEXTURE_2D, 1, &m_Id);
+}
+
+GLTexture::~GLTexture()
+{
+	glDeleteTextures(1, &m_Id);
+}
+
+bool GLTexture::Load(const std::string& fileName) noexcept
+{
+	return Decode(fileName) && Upload(fileName);
+}
+
+bool GLTexture::Decode(const std::string& fileName) noexcept
+{
+	return TextureContainer::IsContainer(fileName) ? LoadContainer(fileName) : DecodeImage(fileName);
+}
+
+bool GLTexture::Upload(const std::string& fileName) noexcept
+{
 	// specify the texture storage type
-	glTextureStorage2D(m_Id, 1, GL_RGBA8, size.x, size.y);
+	glTextureStorage2D(m_Id, m_MipLevels, GetInternalFormat(m_Format), m_Size.x, m_Size.y);
 
-	auto err = glGetError();
+	if (m_MipMode == TextureMipMode::STREAMED) {
+		while (m_ResidentLevel + 1 < m_MipLevels) {
+			const auto size = GetMipLevelSize(m_Size, m_ResidentLevel);
 
-	// fill it with data.
-	glTextureSubImage2D(m_Id, 0, 0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+			if (std::max(size.x, size.y) <= STREAMED_INITIAL_SIZE) {
+				break;
+			}
 
-	stbi_image_free(pixels);
+			++m_ResidentLevel;
+		}
+	}
+
+	// A decoded image that is not streamed only has its base level.
+	const auto levelCount = m_Container.IsOpen() ? m_MipLevels : static_cast<ui32>(m_MipChain.size());
+
+	for (auto level = m_ResidentLevel; level < levelCount; ++level) {
+		UploadLevel(level);
+	}
+
+	if (levelCount < m_MipLevels) {
+		glGenerateTextureMipmap(m_Id);
+	}
+
+	if (m_MipMode == TextureMipMode::STREAMED) {
+		glTextureParameteri(m_Id, GL_TEXTURE_BASE_LEVEL, m_ResidentLevel);
+	}
+
+	ReleaseSourceLevels();
 
 	return true;
 }
@@ -48,3 +178,56 @@ GLuint GLTexture::GetId() const noexcept
 {
 	return m_Id;
 }
+
+TextureFormat GLTexture::GetFormat() const noexcept
+{
+	return m_Format;
+}
+
+ui32 GLTexture::GetMipLevels() const noexcept
+{
+	return m_MipLevels;
+}
+
+ui32 GLTexture::GetResidentLevel() const noexcept
+{
+	return m_ResidentLevel;
+}
+
+size_t GLTexture::GetResidentBytes() const noexcept
+{
+	size_t bytes{ 0 };
+
+	for (auto level = m_ResidentLevel; level < m_MipLevels; ++level) {
+		bytes += GetTextureLevelBytes(m_Format, GetMipLevelSize(m_Size, level));
+	}
+
+	return bytes;
+}
+
+size_t GLTexture::GetNextLevelBytes() const noexcept
+{
+	if (!m_ResidentLevel) {
+		return 0;
+	}
+
+	return GetTextureLevelBytes(m_Format, GetMipLevelSize(m_Size, m_ResidentLevel - 1));
+}
+
+bool GLTexture::StreamNextLevel() noexcept
+{
+	if (m_MipMode != TextureMipMode::STREAMED || !m_ResidentLevel) {
+		return false;
+	}
+
+	--m_ResidentLevel;
+
+	UploadLevel(m_ResidentLevel);
+
+	// Draws issued from here on sample the new level, earlier ones are ordered before the upload.
+	glTextureParameteri(m_Id, GL_TEXTURE_BASE_LEVEL, m_ResidentLevel);
+
+	ReleaseSourceLevels();
+
+	return true;
+}
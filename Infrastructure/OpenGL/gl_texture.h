@@ -1,20 +1,114 @@
 #ifndef GL_TEXTURE_H_
 #define GL_TEXTURE_H_
 #include "resource.h"
+#include "texture.h"
+#include "texture_container.h"
+#include "texture_utilities.h"
 #include <GL/glew.h>
+#include <vector>
 
 class GLTexture final : public Resource {
 private:
 	GLuint m_Id{ 0 };
 
+	TextureMipMode m_MipMode{ TextureMipMode::NONE };
+
+	Vec2ui m_Size;
+
+	TextureFormat m_Format{ TextureFormat::RGBA8 };
+
+	/**
+	 * \brief Levels of the storage, resident or not.
+	 */
+	ui32 m_MipLevels{ 1 };
+
+	/**
+	 * \brief The largest level that holds data, sampling starts at it through GL_TEXTURE_BASE_LEVEL.
+	 */
+	ui32 m_ResidentLevel{ 0 };
+
+	/**
+	 * \brief The decoded levels that are not uploaded yet. Freed once level 0 is resident.
+	 */
+	std::vector<MipLevel> m_MipChain;
+
+	/**
+	 * \brief Replaces m_MipChain when the texture is loaded from a baked container. Closed once level 0 is resident.
+	 */
+	TextureContainer m_Container;
+
+	/**
+	 * \brief Decodes the image into m_MipChain, the whole chain only if it is streamed.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool DecodeImage(const std::string& fileName) noexcept;
+
+	/**
+	 * \brief Maps a container written by the texture baker into m_Container.
+	 * \return TRUE if successful, FALSE otherwise or if the driver cannot sample its format.
+	 */
+	bool LoadContainer(const std::string& fileName) noexcept;
+
+	/**
+	 * \brief Uploads level of the chain, from m_Container if it is open and from m_MipChain otherwise.
+	 */
+	void UploadLevel(ui32 level) const noexcept;
+
+	/**
+	 * \brief Frees the levels that are not resident yet, once there are none left.
+	 */
+	void ReleaseSourceLevels() noexcept;
+
 public:
-	GLTexture() noexcept;
+	/**
+	 * \brief The largest level of a streamed texture that is resident once it is loaded.
+	 */
+	static constexpr ui32 STREAMED_INITIAL_SIZE{ 64 };
+
+	explicit GLTexture(TextureMipMode mipMode = TextureMipMode::NONE) noexcept;
 
 	~GLTexture();
 
+	/**
+	 * \brief Loads an image, or a container written by the texture baker if fileName has its extension.
+	 */
 	bool Load(const std::string& fileName) noexcept override;
 
+	/**
+	 * \brief Decodes the image, or maps the container. Safe to call on a worker thread.
+	 */
+	bool Decode(const std::string& fileName) noexcept override;
+
+	/**
+	 * \brief Allocates the storage and uploads the resident levels, on the thread that owns the context.
+	 */
+	bool Upload(const std::string& fileName) noexcept override;
+
 	GLuint GetId() const noexcept;
+
+	TextureFormat GetFormat() const noexcept;
+
+	ui32 GetMipLevels() const noexcept;
+
+	ui32 GetResidentLevel() const noexcept;
+
+	/**
+	 * \brief Returns the size of the pixels of the resident levels.
+	 */
+	size_t GetResidentBytes() const noexcept;
+
+	/**
+	 * \brief Returns how much GetResidentBytes() grows by with the next StreamNextLevel(), 0 if every level is resident.
+	 */
+	size_t GetNextLevelBytes() const noexcept;
+
+	/**
+	 * \brief Uploads the next larger level of a streamed texture and starts sampling from it.
+	 * \details The storage of the whole chain is allocated up front, immutable
+	 * textures cannot grow, so only the uploads are spread out.
+	 * \return TRUE if a level was made resident, FALSE if every level already was.
+	 */
+	bool StreamNextLevel() noexcept;
 };
 
-#endif //GL_TEXTURE_H_
\ No newline at end of file
+#endif //GL_TEXTURE_H_
@@ -3,6 +3,9 @@
 #include <array>
 #include <algorithm>
 #include <fstream>
+#include <limits>
+#include <string>
+#include "cfg.h"
 
 // Private functions -------------------------------
 bool VulkanApplication::CreateInstance() noexcept
@@ -59,6 +62,83 @@ bool VulkanApplication::CreateCommandBuffers() noexcept
 	return true;
 }
 
+bool VulkanApplication::CreateFrameSynchronization() noexcept
+{
+	const auto imageCount = static_cast<ui32>(m_SwapChain.GetImages().size());
+
+	ConfigFile cfg{ "config/config.cfg" };
+
+	const auto framesInFlight = cfg.GetInteger("attributes.frames_in_flight", static_cast<int>(m_FramesInFlight));
+
+	// More frames than images would only wait on the image fences instead.
+	m_FramesInFlight = std::min(std::max(framesInFlight, 1), static_cast<int>(std::min(imageCount, MAX_FRAMES_IN_FLIGHT)));
+
+	if (static_cast<ui32>(framesInFlight) != m_FramesInFlight) {
+		LOG("frames_in_flight clamped to " + std::to_string(m_FramesInFlight) + ".");
+	}
+
+	VkFenceCreateInfo fenceCreateInfo{};
+	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // The first wait on each frame must not block.
+
+	m_FrameFences.resize(m_FramesInFlight, VK_NULL_HANDLE);
+
+	for (auto& fence : m_FrameFences) {
+		if (vkCreateFence(m_Device, &fenceCreateInfo, nullptr, &fence) != VK_SUCCESS) {
+			ERROR_LOG("Failed to create frame fence.");
+			return false;
+		}
+	}
+
+	m_ImageFences.resize(imageCount, VK_NULL_HANDLE);
+
+	m_PresentComplete.resize(m_FramesInFlight);
+
+	for (auto& semaphore : m_PresentComplete) {
+		if (!semaphore.Create()) {
+			return false;
+		}
+	}
+
+	m_DrawComplete.resize(imageCount);
+
+	for (auto& semaphore : m_DrawComplete) {
+		if (!semaphore.Create()) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void VulkanApplication::ReadGpuTime(const bool imageUsed) noexcept
+{
+	const auto nanosInAnIncrement{ m_Device.GetPhysicalDevice().properties.limits.timestampPeriod };
+
+	std::vector<ui64> gpuResults;
+
+	// The queries are not waited for, the fences already were. Until every
+	// query has results the previous gpuTime is kept.
+	if (!imageUsed || queryPools[m_CurrentBuffer].GetResults(gpuResults, false) != VK_SUCCESS) {
+		return;
+	}
+
+	f32 frameGpuTime = (gpuResults[1] - gpuResults[0]) * nanosInAnIncrement * 1e-6;
+
+	if (deferredBench) {
+		// The deferred pass of this slot ran m_FramesInFlight frames ago.
+		if (m_FrameNumber < m_FramesInFlight ||
+			deferredQueryPools[m_CurrentFrame].GetResults(gpuResults, false) != VK_SUCCESS) {
+			return;
+		}
+
+		deferredGpuTime = (gpuResults[1] - gpuResults[0]) * nanosInAnIncrement * 1e-6;
+		frameGpuTime += deferredGpuTime;
+	}
+
+	gpuTime = frameGpuTime;
+}
+
 bool VulkanApplication::CreateRenderPasses() noexcept
 {
 	std::vector<VkAttachmentDescription> attachments;
@@ -111,10 +191,13 @@ bool VulkanApplication::CreateRenderPasses() noexcept
 
 	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
 	dependencies[0].dstSubpass = 0;
-	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	// The depth attachment is shared by the frames in flight, so the depth tests
+	// also wait for the depth writes of the previous frame.
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+	                            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 	dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
 	dependencies[1].srcSubpass = 0;
@@ -168,6 +251,17 @@ bool VulkanApplication::CreateFramebuffers() noexcept
 	return true;
 }
 
+bool VulkanApplication::RecordCommandBuffers() noexcept
+{
+	const auto recordStart = GetTimer().GetSec();
+
+	const auto result = BuildCommandBuffers();
+
+	recordTime = (GetTimer().GetSec() - recordStart) * 1000.0;
+
+	return result;
+}
+
 // -------------------------------------------------
 
 VulkanApplication::VulkanApplication(const ApplicationSettings& settings)
@@ -178,6 +272,11 @@ VulkanApplication::VulkanApplication(const ApplicationSettings& settings)
 VulkanApplication::~VulkanApplication()
 {
 	vkDeviceWaitIdle(m_Device);
+
+	for (const auto fence : m_FrameFences) {
+		vkDestroyFence(m_Device, fence, nullptr);
+	}
+
 	vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
 }
 
@@ -226,14 +325,32 @@ ui32 VulkanApplication::GetCurrentBufferIndex() const noexcept
 	return m_CurrentBuffer;
 }
 
+ui32 VulkanApplication::GetFramesInFlight() const noexcept
+{
+	return m_FramesInFlight;
+}
+
+ui32 VulkanApplication::GetCurrentFrameIndex() const noexcept
+{
+	return m_CurrentFrame;
+}
+
+VkFence VulkanApplication::ResetFrameFence() noexcept
+{
+	const auto frameFence = m_FrameFences[m_CurrentFrame];
+	vkResetFences(m_Device, 1, &frameFence);
+
+	return frameFence;
+}
+
 const VulkanSemaphore& VulkanApplication::GetPresentCompleteSemaphore() const noexcept
 {
-	return m_PresentComplete;
+	return m_PresentComplete[m_CurrentFrame];
 }
 
 const VulkanSemaphore& VulkanApplication::GetDrawCompleteSemaphore() const noexcept
 {
-	return m_DrawComplete;
+	return m_DrawComplete[m_CurrentBuffer];
 }
 
 bool VulkanApplication::Reshape(const Vec2ui& size) noexcept
@@ -291,6 +408,8 @@ bool VulkanApplication::Reshape(const Vec2ui& size) noexcept
 
 bool VulkanApplication::Initialize() noexcept
 {
+	m_StartupTimer.Start();
+
 	if (!Application::Initialize()) {
 		return false;
 	}
@@ -324,7 +443,11 @@ bool VulkanApplication::Initialize() noexcept
 
 	EnableFeatures();
 
-	if (!m_Device.CreateLogicalDevice(m_FeaturesToEnable, m_ExtensionsToEnable)) {
+	// A dedicated transfer queue lets the uploader copy assets while the graphics queue renders.
+	if (!m_Device.CreateLogicalDevice(m_FeaturesToEnable,
+	                                  m_ExtensionsToEnable,
+	                                  true,
+	                                  VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT)) {
 		return false;
 	}
 
@@ -347,20 +470,17 @@ bool VulkanApplication::Initialize() noexcept
 		return false;
 	}
 
-	if (!m_PresentComplete.Create()) {
-		return false;
-	}
-
-	if (!m_DrawComplete.Create()) {
+	if (!CreateFrameSynchronization()) {
 		return false;
 	}
 
+	// PreDraw points the semaphores at the ones of the current frame and image.
 	m_SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	m_SubmitInfo.pWaitDstStageMask = &m_PipelineStageFlags;
 	m_SubmitInfo.waitSemaphoreCount = 1;
-	m_SubmitInfo.pWaitSemaphores = m_PresentComplete.Get();
+	m_SubmitInfo.pWaitSemaphores = m_PresentComplete[m_CurrentFrame].Get();
 	m_SubmitInfo.signalSemaphoreCount = 1;
-	m_SubmitInfo.pSignalSemaphores = m_DrawComplete.Get();
+	m_SubmitInfo.pSignalSemaphores = m_DrawComplete[m_CurrentBuffer].Get();
 
 	if (!m_CommandPool.Create(m_SwapChain.GetQueueIndex(), VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT)) {
 		return false;
@@ -381,7 +501,11 @@ bool VulkanApplication::Initialize() noexcept
 	}
 
 	if (deferredBench) {
-		deferredQueryPool.Initialize(VK_QUERY_TYPE_TIMESTAMP, 2, VK_NULL_HANDLE);
+		deferredQueryPools.resize(m_FramesInFlight);
+
+		for (auto& queryPool : deferredQueryPools) {
+			queryPool.Initialize(VK_QUERY_TYPE_TIMESTAMP, 2, VK_NULL_HANDLE);
+		}
 	}
 
 	if (!CreateFramebuffers()) {
@@ -400,26 +524,28 @@ i32 VulkanApplication::Run() noexcept
 
 		static auto prev = 0.0;
 
-		Update();
-		Draw();
+		const auto updateStart = GetTimer().GetSec();
 
-		const auto now = GetTimer().GetSec();
-		wholeFrameTime = (now - prev) * 1000.0;
+		Update();
 
-		std::vector<ui64> gpuResults;
-		queryPools[m_CurrentBuffer].GetResults(gpuResults);
+		updateTime = (GetTimer().GetSec() - updateStart) * 1000.0;
 
-		const auto nanosInAnIncrement{ m_Device.GetPhysicalDevice().properties.limits.timestampPeriod };
+		Draw();
 
-		gpuTime = (gpuResults[1] - gpuResults[0]) * nanosInAnIncrement * 1e-6;
+		if (m_StartupTimer.IsRunning()) {
+			m_StartupTimer.Stop();
+			startupTime = m_StartupTimer.GetSec() * 1000.0;
 
-		if (deferredBench) {
-			gpuResults.clear();
-			deferredQueryPool.GetResults(gpuResults);
-			gpuTime += (gpuResults[1] - gpuResults[0]) * nanosInAnIncrement * 1e-6;
+			LOG("Startup time to the first frame: " + std::to_string(startupTime) + " ms.");
 		}
 
-		cpuTime = wholeFrameTime - gpuTime;
+		const auto now = GetTimer().GetSec();
+		wholeFrameTime = (now - prev) * 1000.0;
+
+		// The GPU runs behind the CPU, so gpuTime is the one of the last frames that
+		// completed, read by PreDraw(), and the frame time can no longer be split into
+		// a CPU and a GPU part. The CPU time is whatever was not spent blocked on the GPU.
+		cpuTime = wholeFrameTime - m_FrameWaitTime;
 
 		if (cpuTime < 0.0f) {
 			cpuTime = 0.0f;
@@ -436,6 +562,9 @@ i32 VulkanApplication::Run() noexcept
 			totalFrameTimeSamples.push_back(wholeFrameTime);
 			totalCpuTimeSamples.push_back(cpuTime);
 			totalGpuTimeSamples.push_back(gpuTime);
+			totalUpdateTimeSamples.push_back(updateTime);
+			totalRecordTimeSamples.push_back(recordTime);
+			totalSpawnTimeSamples.push_back(spawnTime);
 
 			if (accum > 1000.0f || calculateResults) {
 				const auto size = wholeFrameTimeSamples.size();
@@ -504,11 +633,15 @@ i32 VulkanApplication::Run() noexcept
 				avgTotalFrameTime += totalFrameTimeSamples[i];
 				avgTotalCpuTime += totalCpuTimeSamples[i];
 				avgTotalGpuTime += totalGpuTimeSamples[i];
+				avgTotalUpdateTime += totalUpdateTimeSamples[i];
+				avgTotalRecordTime += totalRecordTimeSamples[i];
 			}
 
 			avgTotalFrameTime /= static_cast<f32>(totalFrameTimeSamples.size());
 			avgTotalCpuTime /= static_cast<f32>(totalCpuTimeSamples.size());
 			avgTotalGpuTime /= static_cast<f32>(totalGpuTimeSamples.size());
+			avgTotalUpdateTime /= static_cast<f32>(totalUpdateTimeSamples.size());
+			avgTotalRecordTime /= static_cast<f32>(totalRecordTimeSamples.size());
 
 			auto frameTimeVecCopy = totalFrameTimeSamples;
 
@@ -549,17 +682,44 @@ i32 VulkanApplication::Run() noexcept
 
 void VulkanApplication::PreDraw() noexcept
 {
-	VkResult result{ m_SwapChain.GetNextImageIndex(m_PresentComplete, m_CurrentBuffer) };
+	const auto waitStart = GetTimer().GetSec();
+
+	// Only blocks if the GPU is still executing the frame recorded m_FramesInFlight frames ago.
+	const auto frameFence = m_FrameFences[m_CurrentFrame];
+	vkWaitForFences(m_Device, 1, &frameFence, VK_TRUE, std::numeric_limits<ui64>::max());
+
+	const auto& presentComplete = m_PresentComplete[m_CurrentFrame];
+
+	VkResult result{ m_SwapChain.GetNextImageIndex(presentComplete, m_CurrentBuffer) };
 
 	while (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
 		const auto& extent = m_SwapChain.GetExtent();
 		Reshape(Vec2i{ extent.width, extent.height });
 
-		result = m_SwapChain.GetNextImageIndex(m_PresentComplete,
+		result = m_SwapChain.GetNextImageIndex(presentComplete,
 		                                       m_CurrentBuffer);
 	}
 
-	vkQueueWaitIdle(m_Device.GetQueue(QueueFamily::GRAPHICS));
+	// Images are not always acquired in order, so the frame that last rendered
+	// to this one can still be in flight in another slot.
+	auto& imageFence = m_ImageFences[m_CurrentBuffer];
+	const auto imageUsed = imageFence != VK_NULL_HANDLE;
+
+	if (imageUsed && imageFence != frameFence) {
+		vkWaitForFences(m_Device, 1, &imageFence, VK_TRUE, std::numeric_limits<ui64>::max());
+	}
+
+	imageFence = frameFence;
+
+	m_FrameWaitTime = (GetTimer().GetSec() - waitStart) * 1000.0;
+
+	ReadGpuTime(imageUsed);
+
+	m_SubmitInfo.pWaitSemaphores = presentComplete.Get();
+	m_SubmitInfo.pSignalSemaphores = m_DrawComplete[m_CurrentBuffer].Get();
+
+	// Submit the uploads recorded since the last frame ahead of the frame that uses them.
+	m_Device.GetUploader().Flush();
 }
 
 void VulkanApplication::PostDraw() noexcept
@@ -567,7 +727,7 @@ void VulkanApplication::PostDraw() noexcept
 	VkResult result{
 		m_SwapChain.Present(m_Device.GetQueue(QueueFamily::PRESENT),
 		                    m_CurrentBuffer,
-		                    m_DrawComplete)
+		                    m_DrawComplete[m_CurrentBuffer])
 	};
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
@@ -575,6 +735,9 @@ void VulkanApplication::PostDraw() noexcept
 		Reshape(Vec2i{ extent.width, extent.height });
 	}
 
+	m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
+	++m_FrameNumber;
+
 	w2 = GetTimer().GetSec();
 }
 
@@ -582,10 +745,11 @@ void VulkanApplication::SaveToCsv(const std::string& fname)
 {
 	std::ofstream stream{ fname + ".csv" };
 
-	stream << "Whole Frame Time,CPU Time,GPU Time\n";
+	stream << "Whole Frame Time,CPU Time,GPU Time,Update Time,Record Time\n";
 
 	for (auto i = 0u; i < totalFrameTimeSamples.size(); ++i) {
-		stream << totalFrameTimeSamples[i] << "," << totalCpuTimeSamples[i] << "," << totalGpuTimeSamples[i] << "\n";
+		stream << totalFrameTimeSamples[i] << "," << totalCpuTimeSamples[i] << "," << totalGpuTimeSamples[i] << ","
+				<< totalUpdateTimeSamples[i] << "," << totalRecordTimeSamples[i] << "\n";
 	}
 
 	stream << "\nFPS,Whole Frame Time,CPU Time,GPU Time\n";
@@ -595,11 +759,15 @@ void VulkanApplication::SaveToCsv(const std::string& fname)
 				"\n";
 	}
 
-	stream << "\nAverage FPS,Average Frame Time,Average CPU Time,Average GPU Time\n";
-	stream << 1000.0f / avgTotalFrameTime << "," << avgTotalFrameTime << "," << avgTotalCpuTime << "," << avgTotalGpuTime;
+	stream << "\nAverage FPS,Average Frame Time,Average CPU Time,Average GPU Time,Average Update Time,Average Record Time\n";
+	stream << 1000.0f / avgTotalFrameTime << "," << avgTotalFrameTime << "," << avgTotalCpuTime << "," << avgTotalGpuTime << ","
+			<< avgTotalUpdateTime << "," << avgTotalRecordTime;
 
 	stream << "\n99th percentile\n";
 	stream << percentile99th;
 
+	stream << "\nStartup Time\n";
+	stream << startupTime;
+
 	stream.close();
 }
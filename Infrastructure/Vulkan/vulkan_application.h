@@ -96,8 +96,8 @@ private:
 	 * swap chain image. This is convenient when command buffer recording
 	 * is done on initialization. That way the gpu doesn't have to wait for an
 	 * available command buffer.
-	 * \note If command buffers are recorded per frame then 1 command buffer is
-	 * sufficient since it will be prepared every frame and is immediately available.
+	 * \note Command buffers recorded per frame are re-recorded only after
+	 * PreDraw() has waited for the frame that last rendered to the same image.
 	 */
 	std::vector<VkCommandBuffer> m_DrawCommandBuffers;
 
@@ -125,15 +125,54 @@ private:
 	VulkanSwapChain m_SwapChain;
 
 	/**
-	 * \brief Semaphore used to signal that the presentation of an image
-	 * is complete.
+	 * \brief Semaphores used to signal that the presentation of an image
+	 * is complete, one per frame in flight.
 	 */
-	VulkanSemaphore m_PresentComplete;
+	std::vector<VulkanSemaphore> m_PresentComplete;
 
 	/**
-	 * \brief Semaphore used to signal that the drawing is complete.
+	 * \brief Semaphores used to signal that the drawing is complete, one per swap chain image.
+	 * \details The presentation engine waits on them, and only releasing the image
+	 * guarantees it is done with the semaphore.
 	 */
-	VulkanSemaphore m_DrawComplete;
+	std::vector<VulkanSemaphore> m_DrawComplete;
+
+	/**
+	 * \brief Signaled when the GPU finishes each frame in flight. Created signaled.
+	 */
+	std::vector<VkFence> m_FrameFences;
+
+	/**
+	 * \brief The fence of the frame that last rendered to each swap chain image,
+	 * VK_NULL_HANDLE until the image is used.
+	 */
+	std::vector<VkFence> m_ImageFences;
+
+	/**
+	 * \brief How many frames the CPU may record ahead of the GPU.
+	 * \details Read from attributes.frames_in_flight in config.cfg.
+	 */
+	ui32 m_FramesInFlight{ 2 };
+
+	/**
+	 * \brief The frame in flight being recorded, in [0, m_FramesInFlight).
+	 */
+	ui32 m_CurrentFrame{ 0 };
+
+	/**
+	 * \brief Frames presented so far.
+	 */
+	ui64 m_FrameNumber{ 0 };
+
+	/**
+	 * \brief Time the last PreDraw() spent blocked on the GPU and the presentation engine, in ms.
+	 */
+	f32 m_FrameWaitTime{ 0.0f };
+
+	/**
+	 * \brief Started when Initialize() is entered, read once the first frame is done.
+	 */
+	Timer m_StartupTimer;
 
 	/**
 	 * \brief The current command buffer to use based on the index of
@@ -169,7 +208,14 @@ private:
  	 */
 	bool CreateCommandBuffers() noexcept;
 
+	bool CreateFrameSynchronization() noexcept;
 
+	/**
+	 * \brief Updates gpuTime from the timestamps of the frames that completed
+	 * in the current frame slot and swap chain image.
+	 * \details Must be called once their fences have been waited for.
+	 */
+	void ReadGpuTime(bool imageUsed) noexcept;
 
 	std::vector<f32> wholeFrameTimeSamples;
 
@@ -197,11 +243,20 @@ protected:
 	*/
 	virtual bool CreateFramebuffers() noexcept;
 
+	/**
+	 * \brief Calls BuildCommandBuffers() and stores the time it took in recordTime.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool RecordCommandBuffers() noexcept;
+
 public:
 	std::vector<f32> totalFrameTimeSamples;
 	std::vector<f32> totalCpuTimeSamples;
 	std::vector<f32> totalGpuTimeSamples;
 	std::vector<f32> totalFpsSamples;
+	std::vector<f32> totalUpdateTimeSamples;
+	std::vector<f32> totalRecordTimeSamples;
+	std::vector<f32> totalSpawnTimeSamples;
 
 	f32 wholeFrameTime{ 0.0f };
 
@@ -209,6 +264,30 @@ public:
 
 	f32 gpuTime{ 0.0f };
 
+	/**
+	 * \brief CPU time spent in Update() during the last frame, in ms.
+	 */
+	f32 updateTime{ 0.0f };
+
+	/**
+	 * \brief CPU time spent recording command buffers during the last frame, in ms.
+	 * \details Only set by applications that record through RecordCommandBuffers().
+	 */
+	f32 recordTime{ 0.0f };
+
+	/**
+	 * \brief CPU time the scene spent spawning entities during the last Update(), in ms.
+	 * \details Only set by scenes that spawn entities while the benchmark runs.
+	 */
+	f32 spawnTime{ 0.0f };
+
+	/**
+	 * \brief Time from the start of Initialize() to the end of the first frame, in ms.
+	 * \details Includes the pipeline creation of the scene, so it shows the difference
+	 * between a launch with an empty pipeline cache and one with the saved cache data.
+	 */
+	f32 startupTime{ 0.0f };
+
 	f32 totalAppDuration{ 0.0 };
 
 	i64 frameCount{ 0 };
@@ -220,6 +299,8 @@ public:
 	f32 avgTotalFrameTime{ 0.0f };
 	f32 avgTotalCpuTime{ 0.0f };
 	f32 avgTotalGpuTime{ 0.0f };
+	f32 avgTotalUpdateTime{ 0.0f };
+	f32 avgTotalRecordTime{ 0.0f };
 
 	f32 minTotalFrameTime{ std::numeric_limits<f32>::max() };
 	f32 minTotalCpuTime{ std::numeric_limits<f32>::max() };
@@ -251,10 +332,26 @@ public:
 
 	bool frameRateTermination{ false };
 
+	/**
+	 * \brief The upper bound of attributes.frames_in_flight.
+	 * \details The ImGui binding cycles through IMGUI_VK_QUEUED_FRAMES vertex
+	 * buffers, which has to cover every frame in flight.
+	 */
+	static constexpr ui32 MAX_FRAMES_IN_FLIGHT{ 3 };
+
+	/**
+	 * \brief Timestamp queries of the command buffers, one pool per swap chain image
+	 * so that pre recorded command buffers can write to them.
+	 */
 	std::vector<VulkanQueryPool> queryPools;
 
 	bool deferredBench{ false };
-	VulkanQueryPool deferredQueryPool; //used specifically for the deferred benchmark.
+	std::vector<VulkanQueryPool> deferredQueryPools; //used specifically for the deferred benchmark, one per frame in flight.
+
+	/**
+	 * \brief The part of gpuTime spent in the deferred benchmark's G-Buffer pass, in ms.
+	 */
+	f32 deferredGpuTime{ 0.0f };
 
 	f64 w1{ 0.0 };
 	f64 w2{ 0.0 };
@@ -298,6 +395,23 @@ public:
 
 	ui32 GetCurrentBufferIndex() const noexcept;
 
+	ui32 GetFramesInFlight() const noexcept;
+
+	/**
+	 * \brief Returns the frame in flight being recorded.
+	 * \details Per frame resources, like uniform buffers, indexed by it are no longer
+	 * used by the GPU once PreDraw() returns. Update() runs before PreDraw(), so it
+	 * must not write to them.
+	 */
+	ui32 GetCurrentFrameIndex() const noexcept;
+
+	/**
+	 * \brief Resets and returns the fence the last queue submission of the frame has to signal.
+	 * \details Call it right before that submission, so a frame that bails out earlier
+	 * leaves the fence signaled and the next PreDraw() does not wait on it forever.
+	 */
+	VkFence ResetFrameFence() noexcept;
+
 	const VulkanSemaphore& GetPresentCompleteSemaphore() const noexcept;
 
 	const VulkanSemaphore& GetDrawCompleteSemaphore() const noexcept;
@@ -320,8 +434,14 @@ public:
 	 */
 	i32 Run() noexcept final;
 
+	/**
+	 * \brief Waits until the GPU is done with the current frame in flight and acquires the next swap chain image.
+	 */
 	void PreDraw() noexcept override;
 
+	/**
+	 * \brief Presents the image and moves on to the next frame in flight.
+	 */
 	void PostDraw() noexcept override;
 
 	void SaveToCsv(const std::string& fname);
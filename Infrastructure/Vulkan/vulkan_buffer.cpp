@@ -11,20 +11,24 @@ VulkanBuffer::~VulkanBuffer()
 
 VkResult VulkanBuffer::Map(VkDeviceSize size, VkDeviceSize offset) noexcept
 {
-	return vkMapMemory(G_VulkanDevice, memory, offset, size, 0, &data);
+	// Host visible blocks are mapped once by the allocator, mapping only hands out the address.
+	if (!allocation.mappedData) {
+		return VK_ERROR_MEMORY_MAP_FAILED;
+	}
+
+	data = static_cast<ui8*>(allocation.mappedData) + offset;
+
+	return VK_SUCCESS;
 }
 
 void VulkanBuffer::Unmap()
 {
-	if (data) {
-		vkUnmapMemory(G_VulkanDevice, memory);
-		data = nullptr;
-	}
+	data = nullptr;
 }
 
 VkResult VulkanBuffer::Bind(VkDeviceSize offset) const noexcept
 {
-	return vkBindBufferMemory(G_VulkanDevice, buffer, memory, offset);
+	return vkBindBufferMemory(G_VulkanDevice, buffer, allocation.memory, allocation.offset + offset);
 }
 
 void VulkanBuffer::Fill(void* data, VkDeviceSize size) const noexcept
@@ -40,13 +44,14 @@ void VulkanBuffer::InitializeDescriptor(VkDeviceSize range, VkDeviceSize offset)
 	descriptorBufferInfo.offset = offset;
 }
 
-void VulkanBuffer::CleanUp() const noexcept
+void VulkanBuffer::CleanUp() noexcept
 {
 	if (buffer) {
 		vkDestroyBuffer(G_VulkanDevice, buffer, nullptr);
+		buffer = VK_NULL_HANDLE;
 	}
 
-	if (memory) {
-		vkFreeMemory(G_VulkanDevice, memory, nullptr);
-	}
+	data = nullptr;
+
+	G_VulkanDevice.FreeMemory(allocation);
 }
@@ -2,11 +2,15 @@
 #define VULKAN_BUFFER_H_
 
 #include <vulkan/vulkan.h>
+#include "vulkan_memory_allocator.h"
 
 struct VulkanBuffer {
 	VkBuffer buffer{ VK_NULL_HANDLE };
 
-	VkDeviceMemory memory{ VK_NULL_HANDLE };
+	/**
+	 * \brief The range of a shared device memory block the buffer is bound to.
+	 */
+	VulkanAllocation allocation;
 
 	VkDescriptorBufferInfo descriptorBufferInfo{};
 
@@ -32,7 +36,10 @@ struct VulkanBuffer {
 
 	void InitializeDescriptor(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) noexcept;
 
-	void CleanUp() const noexcept;
+	/**
+	 * \brief Destroys the buffer, returns its memory to the allocator and resets the handles.
+	 */
+	void CleanUp() noexcept;
 };
 
 #endif //VULKAN_BUFFER_H_
@@ -0,0 +1,106 @@
+#include "vulkan_command_buffer_allocator.h"
+#include <algorithm>
+#include "logger.h"
+#include "vulkan_infrastructure_context.h"
+
+// Private functions -------------------------------
+VulkanCommandBufferAllocator::Pool& VulkanCommandBufferAllocator::GetPool(const ui32 frameIndex,
+                                                                          const ui32 threadIndex) noexcept
+{
+	return m_Pools[frameIndex * m_ThreadCount + threadIndex];
+}
+
+// -------------------------------------------------
+
+VulkanCommandBufferAllocator::~VulkanCommandBufferAllocator()
+{
+	LOG("Cleaning up VulkanCommandBufferAllocator");
+	CleanUp();
+}
+
+bool VulkanCommandBufferAllocator::Create(const ui32 queueFamilyIndex,
+                                          const ui32 frameCount,
+                                          const ui32 threadCount) noexcept
+{
+	m_ThreadCount = threadCount;
+	m_Pools.resize(frameCount * threadCount);
+
+	// The buffers are re-recorded every frame and never reset individually.
+	for (auto& pool : m_Pools) {
+		pool.commandPool = G_VulkanDevice.CreateCommandPool(queueFamilyIndex, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+		if (!pool.commandPool) {
+			ERROR_LOG("Failed to create transient command pool.");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool VulkanCommandBufferAllocator::Reset(const ui32 frameIndex) noexcept
+{
+	for (auto i = 0u; i < m_ThreadCount; ++i) {
+		auto& pool = GetPool(frameIndex, i);
+
+		// Keep the memory of the pool, the next frame records about as much.
+		if (vkResetCommandPool(G_VulkanDevice, pool.commandPool, 0) != VK_SUCCESS) {
+			ERROR_LOG("Failed to reset command pool.");
+			return false;
+		}
+
+		pool.primaryCount = 0;
+		pool.secondaryCount = 0;
+	}
+
+	return true;
+}
+
+VkCommandBuffer VulkanCommandBufferAllocator::Allocate(const ui32 frameIndex,
+                                                       const ui32 threadIndex,
+                                                       const VkCommandBufferLevel commandBufferLevel) noexcept
+{
+	auto& pool = GetPool(frameIndex, threadIndex);
+
+	const auto isPrimary = commandBufferLevel == VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+	auto& commandBuffers = isPrimary ? pool.primaryCommandBuffers : pool.secondaryCommandBuffers;
+	auto& count = isPrimary ? pool.primaryCount : pool.secondaryCount;
+
+	if (count == commandBuffers.size()) {
+		// Grow geometrically so a frame that records many buffers only allocates a few times.
+		const auto oldSize = commandBuffers.size();
+		const auto newSize = std::max<size_t>(oldSize * 2, 16);
+
+		VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
+		commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		commandBufferAllocateInfo.commandPool = pool.commandPool;
+		commandBufferAllocateInfo.level = commandBufferLevel;
+		commandBufferAllocateInfo.commandBufferCount = static_cast<ui32>(newSize - oldSize);
+
+		commandBuffers.resize(newSize, VK_NULL_HANDLE);
+
+		const auto result = vkAllocateCommandBuffers(G_VulkanDevice,
+		                                             &commandBufferAllocateInfo,
+		                                             commandBuffers.data() + oldSize);
+
+		if (result != VK_SUCCESS) {
+			ERROR_LOG("Failed to allocate command buffers.");
+			commandBuffers.resize(oldSize);
+			return VK_NULL_HANDLE;
+		}
+	}
+
+	return commandBuffers[count++];
+}
+
+void VulkanCommandBufferAllocator::CleanUp() noexcept
+{
+	// Destroying a pool frees the command buffers allocated from it.
+	for (const auto& pool : m_Pools) {
+		vkDestroyCommandPool(G_VulkanDevice, pool.commandPool, nullptr);
+	}
+
+	m_Pools.clear();
+	m_ThreadCount = 0;
+}
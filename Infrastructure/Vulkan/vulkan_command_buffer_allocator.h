@@ -0,0 +1,66 @@
+#ifndef VULKAN_COMMAND_BUFFER_ALLOCATOR_H_
+#define VULKAN_COMMAND_BUFFER_ALLOCATOR_H_
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include "types.h"
+
+/**
+ * \brief Hands out command buffers that are only used for one frame.
+ * \details Every frame in flight has one transient command pool per thread.
+ * Instead of resetting the buffers one by one, Reset() resets all the pools
+ * of a frame at once with vkResetCommandPool and Allocate() hands the buffers
+ * out again in order. Buffers are only allocated when a frame needs more
+ * than any previous one, so the steady state does not allocate.
+ */
+class VulkanCommandBufferAllocator {
+private:
+	struct Pool {
+		VkCommandPool commandPool{ VK_NULL_HANDLE };
+
+		std::vector<VkCommandBuffer> primaryCommandBuffers;
+
+		std::vector<VkCommandBuffer> secondaryCommandBuffers;
+
+		size_t primaryCount{ 0 };
+
+		size_t secondaryCount{ 0 };
+	};
+
+	/**
+	 * \brief The pools of frame f are in [f * m_ThreadCount, (f + 1) * m_ThreadCount).
+	 */
+	std::vector<Pool> m_Pools;
+
+	ui32 m_ThreadCount{ 0 };
+
+	Pool& GetPool(ui32 frameIndex, ui32 threadIndex) noexcept;
+
+public:
+	VulkanCommandBufferAllocator() = default;
+
+	VulkanCommandBufferAllocator(const VulkanCommandBufferAllocator& other) = delete;
+
+	VulkanCommandBufferAllocator& operator=(const VulkanCommandBufferAllocator& other) = delete;
+
+	~VulkanCommandBufferAllocator();
+
+	bool Create(ui32 queueFamilyIndex, ui32 frameCount, ui32 threadCount) noexcept;
+
+	/**
+	 * \brief Resets every pool of the frame, which returns all the buffers it handed out.
+	 * \details The GPU must be done with the frame, i.e. its fence has been waited on.
+	 */
+	bool Reset(ui32 frameIndex) noexcept;
+
+	/**
+	 * \brief Returns the next unused buffer of the thread's pool for the frame.
+	 * \details Only the thread that owns threadIndex may call it, and not while
+	 * the frame is being reset. The buffer is valid until the next Reset() of the frame.
+	 */
+	VkCommandBuffer Allocate(ui32 frameIndex, ui32 threadIndex, VkCommandBufferLevel commandBufferLevel) noexcept;
+
+	void CleanUp() noexcept;
+};
+
+#endif //VULKAN_COMMAND_BUFFER_ALLOCATOR_H_
@@ -56,29 +56,14 @@ bool VulkanDepthStencil::Create(const Vec2ui& size, VkFormat format) noexcept
 		return false;
 	}
 
-	VkMemoryRequirements memoryRequirements{};
-	vkGetImageMemoryRequirements(G_VulkanDevice, m_Image, &memoryRequirements);
-
-	VkMemoryAllocateInfo memoryAllocateInfo{};
-	memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memoryAllocateInfo.allocationSize = memoryRequirements.size;
-	memoryAllocateInfo.memoryTypeIndex = G_VulkanDevice.GetMemoryTypeIndex(memoryRequirements.memoryTypeBits,
-	                                                                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	result = vkAllocateMemory(G_VulkanDevice, &memoryAllocateInfo, nullptr, &m_Memory);
-
-	if (result != VK_SUCCESS) {
+	if (!G_VulkanDevice.AllocateImageMemory(m_Image,
+	                                        imageCreateInfo.tiling,
+	                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+	                                        m_Memory)) {
 		ERROR_LOG("Failed to allocate depth stencil m_Memory.");
 		return false;
 	}
 
-	result = vkBindImageMemory(G_VulkanDevice, m_Image, m_Memory, 0);
-
-	if (result != VK_SUCCESS) {
-		ERROR_LOG("Failed to bind depth image m_Memory.");
-		return false;
-	}
-
 	depthStencilView.image = m_Image;
 
 	result = vkCreateImageView(G_VulkanDevice, &depthStencilView, nullptr, &m_ImageView);
@@ -93,11 +78,11 @@ bool VulkanDepthStencil::Create(const Vec2ui& size, VkFormat format) noexcept
 	return true;
 }
 
-void VulkanDepthStencil::Destroy() const noexcept
+void VulkanDepthStencil::Destroy() noexcept
 {
 	vkDestroyImageView(G_VulkanDevice, m_ImageView, nullptr);
 
 	vkDestroyImage(G_VulkanDevice, m_Image, nullptr);
 
-	vkFreeMemory(G_VulkanDevice, m_Memory, nullptr);
+	G_VulkanDevice.FreeMemory(m_Memory);
 }
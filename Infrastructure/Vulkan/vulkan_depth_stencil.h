@@ -3,6 +3,7 @@
 
 #include <vulkan/vulkan.h>
 #include "types.h"
+#include "vulkan_memory_allocator.h"
 
 class VulkanDevice;
 
@@ -10,7 +11,7 @@ class VulkanDepthStencil {
 private:
 	VkImage m_Image{ VK_NULL_HANDLE };
 
-	VkDeviceMemory m_Memory{ VK_NULL_HANDLE };
+	VulkanAllocation m_Memory;
 
 	VkImageView m_ImageView{ VK_NULL_HANDLE };
 
@@ -27,7 +28,7 @@ public:
 
 	bool Create(const Vec2ui& size, VkFormat format) noexcept;
 
-	void Destroy() const noexcept;
+	void Destroy() noexcept;
 };
 
 #endif //VULKAN_DEPTH_STENCIL_H_
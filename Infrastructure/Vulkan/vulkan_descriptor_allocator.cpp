@@ -0,0 +1,210 @@
+#include "vulkan_descriptor_allocator.h"
+#include <algorithm>
+#include <cmath>
+#include "logger.h"
+#include "vulkan_infrastructure_context.h"
+
+// Private functions -------------------------------
+bool VulkanDescriptorAllocator::NextPool(PoolChain& chain) noexcept
+{
+	VkDescriptorPool pool{ VK_NULL_HANDLE };
+
+	if (!chain.freePools.empty()) {
+		pool = chain.freePools.back();
+		chain.freePools.pop_back();
+	}
+	else {
+		VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+		descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descriptorPoolCreateInfo.maxSets = m_SetsPerPool;
+		descriptorPoolCreateInfo.poolSizeCount = static_cast<ui32>(m_PoolSizes.size());
+		descriptorPoolCreateInfo.pPoolSizes = m_PoolSizes.data();
+
+		if (vkCreateDescriptorPool(G_VulkanDevice, &descriptorPoolCreateInfo, nullptr, &pool) != VK_SUCCESS) {
+			ERROR_LOG("Failed to create descriptor pool.");
+			return false;
+		}
+	}
+
+	chain.usedPools.push_back(pool);
+	chain.currentPoolSetCount = 0;
+
+	return true;
+}
+
+VkDescriptorSet VulkanDescriptorAllocator::Allocate(PoolChain& chain, const VkDescriptorSetLayout layout) noexcept
+{
+	if ((chain.usedPools.empty() || chain.currentPoolSetCount == m_SetsPerPool) && !NextPool(chain)) {
+		return VK_NULL_HANDLE;
+	}
+
+	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptorSetAllocateInfo.descriptorPool = chain.usedPools.back();
+	descriptorSetAllocateInfo.descriptorSetCount = 1;
+	descriptorSetAllocateInfo.pSetLayouts = &layout;
+
+	VkDescriptorSet descriptorSet{ VK_NULL_HANDLE };
+
+	auto result = vkAllocateDescriptorSets(G_VulkanDevice, &descriptorSetAllocateInfo, &descriptorSet);
+
+	// The pool ran out of descriptors before sets, the layout needs more than the ratios
+	// account for. Move on to a fresh pool once.
+	if (result == VK_ERROR_FRAGMENTED_POOL || result == VK_ERROR_OUT_OF_POOL_MEMORY_KHR) {
+		if (!NextPool(chain)) {
+			return VK_NULL_HANDLE;
+		}
+
+		descriptorSetAllocateInfo.descriptorPool = chain.usedPools.back();
+		result = vkAllocateDescriptorSets(G_VulkanDevice, &descriptorSetAllocateInfo, &descriptorSet);
+	}
+
+	if (result != VK_SUCCESS) {
+		ERROR_LOG("Failed to allocate descriptor set.");
+		return VK_NULL_HANDLE;
+	}
+
+	++chain.currentPoolSetCount;
+	++chain.allocatedSetCount;
+
+	return descriptorSet;
+}
+
+bool VulkanDescriptorAllocator::Reset(PoolChain& chain) noexcept
+{
+	for (const auto pool : chain.usedPools) {
+		if (vkResetDescriptorPool(G_VulkanDevice, pool, 0) != VK_SUCCESS) {
+			ERROR_LOG("Failed to reset descriptor pool.");
+			return false;
+		}
+
+		chain.freePools.push_back(pool);
+	}
+
+	chain.usedPools.clear();
+	chain.currentPoolSetCount = 0;
+	chain.allocatedSetCount = 0;
+
+	return true;
+}
+
+void VulkanDescriptorAllocator::Destroy(PoolChain& chain) noexcept
+{
+	// Destroying a pool frees the sets allocated from it.
+	for (const auto pool : chain.usedPools) {
+		vkDestroyDescriptorPool(G_VulkanDevice, pool, nullptr);
+	}
+
+	for (const auto pool : chain.freePools) {
+		vkDestroyDescriptorPool(G_VulkanDevice, pool, nullptr);
+	}
+
+	chain = PoolChain{};
+}
+
+// -------------------------------------------------
+
+VulkanDescriptorAllocator::~VulkanDescriptorAllocator()
+{
+	LOG("Cleaning up VulkanDescriptorAllocator");
+	CleanUp();
+}
+
+bool VulkanDescriptorAllocator::Create(const ui32 frameCount,
+                                       const ui32 setsPerPool,
+                                       const std::vector<VulkanDescriptorPoolSizeRatio>& poolSizeRatios) noexcept
+{
+	if (!setsPerPool || poolSizeRatios.empty()) {
+		ERROR_LOG("Cannot create a descriptor allocator without pool sizes.");
+		return false;
+	}
+
+	m_SetsPerPool = setsPerPool;
+
+	m_PoolSizes.clear();
+
+	for (const auto& poolSizeRatio : poolSizeRatios) {
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = poolSizeRatio.type;
+		poolSize.descriptorCount = std::max(1u, static_cast<ui32>(std::ceil(poolSizeRatio.ratio * setsPerPool)));
+
+		m_PoolSizes.push_back(poolSize);
+	}
+
+	m_FramePools.resize(frameCount);
+
+	return true;
+}
+
+VkDescriptorSet VulkanDescriptorAllocator::Allocate(const VkDescriptorSetLayout layout) noexcept
+{
+	const auto freeSets = m_FreeSets.find(layout);
+
+	if (freeSets != m_FreeSets.end() && !freeSets->second.empty()) {
+		const auto descriptorSet = freeSets->second.back();
+		freeSets->second.pop_back();
+
+		++m_PersistentPools.allocatedSetCount;
+
+		return descriptorSet;
+	}
+
+	return Allocate(m_PersistentPools, layout);
+}
+
+void VulkanDescriptorAllocator::Free(const VkDescriptorSetLayout layout, const VkDescriptorSet descriptorSet) noexcept
+{
+	if (!descriptorSet) {
+		return;
+	}
+
+	// The pools are not created to free sets one by one, so the set is kept for its layout instead.
+	m_FreeSets[layout].push_back(descriptorSet);
+
+	--m_PersistentPools.allocatedSetCount;
+}
+
+VkDescriptorSet VulkanDescriptorAllocator::AllocateTransient(const ui32 frameIndex,
+                                                             const VkDescriptorSetLayout layout) noexcept
+{
+	return Allocate(m_FramePools[frameIndex], layout);
+}
+
+bool VulkanDescriptorAllocator::ResetFrame(const ui32 frameIndex) noexcept
+{
+	return Reset(m_FramePools[frameIndex]);
+}
+
+ui32 VulkanDescriptorAllocator::GetTransientSetCount(const ui32 frameIndex) const noexcept
+{
+	return m_FramePools[frameIndex].allocatedSetCount;
+}
+
+ui32 VulkanDescriptorAllocator::GetPersistentSetCount() const noexcept
+{
+	return m_PersistentPools.allocatedSetCount;
+}
+
+size_t VulkanDescriptorAllocator::GetPoolCount() const noexcept
+{
+	auto count = m_PersistentPools.usedPools.size() + m_PersistentPools.freePools.size();
+
+	for (const auto& chain : m_FramePools) {
+		count += chain.usedPools.size() + chain.freePools.size();
+	}
+
+	return count;
+}
+
+void VulkanDescriptorAllocator::CleanUp() noexcept
+{
+	Destroy(m_PersistentPools);
+
+	m_FreeSets.clear();
+
+	for (auto& chain : m_FramePools) {
+		Destroy(chain);
+	}
+
+	m_FramePools.clear();
+}
@@ -0,0 +1,114 @@
+#ifndef VULKAN_DESCRIPTOR_ALLOCATOR_H_
+#define VULKAN_DESCRIPTOR_ALLOCATOR_H_
+
+#include <vulkan/vulkan.h>
+#include <unordered_map>
+#include <vector>
+#include "types.h"
+
+/**
+ * \brief Number of descriptors of a type that one set needs on average.
+ */
+struct VulkanDescriptorPoolSizeRatio {
+	VkDescriptorType type;
+
+	f32 ratio;
+};
+
+/**
+ * \brief Allocates descriptor sets from pools that are created on demand.
+ * \details Long lived sets come from a list of pools that grows when the last one is
+ * full and is never reset. They can be handed back with Free() instead, then later
+ * allocations of the same layout reuse them. Transient sets come from the pools of a frame in flight,
+ * which are all reset at once with ResetFrame() and then reused, so the steady state
+ * neither creates pools nor frees sets one by one.
+ */
+class VulkanDescriptorAllocator {
+private:
+	struct PoolChain {
+		// Pools that handed out sets since the last reset, sets come from the last one.
+		std::vector<VkDescriptorPool> usedPools;
+
+		// Pools that were reset and are ready to be used again.
+		std::vector<VkDescriptorPool> freePools;
+
+		ui32 currentPoolSetCount{ 0 };
+
+		ui32 allocatedSetCount{ 0 };
+	};
+
+	std::vector<VkDescriptorPoolSize> m_PoolSizes;
+
+	ui32 m_SetsPerPool{ 0 };
+
+	PoolChain m_PersistentPools;
+
+	/**
+	 * \brief Long lived sets returned with Free(), by layout.
+	 */
+	std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSet>> m_FreeSets;
+
+	std::vector<PoolChain> m_FramePools;
+
+	bool NextPool(PoolChain& chain) noexcept;
+
+	VkDescriptorSet Allocate(PoolChain& chain, VkDescriptorSetLayout layout) noexcept;
+
+	static bool Reset(PoolChain& chain) noexcept;
+
+	static void Destroy(PoolChain& chain) noexcept;
+
+public:
+	VulkanDescriptorAllocator() = default;
+
+	VulkanDescriptorAllocator(const VulkanDescriptorAllocator& other) = delete;
+
+	VulkanDescriptorAllocator& operator=(const VulkanDescriptorAllocator& other) = delete;
+
+	~VulkanDescriptorAllocator();
+
+	/**
+	 * \brief Prepares the pool chains. No pool is created until the first allocation.
+	 * \details Every pool holds setsPerPool sets, and ratio * setsPerPool descriptors of
+	 * each type. The ratios should cover the largest layout allocated from the pools.
+	 */
+	bool Create(ui32 frameCount, ui32 setsPerPool, const std::vector<VulkanDescriptorPoolSizeRatio>& poolSizeRatios) noexcept;
+
+	/**
+	 * \brief Allocates a set that lives until the allocator is cleaned up.
+	 */
+	VkDescriptorSet Allocate(VkDescriptorSetLayout layout) noexcept;
+
+	/**
+	 * \brief Returns a set from Allocate() for the next Allocate() with the same layout.
+	 * \details The GPU must be done with the set. It is rewritten by whoever gets it next.
+	 */
+	void Free(VkDescriptorSetLayout layout, VkDescriptorSet descriptorSet) noexcept;
+
+	/**
+	 * \brief Allocates a set that is only valid until the next ResetFrame() of the frame.
+	 */
+	VkDescriptorSet AllocateTransient(ui32 frameIndex, VkDescriptorSetLayout layout) noexcept;
+
+	/**
+	 * \brief Returns every transient set of the frame to its pools.
+	 * \details The GPU must be done with the frame, i.e. its fence has been waited on.
+	 */
+	bool ResetFrame(ui32 frameIndex) noexcept;
+
+	/**
+	 * \brief Number of transient sets allocated for the frame since its last reset.
+	 */
+	ui32 GetTransientSetCount(ui32 frameIndex) const noexcept;
+
+	/**
+	 * \brief Number of sets allocated with Allocate() and not freed.
+	 */
+	ui32 GetPersistentSetCount() const noexcept;
+
+	size_t GetPoolCount() const noexcept;
+
+	void CleanUp() noexcept;
+};
+
+#endif //VULKAN_DESCRIPTOR_ALLOCATOR_H_
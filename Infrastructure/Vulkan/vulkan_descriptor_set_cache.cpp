@@ -0,0 +1,172 @@
+#include "vulkan_descriptor_set_cache.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include "logger.h"
+#include "vulkan_descriptor_allocator.h"
+#include "vulkan_infrastructure_context.h"
+
+// Handles are pointers or 64 bit integers depending on the platform, so they are hashed and compared bitwise.
+template <typename T>
+static ui64 ToBits(const T& value) noexcept
+{
+	static_assert(sizeof(T) <= sizeof(ui64), "Only handles and scalars can be hashed.");
+
+	ui64 bits{ 0 };
+	memcpy(&bits, &value, sizeof value);
+
+	return bits;
+}
+
+template <typename T>
+static void HashCombine(size_t& seed, const T& value) noexcept
+{
+	seed ^= std::hash<ui64>{}(ToBits(value)) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+static size_t Hash(const VkDescriptorSetLayout layout, const std::vector<VulkanDescriptorBinding>& bindings) noexcept
+{
+	size_t seed{ 0 };
+
+	HashCombine(seed, layout);
+
+	for (const auto& binding : bindings) {
+		HashCombine(seed, binding.binding);
+		HashCombine(seed, binding.type);
+		HashCombine(seed, binding.bufferInfo.buffer);
+		HashCombine(seed, binding.bufferInfo.offset);
+		HashCombine(seed, binding.bufferInfo.range);
+		HashCombine(seed, binding.imageInfo.sampler);
+		HashCombine(seed, binding.imageInfo.imageView);
+		HashCombine(seed, binding.imageInfo.imageLayout);
+	}
+
+	return seed;
+}
+
+static bool Equal(const VulkanDescriptorBinding& a, const VulkanDescriptorBinding& b) noexcept
+{
+	return a.binding == b.binding &&
+		a.type == b.type &&
+		ToBits(a.bufferInfo.buffer) == ToBits(b.bufferInfo.buffer) &&
+		a.bufferInfo.offset == b.bufferInfo.offset &&
+		a.bufferInfo.range == b.bufferInfo.range &&
+		ToBits(a.imageInfo.sampler) == ToBits(b.imageInfo.sampler) &&
+		ToBits(a.imageInfo.imageView) == ToBits(b.imageInfo.imageView) &&
+		a.imageInfo.imageLayout == b.imageInfo.imageLayout;
+}
+
+static bool IsBufferDescriptor(const VkDescriptorType type) noexcept
+{
+	return type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
+		type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
+		type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+		type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+}
+
+void VulkanDescriptorSetCache::Create(VulkanDescriptorAllocator* pAllocator) noexcept
+{
+	m_pAllocator = pAllocator;
+}
+
+VkDescriptorSet VulkanDescriptorSetCache::Get(const VkDescriptorSetLayout layout,
+                                              const std::vector<VulkanDescriptorBinding>& bindings) noexcept
+{
+	const auto hash = Hash(layout, bindings);
+
+	const auto range = m_Entries.equal_range(hash);
+
+	for (auto it = range.first; it != range.second; ++it) {
+		const auto& entry = it->second;
+
+		if (ToBits(entry.layout) != ToBits(layout) || entry.bindings.size() != bindings.size()) {
+			continue;
+		}
+
+		if (std::equal(bindings.cbegin(), bindings.cend(), entry.bindings.cbegin(), Equal)) {
+			++m_HitCount;
+			return entry.descriptorSet;
+		}
+	}
+
+	++m_MissCount;
+
+	const auto descriptorSet = m_pAllocator->Allocate(layout);
+
+	if (!descriptorSet) {
+		ERROR_LOG("Failed to allocate cached descriptor set.");
+		return VK_NULL_HANDLE;
+	}
+
+	Write(descriptorSet, bindings);
+
+	Entry entry{};
+	entry.layout = layout;
+	entry.bindings = bindings;
+	entry.descriptorSet = descriptorSet;
+
+	m_Entries.emplace(hash, std::move(entry));
+
+	return descriptorSet;
+}
+
+void VulkanDescriptorSetCache::Clear() noexcept
+{
+	for (const auto& entry : m_Entries) {
+		m_pAllocator->Free(entry.second.layout, entry.second.descriptorSet);
+	}
+
+	m_Entries.clear();
+}
+
+size_t VulkanDescriptorSetCache::GetSetCount() const noexcept
+{
+	return m_Entries.size();
+}
+
+size_t VulkanDescriptorSetCache::GetHitCount() const noexcept
+{
+	return m_HitCount;
+}
+
+size_t VulkanDescriptorSetCache::GetMissCount() const noexcept
+{
+	return m_MissCount;
+}
+
+void VulkanDescriptorSetCache::Write(const VkDescriptorSet descriptorSet,
+                                     const std::vector<VulkanDescriptorBinding>& bindings) noexcept
+{
+	// Sets rarely have more bindings than this, larger ones are written in several calls.
+	std::array<VkWriteDescriptorSet, 16> descriptorWrites{};
+
+	auto count = 0u;
+
+	for (const auto& binding : bindings) {
+		auto& descriptorWrite = descriptorWrites[count++];
+		descriptorWrite = {};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = descriptorSet;
+		descriptorWrite.dstBinding = binding.binding;
+		descriptorWrite.dstArrayElement = 0;
+		descriptorWrite.descriptorType = binding.type;
+		descriptorWrite.descriptorCount = 1;
+
+		if (IsBufferDescriptor(binding.type)) {
+			descriptorWrite.pBufferInfo = &binding.bufferInfo;
+		}
+		else {
+			descriptorWrite.pImageInfo = &binding.imageInfo;
+		}
+
+		if (count == descriptorWrites.size()) {
+			vkUpdateDescriptorSets(G_VulkanDevice, count, descriptorWrites.data(), 0, nullptr);
+			count = 0;
+		}
+	}
+
+	if (count) {
+		vkUpdateDescriptorSets(G_VulkanDevice, count, descriptorWrites.data(), 0, nullptr);
+	}
+}
@@ -0,0 +1,78 @@
+#ifndef VULKAN_DESCRIPTOR_SET_CACHE_H_
+#define VULKAN_DESCRIPTOR_SET_CACHE_H_
+
+#include <vulkan/vulkan.h>
+#include <unordered_map>
+#include <vector>
+#include "types.h"
+
+class VulkanDescriptorAllocator;
+
+/**
+ * \brief One descriptor of a set. Buffer types use bufferInfo, image and sampler types use imageInfo.
+ * Texel buffers are not supported.
+ */
+struct VulkanDescriptorBinding {
+	ui32 binding{ 0 };
+
+	VkDescriptorType type{ VK_DESCRIPTOR_TYPE_MAX_ENUM };
+
+	VkDescriptorBufferInfo bufferInfo{};
+
+	VkDescriptorImageInfo imageInfo{};
+};
+
+/**
+ * \brief Hands out one descriptor set per distinct layout and set of bound resources.
+ * \details Sets are looked up by a hash of the layout and the bindings, so materials
+ * that bind the same textures share a set instead of each allocating and writing
+ * their own. The sets are allocated from the persistent pools of the allocator and
+ * handed back to it by Clear(). Call Clear() before destroying a resource that a
+ * cached set refers to.
+ */
+class VulkanDescriptorSetCache {
+private:
+	struct Entry {
+		VkDescriptorSetLayout layout{ VK_NULL_HANDLE };
+
+		std::vector<VulkanDescriptorBinding> bindings;
+
+		VkDescriptorSet descriptorSet{ VK_NULL_HANDLE };
+	};
+
+	VulkanDescriptorAllocator* m_pAllocator{ nullptr };
+
+	// Keyed by the hash alone, colliding entries are told apart by comparing the bindings.
+	std::unordered_multimap<size_t, Entry> m_Entries;
+
+	size_t m_HitCount{ 0 };
+
+	size_t m_MissCount{ 0 };
+
+public:
+	void Create(VulkanDescriptorAllocator* pAllocator) noexcept;
+
+	/**
+	 * \brief Returns the set with the given layout and bindings, allocating and writing it on the first request.
+	 */
+	VkDescriptorSet Get(VkDescriptorSetLayout layout, const std::vector<VulkanDescriptorBinding>& bindings) noexcept;
+
+	/**
+	 * \brief Returns every cached set to the allocator, which reuses them for later sets of the same layout.
+	 * \details The GPU must be done with the sets.
+	 */
+	void Clear() noexcept;
+
+	size_t GetSetCount() const noexcept;
+
+	size_t GetHitCount() const noexcept;
+
+	size_t GetMissCount() const noexcept;
+
+	/**
+	 * \brief Writes the bindings to descriptorSet without allocating.
+	 */
+	static void Write(VkDescriptorSet descriptorSet, const std::vector<VulkanDescriptorBinding>& bindings) noexcept;
+};
+
+#endif //VULKAN_DESCRIPTOR_SET_CACHE_H_
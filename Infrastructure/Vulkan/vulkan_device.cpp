@@ -77,11 +77,38 @@ bool VulkanDevice::PickPhysicalDevice(VkInstance instance)
 
 	return true;
 }
+
+bool VulkanDevice::SubmitAndWait(VkCommandBuffer commandBuffer, VkQueue queue) const noexcept
+{
+	auto queueFamily = QueueFamily::GRAPHICS;
+
+	if (queue == m_TransferQueue && queue != m_GraphicsQueue) {
+		queueFamily = QueueFamily::TRANSFER;
+	} else if (queue == m_ComputeQueue && queue != m_GraphicsQueue) {
+		queueFamily = QueueFamily::COMPUTE;
+	}
+
+	const auto value = m_Timeline.Submit(queueFamily, { commandBuffer });
+
+	const auto completed = value && m_Timeline.Wait(queueFamily, value);
+
+	if (!completed) {
+		ERROR_LOG("Single use command buffer submission failed.");
+	}
+
+	vkFreeCommandBuffers(m_LogicalDevice, m_CommandPool, 1, &commandBuffer);
+
+	return completed;
+}
+
 // -------------------------------------------------------------
 
 VulkanDevice::~VulkanDevice()
 {
 	LOG("Cleaning up VulkanDevice");
+	m_Uploader.CleanUp();
+	m_Timeline.CleanUp();
+	m_MemoryAllocator.CleanUp();
 	vkDestroyCommandPool(m_LogicalDevice, m_CommandPool, nullptr);
 	vkDestroyDevice(m_LogicalDevice, nullptr);
 }
@@ -202,10 +229,22 @@ bool VulkanDevice::CreateLogicalDevice(VkPhysicalDeviceFeatures featuresToEnable
 
 	m_EnabledFeatures = featuresToEnable;
 
+	m_MemoryAllocator.Initialize(m_LogicalDevice, m_PhysicalDevice.memoryProperties);
+
 	vkGetDeviceQueue(m_LogicalDevice, m_QueueFamilyIndices.graphics, 0, &m_GraphicsQueue);
 	vkGetDeviceQueue(m_LogicalDevice, m_QueueFamilyIndices.transfer, 0, &m_TransferQueue);
 	vkGetDeviceQueue(m_LogicalDevice, m_QueueFamilyIndices.compute, 0, &m_ComputeQueue);
 
+	if (!m_Timeline.Initialize(*this)) {
+		ERROR_LOG("Failed to initialize the timeline.");
+		return false;
+	}
+
+	if (!m_Uploader.Initialize(*this)) {
+		ERROR_LOG("Failed to initialize the uploader.");
+		return false;
+	}
+
 	return true;
 }
 
@@ -214,6 +253,11 @@ const VulkanPhysicalDevice& VulkanDevice::GetPhysicalDevice() const noexcept
 	return m_PhysicalDevice;
 }
 
+const VkPhysicalDeviceFeatures& VulkanDevice::GetEnabledFeatures() const noexcept
+{
+	return m_EnabledFeatures;
+}
+
 ui32 VulkanDevice::GetMemoryTypeIndex(ui32 memoryTypeMask, VkMemoryPropertyFlags memoryPropertyFlags) const noexcept
 {
 	for (uint32_t i = 0; i < m_PhysicalDevice.memoryProperties.memoryTypeCount; i++) {
@@ -263,27 +307,19 @@ bool VulkanDevice::CreateBuffer(VkBufferUsageFlags usageFlags,
 	VkMemoryRequirements memoryRequirements{};
 	vkGetBufferMemoryRequirements(m_LogicalDevice, buffer.buffer, &memoryRequirements);
 
-	VkMemoryAllocateInfo memoryAllocateInfo{};
-	memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memoryAllocateInfo.allocationSize = memoryRequirements.size;
-
 	ui32 memoryTypeIndex{ GetMemoryTypeIndex(memoryRequirements.memoryTypeBits, memoryPropertyFlags) };
 
 	if (memoryTypeIndex == std::numeric_limits<ui32>::max()) {
 		return false;
 	}
 
-	memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
-
-	result = vkAllocateMemory(m_LogicalDevice, &memoryAllocateInfo, nullptr, &buffer.memory);
-
-	if (result != VK_SUCCESS) {
+	if (!m_MemoryAllocator.Allocate(memoryRequirements, memoryTypeIndex, ResourceTiling::LINEAR, buffer.allocation)) {
 		ERROR_LOG("Failed to allocate m_Buffer m_Memory");
 		return false;
 	}
 
 	buffer.memoryAlignment = memoryRequirements.alignment;
-	buffer.size = memoryAllocateInfo.allocationSize;
+	buffer.size = memoryRequirements.size;
 	buffer.usageFlags = usageFlags;
 	buffer.memoryPropertyFlags = memoryPropertyFlags;
 
@@ -317,7 +353,8 @@ bool VulkanDevice::CreateImage(const Vec2ui& imageDimensions,
                                VkImageUsageFlags imageUsageFlags,
                                VkMemoryPropertyFlags memoryPropertyFlags,
                                VkImage& image,
-                               VkDeviceMemory& imageMemory) const noexcept
+                               VulkanAllocation& imageMemory,
+                               const ui32 mipLevels) const noexcept
 {
 	VkImageCreateInfo imageCreateInfo{};
 	imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -325,7 +362,7 @@ bool VulkanDevice::CreateImage(const Vec2ui& imageDimensions,
 	imageCreateInfo.extent.width = imageDimensions.x;
 	imageCreateInfo.extent.height = imageDimensions.y;
 	imageCreateInfo.extent.depth = 1;
-	imageCreateInfo.mipLevels = 1;
+	imageCreateInfo.mipLevels = mipLevels;
 	imageCreateInfo.arrayLayers = 1;
 	imageCreateInfo.format = format;
 	imageCreateInfo.tiling = imageTiling;
@@ -341,33 +378,61 @@ bool VulkanDevice::CreateImage(const Vec2ui& imageDimensions,
 		return false;
 	}
 
+	return AllocateImageMemory(image, imageTiling, memoryPropertyFlags, imageMemory);
+}
+
+bool VulkanDevice::AllocateImageMemory(VkImage image,
+                                       VkImageTiling imageTiling,
+                                       VkMemoryPropertyFlags memoryPropertyFlags,
+                                       VulkanAllocation& imageMemory) const noexcept
+{
 	VkMemoryRequirements memoryRequirements{};
 	vkGetImageMemoryRequirements(m_LogicalDevice, image, &memoryRequirements);
 
-	VkMemoryAllocateInfo memoryAllocateInfo{};
-	memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memoryAllocateInfo.allocationSize = memoryRequirements.size;
-
 	ui32 memoryTypeIndex{ GetMemoryTypeIndex(memoryRequirements.memoryTypeBits, memoryPropertyFlags) };
 
 	if (memoryTypeIndex == std::numeric_limits<ui32>::max()) {
 		return false;
 	}
 
-	memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
-
-	result = vkAllocateMemory(m_LogicalDevice, &memoryAllocateInfo, nullptr, &imageMemory);
+	const auto tiling = imageTiling == VK_IMAGE_TILING_LINEAR ? ResourceTiling::LINEAR : ResourceTiling::OPTIMAL;
 
-	if (result != VK_SUCCESS) {
+	if (!m_MemoryAllocator.Allocate(memoryRequirements, memoryTypeIndex, tiling, imageMemory)) {
 		ERROR_LOG("Failed to allocate image memory.");
 		return false;
 	}
 
-	vkBindImageMemory(m_LogicalDevice, image, imageMemory, 0);
+	VkResult result{ vkBindImageMemory(m_LogicalDevice, image, imageMemory.memory, imageMemory.offset) };
+
+	if (result != VK_SUCCESS) {
+		ERROR_LOG("Failed to bind image memory.");
+		m_MemoryAllocator.Free(imageMemory);
+		return false;
+	}
 
 	return true;
 }
 
+void VulkanDevice::FreeMemory(VulkanAllocation& allocation) const noexcept
+{
+	m_MemoryAllocator.Free(allocation);
+}
+
+VulkanMemoryStatistics VulkanDevice::GetMemoryStatistics() const noexcept
+{
+	return m_MemoryAllocator.GetStatistics();
+}
+
+VulkanUploader& VulkanDevice::GetUploader() const noexcept
+{
+	return m_Uploader;
+}
+
+VulkanTimeline& VulkanDevice::GetTimeline() const noexcept
+{
+	return m_Timeline;
+}
+
 VkCommandBuffer VulkanDevice::CreateCommandBuffer(VkCommandBufferLevel commandBufferLevel) const noexcept
 {
 	VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
@@ -496,25 +561,7 @@ bool VulkanDevice::CopyBuffer(const VulkanBuffer& source,
 
 	vkEndCommandBuffer(commandBuffer);
 
-	VkFenceCreateInfo fenceCreateInfo{};
-	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceCreateInfo.flags = VK_NULL_HANDLE;
-
-	VkFence fence{ VK_NULL_HANDLE };
-
-	result = vkCreateFence(m_LogicalDevice, &fenceCreateInfo, nullptr, &fence);
-
-	if (result != VK_SUCCESS) {
-		ERROR_LOG("Failed to create fence.");
-		return false;
-	}
-
-	if (!SubmitCommandBuffer(commandBuffer, transferQueue, fence)) {
-		ERROR_LOG("Command buffer submission failed.");
-		return false;
-	}
-
-	return true;
+	return SubmitAndWait(commandBuffer, transferQueue);
 }
 
 bool VulkanDevice::CopyBufferToImage(const VulkanBuffer& source,
@@ -552,25 +599,7 @@ bool VulkanDevice::CopyBufferToImage(const VulkanBuffer& source,
 
 	vkEndCommandBuffer(commandBuffer);
 
-	VkFenceCreateInfo fenceCreateInfo{};
-	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceCreateInfo.flags = VK_NULL_HANDLE;
-
-	VkFence fence{ VK_NULL_HANDLE };
-
-	VkResult result{ vkCreateFence(m_LogicalDevice, &fenceCreateInfo, nullptr, &fence) };
-
-	if (result != VK_SUCCESS) {
-		ERROR_LOG("Failed to create fence.");
-		return false;
-	}
-
-	if (!SubmitCommandBuffer(commandBuffer, m_TransferQueue, fence)) {
-		ERROR_LOG("Command buffer submission failed.");
-		return false;
-	}
-
-	return true;
+	return SubmitAndWait(commandBuffer, m_GraphicsQueue);
 }
 
 bool VulkanDevice::TransitionImageLayout(VkImage image,
@@ -688,25 +717,7 @@ bool VulkanDevice::TransitionImageLayout(VkImage image,
 
 	vkEndCommandBuffer(commandBuffer);
 
-	VkFenceCreateInfo fenceCreateInfo{};
-	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceCreateInfo.flags = VK_NULL_HANDLE;
-
-	VkFence fence{ VK_NULL_HANDLE };
-
-	VkResult result{ vkCreateFence(m_LogicalDevice, &fenceCreateInfo, nullptr, &fence) };
-
-	if (result != VK_SUCCESS) {
-		ERROR_LOG("Failed to create fence.");
-		return false;
-	}
-
-	if (!SubmitCommandBuffer(commandBuffer, m_TransferQueue, fence)) {
-		ERROR_LOG("Command buffer submission failed.");
-		return false;
-	}
-
-	return true;
+	return SubmitAndWait(commandBuffer, m_GraphicsQueue);
 }
 
 VkQueue VulkanDevice::GetQueue(QueueFamily queueFamily) const noexcept
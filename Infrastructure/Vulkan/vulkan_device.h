@@ -4,6 +4,9 @@
 #include <vulkan/vulkan.h>
 #include "vulkan_physical_device.h"
 #include "vulkan_buffer.h"
+#include "vulkan_memory_allocator.h"
+#include "vulkan_timeline.h"
+#include "vulkan_uploader.h"
 
 /**
  * \brief A structure that contains the device queue family indices.
@@ -70,6 +73,22 @@ private:
      */
     VkPhysicalDeviceFeatures m_EnabledFeatures;
 
+    /**
+     * \brief Sub-allocates the memory of every buffer and image created through the device.
+     * \details Mutable since handing out memory does not change the device itself.
+     */
+    mutable VulkanMemoryAllocator m_MemoryAllocator;
+
+    /**
+     * \brief Batches the staging uploads of meshes and textures on the transfer queue.
+     */
+    mutable VulkanUploader m_Uploader;
+
+    /**
+     * \brief Tracks the submissions to the queues, the single use commands wait on it instead of creating fences.
+     */
+    mutable VulkanTimeline m_Timeline;
+
     /**
      * \brief Select the most suitable physical device (GPU).
      * \param instance The Vulkan instance.
@@ -77,6 +96,14 @@ private:
      */
     bool PickPhysicalDevice(VkInstance instance);
 
+    /**
+     * \brief Submits a single use command buffer through the timeline, waits for it and frees it.
+     * \param commandBuffer A command buffer allocated from the device's command pool.
+     * \param queue The queue to submit to.
+     * \return TRUE if successful, FALSE otherwise.
+     */
+    bool SubmitAndWait(VkCommandBuffer commandBuffer, VkQueue queue) const noexcept;
+
 public:
     ~VulkanDevice();
 
@@ -108,6 +135,12 @@ public:
      */
     const VulkanPhysicalDevice &GetPhysicalDevice() const noexcept;
 
+    /**
+     * \brief Returns the features enabled on the logical device.
+     * \return The enabled features.
+     */
+    const VkPhysicalDeviceFeatures &GetEnabledFeatures() const noexcept;
+
     /**
      * \brief Returns the index of the appropriate device memory type.
      * \param memoryTypeMask The memory requirements.
@@ -147,7 +180,33 @@ public:
                      VkImageUsageFlags imageUsageFlags,
                      VkMemoryPropertyFlags memoryPropertyFlags,
                      VkImage &image,
-                     VkDeviceMemory &imageMemory) const noexcept;
+                     VulkanAllocation &imageMemory,
+                     ui32 mipLevels = 1) const noexcept;
+
+    /**
+     * \brief Allocates memory for an image from the memory allocator and binds it.
+     * \param image The image.
+     * \param imageTiling The tiling the image was created with.
+     * \param memoryPropertyFlags Flags that specify the memory properties of the image.
+     * \param imageMemory The allocation the image is bound to.
+     * \return TRUE if successful, FALSE otherwise.
+     */
+    bool AllocateImageMemory(VkImage image,
+                             VkImageTiling imageTiling,
+                             VkMemoryPropertyFlags memoryPropertyFlags,
+                             VulkanAllocation &imageMemory) const noexcept;
+
+    /**
+     * \brief Returns an allocation made by CreateBuffer, CreateImage or AllocateImageMemory.
+     * \param allocation The allocation. It is reset.
+     */
+    void FreeMemory(VulkanAllocation &allocation) const noexcept;
+
+    VulkanMemoryStatistics GetMemoryStatistics() const noexcept;
+
+    VulkanUploader &GetUploader() const noexcept;
+
+    VulkanTimeline &GetTimeline() const noexcept;
 
     VkCommandBuffer CreateCommandBuffer(VkCommandBufferLevel commandBufferLevel) const noexcept;
 
@@ -0,0 +1,369 @@
+#include "vulkan_memory_allocator.h"
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include "logger.h"
+
+struct FreeRange {
+	VkDeviceSize offset{ 0 };
+	VkDeviceSize size{ 0 };
+};
+
+struct VulkanMemoryBlock {
+	VkDeviceMemory memory{ VK_NULL_HANDLE };
+
+	VkDeviceSize size{ 0 };
+
+	ui32 memoryTypeIndex{ 0 };
+
+	ResourceTiling tiling{ ResourceTiling::LINEAR };
+
+	bool dedicated{ false };
+
+	void* mappedData{ nullptr };
+
+	/**
+	 * \brief Free ranges sorted by offset. Adjacent ranges are always merged.
+	 */
+	std::vector<FreeRange> freeRanges;
+
+	size_t allocationCount{ 0 };
+
+	VkDeviceSize usedBytes{ 0 };
+};
+
+static VkDeviceSize AlignUp(const VkDeviceSize value, const VkDeviceSize alignment) noexcept
+{
+	return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+// Returns the best fitting free range of block for size bytes at alignment, or -1.
+static i64 FindFreeRange(const VulkanMemoryBlock& block, const VkDeviceSize size, const VkDeviceSize alignment) noexcept
+{
+	i64 bestRange{ -1 };
+
+	for (auto i = 0u; i < block.freeRanges.size(); ++i) {
+		const auto& range = block.freeRanges[i];
+		const auto offset = AlignUp(range.offset, alignment);
+
+		if (offset + size > range.offset + range.size) {
+			continue;
+		}
+
+		if (bestRange < 0 || range.size < block.freeRanges[bestRange].size) {
+			bestRange = i;
+		}
+	}
+
+	return bestRange;
+}
+
+// Carves size bytes out of free range rangeIndex of block. The alignment padding stays free.
+static VkDeviceSize TakeFromRange(VulkanMemoryBlock& block,
+                                  const size_t rangeIndex,
+                                  const VkDeviceSize size,
+                                  const VkDeviceSize alignment) noexcept
+{
+	const auto range = block.freeRanges[rangeIndex];
+	const auto offset = AlignUp(range.offset, alignment);
+	const auto end = offset + size;
+
+	block.freeRanges.erase(block.freeRanges.begin() + rangeIndex);
+
+	if (end < range.offset + range.size) {
+		block.freeRanges.insert(block.freeRanges.begin() + rangeIndex, FreeRange{ end, range.offset + range.size - end });
+	}
+
+	if (offset > range.offset) {
+		block.freeRanges.insert(block.freeRanges.begin() + rangeIndex, FreeRange{ range.offset, offset - range.offset });
+	}
+
+	++block.allocationCount;
+	block.usedBytes += size;
+
+	return offset;
+}
+
+static void ReturnToBlock(VulkanMemoryBlock& block, const VkDeviceSize offset, const VkDeviceSize size) noexcept
+{
+	auto next = std::lower_bound(block.freeRanges.begin(),
+	                             block.freeRanges.end(),
+	                             offset,
+	                             [](const FreeRange& range, const VkDeviceSize value)
+	                             {
+		                             return range.offset < value;
+	                             });
+
+	next = block.freeRanges.insert(next, FreeRange{ offset, size });
+
+	// Merge with the following range...
+	const auto following = next + 1;
+
+	if (following != block.freeRanges.end() && next->offset + next->size == following->offset) {
+		next->size += following->size;
+		block.freeRanges.erase(following);
+	}
+
+	// ...and with the preceding one.
+	if (next != block.freeRanges.begin()) {
+		const auto preceding = next - 1;
+
+		if (preceding->offset + preceding->size == next->offset) {
+			preceding->size += next->size;
+			block.freeRanges.erase(next);
+		}
+	}
+
+	assert(block.allocationCount > 0);
+	--block.allocationCount;
+	block.usedBytes -= size;
+}
+
+// Private functions -------------------------------------------
+VkDeviceSize VulkanMemoryAllocator::GetBlockSize(const ui32 memoryTypeIndex) const noexcept
+{
+	const auto heapIndex = m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+	const auto heapSize = m_MemoryProperties.memoryHeaps[heapIndex].size;
+
+	// Small heaps, like the host visible part of device local memory, would be
+	// exhausted by a couple of blocks.
+	return std::min(m_PreferredBlockSize, heapSize / 8);
+}
+
+VulkanMemoryBlock* VulkanMemoryAllocator::CreateBlock(const ui32 memoryTypeIndex,
+                                                      const ResourceTiling tiling,
+                                                      const VkDeviceSize size,
+                                                      const bool dedicated) noexcept
+{
+	VkMemoryAllocateInfo memoryAllocateInfo{};
+	memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memoryAllocateInfo.allocationSize = size;
+	memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+	auto block = std::make_unique<VulkanMemoryBlock>();
+
+	VkResult result{ vkAllocateMemory(m_Device, &memoryAllocateInfo, nullptr, &block->memory) };
+
+	if (result != VK_SUCCESS) {
+		ERROR_LOG("Failed to allocate a device memory block of " + std::to_string(size) + " bytes.");
+		return nullptr;
+	}
+
+	if (m_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		result = vkMapMemory(m_Device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mappedData);
+
+		if (result != VK_SUCCESS) {
+			ERROR_LOG("Failed to map a host visible device memory block.");
+			vkFreeMemory(m_Device, block->memory, nullptr);
+			return nullptr;
+		}
+	}
+
+	block->size = size;
+	block->memoryTypeIndex = memoryTypeIndex;
+	block->tiling = tiling;
+	block->dedicated = dedicated;
+	block->freeRanges.push_back(FreeRange{ 0, size });
+
+	auto& blocks = m_Blocks[memoryTypeIndex][static_cast<size_t>(tiling)];
+	blocks.push_back(std::move(block));
+
+	return blocks.back().get();
+}
+
+void VulkanMemoryAllocator::DestroyBlock(VulkanMemoryBlock& block) const noexcept
+{
+	if (block.mappedData) {
+		vkUnmapMemory(m_Device, block.memory);
+	}
+
+	vkFreeMemory(m_Device, block.memory, nullptr);
+}
+// -------------------------------------------------------------
+
+// The blocks are only complete here.
+VulkanMemoryAllocator::VulkanMemoryAllocator() = default;
+
+VulkanMemoryAllocator::~VulkanMemoryAllocator()
+{
+	CleanUp();
+}
+
+void VulkanMemoryAllocator::Initialize(const VkDevice device,
+                                       const VkPhysicalDeviceMemoryProperties& memoryProperties,
+                                       const VkDeviceSize preferredBlockSize) noexcept
+{
+	m_Device = device;
+	m_MemoryProperties = memoryProperties;
+	m_PreferredBlockSize = preferredBlockSize;
+}
+
+bool VulkanMemoryAllocator::Allocate(const VkMemoryRequirements& memoryRequirements,
+                                     const ui32 memoryTypeIndex,
+                                     const ResourceTiling tiling,
+                                     VulkanAllocation& allocation) noexcept
+{
+	assert(memoryTypeIndex < m_MemoryProperties.memoryTypeCount);
+
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	if (!m_Device) {
+		ERROR_LOG("The memory allocator is not initialized.");
+		return false;
+	}
+
+	const auto size = memoryRequirements.size;
+	const auto alignment = memoryRequirements.alignment;
+	const auto blockSize = GetBlockSize(memoryTypeIndex);
+
+	VulkanMemoryBlock* block{ nullptr };
+	i64 rangeIndex{ -1 };
+
+	if (size > blockSize / 2) {
+		block = CreateBlock(memoryTypeIndex, tiling, size, true);
+		rangeIndex = 0;
+	}
+	else {
+		for (auto& candidate : m_Blocks[memoryTypeIndex][static_cast<size_t>(tiling)]) {
+			if (candidate->dedicated) {
+				continue;
+			}
+
+			rangeIndex = FindFreeRange(*candidate, size, alignment);
+
+			if (rangeIndex >= 0) {
+				block = candidate.get();
+				break;
+			}
+		}
+
+		if (!block) {
+			block = CreateBlock(memoryTypeIndex, tiling, blockSize, false);
+			rangeIndex = 0;
+		}
+	}
+
+	if (!block) {
+		return false;
+	}
+
+	allocation.memory = block->memory;
+	allocation.offset = TakeFromRange(*block, static_cast<size_t>(rangeIndex), size, alignment);
+	allocation.size = size;
+	allocation.block = block;
+	allocation.mappedData = block->mappedData ? static_cast<ui8*>(block->mappedData) + allocation.offset : nullptr;
+
+	return true;
+}
+
+void VulkanMemoryAllocator::Free(VulkanAllocation& allocation) noexcept
+{
+	if (!allocation.block) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	// The blocks are gone, the driver already reclaimed the memory.
+	if (!m_Device) {
+		allocation = VulkanAllocation{};
+		return;
+	}
+
+	auto& block = *allocation.block;
+
+	ReturnToBlock(block, allocation.offset, allocation.size);
+
+	allocation = VulkanAllocation{};
+
+	if (block.allocationCount) {
+		return;
+	}
+
+	auto& blocks = m_Blocks[block.memoryTypeIndex][static_cast<size_t>(block.tiling)];
+
+	// Keep one empty shared block around so that a create/destroy cycle does not hit the driver every time.
+	const auto sharedBlockCount = std::count_if(blocks.cbegin(), blocks.cend(), [](const auto& b)
+	{
+		return !b->dedicated;
+	});
+
+	if (!block.dedicated && sharedBlockCount == 1) {
+		return;
+	}
+
+	DestroyBlock(block);
+
+	blocks.erase(std::find_if(blocks.begin(), blocks.end(), [&block](const auto& b)
+	{
+		return b.get() == &block;
+	}));
+}
+
+VulkanMemoryStatistics VulkanMemoryAllocator::GetStatistics() const noexcept
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	VulkanMemoryStatistics statistics;
+
+	VkDeviceSize freeBytes{ 0 };
+	VkDeviceSize largestFreeRangesBytes{ 0 };
+
+	for (const auto& memoryTypeBlocks : m_Blocks) {
+		for (const auto& blocks : memoryTypeBlocks) {
+			for (const auto& block : blocks) {
+				++statistics.blockCount;
+
+				if (block->dedicated) {
+					++statistics.dedicatedBlockCount;
+				}
+
+				statistics.allocationCount += block->allocationCount;
+				statistics.reservedBytes += block->size;
+				statistics.usedBytes += block->usedBytes;
+				statistics.freeRangeCount += block->freeRanges.size();
+
+				VkDeviceSize largestFreeRange{ 0 };
+
+				for (const auto& range : block->freeRanges) {
+					freeBytes += range.size;
+					largestFreeRange = std::max(largestFreeRange, range.size);
+				}
+
+				largestFreeRangesBytes += largestFreeRange;
+				statistics.largestFreeRange = std::max(statistics.largestFreeRange, largestFreeRange);
+			}
+		}
+	}
+
+	if (freeBytes) {
+		statistics.fragmentation = 1.0f - static_cast<f32>(largestFreeRangesBytes) / static_cast<f32>(freeBytes);
+	}
+
+	return statistics;
+}
+
+void VulkanMemoryAllocator::CleanUp() noexcept
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	if (!m_Device) {
+		return;
+	}
+
+	for (auto& memoryTypeBlocks : m_Blocks) {
+		for (auto& blocks : memoryTypeBlocks) {
+			for (auto& block : blocks) {
+				if (block->allocationCount) {
+					LOG(std::to_string(block->allocationCount) + " allocations still live in a device memory block.");
+				}
+
+				DestroyBlock(*block);
+			}
+
+			blocks.clear();
+		}
+	}
+
+	m_Device = VK_NULL_HANDLE;
+}
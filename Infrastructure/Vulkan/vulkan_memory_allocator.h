@@ -0,0 +1,137 @@
+#ifndef VULKAN_MEMORY_ALLOCATOR_H_
+#define VULKAN_MEMORY_ALLOCATOR_H_
+
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "types.h"
+
+struct VulkanMemoryBlock;
+
+/**
+ * \brief Distinguishes the resources that bufferImageGranularity applies to.
+ * \details Buffers and linearly tiled images are LINEAR, optimally tiled images are OPTIMAL.
+ */
+enum class ResourceTiling {
+	LINEAR,
+	OPTIMAL
+};
+
+/**
+ * \brief A range of a device memory block handed out by VulkanMemoryAllocator.
+ */
+struct VulkanAllocation {
+	VkDeviceMemory memory{ VK_NULL_HANDLE };
+
+	VkDeviceSize offset{ 0 };
+
+	VkDeviceSize size{ 0 };
+
+	/**
+	 * \brief Host address of the allocation if its memory type is host visible, nullptr otherwise.
+	 * \details Host visible blocks stay mapped for their whole lifetime.
+	 */
+	void* mappedData{ nullptr };
+
+	VulkanMemoryBlock* block{ nullptr };
+};
+
+struct VulkanMemoryStatistics {
+	size_t blockCount{ 0 };
+
+	/**
+	 * \brief Blocks that hold a single allocation too large for a shared block.
+	 */
+	size_t dedicatedBlockCount{ 0 };
+
+	size_t allocationCount{ 0 };
+
+	/**
+	 * \brief Total size of the device memory allocated from the driver.
+	 */
+	VkDeviceSize reservedBytes{ 0 };
+
+	/**
+	 * \brief Bytes used by live allocations, alignment padding excluded.
+	 */
+	VkDeviceSize usedBytes{ 0 };
+
+	size_t freeRangeCount{ 0 };
+
+	VkDeviceSize largestFreeRange{ 0 };
+
+	/**
+	 * \brief 0 when the free space of every block is a single range, approaches 1 as it gets split into many small ranges.
+	 */
+	f32 fragmentation{ 0.0f };
+};
+
+/**
+ * \brief Sub-allocates buffers and images from large per memory type device memory blocks.
+ * \details Every memory type has separate block lists for linear and optimal
+ * resources, so a block never mixes the two and bufferImageGranularity never
+ * has to be padded for. Each block keeps a list of free ranges sorted by offset;
+ * allocations use the best fitting range and freed ranges are merged with their
+ * neighbors. Allocations larger than half a block get a dedicated block.
+ * All the public functions are thread safe.
+ */
+class VulkanMemoryAllocator {
+private:
+	VkDevice m_Device{ VK_NULL_HANDLE };
+
+	VkPhysicalDeviceMemoryProperties m_MemoryProperties{};
+
+	VkDeviceSize m_PreferredBlockSize{ 0 };
+
+	std::vector<std::unique_ptr<VulkanMemoryBlock>> m_Blocks[VK_MAX_MEMORY_TYPES][2];
+
+	mutable std::mutex m_Mutex;
+
+	VkDeviceSize GetBlockSize(ui32 memoryTypeIndex) const noexcept;
+
+	VulkanMemoryBlock* CreateBlock(ui32 memoryTypeIndex, ResourceTiling tiling, VkDeviceSize size, bool dedicated) noexcept;
+
+	void DestroyBlock(VulkanMemoryBlock& block) const noexcept;
+
+public:
+	static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE{ 64 * 1024 * 1024 };
+
+	VulkanMemoryAllocator();
+
+	~VulkanMemoryAllocator();
+
+	/**
+	 * \brief Initializes the allocator.
+	 * \param device The logical device to allocate from.
+	 * \param memoryProperties The memory properties of the physical device.
+	 * \param preferredBlockSize The size of the shared blocks. Smaller heaps use an eighth of their size instead.
+	 */
+	void Initialize(VkDevice device,
+	                const VkPhysicalDeviceMemoryProperties& memoryProperties,
+	                VkDeviceSize preferredBlockSize = DEFAULT_BLOCK_SIZE) noexcept;
+
+	/**
+	 * \brief Allocates a range that satisfies the size and alignment of memoryRequirements.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool Allocate(const VkMemoryRequirements& memoryRequirements,
+	              ui32 memoryTypeIndex,
+	              ResourceTiling tiling,
+	              VulkanAllocation& allocation) noexcept;
+
+	/**
+	 * \brief Returns the range of allocation to its block and resets allocation.
+	 * \details Blocks that become empty are released, except the last shared block of each list.
+	 */
+	void Free(VulkanAllocation& allocation) noexcept;
+
+	VulkanMemoryStatistics GetStatistics() const noexcept;
+
+	/**
+	 * \brief Releases every block. Allocations freed afterwards are ignored.
+	 */
+	void CleanUp() noexcept;
+};
+
+#endif //VULKAN_MEMORY_ALLOCATOR_H_
@@ -1,68 +1,92 @@
-#include <array>
 #include "logger.h"
 #include "vulkan_mesh.h"
 #include "vulkan_infrastructure_context.h"
 
-VkVertexInputBindingDescription VulkanMesh::GetVertexInputBindingDescription() noexcept
+static VkFormat GetVkFormat(const VertexFormat format) noexcept
+{
+	switch (format) {
+		case VertexFormat::FLOAT2:
+			return VK_FORMAT_R32G32_SFLOAT;
+		case VertexFormat::FLOAT3:
+			return VK_FORMAT_R32G32B32_SFLOAT;
+		case VertexFormat::HALF2:
+			return VK_FORMAT_R16G16_SFLOAT;
+		case VertexFormat::SNORM_10_10_10_2:
+			return VK_FORMAT_A2B10G10R10_SNORM_PACK32;
+		case VertexFormat::OCTAHEDRAL_SNORM8:
+			return VK_FORMAT_R8G8_SNORM;
+		case VertexFormat::UNORM8_4:
+			return VK_FORMAT_R8G8B8A8_UNORM;
+		default:
+			return VK_FORMAT_UNDEFINED;
+	}
+}
+
+VkVertexInputBindingDescription VulkanMesh::GetVertexInputBindingDescription(const VertexLayout& vertexLayout) noexcept
 {
 	VkVertexInputBindingDescription vertexInputBindingDescription{};
 	vertexInputBindingDescription.binding = 0;
-	vertexInputBindingDescription.stride = sizeof(Vertex);
+	vertexInputBindingDescription.stride = vertexLayout.GetStride();
 	vertexInputBindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
 	return vertexInputBindingDescription;
 }
 
-std::array<VkVertexInputAttributeDescription, 5> VulkanMesh::GetVertexInputAttributeDescriptions() noexcept
+std::vector<VkVertexInputAttributeDescription> VulkanMesh::GetVertexInputAttributeDescriptions(const VertexLayout& vertexLayout) noexcept
 {
-	std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions{};
-
-	attributeDescriptions[0].binding = 0;
-	attributeDescriptions[0].location = 0;
-	attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-	attributeDescriptions[0].offset = static_cast<ui32>(offsetof(Vertex, position));
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
 
-	attributeDescriptions[1].binding = 0;
-	attributeDescriptions[1].location = 1;
-	attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-	attributeDescriptions[1].offset = static_cast<ui32>(offsetof(Vertex, normal));
+	for (auto location = 0u; location < VERTEX_ATTRIBUTE_COUNT; ++location) {
+		const auto& attribute = vertexLayout.GetAttribute(static_cast<VertexAttribute>(location));
 
-	attributeDescriptions[2].binding = 0;
-	attributeDescriptions[2].location = 2;
-	attributeDescriptions[2].format = VK_FORMAT_R32G32B32_SFLOAT;
-	attributeDescriptions[2].offset = static_cast<ui32>(offsetof(Vertex, tangent));
+		if (attribute.format == VertexFormat::NONE) {
+			continue;
+		}
 
-	attributeDescriptions[3].binding = 0;
-	attributeDescriptions[3].location = 3;
-	attributeDescriptions[3].format = VK_FORMAT_R32G32B32_SFLOAT;
-	attributeDescriptions[3].offset = static_cast<ui32>(offsetof(Vertex, color));
+		VkVertexInputAttributeDescription attributeDescription{};
+		attributeDescription.binding = 0;
+		attributeDescription.location = location;
+		attributeDescription.format = GetVkFormat(attribute.format);
+		attributeDescription.offset = attribute.offset;
 
-	attributeDescriptions[4].binding = 0;
-	attributeDescriptions[4].location = 4;
-	attributeDescriptions[4].format = VK_FORMAT_R32G32_SFLOAT;
-	attributeDescriptions[4].offset = static_cast<ui32>(offsetof(Vertex, texcoord));
+		attributeDescriptions.push_back(attributeDescription);
+	}
 
 	return attributeDescriptions;
 }
 
+bool VulkanMesh::IsVertexLayoutSupported(const VertexLayout& vertexLayout) noexcept
+{
+	for (const auto& attributeDescription : GetVertexInputAttributeDescriptions(vertexLayout)) {
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(G_VulkanDevice.GetPhysicalDevice().device, attributeDescription.format, &formatProperties);
+
+		if (!(formatProperties.bufferFeatures & VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 bool VulkanMesh::CreateBuffers() noexcept
 {
-	VulkanBuffer stagingBuffer;
+	auto& uploader = G_VulkanDevice.GetUploader();
 
-	ui64 vertexBufferSize{ static_cast<ui64>(sizeof(Vertex) * GetVertices().size()) };
+	const auto& vertexLayout = GetVertexLayout();
 
-	//Create and fill a staging buffer.
-	//Used to save the data locally so it can be copied to device local memory for optimal performance.
-	if (!G_VulkanDevice.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-	                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-	                                 stagingBuffer,
-	                                 vertexBufferSize,
-	                                 GetVertexDataPtr())) {
-		ERROR_LOG("| VulkanMesh buffer creation failed:");
-		ERROR_LOG("|-- Failed to create staging buffer.");
-		return false;
+	// The full layout is uploaded as it is, the others are converted first.
+	std::vector<ui8> packedVertices;
+
+	const void* vertexData = GetVertexDataPtr();
+
+	if (vertexLayout.GetType() != VertexLayoutType::FULL) {
+		packedVertices = vertexLayout.Pack(GetVertexDataPtr(), GetVertices().size());
+		vertexData = packedVertices.data();
 	}
 
+	ui64 vertexBufferSize{ static_cast<ui64>(vertexLayout.GetStride()) * GetVertices().size() };
+
 	//Create the vertex buffer with device local memory properties.
 	//Additional mark the buffer a transfer destination so we can optimally copy data into it.
 	if (!G_VulkanDevice.CreateBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
@@ -75,30 +99,17 @@ bool VulkanMesh::CreateBuffers() noexcept
 		return false;
 	}
 
-	// Copy the staging buffer to the vertex buffer.
-	if (!G_VulkanDevice.CopyBuffer(stagingBuffer, m_Vbo, G_VulkanDevice.GetQueue(QueueFamily::TRANSFER))) {
+	// The vertices are copied to the uploader's staging ring right away,
+	// the copy to the vertex buffer is submitted with the uploader's next batch.
+	if (!uploader.UploadBuffer(m_Vbo, vertexData, vertexBufferSize)) {
 		ERROR_LOG("| VulkanMesh buffer creation failed:");
-		ERROR_LOG("|-- Failed to transfer data from the staging buffer to the vertex buffer");
+		ERROR_LOG("|-- Failed to upload the vertex data.");
 		return false;
 	}
 
 	ui64 indexBufferSize{ static_cast<ui64>(sizeof(ui32) * GetIndices().size()) };
 
 	if (indexBufferSize) {
-		//Cleanup the staging buffer to re-use it for the index buffer.
-		stagingBuffer.CleanUp();
-
-		// Re-create the staging buffer with the index data.
-		if (!G_VulkanDevice.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		                                 stagingBuffer,
-		                                 indexBufferSize,
-		                                 GetIndexDataPtr())) {
-			ERROR_LOG("| VulkanMesh buffer creation failed:");
-			ERROR_LOG("|-- Failed to create staging buffer.");
-			return false;
-		}
-
 		// Create the index buffer.
 		if (!G_VulkanDevice.CreateBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 		                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
@@ -110,19 +121,17 @@ bool VulkanMesh::CreateBuffers() noexcept
 			return false;
 		}
 
-		if (!G_VulkanDevice.CopyBuffer(stagingBuffer, m_Ibo, G_VulkanDevice.GetQueue(QueueFamily::TRANSFER))) {
+		if (!uploader.UploadBuffer(m_Ibo, GetIndexDataPtr(), indexBufferSize)) {
 			ERROR_LOG("| VulkanMesh buffer creation failed:");
-			ERROR_LOG("|-- Failed to transfer data from the staging buffer to the index buffer");
+			ERROR_LOG("|-- Failed to upload the index data.");
 			return false;
 		}
 	}
 
-	//The staging buffer goes out of scope and cleans up itself.
-
 	return true;
 }
 
-void VulkanMesh::Draw(VkCommandBuffer commandBuffer) noexcept
+void VulkanMesh::Draw(VkCommandBuffer commandBuffer, const ui32 instanceCount, const ui32 firstInstance) noexcept
 {
 	//Bind the vbo.
 	VkDeviceSize offsets{ 0 };
@@ -134,10 +143,31 @@ void VulkanMesh::Draw(VkCommandBuffer commandBuffer) noexcept
 		vkCmdBindIndexBuffer(commandBuffer, m_Ibo.buffer, 0, VK_INDEX_TYPE_UINT32);
 
 		// Record draw indexed command.
-		vkCmdDrawIndexed(commandBuffer, static_cast<ui32>(GetIndices().size()), 1, 0, 0, 0);
+		vkCmdDrawIndexed(commandBuffer, static_cast<ui32>(GetIndices().size()), instanceCount, 0, 0, firstInstance);
 	} else {
 		//the mesh has no indices, record simple draw command.
-		vkCmdDraw(commandBuffer, static_cast<ui32>(GetVertices().size()), 1, 0, 0);
+		vkCmdDraw(commandBuffer, static_cast<ui32>(GetVertices().size()), instanceCount, 0, firstInstance);
+	}
+}
+
+void VulkanMesh::DrawIndirect(VkCommandBuffer commandBuffer,
+                              VkBuffer indirectBuffer,
+                              const VkDeviceSize offset,
+                              const ui32 drawCount) noexcept
+{
+	VkDeviceSize offsets{ 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_Vbo.buffer, &offsets);
+	vkCmdBindIndexBuffer(commandBuffer, m_Ibo.buffer, 0, VK_INDEX_TYPE_UINT32);
+
+	constexpr auto stride = static_cast<ui32>(sizeof(VkDrawIndexedIndirectCommand));
+
+	if (G_VulkanDevice.GetEnabledFeatures().multiDrawIndirect) {
+		vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, offset, drawCount, stride);
+	} else {
+		// drawCount has to be 0 or 1 without multi draw indirect.
+		for (auto i = 0u; i < drawCount; ++i) {
+			vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, offset + i * stride, 1, stride);
+		}
 	}
 }
 
@@ -2,7 +2,7 @@
 #define VULKAN_MESH_H_
 
 #include <vulkan/vulkan.h>
-#include <array>
+#include <vector>
 #include "mesh.h"
 #include "vulkan_device.h"
 
@@ -15,13 +15,35 @@ private:
 	ui32 m_MaterialIndex{ 0 };
 
 public:
-	static VkVertexInputBindingDescription GetVertexInputBindingDescription() noexcept;
+	static VkVertexInputBindingDescription GetVertexInputBindingDescription(const VertexLayout& vertexLayout = VertexLayout{}) noexcept;
 
-	static std::array<VkVertexInputAttributeDescription, 5> GetVertexInputAttributeDescriptions() noexcept;
+	/**
+	 * \brief Returns a description for every attribute the layout stores, at the location of the attribute.
+	 */
+	static std::vector<VkVertexInputAttributeDescription> GetVertexInputAttributeDescriptions(const VertexLayout& vertexLayout = VertexLayout{}) noexcept;
 
+	/**
+	 * \brief Returns TRUE if the device can fetch every attribute format of the layout from a vertex buffer.
+	 */
+	static bool IsVertexLayoutSupported(const VertexLayout& vertexLayout) noexcept;
+
+	/**
+	 * \brief Converts the vertices to the vertex layout and queues the uploads of the vertices and indices.
+	 */
 	bool CreateBuffers() noexcept override;
 
-	void Draw(VkCommandBuffer commandBuffer) noexcept;
+	/**
+	 * \brief Records a draw of the mesh. gl_InstanceIndex starts at firstInstance in the shaders.
+	 */
+	void Draw(VkCommandBuffer commandBuffer, ui32 instanceCount = 1, ui32 firstInstance = 0) noexcept;
+
+	/**
+	 * \brief Records drawCount VkDrawIndexedIndirectCommand records stored in indirectBuffer at offset.
+	 * \details The commands index into this mesh's vertex and index buffers,
+	 * see Mesh::Append(). Without the multiDrawIndirect feature a separate
+	 * indirect draw is recorded for each command.
+	 */
+	void DrawIndirect(VkCommandBuffer commandBuffer, VkBuffer indirectBuffer, VkDeviceSize offset, ui32 drawCount) noexcept;
 
 	void SetMaterialIndex(const ui32 materialIndex) noexcept
 	{
@@ -0,0 +1,173 @@
+#include "vulkan_pipeline_builder.h"
+#include <algorithm>
+#include <atomic>
+#include "logger.h"
+#include "thread_pool.h"
+#include "timer.h"
+#include "vulkan_infrastructure_context.h"
+
+static void DestroyPipelines(std::vector<VkPipeline>& pipelines) noexcept
+{
+	for (auto& pipeline : pipelines) {
+		vkDestroyPipeline(G_VulkanDevice, pipeline, nullptr);
+		pipeline = VK_NULL_HANDLE;
+	}
+}
+
+// Private functions -------------------------------
+bool VulkanPipelineBuilder::BuildSerial(VkPipelineCache pipelineCache,
+                                        const std::vector<VkGraphicsPipelineCreateInfo>& createInfos,
+                                        std::vector<VkPipeline>& pipelines) noexcept
+{
+	// One call per pipeline, the same work the parallel path does per task.
+	for (auto i = 0u; i < createInfos.size(); ++i) {
+		const auto result = vkCreateGraphicsPipelines(G_VulkanDevice,
+		                                              pipelineCache,
+		                                              1,
+		                                              &createInfos[i],
+		                                              nullptr,
+		                                              &pipelines[i]);
+
+		if (result != VK_SUCCESS) {
+			ERROR_LOG("Failed to create pipeline " + std::to_string(i) + " of the batch.");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool VulkanPipelineBuilder::BuildParallel(ThreadPool& threadPool,
+                                          VkPipelineCache pipelineCache,
+                                          const std::vector<VkGraphicsPipelineCreateInfo>& createInfos,
+                                          std::vector<VkPipeline>& pipelines) noexcept
+{
+	const auto cacheCount = std::min(threadPool.GetWorkerCount(), createInfos.size());
+
+	// Seed every worker cache with what the destination already holds, otherwise
+	// a warm cache loaded from disk would only help the calling thread.
+	size_t initialDataSize{ 0 };
+	std::vector<ui8> initialData;
+
+	if (vkGetPipelineCacheData(G_VulkanDevice, pipelineCache, &initialDataSize, nullptr) == VK_SUCCESS) {
+		initialData.resize(initialDataSize);
+
+		if (vkGetPipelineCacheData(G_VulkanDevice, pipelineCache, &initialDataSize, initialData.data()) != VK_SUCCESS) {
+			initialData.clear();
+		}
+	}
+
+	VkPipelineCacheCreateInfo pipelineCacheCreateInfo{};
+	pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipelineCacheCreateInfo.initialDataSize = initialData.size();
+	pipelineCacheCreateInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+	std::vector<VkPipelineCache> workerCaches(cacheCount, VK_NULL_HANDLE);
+
+	for (auto& workerCache : workerCaches) {
+		if (vkCreatePipelineCache(G_VulkanDevice, &pipelineCacheCreateInfo, nullptr, &workerCache) != VK_SUCCESS) {
+			ERROR_LOG("Failed to create worker pipeline cache.");
+
+			for (const auto cache : workerCaches) {
+				vkDestroyPipelineCache(G_VulkanDevice, cache, nullptr);
+			}
+
+			return false;
+		}
+	}
+
+	std::atomic<bool> failed{ false };
+
+	TaskGroup group;
+
+	// The tasks are pinned, so a worker cache is only ever used by the worker that owns it.
+	for (auto i = 0u; i < createInfos.size(); ++i) {
+		const auto worker = i % cacheCount;
+
+		const auto* pCreateInfo = &createInfos[i];
+		auto* pPipeline = &pipelines[i];
+		auto workerCache = workerCaches[worker];
+		auto* pFailed = &failed;
+
+		threadPool.Run(group, static_cast<int>(worker), [pCreateInfo, pPipeline, workerCache, pFailed]() {
+			const auto result = vkCreateGraphicsPipelines(G_VulkanDevice,
+			                                              workerCache,
+			                                              1,
+			                                              pCreateInfo,
+			                                              nullptr,
+			                                              pPipeline);
+
+			if (result != VK_SUCCESS) {
+				pFailed->store(true, std::memory_order_relaxed);
+			}
+		});
+	}
+
+	threadPool.Wait(group);
+
+	// Keep whatever was compiled, even if part of the batch failed.
+	if (vkMergePipelineCaches(G_VulkanDevice, pipelineCache, cacheCount, workerCaches.data()) != VK_SUCCESS) {
+		ERROR_LOG("Failed to merge the worker pipeline caches.");
+	}
+
+	for (const auto cache : workerCaches) {
+		vkDestroyPipelineCache(G_VulkanDevice, cache, nullptr);
+	}
+
+	if (failed.load(std::memory_order_relaxed)) {
+		ERROR_LOG("Failed to create one or more pipelines of the batch.");
+		return false;
+	}
+
+	return true;
+}
+
+// -------------------------------------------------
+
+bool VulkanPipelineBuilder::Build(ThreadPool* pThreadPool,
+                                  VkPipelineCache pipelineCache,
+                                  const std::vector<VkGraphicsPipelineCreateInfo>& createInfos,
+                                  std::vector<VkPipeline>& pipelines) noexcept
+{
+	pipelines.assign(createInfos.size(), VK_NULL_HANDLE);
+
+	if (createInfos.empty()) {
+		return true;
+	}
+
+	Timer timer;
+	timer.Start();
+
+	const auto parallel = pThreadPool && pThreadPool->GetWorkerCount() > 1;
+
+	const auto result = parallel
+		                    ? BuildParallel(*pThreadPool, pipelineCache, createInfos, pipelines)
+		                    : BuildSerial(pipelineCache, createInfos, pipelines);
+
+	timer.Stop();
+
+	if (!result) {
+		DestroyPipelines(pipelines);
+		return false;
+	}
+
+	const auto buildTime = static_cast<f32>(timer.GetSec() * 1000.0);
+
+	m_BuildTime += buildTime;
+	m_PipelineCount += pipelines.size();
+
+	LOG("Built " + std::to_string(pipelines.size()) + " pipelines in " + std::to_string(buildTime) + " ms on " +
+		std::to_string(parallel ? std::min(pThreadPool->GetWorkerCount(), createInfos.size()) : 1) + " thread(s).");
+
+	return true;
+}
+
+f32 VulkanPipelineBuilder::GetBuildTime() const noexcept
+{
+	return m_BuildTime;
+}
+
+size_t VulkanPipelineBuilder::GetPipelineCount() const noexcept
+{
+	return m_PipelineCount;
+}
@@ -0,0 +1,54 @@
+#ifndef VULKAN_PIPELINE_BUILDER_H_
+#define VULKAN_PIPELINE_BUILDER_H_
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include "types.h"
+
+class ThreadPool;
+
+/**
+ * \brief Compiles batches of graphics pipelines, optionally across the workers of a ThreadPool.
+ * \details Every worker compiles into its own VkPipelineCache, seeded with the data of
+ * the destination cache, so the workers never contend on a cache. Once the batch is done
+ * the worker caches are merged into the destination with vkMergePipelineCaches.
+ */
+class VulkanPipelineBuilder {
+private:
+	f32 m_BuildTime{ 0.0f };
+
+	size_t m_PipelineCount{ 0 };
+
+	bool BuildSerial(VkPipelineCache pipelineCache,
+	                 const std::vector<VkGraphicsPipelineCreateInfo>& createInfos,
+	                 std::vector<VkPipeline>& pipelines) noexcept;
+
+	bool BuildParallel(ThreadPool& threadPool,
+	                   VkPipelineCache pipelineCache,
+	                   const std::vector<VkGraphicsPipelineCreateInfo>& createInfos,
+	                   std::vector<VkPipeline>& pipelines) noexcept;
+
+public:
+	/**
+	 * \brief Creates one pipeline for every create info, pipelines[i] is built from createInfos[i].
+	 * \details Without a thread pool the pipelines are compiled one after the other on the
+	 * calling thread, directly into pipelineCache. Everything the create infos point to has
+	 * to stay alive until the call returns. On failure no pipeline of the batch is kept.
+	 */
+	bool Build(ThreadPool* pThreadPool,
+	           VkPipelineCache pipelineCache,
+	           const std::vector<VkGraphicsPipelineCreateInfo>& createInfos,
+	           std::vector<VkPipeline>& pipelines) noexcept;
+
+	/**
+	 * \brief Wall clock time spent in Build() so far, in milliseconds.
+	 */
+	f32 GetBuildTime() const noexcept;
+
+	/**
+	 * \brief Number of pipelines created by Build() so far.
+	 */
+	size_t GetPipelineCount() const noexcept;
+};
+
+#endif //VULKAN_PIPELINE_BUILDER_H_
@@ -1,24 +1,194 @@
 #include "vulkan_pipeline_cache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include "logger.h"
 #include "vulkan_infrastructure_context.h"
 
+/**
+ * \brief Prepended to the data returned by vkGetPipelineCacheData so that
+ * truncated or damaged files are detected before the driver sees them.
+ */
+struct PipelineCacheFileHeader {
+	ui32 magic;
+	ui32 version;
+	ui64 dataSize;
+	ui64 checksum;
+};
+
+static constexpr ui32 s_PipelineCacheFileMagic{ 0x43504B56 }; // "VKPC"
+static constexpr ui32 s_PipelineCacheFileVersion{ 1 };
+
+// Size of VkPipelineCacheHeaderVersionOne: length, version, vendorID, deviceID and the UUID.
+static constexpr size_t s_PipelineCacheHeaderSize{ 4 * sizeof(ui32) + VK_UUID_SIZE };
+
+// FNV-1a
+static ui64 Checksum(const ui8* data, const size_t size) noexcept
+{
+	ui64 hash{ 14695981039346656037ull };
+
+	for (auto i = 0u; i < size; ++i) {
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+// Private functions -------------------------------
+std::vector<ui8> VulkanPipelineCache::LoadFromFile() const noexcept
+{
+	std::ifstream stream{ m_FileName, std::ios::binary | std::ios::ate };
+
+	if (!stream.is_open()) {
+		LOG("No pipeline cache data in " + m_FileName + ", starting with an empty cache.");
+		return {};
+	}
+
+	const auto fileSize = static_cast<size_t>(stream.tellg());
+	stream.seekg(0);
+
+	PipelineCacheFileHeader fileHeader{};
+
+	if (fileSize < sizeof fileHeader || !stream.read(reinterpret_cast<char*>(&fileHeader), sizeof fileHeader)) {
+		ERROR_LOG("Pipeline cache file " + m_FileName + " is truncated, ignoring it.");
+		return {};
+	}
+
+	if (fileHeader.magic != s_PipelineCacheFileMagic || fileHeader.version != s_PipelineCacheFileVersion) {
+		ERROR_LOG("Pipeline cache file " + m_FileName + " has an unknown format, ignoring it.");
+		return {};
+	}
+
+	if (fileHeader.dataSize != fileSize - sizeof fileHeader || fileHeader.dataSize < s_PipelineCacheHeaderSize) {
+		ERROR_LOG("Pipeline cache file " + m_FileName + " has the wrong size, ignoring it.");
+		return {};
+	}
+
+	std::vector<ui8> data(fileHeader.dataSize);
+
+	if (!stream.read(reinterpret_cast<char*>(data.data()), data.size()) ||
+		Checksum(data.data(), data.size()) != fileHeader.checksum) {
+		ERROR_LOG("Pipeline cache file " + m_FileName + " is corrupt, ignoring it.");
+		return {};
+	}
+
+	// The data starts with a VkPipelineCacheHeaderVersionOne, which the driver only
+	// accepts if it was written by the same device and driver build.
+	ui32 headerFields[4];
+	memcpy(headerFields, data.data(), sizeof headerFields);
+
+	const auto& properties = G_VulkanDevice.GetPhysicalDevice().properties;
+
+	if (headerFields[0] < s_PipelineCacheHeaderSize ||
+		headerFields[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+		headerFields[2] != properties.vendorID ||
+		headerFields[3] != properties.deviceID ||
+		memcmp(data.data() + sizeof headerFields, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+		LOG("Pipeline cache data in " + m_FileName + " is from another device or driver, starting with an empty cache.");
+		return {};
+	}
+
+	return data;
+}
+
+// -------------------------------------------------
+
 VulkanPipelineCache::~VulkanPipelineCache()
 {
 	LOG("Cleaning up VulkanPipelineCache");
+
+	if (m_PipelineCache && !m_FileName.empty()) {
+		Save();
+	}
+
 	vkDestroyPipelineCache(G_VulkanDevice, m_PipelineCache, nullptr);
 }
 
-bool VulkanPipelineCache::Create() noexcept
+bool VulkanPipelineCache::Create(const std::string& name) noexcept
 {
+	std::vector<ui8> initialData;
+
+	if (!name.empty()) {
+		const auto& properties = G_VulkanDevice.GetPhysicalDevice().properties;
+
+		m_FileName = name + "_" + std::to_string(properties.vendorID) + "_" + std::to_string(properties.deviceID) +
+				".pipeline_cache";
+
+		initialData = LoadFromFile();
+	}
+
 	VkPipelineCacheCreateInfo pipelineCacheCreateInfo{};
 	pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipelineCacheCreateInfo.initialDataSize = initialData.size();
+	pipelineCacheCreateInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
 	VkResult result{ vkCreatePipelineCache(G_VulkanDevice, &pipelineCacheCreateInfo, nullptr, &m_PipelineCache) };
 
+	// Drivers may still refuse data that passed the checks above. Fall back to an empty cache.
+	if (result != VK_SUCCESS && !initialData.empty()) {
+		ERROR_LOG("The driver rejected the pipeline cache data in " + m_FileName + ", starting with an empty cache.");
+
+		pipelineCacheCreateInfo.initialDataSize = 0;
+		pipelineCacheCreateInfo.pInitialData = nullptr;
+		result = vkCreatePipelineCache(G_VulkanDevice, &pipelineCacheCreateInfo, nullptr, &m_PipelineCache);
+	}
+
 	if (result != VK_SUCCESS) {
 		ERROR_LOG("Failed to create pipeline cache.");
 		return false;
 	}
 
+	if (!initialData.empty()) {
+		LOG("Loaded " + std::to_string(initialData.size()) + " bytes of pipeline cache data from " + m_FileName + ".");
+	}
+
+	return true;
+}
+
+bool VulkanPipelineCache::Save() const noexcept
+{
+	size_t dataSize{ 0 };
+
+	if (vkGetPipelineCacheData(G_VulkanDevice, m_PipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) {
+		ERROR_LOG("Failed to get the pipeline cache data size.");
+		return false;
+	}
+
+	std::vector<ui8> data(dataSize);
+
+	if (vkGetPipelineCacheData(G_VulkanDevice, m_PipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+		ERROR_LOG("Failed to get the pipeline cache data.");
+		return false;
+	}
+
+	PipelineCacheFileHeader fileHeader{};
+	fileHeader.magic = s_PipelineCacheFileMagic;
+	fileHeader.version = s_PipelineCacheFileVersion;
+	fileHeader.dataSize = dataSize;
+	fileHeader.checksum = Checksum(data.data(), dataSize);
+
+	// Write to a temporary file first, an interrupted write must not leave a half written cache behind.
+	const auto tempFileName = m_FileName + ".tmp";
+
+	{
+		std::ofstream stream{ tempFileName, std::ios::binary | std::ios::trunc };
+
+		if (!stream.write(reinterpret_cast<const char*>(&fileHeader), sizeof fileHeader) ||
+			!stream.write(reinterpret_cast<const char*>(data.data()), dataSize)) {
+			ERROR_LOG("Failed to write the pipeline cache file " + tempFileName + ".");
+			return false;
+		}
+	}
+
+	std::remove(m_FileName.c_str());
+
+	if (std::rename(tempFileName.c_str(), m_FileName.c_str()) != 0) {
+		ERROR_LOG("Failed to replace the pipeline cache file " + m_FileName + ".");
+		return false;
+	}
+
+	LOG("Saved " + std::to_string(dataSize) + " bytes of pipeline cache data to " + m_FileName + ".");
+
 	return true;
 }
 
@@ -2,15 +2,42 @@
 #define VULKAN_PIPELINE_CACHE_H_
 
 #include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include "types.h"
 
 class VulkanPipelineCache {
 private:
 	VkPipelineCache m_PipelineCache{ VK_NULL_HANDLE };
 
+	/**
+	 * \brief Where the cache data is loaded from and saved to. Empty if the cache is not persistent.
+	 */
+	std::string m_FileName;
+
+	/**
+	 * \brief Reads the cache data saved by a previous run.
+	 * \return The data, or nothing if the file is missing, corrupt or was written by
+	 * another device or driver version.
+	 */
+	std::vector<ui8> LoadFromFile() const noexcept;
+
 public:
 	~VulkanPipelineCache();
 
-	bool Create() noexcept;
+	/**
+	 * \brief Creates the pipeline cache.
+	 * \details If a name is given the cache is seeded with the data saved by the last run
+	 * of that name on the same device, and written back on destruction. The file name
+	 * contains the vendor and device IDs, and the header of the data has to match the
+	 * pipelineCacheUUID of the driver, so stale data is never passed to the driver.
+	 */
+	bool Create(const std::string& name = "") noexcept;
+
+	/**
+	 * \brief Writes the current cache data to the file of the cache.
+	 */
+	bool Save() const noexcept;
 
 	operator VkPipelineCache() const noexcept;
 };
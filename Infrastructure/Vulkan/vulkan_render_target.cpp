@@ -27,7 +27,7 @@ VulkanRenderTargetAttachment::~VulkanRenderTargetAttachment()
 {
 	vkDestroyImage(G_VulkanDevice, m_Image, nullptr);
 	vkDestroyImageView(G_VulkanDevice, m_ImageView, nullptr);
-	vkFreeMemory(G_VulkanDevice, m_Memory, nullptr);
+	G_VulkanDevice.FreeMemory(m_Memory);
 }
 
 bool VulkanRenderTargetAttachment::HasDepth() const
@@ -107,27 +107,12 @@ bool VulkanRenderTargetAttachment::Create() noexcept
 		return false;
 	}
 
-	// Allocate memory for the image.
-	VkMemoryAllocateInfo memoryAllocateInfo{};
-	memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-
-	const VkMemoryRequirements memoryRequirements{ G_VulkanDevice.GetImageMemoryRequirements(m_Image) };
-
-	memoryAllocateInfo.allocationSize = memoryRequirements.size;
-	memoryAllocateInfo.memoryTypeIndex = G_VulkanDevice.GetMemoryTypeIndex(memoryRequirements.memoryTypeBits,
-	                                                                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	result = vkAllocateMemory(G_VulkanDevice, &memoryAllocateInfo, nullptr, &m_Memory);
-
-	if (result != VK_SUCCESS) {
+	// Allocate memory for the image and bind it.
+	if (!G_VulkanDevice.AllocateImageMemory(m_Image,
+	                                        imageCreateInfo.tiling,
+	                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+	                                        m_Memory)) {
 		ERROR_LOG("Failed to allocate memory for render target attachment image.");
-	}
-
-	// Bind the memory to the image
-	result = vkBindImageMemory(G_VulkanDevice, m_Image, m_Memory, 0);
-
-	if (result != VK_SUCCESS) {
-		ERROR_LOG("Failed to bind memory for render target attachment image.");
 		return false;
 	}
 
@@ -299,10 +284,13 @@ bool VulkanRenderTarget::Create(const Vec2ui& size) noexcept
 	std::array<VkSubpassDependency, 2> subpassDependencies;
 	subpassDependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
 	subpassDependencies[0].dstSubpass = 0;
-	subpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	subpassDependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	subpassDependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	subpassDependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	// The depth attachment is shared by the frames in flight, so the depth tests
+	// also wait for the depth writes of the previous frame.
+	subpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	subpassDependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	subpassDependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	subpassDependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+	                                      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 	subpassDependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
 	subpassDependencies[1].srcSubpass = 0;
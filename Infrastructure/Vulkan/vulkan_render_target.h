@@ -3,6 +3,7 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include "types.h"
+#include "vulkan_memory_allocator.h"
 
 enum class AttachmentType {
 	COLOR,
@@ -13,7 +14,7 @@ class VulkanRenderTargetAttachment {
 private:
 	VkImage m_Image{ VK_NULL_HANDLE };
 
-	VkDeviceMemory m_Memory{ VK_NULL_HANDLE };
+	VulkanAllocation m_Memory;
 
 	VkImageView m_ImageView{ VK_NULL_HANDLE };
 
@@ -1,4 +1,5 @@
 #include <logger.h>
+#include <algorithm>
 #include "vulkan_texture.h"
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -6,34 +7,20 @@
 #include "stb_image.h"
 #include "vulkan_infrastructure_context.h"
 
-VulkanTexture::VulkanTexture(TextureType textureType,
-                             VkFormat format,
-                             VkImageAspectFlagBits imageAspectFlagBits)
-	: Texture{ textureType },
-	  m_Format{ format }
+static VkFormat GetVkFormat(const TextureFormat format) noexcept
 {
-	m_ImageAspectFlags |= imageAspectFlagBits;
-}
-
-VulkanTexture::~VulkanTexture()
-{
-	LOG("Cleaning up VulkanTexture");
-	vkDestroyImageView(G_VulkanDevice, m_ImageView, nullptr);
-	vkDestroyImage(G_VulkanDevice, m_Image, nullptr);
-	vkFreeMemory(G_VulkanDevice, m_ImageMemory, nullptr);
-}
-
-VkImageView VulkanTexture::GetImageView() const noexcept
-{
-	return m_ImageView;
-}
-
-VkImageLayout VulkanTexture::GetImageLayout() const noexcept
-{
-	return m_ImageLayout;
+	switch (format) {
+		case TextureFormat::BC1:
+			return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+		case TextureFormat::BC3:
+			return VK_FORMAT_BC3_UNORM_BLOCK;
+		default:
+			return VK_FORMAT_R8G8B8A8_UNORM;
+	}
 }
 
-bool VulkanTexture::Load(const std::string& fileName) noexcept
+// Private functions -------------------------------------------
+bool VulkanTexture::DecodeImage(const std::string& fileName) noexcept
 {
 	Vec2i size;
 	int colorChannels;
@@ -46,71 +33,99 @@ bool VulkanTexture::Load(const std::string& fileName) noexcept
 		          STBI_rgb_alpha)
 	};
 
-	m_Size = Vec2ui{ size.x, size.y };
-
-	VkDeviceSize imageSize{ static_cast<ui32>(size.x) * static_cast<ui32>(size.y) * 4 };
-
 	if (!pixels) {
 		ERROR_LOG("Failed to load image: " + fileName);
 		return false;
 	}
 
-	VulkanBuffer stagingBuffer;
+	m_Size = Vec2ui{ size.x, size.y };
 
-	if (!G_VulkanDevice.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-	                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-	                                 stagingBuffer,
-	                                 imageSize,
-	                                 pixels)) {
-		ERROR_LOG("Failed to create staging buffer.");
-		return false;
+	if (m_MipMode == TextureMipMode::NONE) {
+		m_MipChain.resize(1);
+		m_MipChain[0].size = m_Size;
+		m_MipChain[0].pixels.assign(pixels, pixels + GetTextureLevelBytes(TextureFormat::RGBA8, m_Size));
+	}
+	else {
+		m_MipChain = GenerateMipChain(pixels, m_Size);
 	}
 
 	//Data got copied. No need to keep it around.
 	stbi_image_free(pixels);
 
-	// Create the image
-	if (!G_VulkanDevice.CreateImage(m_Size,
-	                                VK_FORMAT_R8G8B8A8_UNORM, //make this a texture class member.
-	                                VK_IMAGE_TILING_OPTIMAL,
-	                                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-	                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-	                                m_Image,
-	                                m_ImageMemory)) {
-		ERROR_LOG("Failed to create image.");
+	m_TextureFormat = TextureFormat::RGBA8;
+	m_MipLevels = static_cast<ui32>(m_MipChain.size());
+
+	return true;
+}
+
+bool VulkanTexture::LoadContainer(const std::string& fileName) noexcept
+{
+	if (!m_Container.Open(fileName)) {
 		return false;
 	}
 
-	// transition the image from the default pre-initialized layout to
-	// transfer destination optimal to copy the pixels from the staging buffer.
-	if (!G_VulkanDevice.TransitionImageLayout(m_Image,
-	                                          m_Format,
-	                                          m_ImageLayout,
-	                                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)) {
-		ERROR_LOG("Failed to transition image layout.");
+	const auto format = GetVkFormat(m_Container.GetFormat());
+
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(G_VulkanDevice.GetPhysicalDevice().device, format, &formatProperties);
+
+	if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+		ERROR_LOG("The device cannot sample the format of " + fileName + ", bake it as rgba8 instead.");
+		m_Container.Close();
 		return false;
 	}
 
-	m_ImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	m_Size = m_Container.GetSize();
+	m_Format = format;
+	m_TextureFormat = m_Container.GetFormat();
 
-	// Copy the data from the staging buffer to the image.
-	if (!G_VulkanDevice.CopyBufferToImage(stagingBuffer,
-	                                      m_Image,
-	                                      m_Size)) {
-		ERROR_LOG("Failed to copy buffer to image.");
-		return false;
+	// The baker always writes the whole chain, without mips only its base level is used.
+	m_MipLevels = m_MipMode == TextureMipMode::NONE ? 1 : m_Container.GetLevelCount();
+
+	return true;
+}
+
+void VulkanTexture::ReleaseSourceLevels() noexcept
+{
+	// The staging ring or the image has its own copy of the resident levels.
+	if (m_ResidentLevel) {
+		for (auto level = m_ResidentLevel; level < m_MipChain.size(); ++level) {
+			m_MipChain[level].pixels.clear();
+			m_MipChain[level].pixels.shrink_to_fit();
+		}
+
+		return;
 	}
 
-	// Transition the image layout to shader read only optimal for optimal shader sampling.
-	if (!G_VulkanDevice.TransitionImageLayout(m_Image,
-	                                          m_Format,
-	                                          m_ImageLayout,
-	                                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)) {
-		ERROR_LOG("Failed to transition image layout.");
-		return false;
+	m_MipChain.clear();
+	m_MipChain.shrink_to_fit();
+
+	m_Container.Close();
+}
+
+bool VulkanTexture::CreateResidentImage(const ui32 level) noexcept
+{
+	const auto levelCount = m_MipLevels - level;
+
+	// The image of a streamed texture is the source of the copies to its successor.
+	VkImageUsageFlags usage{ VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT };
+
+	if (m_MipMode == TextureMipMode::STREAMED) {
+		usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 	}
 
-	m_ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	// Create the image
+	if (!G_VulkanDevice.CreateImage(GetMipLevelSize(m_Size, level),
+	                                m_Format,
+	                                VK_IMAGE_TILING_OPTIMAL,
+	                                usage,
+	                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+	                                m_Image,
+	                                m_ImageMemory,
+	                                levelCount)) {
+		ERROR_LOG("Failed to create image.");
+		return false;
+	}
 
 	// Create the image view
 	VkImageViewCreateInfo viewInfo{};
@@ -120,7 +135,7 @@ bool VulkanTexture::Load(const std::string& fileName) noexcept
 	viewInfo.format = m_Format;
 	viewInfo.subresourceRange.aspectMask = m_ImageAspectFlags;
 	viewInfo.subresourceRange.baseMipLevel = 0;
-	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.levelCount = levelCount;
 	viewInfo.subresourceRange.baseArrayLayer = 0;
 	viewInfo.subresourceRange.layerCount = 1;
 
@@ -133,3 +148,216 @@ bool VulkanTexture::Load(const std::string& fileName) noexcept
 
 	return true;
 }
+
+bool VulkanTexture::UploadLevel(const ui32 chainLevel, const ui32 imageLevel) noexcept
+{
+	// The pixels are copied to the uploader's staging ring right away, for a container
+	// straight from the mapped file. The copy, and the transitions around it, are
+	// submitted with the uploader's next batch.
+	const auto data = m_Container.IsOpen() ? m_Container.GetLevelData(chainLevel) : m_MipChain[chainLevel].pixels.data();
+	const auto bytes = m_Container.IsOpen() ? m_Container.GetLevelBytes(chainLevel) : m_MipChain[chainLevel].pixels.size();
+
+	if (!G_VulkanDevice.GetUploader().UploadImage(m_Image,
+	                                              GetMipLevelSize(m_Size, chainLevel),
+	                                              data,
+	                                              bytes,
+	                                              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	                                              imageLevel)) {
+		ERROR_LOG("Failed to upload image.");
+		return false;
+	}
+
+	return true;
+}
+
+void VulkanTexture::DestroyImage(const VkImage image, VulkanAllocation& memory, const VkImageView view) const noexcept
+{
+	vkDestroyImageView(G_VulkanDevice, view, nullptr);
+	vkDestroyImage(G_VulkanDevice, image, nullptr);
+	G_VulkanDevice.FreeMemory(memory);
+}
+
+// -------------------------------------------------------------
+
+VulkanTexture::VulkanTexture(TextureType textureType,
+                             VkFormat format,
+                             VkImageAspectFlagBits imageAspectFlagBits,
+                             const TextureMipMode mipMode)
+	: Texture{ textureType },
+	  m_Format{ format },
+	  m_MipMode{ mipMode }
+{
+	m_ImageAspectFlags |= imageAspectFlagBits;
+}
+
+VulkanTexture::~VulkanTexture()
+{
+	LOG("Cleaning up VulkanTexture");
+	DestroyImage(m_Image, m_ImageMemory, m_ImageView);
+
+	for (auto& retired : m_RetiredImages) {
+		DestroyImage(retired.image, retired.memory, retired.view);
+	}
+}
+
+VkImageView VulkanTexture::GetImageView() const noexcept
+{
+	return m_ImageView;
+}
+
+VkImageLayout VulkanTexture::GetImageLayout() const noexcept
+{
+	return m_ImageLayout;
+}
+
+bool VulkanTexture::Load(const std::string& fileName) noexcept
+{
+	return Decode(fileName) && Upload(fileName);
+}
+
+bool VulkanTexture::Decode(const std::string& fileName) noexcept
+{
+	return TextureContainer::IsContainer(fileName) ? LoadContainer(fileName) : DecodeImage(fileName);
+}
+
+bool VulkanTexture::Upload(const std::string& fileName) noexcept
+{
+	// A streamed texture starts out with the levels up to STREAMED_INITIAL_SIZE.
+	auto level = 0u;
+
+	if (m_MipMode == TextureMipMode::STREAMED) {
+		while (level + 1 < m_MipLevels) {
+			const auto size = GetMipLevelSize(m_Size, level);
+
+			if (std::max(size.x, size.y) <= STREAMED_INITIAL_SIZE) {
+				break;
+			}
+
+			++level;
+		}
+	}
+
+	if (!CreateResidentImage(level)) {
+		return false;
+	}
+
+	// Level 0 of the image is level "level" of the chain.
+	for (auto chainLevel = level; chainLevel < m_MipLevels; ++chainLevel) {
+		if (!UploadLevel(chainLevel, chainLevel - level)) {
+			return false;
+		}
+	}
+
+	m_ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	m_ResidentLevel = level;
+
+	ReleaseSourceLevels();
+
+	return true;
+}
+
+ui32 VulkanTexture::GetMipLevels() const noexcept
+{
+	return m_MipLevels;
+}
+
+ui32 VulkanTexture::GetResidentLevel() const noexcept
+{
+	return m_ResidentLevel;
+}
+
+TextureFormat VulkanTexture::GetTextureFormat() const noexcept
+{
+	return m_TextureFormat;
+}
+
+VkDeviceSize VulkanTexture::GetResidentBytes() const noexcept
+{
+	VkDeviceSize bytes{ 0 };
+
+	for (auto level = m_ResidentLevel; level < m_MipLevels; ++level) {
+		bytes += GetTextureLevelBytes(m_TextureFormat, GetMipLevelSize(m_Size, level));
+	}
+
+	return bytes;
+}
+
+VkDeviceSize VulkanTexture::GetNextLevelBytes() const noexcept
+{
+	if (!m_ResidentLevel) {
+		return 0;
+	}
+
+	return GetTextureLevelBytes(m_TextureFormat, GetMipLevelSize(m_Size, m_ResidentLevel - 1));
+}
+
+bool VulkanTexture::StreamNextLevel(const ui64 frameNumber) noexcept
+{
+	if (m_MipMode != TextureMipMode::STREAMED || !m_ResidentLevel) {
+		return false;
+	}
+
+	RetiredImage retired{};
+	retired.image = m_Image;
+	retired.memory = m_ImageMemory;
+	retired.view = m_ImageView;
+	retired.retiredAt = frameNumber;
+
+	m_Image = VK_NULL_HANDLE;
+	m_ImageMemory = VulkanAllocation{};
+	m_ImageView = VK_NULL_HANDLE;
+
+	const auto level = m_ResidentLevel - 1;
+
+	// Only the new level comes from the CPU. The resident ones move one level down
+	// in the new image and are copied there from the old one on the GPU.
+	const auto streamed = CreateResidentImage(level) &&
+	                      UploadLevel(level, 0) &&
+	                      G_VulkanDevice.GetUploader().CopyImageLevels(retired.image,
+	                                                                   0,
+	                                                                   m_Image,
+	                                                                   1,
+	                                                                   m_MipLevels - m_ResidentLevel,
+	                                                                   GetMipLevelSize(m_Size, m_ResidentLevel));
+
+	if (!streamed) {
+		// Uploads to the new image may already be recorded, so it is retired
+		// as well and the old one stays in use.
+		RetiredImage failed{};
+		failed.image = m_Image;
+		failed.memory = m_ImageMemory;
+		failed.view = m_ImageView;
+		failed.retiredAt = frameNumber;
+
+		m_RetiredImages.push_back(failed);
+
+		m_Image = retired.image;
+		m_ImageMemory = retired.memory;
+		m_ImageView = retired.view;
+
+		return false;
+	}
+
+	m_RetiredImages.push_back(retired);
+
+	m_ResidentLevel = level;
+
+	ReleaseSourceLevels();
+
+	return true;
+}
+
+void VulkanTexture::ReleaseRetiredImages(const ui64 completedFrameNumber) noexcept
+{
+	auto it = m_RetiredImages.begin();
+
+	while (it != m_RetiredImages.end()) {
+		if (it->retiredAt > completedFrameNumber) {
+			++it;
+			continue;
+		}
+
+		DestroyImage(it->image, it->memory, it->view);
+		it = m_RetiredImages.erase(it);
+	}
+}
@@ -2,14 +2,30 @@
 #define VULKAN_TEXTURE_H_
 
 #include <vulkan/vulkan.h>
+#include <vector>
 #include "texture.h"
+#include "texture_container.h"
+#include "texture_utilities.h"
 #include "vulkan_device.h"
 
 class VulkanTexture : public Texture {
 private:
+	/**
+	 * \brief An image replaced by StreamNextLevel() that frames in flight may still sample.
+	 */
+	struct RetiredImage {
+		VkImage image{ VK_NULL_HANDLE };
+
+		VulkanAllocation memory;
+
+		VkImageView view{ VK_NULL_HANDLE };
+
+		ui64 retiredAt{ 0 };
+	};
+
 	VkImage m_Image{ VK_NULL_HANDLE };
 
-	VkDeviceMemory m_ImageMemory{ VK_NULL_HANDLE };
+	VulkanAllocation m_ImageMemory;
 
 	VkImageView m_ImageView{ VK_NULL_HANDLE };
 
@@ -21,10 +37,73 @@ private:
 
 	Vec2ui m_Size;
 
+	TextureFormat m_TextureFormat{ TextureFormat::RGBA8 };
+
+	TextureMipMode m_MipMode{ TextureMipMode::NONE };
+
+	/**
+	 * \brief Levels of the whole chain, resident or not.
+	 */
+	ui32 m_MipLevels{ 1 };
+
+	/**
+	 * \brief The largest level that is resident. The image holds this level and every smaller one.
+	 */
+	ui32 m_ResidentLevel{ 0 };
+
+	/**
+	 * \brief The chain a streamed texture makes resident from. The pixels of a level are freed once it is resident.
+	 */
+	std::vector<MipLevel> m_MipChain;
+
+	/**
+	 * \brief Replaces m_MipChain when the texture is loaded from a baked container. Closed once level 0 is resident.
+	 */
+	TextureContainer m_Container;
+
+	std::vector<RetiredImage> m_RetiredImages;
+
+	/**
+	 * \brief Decodes the image and builds the chain the mip mode needs in m_MipChain.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool DecodeImage(const std::string& fileName) noexcept;
+
+	/**
+	 * \brief Maps a container written by the texture baker into m_Container.
+	 * \return TRUE if successful, FALSE otherwise or if the device cannot sample its format.
+	 */
+	bool LoadContainer(const std::string& fileName) noexcept;
+
+	/**
+	 * \brief Frees the pixels of the resident levels, and the whole source once level 0 is resident.
+	 */
+	void ReleaseSourceLevels() noexcept;
+
+	/**
+	 * \brief Creates the image and the view that hold the levels of the chain from level down.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool CreateResidentImage(ui32 level) noexcept;
+
+	/**
+	 * \brief Queues the upload of a level of the chain to imageLevel of the image on the uploader.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool UploadLevel(ui32 chainLevel, ui32 imageLevel) noexcept;
+
+	void DestroyImage(VkImage image, VulkanAllocation& memory, VkImageView view) const noexcept;
+
 public:
+	/**
+	 * \brief The largest level of a streamed texture that is resident once it is loaded.
+	 */
+	static constexpr ui32 STREAMED_INITIAL_SIZE{ 64 };
+
 	explicit VulkanTexture(TextureType textureType,
 	                       VkFormat format,
-	                       VkImageAspectFlagBits imageAspectFlagBits);
+	                       VkImageAspectFlagBits imageAspectFlagBits,
+	                       TextureMipMode mipMode = TextureMipMode::NONE);
 
 	~VulkanTexture() override;
 
@@ -32,7 +111,54 @@ public:
 
 	VkImageLayout GetImageLayout() const noexcept;
 
+	/**
+	 * \brief Loads an image, or a container written by the texture baker if fileName has its extension.
+	 * \details The format of a container replaces the one the texture was created with.
+	 */
 	bool Load(const std::string& fileName) noexcept override;
+
+	/**
+	 * \brief Decodes the image, or maps the container. Safe to call on a worker thread.
+	 */
+	bool Decode(const std::string& fileName) noexcept override;
+
+	/**
+	 * \brief Creates the image and queues the uploads of the resident levels on the uploader.
+	 */
+	bool Upload(const std::string& fileName) noexcept override;
+
+	ui32 GetMipLevels() const noexcept;
+
+	ui32 GetResidentLevel() const noexcept;
+
+	TextureFormat GetTextureFormat() const noexcept;
+
+	/**
+	 * \brief Returns the size of the pixels of the resident levels.
+	 */
+	VkDeviceSize GetResidentBytes() const noexcept;
+
+	/**
+	 * \brief Returns how much GetResidentBytes() grows by with the next StreamNextLevel(), 0 if every level is resident.
+	 */
+	VkDeviceSize GetNextLevelBytes() const noexcept;
+
+	/**
+	 * \brief Makes the next larger level of a streamed texture resident.
+	 * \details The image is recreated with one more level. Only the new level is uploaded,
+	 * the resident ones are copied from the old image on the GPU. Both go through the
+	 * uploader, so the new view only replaces the old one once the uploader is flushed.
+	 * Descriptors that refer to the old view have to be rewritten. The old image is kept
+	 * until ReleaseRetiredImages() is called with a frame at or after frameNumber.
+	 * \param frameNumber The frame the old image was last used by.
+	 * \return TRUE if a level was made resident, FALSE if every level already was or it failed.
+	 */
+	bool StreamNextLevel(ui64 frameNumber) noexcept;
+
+	/**
+	 * \brief Destroys the images retired at or before completedFrameNumber.
+	 */
+	void ReleaseRetiredImages(ui64 completedFrameNumber) noexcept;
 };
 
 #endif //VULKAN_TEXTURE_H_
@@ -0,0 +1,370 @@
+#include "vulkan_timeline.h"
+#include <iterator>
+#include "logger.h"
+#include "vulkan_device.h"
+
+// Private functions -------------------------------------------
+VulkanTimeline::ReleasedWork::~ReleasedWork()
+{
+	for (auto& release : work) {
+		release();
+	}
+}
+
+VulkanTimeline::Queue& VulkanTimeline::GetQueue(const QueueFamily queueFamily) noexcept
+{
+	switch (queueFamily) {
+		case QueueFamily::TRANSFER:
+			return m_Queues[1];
+		case QueueFamily::COMPUTE:
+			return m_Queues[2];
+		default:
+			return m_Queues[0];
+	}
+}
+
+VkFence VulkanTimeline::AcquireFence() noexcept
+{
+	if (!m_FreeFences.empty()) {
+		const auto fence = m_FreeFences.back();
+		m_FreeFences.pop_back();
+
+		return fence;
+	}
+
+	VkFenceCreateInfo fenceCreateInfo{};
+	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+	VkFence fence{ VK_NULL_HANDLE };
+
+	if (vkCreateFence(*m_pDevice, &fenceCreateInfo, nullptr, &fence) != VK_SUCCESS) {
+		ERROR_LOG("Failed to create timeline fence.");
+		return VK_NULL_HANDLE;
+	}
+
+	return fence;
+}
+
+VkSemaphore VulkanTimeline::AcquireSemaphore() noexcept
+{
+	if (!m_FreeSemaphores.empty()) {
+		const auto semaphore = m_FreeSemaphores.back();
+		m_FreeSemaphores.pop_back();
+
+		return semaphore;
+	}
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo{};
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	VkSemaphore semaphore{ VK_NULL_HANDLE };
+
+	if (vkCreateSemaphore(*m_pDevice, &semaphoreCreateInfo, nullptr, &semaphore) != VK_SUCCESS) {
+		ERROR_LOG("Failed to create timeline semaphore.");
+		return VK_NULL_HANDLE;
+	}
+
+	return semaphore;
+}
+
+bool VulkanTimeline::Retire(Queue& queue, ReleasedWork& released) noexcept
+{
+	while (!queue.pendingSubmissions.empty()) {
+		auto& submission = queue.pendingSubmissions.front();
+
+		const auto status = vkGetFenceStatus(*m_pDevice, submission.fence);
+
+		if (status == VK_NOT_READY) {
+			break;
+		}
+
+		if (status != VK_SUCCESS) {
+			ERROR_LOG("Failed to get the status of a timeline fence.");
+			return false;
+		}
+
+		if (vkResetFences(*m_pDevice, 1, &submission.fence) != VK_SUCCESS) {
+			ERROR_LOG("Failed to reset timeline fence.");
+			return false;
+		}
+
+		m_FreeFences.push_back(submission.fence);
+
+		// The waits of the submission have executed, so its semaphores are unsignaled again.
+		m_FreeSemaphores.insert(m_FreeSemaphores.end(),
+		                        submission.consumedSemaphores.cbegin(),
+		                        submission.consumedSemaphores.cend());
+
+		queue.completedValue = submission.value;
+		queue.pendingSubmissions.pop_front();
+	}
+
+	// The work is recycled in value order, so it stops at the first value not reached yet.
+	while (!queue.recycleQueue.empty() && queue.recycleQueue.front().first <= queue.completedValue) {
+		released.work.push_back(std::move(queue.recycleQueue.front().second));
+		queue.recycleQueue.pop_front();
+	}
+
+	return true;
+}
+
+bool VulkanTimeline::WaitLocked(Queue& queue,
+                                const ui64 value,
+                                const ui64 timeout,
+                                ReleasedWork& released) noexcept
+{
+	if (value >= queue.nextValue) {
+		ERROR_LOG("Cannot wait for a timeline value that was never submitted.");
+		return false;
+	}
+
+	if (value <= queue.completedValue) {
+		return true;
+	}
+
+	// Values map one to one to submissions, so the submission of value is found by its distance from the oldest.
+	const auto& submission = queue.pendingSubmissions[value - queue.pendingSubmissions.front().value];
+
+	const auto result = vkWaitForFences(*m_pDevice, 1, &submission.fence, VK_TRUE, timeout);
+
+	if (result == VK_TIMEOUT) {
+		return false;
+	}
+
+	if (result != VK_SUCCESS) {
+		ERROR_LOG("Wait for timeline fence failed.");
+		return false;
+	}
+
+	return Retire(queue, released);
+}
+
+// -------------------------------------------------------------
+
+VulkanTimeline::~VulkanTimeline()
+{
+	LOG("Cleaning up VulkanTimeline");
+	CleanUp();
+}
+
+bool VulkanTimeline::Initialize(const VulkanDevice& device) noexcept
+{
+	m_pDevice = &device;
+
+	GetQueue(QueueFamily::GRAPHICS).queue = device.GetQueue(QueueFamily::GRAPHICS);
+	GetQueue(QueueFamily::TRANSFER).queue = device.GetQueue(QueueFamily::TRANSFER);
+	GetQueue(QueueFamily::COMPUTE).queue = device.GetQueue(QueueFamily::COMPUTE);
+
+	return true;
+}
+
+ui64 VulkanTimeline::Submit(const QueueFamily queueFamily,
+                            const std::vector<VkCommandBuffer>& commandBuffers,
+                            const std::vector<VulkanTimelineWait>& waits,
+                            const bool chained) noexcept
+{
+	ReleasedWork released;
+
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	auto& queue = GetQueue(queueFamily);
+
+	if (!queue.queue) {
+		ERROR_LOG("The timeline queue was not created with the device.");
+		return 0;
+	}
+
+	std::vector<VkSemaphore> waitSemaphores;
+	std::vector<VkPipelineStageFlags> waitStageMasks;
+
+	for (const auto& wait : waits) {
+		auto& waitQueue = GetQueue(wait.queue);
+
+		// A chained value is waited for on the GPU, the semaphore can only be consumed once.
+		const auto chainSemaphore = waitQueue.chainSemaphores.find(wait.value);
+
+		if (chainSemaphore != waitQueue.chainSemaphores.end()) {
+			waitSemaphores.push_back(chainSemaphore->second);
+			waitStageMasks.push_back(wait.stageMask);
+
+			waitQueue.chainSemaphores.erase(chainSemaphore);
+
+			continue;
+		}
+
+		// Submissions to the same queue already execute in order.
+		if (&waitQueue == &queue) {
+			continue;
+		}
+
+		if (!Retire(waitQueue, released)) {
+			return 0;
+		}
+
+		if (wait.value <= waitQueue.completedValue) {
+			continue;
+		}
+
+		if (!WaitLocked(waitQueue, wait.value, std::numeric_limits<ui64>::max(), released)) {
+			return 0;
+		}
+	}
+
+	const auto fence = AcquireFence();
+
+	if (!fence) {
+		return 0;
+	}
+
+	VkSemaphore signalSemaphore{ VK_NULL_HANDLE };
+
+	if (chained) {
+		signalSemaphore = AcquireSemaphore();
+
+		if (!signalSemaphore) {
+			m_FreeFences.push_back(fence);
+			return 0;
+		}
+	}
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.waitSemaphoreCount = static_cast<ui32>(waitSemaphores.size());
+	submitInfo.pWaitSemaphores = waitSemaphores.data();
+	submitInfo.pWaitDstStageMask = waitStageMasks.data();
+	submitInfo.commandBufferCount = static_cast<ui32>(commandBuffers.size());
+	submitInfo.pCommandBuffers = commandBuffers.data();
+	submitInfo.signalSemaphoreCount = chained ? 1 : 0;
+	submitInfo.pSignalSemaphores = &signalSemaphore;
+
+	if (vkQueueSubmit(queue.queue, 1, &submitInfo, fence) != VK_SUCCESS) {
+		ERROR_LOG("Timeline submission failed.");
+
+		m_FreeFences.push_back(fence);
+
+		if (signalSemaphore) {
+			m_FreeSemaphores.push_back(signalSemaphore);
+		}
+
+		return 0;
+	}
+
+	Submission submission{};
+	submission.value = queue.nextValue++;
+	submission.fence = fence;
+	submission.consumedSemaphores = std::move(waitSemaphores);
+
+	if (chained) {
+		queue.chainSemaphores[submission.value] = signalSemaphore;
+	}
+
+	queue.pendingSubmissions.push_back(std::move(submission));
+
+	return queue.nextValue - 1;
+}
+
+bool VulkanTimeline::Wait(const QueueFamily queueFamily, const ui64 value, const ui64 timeout) noexcept
+{
+	ReleasedWork released;
+
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	return WaitLocked(GetQueue(queueFamily), value, timeout, released);
+}
+
+bool VulkanTimeline::WaitIdle() noexcept
+{
+	ReleasedWork released;
+
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	for (auto& queue : m_Queues) {
+		if (queue.nextValue > 1 && !WaitLocked(queue, queue.nextValue - 1, std::numeric_limits<ui64>::max(), released)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+ui64 VulkanTimeline::GetCompletedValue(const QueueFamily queueFamily) noexcept
+{
+	ReleasedWork released;
+
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	auto& queue = GetQueue(queueFamily);
+
+	Retire(queue, released);
+
+	return queue.completedValue;
+}
+
+ui64 VulkanTimeline::GetLastSubmittedValue(const QueueFamily queueFamily) noexcept
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	return GetQueue(queueFamily).nextValue - 1;
+}
+
+void VulkanTimeline::Recycle(const QueueFamily queueFamily, const ui64 value, std::function<void()> release) noexcept
+{
+	ReleasedWork released;
+
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	auto& queue = GetQueue(queueFamily);
+
+	if (value <= queue.completedValue) {
+		released.work.push_back(std::move(release));
+		return;
+	}
+
+	// Keep the queue sorted by value, the work is usually recycled at the latest value anyway.
+	auto it = queue.recycleQueue.end();
+
+	while (it != queue.recycleQueue.begin() && std::prev(it)->first > value) {
+		--it;
+	}
+
+	queue.recycleQueue.emplace(it, value, std::move(release));
+}
+
+void VulkanTimeline::CleanUp() noexcept
+{
+	if (!m_pDevice) {
+		return;
+	}
+
+	WaitIdle();
+
+	ReleasedWork released;
+
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	for (auto& queue : m_Queues) {
+		for (auto& recycled : queue.recycleQueue) {
+			released.work.push_back(std::move(recycled.second));
+		}
+
+		// Signaled and never waited for, destroying them is fine once the device is done with them.
+		for (const auto& chainSemaphore : queue.chainSemaphores) {
+			vkDestroySemaphore(*m_pDevice, chainSemaphore.second, nullptr);
+		}
+
+		queue = Queue{};
+	}
+
+	for (const auto fence : m_FreeFences) {
+		vkDestroyFence(*m_pDevice, fence, nullptr);
+	}
+
+	for (const auto semaphore : m_FreeSemaphores) {
+		vkDestroySemaphore(*m_pDevice, semaphore, nullptr);
+	}
+
+	m_FreeFences.clear();
+	m_FreeSemaphores.clear();
+
+	m_pDevice = nullptr;
+}
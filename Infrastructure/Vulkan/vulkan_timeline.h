@@ -0,0 +1,162 @@
+#ifndef VULKAN_TIMELINE_H_
+#define VULKAN_TIMELINE_H_
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "types.h"
+
+class VulkanDevice;
+
+enum class QueueFamily;
+
+/**
+ * \brief A submission has to wait for value to be reached on queue before stageMask.
+ */
+struct VulkanTimelineWait {
+	QueueFamily queue;
+
+	ui64 value;
+
+	VkPipelineStageFlags stageMask;
+};
+
+/**
+ * \brief Tracks the progress of the graphics, transfer and compute queues as monotonically increasing values.
+ * \details Every submission made through the timeline gets the next value of its
+ * queue. A value is reached once its submission, and with it every earlier one
+ * on the same queue, has completed. The values are backed by fences that are
+ * reset and reused instead of being created per submission. A submission can
+ * be chained to another queue: it then also signals a semaphore that exactly
+ * one later submission waiting for its value consumes. Waiting for a value
+ * that was not chained blocks the CPU until it is reached. Work that owns
+ * resources the GPU still uses can be handed to Recycle(), it runs once the
+ * value is reached. All the public functions are thread safe.
+ * VulkanDevice::SubmitAndWait() and the VulkanUploader submit through it, the
+ * frames keep their own fences since they are submitted with the swapchain
+ * semaphores.
+ */
+class VulkanTimeline {
+private:
+	struct Submission {
+		ui64 value{ 0 };
+
+		VkFence fence{ VK_NULL_HANDLE };
+
+		/**
+		 * \brief Chain semaphores this submission waited on, reusable once it completes.
+		 */
+		std::vector<VkSemaphore> consumedSemaphores;
+	};
+
+	struct Queue {
+		VkQueue queue{ VK_NULL_HANDLE };
+
+		ui64 nextValue{ 1 };
+
+		ui64 completedValue{ 0 };
+
+		/**
+		 * \brief Submitted and not yet completed, oldest first.
+		 */
+		std::deque<Submission> pendingSubmissions;
+
+		/**
+		 * \brief Semaphores signaled by chained submissions that nothing has waited on yet, by value.
+		 */
+		std::map<ui64, VkSemaphore> chainSemaphores;
+
+		std::deque<std::pair<ui64, std::function<void()>>> recycleQueue;
+	};
+
+	/**
+	 * \brief Recycled work that became ready while the timeline was locked.
+	 * \details Declared before the lock, so it runs once the lock is released.
+	 */
+	struct ReleasedWork {
+		std::vector<std::function<void()>> work;
+
+		~ReleasedWork();
+	};
+
+	const VulkanDevice* m_pDevice{ nullptr };
+
+	std::array<Queue, 3> m_Queues;
+
+	std::vector<VkFence> m_FreeFences;
+
+	std::vector<VkSemaphore> m_FreeSemaphores;
+
+	std::mutex m_Mutex;
+
+	Queue& GetQueue(QueueFamily queueFamily) noexcept;
+
+	VkFence AcquireFence() noexcept;
+
+	VkSemaphore AcquireSemaphore() noexcept;
+
+	/**
+	 * \brief Retires the completed submissions of the queue.
+	 * \param released Receives the work recycled up to the completed value.
+	 */
+	bool Retire(Queue& queue, ReleasedWork& released) noexcept;
+
+	bool WaitLocked(Queue& queue, ui64 value, ui64 timeout, ReleasedWork& released) noexcept;
+
+public:
+	~VulkanTimeline();
+
+	/**
+	 * \brief Fetches the queues of the device.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool Initialize(const VulkanDevice& device) noexcept;
+
+	/**
+	 * \brief Submits the command buffers to the queue once every wait is satisfied.
+	 * \param chained The value will be waited for by a submission on another queue.
+	 * \return The value the submission signals, 0 if it failed.
+	 */
+	ui64 Submit(QueueFamily queueFamily,
+	            const std::vector<VkCommandBuffer>& commandBuffers,
+	            const std::vector<VulkanTimelineWait>& waits = {},
+	            bool chained = false) noexcept;
+
+	/**
+	 * \brief Blocks until value is reached on the queue or timeout nanoseconds have passed.
+	 * \return TRUE if the value was reached, FALSE otherwise.
+	 */
+	bool Wait(QueueFamily queueFamily, ui64 value, ui64 timeout = std::numeric_limits<ui64>::max()) noexcept;
+
+	/**
+	 * \brief Waits for the last value submitted to every queue.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool WaitIdle() noexcept;
+
+	/**
+	 * \brief Returns the highest value reached on the queue, without blocking.
+	 */
+	ui64 GetCompletedValue(QueueFamily queueFamily) noexcept;
+
+	/**
+	 * \brief Returns the value the last submission to the queue signals, 0 if nothing was submitted.
+	 */
+	ui64 GetLastSubmittedValue(QueueFamily queueFamily) noexcept;
+
+	/**
+	 * \brief Runs release once value is reached on the queue, right away if it already is.
+	 * \details The pending work runs on the thread that polls or waits on the queue,
+	 * after the timeline is unlocked again.
+	 */
+	void Recycle(QueueFamily queueFamily, ui64 value, std::function<void()> release) noexcept;
+
+	void CleanUp() noexcept;
+};
+
+#endif //VULKAN_TIMELINE_H_
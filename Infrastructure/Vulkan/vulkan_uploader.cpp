@@ -0,0 +1,750 @@
+#include "vulkan_uploader.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include "logger.h"
+#include "texture_utilities.h"
+#include "vulkan_device.h"
+
+static VkDeviceSize AlignUp(const VkDeviceSize value, const VkDeviceSize alignment) noexcept
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+// The accesses that follow the upload of an image that ends up in layout.
+static VkAccessFlags GetAccessMask(const VkImageLayout layout) noexcept
+{
+	switch (layout) {
+		case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+			return VK_ACCESS_SHADER_READ_BIT;
+		case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+			return VK_ACCESS_TRANSFER_READ_BIT;
+		case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+			return VK_ACCESS_TRANSFER_WRITE_BIT;
+		default:
+			return VK_ACCESS_MEMORY_READ_BIT;
+	}
+}
+
+// Private functions -------------------------------------------
+bool VulkanUploader::OwnershipTransferRequired() const noexcept
+{
+	return m_TransferQueueFamily != m_GraphicsQueueFamily;
+}
+
+QueueFamily VulkanUploader::GetCompletionQueue() const noexcept
+{
+	return OwnershipTransferRequired() ? QueueFamily::GRAPHICS : QueueFamily::TRANSFER;
+}
+
+bool VulkanUploader::OpenBatch() noexcept
+{
+	if (m_OpenBatch) {
+		return true;
+	}
+
+	if (!m_FreeBatches.empty()) {
+		m_OpenBatch = std::move(m_FreeBatches.back());
+		m_FreeBatches.pop_back();
+	} else {
+		auto batch = std::make_unique<Batch>();
+
+		if (!CreateBatch(*batch)) {
+			DestroyBatch(*batch);
+			return false;
+		}
+
+		m_OpenBatch = std::move(batch);
+	}
+
+	VkCommandBufferBeginInfo commandBufferBeginInfo{};
+	commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	VkResult result{ vkBeginCommandBuffer(m_OpenBatch->transferCommandBuffer, &commandBufferBeginInfo) };
+
+	if (result != VK_SUCCESS) {
+		ERROR_LOG("Failed to begin upload command buffer.");
+		m_FreeBatches.push_back(std::move(m_OpenBatch));
+		return false;
+	}
+
+	return true;
+}
+
+bool VulkanUploader::CreateBatch(Batch& batch) const noexcept
+{
+	batch.transferCommandBuffer = m_pDevice->CreateCommandBuffer(m_TransferCommandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+	if (!batch.transferCommandBuffer) {
+		return false;
+	}
+
+	if (OwnershipTransferRequired()) {
+		batch.graphicsCommandBuffer = m_pDevice->CreateCommandBuffer(m_GraphicsCommandPool,
+		                                                             VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+		if (!batch.graphicsCommandBuffer) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void VulkanUploader::DestroyBatch(Batch& batch) const noexcept
+{
+	// The command buffers go away with their pools.
+	batch.dedicatedStagingBuffers.clear();
+}
+
+bool VulkanUploader::Stage(const void* data,
+                           const VkDeviceSize size,
+                           VkBuffer& stagingBuffer,
+                           VkDeviceSize& stagingOffset) noexcept
+{
+	const auto capacity = m_StagingBuffer.size;
+
+	// Too large for the ring, it gets its own staging buffer which lives as long as the batch.
+	if (size > capacity) {
+		auto dedicatedStagingBuffer = std::make_unique<VulkanBuffer>();
+
+		if (!m_pDevice->CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		                             *dedicatedStagingBuffer,
+		                             size,
+		                             const_cast<void*>(data))) {
+			ERROR_LOG("Failed to create staging buffer.");
+			return false;
+		}
+
+		stagingBuffer = dedicatedStagingBuffer->buffer;
+		stagingOffset = 0;
+
+		m_OpenBatch->dedicatedStagingBuffers.push_back(std::move(dedicatedStagingBuffer));
+
+		return true;
+	}
+
+	VkDeviceSize offset{ 0 };
+	VkDeviceSize padding{ 0 };
+
+	while (true) {
+		offset = AlignUp(m_Head, m_StagingAlignment);
+		padding = offset - m_Head;
+
+		// Wrap around, the end of the ring is wasted until this batch completes.
+		if (offset + size > capacity) {
+			padding = capacity - m_Head;
+			offset = 0;
+		}
+
+		if (padding + size <= capacity - m_UsedBytes) {
+			break;
+		}
+
+		// The ring is full. Submit what has been recorded so far and wait for the oldest batch.
+		++m_Statistics.stallCount;
+
+		if (m_OpenBatch->copyCount) {
+			if (!SubmitOpenBatch() || !OpenBatch()) {
+				return false;
+			}
+		}
+
+		if (m_PendingBatches.empty() || !RetireBatches(true)) {
+			ERROR_LOG("Failed to free staging space.");
+			return false;
+		}
+	}
+
+	std::memcpy(static_cast<ui8*>(m_StagingBuffer.data) + offset, data, size);
+
+	m_Head = offset + size;
+	m_UsedBytes += padding + size;
+	m_OpenBatch->stagingBytes += padding + size;
+
+	stagingBuffer = m_StagingBuffer.buffer;
+	stagingOffset = offset;
+
+	return true;
+}
+
+void VulkanUploader::RecordImageLevelCopy(VkCommandBuffer commandBuffer, const ImageLevelCopy& copy) noexcept
+{
+	std::array<VkImageMemoryBarrier, 2> barriers{};
+
+	for (auto& barrier : barriers) {
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = copy.levelCount;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+	}
+
+	// The source may have been uploaded earlier in the batch and may still be sampled by frames in flight.
+	barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barriers[0].oldLayout = copy.layout;
+	barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barriers[0].image = copy.source;
+	barriers[0].subresourceRange.baseMipLevel = copy.sourceLevel;
+
+	barriers[1].srcAccessMask = 0;
+	barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barriers[1].image = copy.destination;
+	barriers[1].subresourceRange.baseMipLevel = copy.destinationLevel;
+
+	vkCmdPipelineBarrier(commandBuffer,
+	                     VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+	                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                     0,
+	                     0,
+	                     nullptr,
+	                     0,
+	                     nullptr,
+	                     static_cast<ui32>(barriers.size()),
+	                     barriers.data());
+
+	std::vector<VkImageCopy> regions(copy.levelCount);
+
+	for (auto i = 0u; i < copy.levelCount; ++i) {
+		const auto extent = GetMipLevelSize(copy.extent, i);
+
+		auto& region = regions[i];
+		region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.srcSubresource.mipLevel = copy.sourceLevel + i;
+		region.srcSubresource.baseArrayLayer = 0;
+		region.srcSubresource.layerCount = 1;
+		region.dstSubresource = region.srcSubresource;
+		region.dstSubresource.mipLevel = copy.destinationLevel + i;
+		region.extent = VkExtent3D{ extent.x, extent.y, 1 };
+	}
+
+	vkCmdCopyImage(commandBuffer,
+	               copy.source,
+	               VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	               copy.destination,
+	               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	               static_cast<ui32>(regions.size()),
+	               regions.data());
+
+	// Both go back to the layout they are sampled in.
+	barriers[0].srcAccessMask = 0;
+	barriers[0].dstAccessMask = GetAccessMask(copy.layout);
+	barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barriers[0].newLayout = copy.layout;
+
+	barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barriers[1].dstAccessMask = GetAccessMask(copy.layout);
+	barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barriers[1].newLayout = copy.layout;
+
+	vkCmdPipelineBarrier(commandBuffer,
+	                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                     VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+	                     0,
+	                     0,
+	                     nullptr,
+	                     0,
+	                     nullptr,
+	                     static_cast<ui32>(barriers.size()),
+	                     barriers.data());
+}
+
+bool VulkanUploader::SubmitOpenBatch() noexcept
+{
+	if (!m_OpenBatch || !m_OpenBatch->copyCount) {
+		return true;
+	}
+
+	auto& batch = *m_OpenBatch;
+
+	if (!OwnershipTransferRequired()) {
+		// Same queue: make the copies visible to everything submitted after the batch.
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+		vkCmdPipelineBarrier(batch.transferCommandBuffer,
+		                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                     VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		                     0,
+		                     1,
+		                     &barrier,
+		                     0,
+		                     nullptr,
+		                     0,
+		                     nullptr);
+	}
+
+	VkResult result{ vkEndCommandBuffer(batch.transferCommandBuffer) };
+
+	if (result != VK_SUCCESS) {
+		ERROR_LOG("Failed to end upload command buffer.");
+		return false;
+	}
+
+	auto& timeline = m_pDevice->GetTimeline();
+
+	// The acquisition waits for the transfer on the GPU, so the transfer value is chained to it.
+	batch.value = timeline.Submit(QueueFamily::TRANSFER, { batch.transferCommandBuffer }, {}, OwnershipTransferRequired());
+
+	if (!batch.value) {
+		ERROR_LOG("Failed to submit uploads to the transfer queue.");
+		return false;
+	}
+
+	if (OwnershipTransferRequired()) {
+		// Acquire every destination released by the transfer queue in a single barrier.
+		VkCommandBufferBeginInfo commandBufferBeginInfo{};
+		commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(batch.graphicsCommandBuffer, &commandBufferBeginInfo);
+
+		vkCmdPipelineBarrier(batch.graphicsCommandBuffer,
+		                     VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		                     VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		                     0,
+		                     0,
+		                     nullptr,
+		                     static_cast<ui32>(batch.bufferAcquireBarriers.size()),
+		                     batch.bufferAcquireBarriers.data(),
+		                     static_cast<ui32>(batch.imageAcquireBarriers.size()),
+		                     batch.imageAcquireBarriers.data());
+
+		// The sources of the level copies live on the graphics queue, so they are copied there.
+		for (const auto& copy : batch.imageLevelCopies) {
+			RecordImageLevelCopy(batch.graphicsCommandBuffer, copy);
+		}
+
+		vkEndCommandBuffer(batch.graphicsCommandBuffer);
+
+		batch.value = timeline.Submit(QueueFamily::GRAPHICS,
+		                              { batch.graphicsCommandBuffer },
+		                              { { QueueFamily::TRANSFER, batch.value, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT } });
+
+		if (!batch.value) {
+			ERROR_LOG("Failed to submit the ownership acquisitions to the graphics queue.");
+			return false;
+		}
+	}
+
+	// The dedicated staging buffers are only needed until the batch completes, whoever polls the timeline first frees them.
+	if (!batch.dedicatedStagingBuffers.empty()) {
+		auto dedicatedStagingBuffers = std::make_shared<std::vector<std::unique_ptr<VulkanBuffer>>>(
+			std::move(batch.dedicatedStagingBuffers));
+
+		timeline.Recycle(GetCompletionQueue(), batch.value, [dedicatedStagingBuffers]() {
+			dedicatedStagingBuffers->clear();
+		});
+
+		batch.dedicatedStagingBuffers.clear();
+	}
+
+	++m_Statistics.batchCount;
+
+	m_PendingBatches.push_back(std::move(m_OpenBatch));
+
+	return true;
+}
+
+bool VulkanUploader::RetireBatches(const bool waitForOldest) noexcept
+{
+	if (m_PendingBatches.empty()) {
+		return true;
+	}
+
+	auto& timeline = m_pDevice->GetTimeline();
+
+	if (waitForOldest && !timeline.Wait(GetCompletionQueue(), m_PendingBatches.front()->value)) {
+		ERROR_LOG("Wait for upload batch failed.");
+		return false;
+	}
+
+	// Every batch completes on the same queue, so their values are in submission order.
+	const auto completedValue = timeline.GetCompletedValue(GetCompletionQueue());
+
+	while (!m_PendingBatches.empty() && m_PendingBatches.front()->value <= completedValue) {
+		auto& batch = *m_PendingBatches.front();
+
+		m_UsedBytes -= batch.stagingBytes;
+
+		batch.value = 0;
+		batch.stagingBytes = 0;
+		batch.copyCount = 0;
+		batch.bufferAcquireBarriers.clear();
+		batch.imageAcquireBarriers.clear();
+		batch.imageLevelCopies.clear();
+
+		m_FreeBatches.push_back(std::move(m_PendingBatches.front()));
+		m_PendingBatches.pop_front();
+	}
+
+	if (!m_UsedBytes) {
+		m_Head = 0;
+	}
+
+	return true;
+}
+// -------------------------------------------------------------
+
+VulkanUploader::~VulkanUploader()
+{
+	CleanUp();
+}
+
+bool VulkanUploader::Initialize(const VulkanDevice& device, const VkDeviceSize stagingSize) noexcept
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	m_pDevice = &device;
+
+	m_TransferQueueFamily = device.GetQueueFamilyIndex(QueueFamily::TRANSFER);
+	m_GraphicsQueueFamily = device.GetQueueFamilyIndex(QueueFamily::GRAPHICS);
+
+	// Buffer to image copies need offsets that are a multiple of 4 and of the texel size.
+	m_StagingAlignment = std::max<VkDeviceSize>(16, device.GetPhysicalDevice().properties.limits.optimalBufferCopyOffsetAlignment);
+
+	m_TransferCommandPool = device.CreateCommandPool(m_TransferQueueFamily);
+
+	if (!m_TransferCommandPool) {
+		ERROR_LOG("Failed to create the transfer command pool.");
+		return false;
+	}
+
+	if (OwnershipTransferRequired()) {
+		m_GraphicsCommandPool = device.CreateCommandPool(m_GraphicsQueueFamily);
+
+		if (!m_GraphicsCommandPool) {
+			ERROR_LOG("Failed to create the ownership acquisition command pool.");
+			return false;
+		}
+	}
+
+	if (!device.CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+	                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	                         m_StagingBuffer,
+	                         stagingSize) || m_StagingBuffer.Map() != VK_SUCCESS) {
+		ERROR_LOG("Failed to create the staging ring buffer.");
+		return false;
+	}
+
+	LOG(std::string{ "Uploading on queue family " } + std::to_string(m_TransferQueueFamily) +
+		(OwnershipTransferRequired() ? " with ownership transfers to the graphics queue family." : "."));
+
+	return true;
+}
+
+bool VulkanUploader::UploadBuffer(const VulkanBuffer& destination,
+                                  const void* data,
+                                  const VkDeviceSize size,
+                                  const VkDeviceSize destinationOffset) noexcept
+{
+	if (!size) {
+		return true;
+	}
+
+	assert(destination.buffer && data);
+
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	VkBuffer stagingBuffer{ VK_NULL_HANDLE };
+	VkDeviceSize stagingOffset{ 0 };
+
+	if (!OpenBatch() || !Stage(data, size, stagingBuffer, stagingOffset)) {
+		return false;
+	}
+
+	// Staging may have submitted the previous batch, only take the open one now.
+	auto& batch = *m_OpenBatch;
+
+	VkBufferCopy region{};
+	region.srcOffset = stagingOffset;
+	region.dstOffset = destinationOffset;
+	region.size = size;
+
+	vkCmdCopyBuffer(batch.transferCommandBuffer, stagingBuffer, destination.buffer, 1, &region);
+
+	if (OwnershipTransferRequired()) {
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		barrier.srcQueueFamilyIndex = m_TransferQueueFamily;
+		barrier.dstQueueFamilyIndex = m_GraphicsQueueFamily;
+		barrier.buffer = destination.buffer;
+		barrier.offset = destinationOffset;
+		barrier.size = size;
+
+		vkCmdPipelineBarrier(batch.transferCommandBuffer,
+		                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                     VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		                     0,
+		                     0,
+		                     nullptr,
+		                     1,
+		                     &barrier,
+		                     0,
+		                     nullptr);
+
+		// The matching acquisition is recorded on the graphics queue when the batch is submitted.
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+		                        VK_ACCESS_INDEX_READ_BIT |
+		                        VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+		                        VK_ACCESS_UNIFORM_READ_BIT |
+		                        VK_ACCESS_SHADER_READ_BIT |
+		                        VK_ACCESS_TRANSFER_READ_BIT;
+
+		batch.bufferAcquireBarriers.push_back(barrier);
+	}
+
+	++batch.copyCount;
+	++m_Statistics.copyCount;
+	m_Statistics.uploadedBytes += size;
+
+	return true;
+}
+
+bool VulkanUploader::UploadImage(VkImage destination,
+                                 const Vec2ui& extent,
+                                 const void* data,
+                                 const VkDeviceSize size,
+                                 const VkImageLayout finalLayout,
+                                 const ui32 mipLevel) noexcept
+{
+	if (!size) {
+		return true;
+	}
+
+	assert(destination && data);
+
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	VkBuffer stagingBuffer{ VK_NULL_HANDLE };
+	VkDeviceSize stagingOffset{ 0 };
+
+	if (!OpenBatch() || !Stage(data, size, stagingBuffer, stagingOffset)) {
+		return false;
+	}
+
+	auto& batch = *m_OpenBatch;
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = destination;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = mipLevel;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	vkCmdPipelineBarrier(batch.transferCommandBuffer,
+	                     VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+	                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+	                     0,
+	                     0,
+	                     nullptr,
+	                     0,
+	                     nullptr,
+	                     1,
+	                     &barrier);
+
+	VkBufferImageCopy region{};
+	region.bufferOffset = stagingOffset;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = mipLevel;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent = VkExtent3D{ extent.x, extent.y, 1 };
+
+	vkCmdCopyBufferToImage(batch.transferCommandBuffer,
+	                       stagingBuffer,
+	                       destination,
+	                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	                       1,
+	                       &region);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = finalLayout;
+
+	if (OwnershipTransferRequired()) {
+		// Release. The layout transition happens once, between the release and the acquisition.
+		barrier.dstAccessMask = 0;
+		barrier.srcQueueFamilyIndex = m_TransferQueueFamily;
+		barrier.dstQueueFamilyIndex = m_GraphicsQueueFamily;
+
+		vkCmdPipelineBarrier(batch.transferCommandBuffer,
+		                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                     VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		                     0,
+		                     0,
+		                     nullptr,
+		                     0,
+		                     nullptr,
+		                     1,
+		                     &barrier);
+
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = GetAccessMask(finalLayout);
+
+		batch.imageAcquireBarriers.push_back(barrier);
+	} else {
+		barrier.dstAccessMask = GetAccessMask(finalLayout);
+
+		vkCmdPipelineBarrier(batch.transferCommandBuffer,
+		                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                     VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		                     0,
+		                     0,
+		                     nullptr,
+		                     0,
+		                     nullptr,
+		                     1,
+		                     &barrier);
+	}
+
+	++batch.copyCount;
+	++m_Statistics.copyCount;
+	m_Statistics.uploadedBytes += size;
+
+	return true;
+}
+
+bool VulkanUploader::CopyImageLevels(VkImage source,
+                                     const ui32 sourceLevel,
+                                     VkImage destination,
+                                     const ui32 destinationLevel,
+                                     const ui32 levelCount,
+                                     const Vec2ui& extent,
+                                     const VkImageLayout layout) noexcept
+{
+	if (!levelCount) {
+		return true;
+	}
+
+	assert(source && destination);
+
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	if (!OpenBatch()) {
+		return false;
+	}
+
+	ImageLevelCopy copy{};
+	copy.source = source;
+	copy.sourceLevel = sourceLevel;
+	copy.destination = destination;
+	copy.destinationLevel = destinationLevel;
+	copy.levelCount = levelCount;
+	copy.extent = extent;
+	copy.layout = layout;
+
+	if (OwnershipTransferRequired()) {
+		m_OpenBatch->imageLevelCopies.push_back(copy);
+	} else {
+		RecordImageLevelCopy(m_OpenBatch->transferCommandBuffer, copy);
+	}
+
+	++m_OpenBatch->copyCount;
+	++m_Statistics.copyCount;
+
+	return true;
+}
+
+bool VulkanUploader::Flush() noexcept
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	if (!m_pDevice) {
+		return false;
+	}
+
+	return SubmitOpenBatch() && RetireBatches(false);
+}
+
+bool VulkanUploader::WaitIdle() noexcept
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	if (!m_pDevice || !SubmitOpenBatch()) {
+		return false;
+	}
+
+	while (!m_PendingBatches.empty()) {
+		if (!RetireBatches(true)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+VulkanUploadStatistics VulkanUploader::GetStatistics() noexcept
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	auto statistics = m_Statistics;
+	statistics.pendingBatchCount = m_PendingBatches.size();
+
+	return statistics;
+}
+
+void VulkanUploader::CleanUp() noexcept
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	if (!m_pDevice) {
+		return;
+	}
+
+	// Whatever is still recorded was never needed by a frame, only wait for what is in flight.
+	if (!m_PendingBatches.empty()) {
+		m_pDevice->GetTimeline().Wait(GetCompletionQueue(), m_PendingBatches.back()->value);
+	}
+
+	for (auto& batch : m_PendingBatches) {
+		DestroyBatch(*batch);
+	}
+
+	m_PendingBatches.clear();
+
+	if (m_OpenBatch) {
+		DestroyBatch(*m_OpenBatch);
+		m_OpenBatch.reset();
+	}
+
+	for (auto& batch : m_FreeBatches) {
+		DestroyBatch(*batch);
+	}
+
+	m_FreeBatches.clear();
+
+	vkDestroyCommandPool(*m_pDevice, m_TransferCommandPool, nullptr);
+	vkDestroyCommandPool(*m_pDevice, m_GraphicsCommandPool, nullptr);
+
+	m_TransferCommandPool = VK_NULL_HANDLE;
+	m_GraphicsCommandPool = VK_NULL_HANDLE;
+
+	m_StagingBuffer.CleanUp();
+
+	m_Head = 0;
+	m_UsedBytes = 0;
+
+	m_pDevice = nullptr;
+}
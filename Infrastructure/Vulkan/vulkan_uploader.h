@@ -0,0 +1,244 @@
+#ifndef VULKAN_UPLOADER_H_
+#define VULKAN_UPLOADER_H_
+
+#include <vulkan/vulkan.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "types.h"
+#include "vulkan_buffer.h"
+
+class VulkanDevice;
+
+enum class QueueFamily;
+
+struct VulkanUploadStatistics {
+	/**
+	 * \brief Batches submitted to the transfer queue.
+	 */
+	ui64 batchCount{ 0 };
+
+	ui64 copyCount{ 0 };
+
+	ui64 uploadedBytes{ 0 };
+
+	/**
+	 * \brief How many times an upload had to wait for an earlier batch to free staging space.
+	 */
+	ui64 stallCount{ 0 };
+
+	size_t pendingBatchCount{ 0 };
+};
+
+/**
+ * \brief Batches the staging uploads of buffers and images into single transfer queue submissions.
+ * \details The data is copied into a persistently mapped staging ring buffer
+ * right away and the copy commands are recorded into the open batch, which is
+ * only submitted by Flush(). If the transfer queue belongs to another queue
+ * family than the graphics queue, the ownership of every destination is
+ * released on the transfer queue and acquired on the graphics queue. Both are
+ * submitted through the VulkanTimeline of the device, the acquisition waits
+ * for the chained transfer value on the GPU. Copies between images are
+ * recorded on the graphics queue then, after the acquisitions, since their
+ * sources belong to it. Once the value of a batch is reached its staging
+ * space and command buffers are reused. Uploads larger than the ring get a
+ * staging buffer of their own, which is recycled through the timeline. All
+ * the public functions are thread safe.
+ */
+class VulkanUploader {
+private:
+	struct ImageLevelCopy {
+		VkImage source{ VK_NULL_HANDLE };
+
+		ui32 sourceLevel{ 0 };
+
+		VkImage destination{ VK_NULL_HANDLE };
+
+		ui32 destinationLevel{ 0 };
+
+		ui32 levelCount{ 0 };
+
+		/**
+		 * \brief The extent of sourceLevel.
+		 */
+		Vec2ui extent;
+
+		VkImageLayout layout{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	};
+
+	struct Batch {
+		VkCommandBuffer transferCommandBuffer{ VK_NULL_HANDLE };
+
+		/**
+		 * \brief Records the ownership acquisitions. Only used if the queue families differ.
+		 */
+		VkCommandBuffer graphicsCommandBuffer{ VK_NULL_HANDLE };
+
+		/**
+		 * \brief Timeline value of the completion queue the batch is done at.
+		 */
+		ui64 value{ 0 };
+
+		/**
+		 * \brief Bytes of the staging ring used by the batch, alignment and wrap around padding included.
+		 */
+		VkDeviceSize stagingBytes{ 0 };
+
+		std::vector<std::unique_ptr<VulkanBuffer>> dedicatedStagingBuffers;
+
+		std::vector<VkBufferMemoryBarrier> bufferAcquireBarriers;
+
+		std::vector<VkImageMemoryBarrier> imageAcquireBarriers;
+
+		/**
+		 * \brief Level copies recorded on the graphics queue once the destinations are acquired.
+		 * Only used if the queue families differ.
+		 */
+		std::vector<ImageLevelCopy> imageLevelCopies;
+
+		size_t copyCount{ 0 };
+	};
+
+	const VulkanDevice* m_pDevice{ nullptr };
+
+	VulkanBuffer m_StagingBuffer;
+
+	/**
+	 * \brief Offset of the next staging allocation.
+	 */
+	VkDeviceSize m_Head{ 0 };
+
+	/**
+	 * \brief Bytes of the staging ring used by the open and the pending batches.
+	 */
+	VkDeviceSize m_UsedBytes{ 0 };
+
+	VkDeviceSize m_StagingAlignment{ 16 };
+
+	ui32 m_TransferQueueFamily{ 0 };
+
+	ui32 m_GraphicsQueueFamily{ 0 };
+
+	VkCommandPool m_TransferCommandPool{ VK_NULL_HANDLE };
+
+	VkCommandPool m_GraphicsCommandPool{ VK_NULL_HANDLE };
+
+	std::unique_ptr<Batch> m_OpenBatch;
+
+	/**
+	 * \brief Submitted batches, oldest first.
+	 */
+	std::deque<std::unique_ptr<Batch>> m_PendingBatches;
+
+	std::vector<std::unique_ptr<Batch>> m_FreeBatches;
+
+	VulkanUploadStatistics m_Statistics;
+
+	std::mutex m_Mutex;
+
+	bool OwnershipTransferRequired() const noexcept;
+
+	/**
+	 * \brief The queue the last submission of every batch goes to.
+	 */
+	QueueFamily GetCompletionQueue() const noexcept;
+
+	bool OpenBatch() noexcept;
+
+	bool CreateBatch(Batch& batch) const noexcept;
+
+	void DestroyBatch(Batch& batch) const noexcept;
+
+	/**
+	 * \brief Copies size bytes of data into the staging ring, waiting for pending batches if it is full.
+	 * \param stagingBuffer The buffer the data was copied to.
+	 * \param stagingOffset The offset of the data in stagingBuffer.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool Stage(const void* data, VkDeviceSize size, VkBuffer& stagingBuffer, VkDeviceSize& stagingOffset) noexcept;
+
+	static void RecordImageLevelCopy(VkCommandBuffer commandBuffer, const ImageLevelCopy& copy) noexcept;
+
+	bool SubmitOpenBatch() noexcept;
+
+	/**
+	 * \brief Recycles the pending batches that have completed.
+	 * \param waitForOldest Blocks until the oldest pending batch completes first.
+	 */
+	bool RetireBatches(bool waitForOldest) noexcept;
+
+public:
+	static constexpr VkDeviceSize DEFAULT_STAGING_SIZE{ 32 * 1024 * 1024 };
+
+	~VulkanUploader();
+
+	/**
+	 * \brief Creates the staging ring and the command pools.
+	 * \param device The device the uploads are submitted to.
+	 * \param stagingSize The size of the staging ring.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool Initialize(const VulkanDevice& device, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE) noexcept;
+
+	/**
+	 * \brief Records a copy of size bytes of data into destination.
+	 * \details The destination needs VK_BUFFER_USAGE_TRANSFER_DST_BIT. It must not be used before the batch is flushed.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool UploadBuffer(const VulkanBuffer& destination,
+	                  const void* data,
+	                  VkDeviceSize size,
+	                  VkDeviceSize destinationOffset = 0) noexcept;
+
+	/**
+	 * \brief Records a copy of tightly packed pixels into one mip level of a color image.
+	 * \details The previous contents of the level are discarded. The level ends up in finalLayout,
+	 * the other levels are left alone.
+	 * \param extent The extent of mipLevel, not of the whole image.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool UploadImage(VkImage destination,
+	                 const Vec2ui& extent,
+	                 const void* data,
+	                 VkDeviceSize size,
+	                 VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	                 ui32 mipLevel = 0) noexcept;
+
+	/**
+	 * \brief Records a copy of levelCount mip levels of a color image into another one, on the GPU.
+	 * \details Both images are in layout outside of the copy. The source levels may have been
+	 * uploaded by the same batch, the previous contents of the destination levels are discarded.
+	 * \param extent The extent of sourceLevel, not of the whole image.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool CopyImageLevels(VkImage source,
+	                     ui32 sourceLevel,
+	                     VkImage destination,
+	                     ui32 destinationLevel,
+	                     ui32 levelCount,
+	                     const Vec2ui& extent,
+	                     VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) noexcept;
+
+	/**
+	 * \brief Submits the recorded uploads without waiting for them.
+	 * \details Graphics queue submissions made afterwards see the uploaded data.
+	 * Submitting touches the transfer and graphics queues, so like any other
+	 * submission it has to be synchronized with the thread that renders. An
+	 * upload that finds the staging ring full submits as well.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool Flush() noexcept;
+
+	/**
+	 * \brief Submits the recorded uploads and waits for every pending batch.
+	 * \return TRUE if successful, FALSE otherwise.
+	 */
+	bool WaitIdle() noexcept;
+
+	VulkanUploadStatistics GetStatistics() noexcept;
+
+	void CleanUp() noexcept;
+};
+
+#endif //VULKAN_UPLOADER_H_
@@ -1,8 +1,14 @@
 #include "demo_entity.h"
 
-DemoEntity::DemoEntity(GLMesh* mesh)
+DemoEntity::DemoEntity(GLMesh* mesh, const TransformHandle transform)
+	: m_Mesh{ mesh },
+	  m_Transform{ transform }
 {
-	m_Mesh = mesh;
+}
+
+TransformHandle DemoEntity::GetTransform() const noexcept
+{
+	return m_Transform;
 }
 
 DemoMaterial& DemoEntity::GetMaterial() const noexcept
@@ -1,17 +1,22 @@
 #ifndef DEMO_ENTITY_H_
 #define DEMO_ENTITY_H_
-#include "entity.h"
+#include "resource.h"
+#include "transform_store.h"
 #include "demo_material.h"
 #include "gl_mesh.h"
 
-class DemoEntity final : public Entity {
+class DemoEntity final : public Resource {
 private:
 	GLMesh* m_Mesh{ nullptr };
 
+	TransformHandle m_Transform;
+
 	DemoMaterial* m_Material{ nullptr };
 
 public:
-	explicit DemoEntity(GLMesh* mesh);
+	DemoEntity(GLMesh* mesh, TransformHandle transform);
+
+	TransformHandle GetTransform() const noexcept;
 
 	DemoMaterial& GetMaterial() const noexcept;
 
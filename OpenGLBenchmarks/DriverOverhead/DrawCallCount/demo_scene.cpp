@@ -7,6 +7,7 @@
 #include <mutex>
 #include "demo_scene.h"
 #include <algorithm>
+#include "timer.h"
 #include <gl_application.h>
 #include "imgui.h"
 #include <fstream>
@@ -15,6 +16,8 @@
 #include "gl_texture_sampler.h"
 #include "imgui_impl_glfw_gl3.h"
 #include "gl_render_target.h"
+#include <cstring>
+#include <cfg.h>
 
 static std::mt19937 s_Rng;
 static const GLfloat clearColor[]{ 0.0f, 0.0f, 0.0f, 0.0f };
@@ -27,30 +30,168 @@ static auto RealRangeRng(const f32 begin, const f32 end)
 }
 
 // Private functions -------------------------------------------------
-bool DemoScene::SpawnEntity() noexcept
+bool DemoScene::SpawnEntities(const size_t count) noexcept
 {
-	auto entity = std::make_unique<DemoEntity>(&m_CubeMesh);
+	if (!count) {
+		return true;
+	}
 
-	entity->SetPosition(Vec3f{
-		RealRangeRng(-20.0f, 20.0f),
-		RealRangeRng(-20.0f, 20.0f),
-		RealRangeRng(-20.0f, 20.0f)
-	});
+	const auto spawnedCount = m_Entities.size();
+
+	for (auto i = 0u; i < count; ++i) {
+		const auto transform = m_Transforms.Create();
 
+		m_Transforms.SetPosition(transform, Vec3f{
+			RealRangeRng(-20.0f, 20.0f),
+			RealRangeRng(-20.0f, 20.0f),
+			RealRangeRng(-20.0f, 20.0f)
+		});
 
-	entity->SetMaterial(&m_Material);
+		auto entity = std::make_unique<DemoEntity>(&m_CubeMesh, transform);
 
-	m_Entities.push_back(std::move(entity));
+		entity->SetMaterial(&m_Material);
 
-	// Sort entities from back to front to avoid early z optimizations.
-	std::sort(m_Entities.begin(), m_Entities.end(), [](auto& a, auto& b)
+		m_Entities.push_back(std::move(entity));
+	}
+
+	// Keep the entities sorted from back to front to avoid early z optimizations.
+	// Only the new batch is sorted, then it is merged into the already sorted entities.
+	const auto backToFront = [this](const auto& a, const auto& b)
 	{
-		return a->GetPosition().z > b->GetPosition().z;
+		return m_Transforms.GetPosition(a->GetTransform()).z > m_Transforms.GetPosition(b->GetTransform()).z;
+	};
+
+	const auto firstSpawned = m_Entities.begin() + spawnedCount;
+
+	std::sort(firstSpawned, m_Entities.end(), backToFront);
+	std::inplace_merge(m_Entities.begin(), firstSpawned, m_Entities.end(), backToFront);
+
+	return true;
+}
+
+void DemoScene::ReserveInstanceData(const size_t count) noexcept
+{
+	if (count <= m_InstanceCapacity) {
+		return;
+	}
+
+	auto capacity = std::max<size_t>(m_InstanceCapacity, 1024);
+
+	while (capacity < count) {
+		capacity *= 2;
+	}
+
+	if (!m_InstanceXformsSsbo) {
+		glCreateBuffers(1, &m_InstanceXformsSsbo);
+		assert(glGetError() == GL_NO_ERROR);
+	}
+
+	glNamedBufferData(m_InstanceXformsSsbo, capacity * sizeof(Mat4f), nullptr, GL_STREAM_DRAW);
+	assert(glGetError() == GL_NO_ERROR);
+
+	if (m_RenderMode == RenderMode::INDIRECT) {
+		if (!m_IndirectCommands) {
+			glCreateBuffers(1, &m_IndirectCommands);
+			assert(glGetError() == GL_NO_ERROR);
+		}
+
+		glNamedBufferData(m_IndirectCommands, capacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_DRAW);
+		assert(glGetError() == GL_NO_ERROR);
+	}
+
+	m_InstanceCapacity = capacity;
+}
+
+// Invalidating the buffer lets the driver hand out fresh storage instead of
+// waiting for the previous frame to stop reading from it.
+template <typename T>
+static T* MapForOverwrite(const GLuint buffer, const size_t count) noexcept
+{
+	return static_cast<T*>(glMapNamedBufferRange(buffer,
+	                                             0,
+	                                             count * sizeof(T),
+	                                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+}
+
+bool DemoScene::UploadInstanceData() noexcept
+{
+	ReserveInstanceData(m_Entities.size());
+
+	const auto instanceXforms = MapForOverwrite<Mat4f>(m_InstanceXformsSsbo, m_Entities.size());
+
+	if (!instanceXforms) {
+		ERROR_LOG("Failed to map instance transforms storage buffer.");
+		return false;
+	}
+
+	DrawElementsIndirectCommand* commands{ nullptr };
+
+	if (m_RenderMode == RenderMode::INDIRECT) {
+		commands = MapForOverwrite<DrawElementsIndirectCommand>(m_IndirectCommands, m_Entities.size());
+
+		if (!commands) {
+			glUnmapNamedBuffer(m_InstanceXformsSsbo);
+			ERROR_LOG("Failed to map indirect command buffer.");
+			return false;
+		}
+	}
+
+	const auto indexCount = static_cast<GLuint>(m_CubeMesh.GetIndices().size());
+
+	// The entities are sorted back to front, so they are gathered from the
+	// transform store in draw order rather than copied in creation order.
+	m_ThreadPool.ParallelFor(0, m_Entities.size(), 4096, [=](const size_t begin, const size_t end)
+	{
+		for (auto i = begin; i < end; ++i) {
+			memcpy(&instanceXforms[i], &m_Transforms.GetXform(m_Entities[i]->GetTransform()), sizeof(Mat4f));
+		}
+
+		if (!commands) {
+			return;
+		}
+
+		// One command per cube. baseInstance selects the cube's world matrix in the vertex shader.
+		for (auto i = begin; i < end; ++i) {
+			commands[i].count = indexCount;
+			commands[i].instanceCount = 1;
+			commands[i].firstIndex = 0;
+			commands[i].baseVertex = 0;
+			commands[i].baseInstance = static_cast<GLuint>(i);
+		}
 	});
 
+	glUnmapNamedBuffer(m_InstanceXformsSsbo);
+
+	if (commands) {
+		glUnmapNamedBuffer(m_IndirectCommands);
+	}
+
+	assert(glGetError() == GL_NO_ERROR);
+
 	return true;
 }
 
+const char* DemoScene::GetRenderModeName() const noexcept
+{
+	switch (m_RenderMode) {
+	case RenderMode::INSTANCED:
+		return "Instanced";
+	case RenderMode::INDIRECT:
+		return "Multi draw indirect";
+	default:
+		return "Per draw";
+	}
+}
+
+size_t DemoScene::GetDrawCallCount() const noexcept
+{
+	if (m_RenderMode == RenderMode::PER_DRAW) {
+		return m_Entities.size();
+	}
+
+	return m_Entities.empty() ? 0 : 1;
+}
+
 void DemoScene::DrawUi() const noexcept
 {
 	auto& application = G_Application;
@@ -115,7 +256,9 @@ void DemoScene::DrawUi() const noexcept
 
 		ImGui::NewLine();
 		ImGui::Text("Total Vertex Count: %d", m_Entities.size() * 24);
-		ImGui::Text("Draw calls: %u", m_Entities.size());
+		ImGui::Text("Render mode: %s", GetRenderModeName());
+		ImGui::Text("Draw calls: %zu", GetDrawCallCount());
+		ImGui::Text("Spawn time: %f ms", application.spawnTime);
 		ImGui::Text("Running time: %f s", application.GetTimer().GetSec());
 		ImGui::Text("Frame count: %lld", application.frameCount);
 		ImGui::End();
@@ -168,7 +311,8 @@ void DemoScene::DrawUi() const noexcept
 		ImGui::NewLine();
 
 		ImGui::Text("Total Vertex Count: %d", m_Entities.size() * 24);
-		ImGui::Text("Draw calls: %u", m_Entities.size());
+		ImGui::Text("Render mode: %s", GetRenderModeName());
+		ImGui::Text("Draw calls: %zu", GetDrawCallCount());
 		ImGui::Text("Total Frames: %lld", application.frameCount);
 		ImGui::Text("Total duration: %f s", application.totalAppDuration);
 		ImGui::Text("Average FPS: %f", 1000.0f / application.avgTotalFrameTime);
@@ -198,6 +342,9 @@ void DemoScene::DrawUi() const noexcept
 // -------------------------------------------------------------------
 DemoScene::~DemoScene()
 {
+	glDeleteBuffers(1, &m_InstanceXformsSsbo);
+	glDeleteBuffers(1, &m_IndirectCommands);
+
 	ImGui_ImplGlfwGL3_Shutdown();
 }
 
@@ -207,6 +354,29 @@ bool DemoScene::Initialize() noexcept
 	const auto seed = high_resolution_clock::now().time_since_epoch().count();
 	s_Rng = std::mt19937(seed);
 
+	ConfigFile cfg{ "config/config.cfg" };
+
+	if (!cfg.IsOpen()) {
+		ERROR_LOG("Failed to open configuration file");
+		return false;
+	}
+
+	const std::string renderMode{ cfg.GetString("attributes.render_mode", "per_draw") };
+
+	if (renderMode == "instanced") {
+		m_RenderMode = RenderMode::INSTANCED;
+	}
+	else if (renderMode == "indirect") {
+		m_RenderMode = RenderMode::INDIRECT;
+	}
+	else if (renderMode != "per_draw") {
+		ERROR_LOG("Unknown render mode: " + renderMode + ", falling back to per_draw.");
+	}
+
+	if (!m_ThreadPool.Initialize()) {
+		return false;
+	}
+
 	if (!GenerateCube(&m_CubeMesh, 1.0f)) {
 		ERROR_LOG("Failed to generate cube mesh.");
 		return false;
@@ -230,7 +400,10 @@ bool DemoScene::Initialize() noexcept
 
 	m_Material.textures[TEX_NORMAL] = G_ResourceManager.Get<GLTexture>("../../../Assets/opengl_norm.png");
 
-	const auto vert = G_ResourceManager.Get<GLShader>("sdr/default.vert.spv", VERTEX);
+	// The instanced vertex shader fetches the model matrix from the instance storage buffer, the indirect mode uses it too.
+	const auto vertexShaderFile = m_RenderMode == RenderMode::PER_DRAW ? "sdr/default.vert.spv" : "sdr/instanced.vert.spv";
+
+	const auto vert = G_ResourceManager.Get<GLShader>(vertexShaderFile, VERTEX);
 	const auto frag = G_ResourceManager.Get<GLShader>("sdr/default.frag.spv", FRAGMENT);
 
 	m_Pipeline.AddShader(vert);
@@ -267,6 +440,9 @@ static f64 entitiesToSpawn{ 0.0f };
 
 void DemoScene::Update(i64 msec, f64 dt) noexcept
 {
+	// The tasks of this frame are stored apart from the ones of the last frame.
+	m_ThreadPool.BeginEpoch();
+
 	if (!G_Application.benchmarkComplete) {
 		entitiesToSpawn += spawnRate * dt;
 
@@ -274,15 +450,18 @@ void DemoScene::Update(i64 msec, f64 dt) noexcept
 
 		entitiesToSpawn -= e;
 
-		int i = 0;
-		while (i < e) {
-			SpawnEntity();
-			++i;
-		}
+		Timer spawnTimer;
+		spawnTimer.Start();
 
-		for (auto& entity : m_Entities) {
-			entity->Update(dt);
-		}
+		SpawnEntities(e);
+
+		spawnTimer.Stop();
+
+		// Sampled by the application together with the frame time.
+		G_Application.spawnTime = spawnTimer.GetSec() * 1000.0;
+
+		// Only the transforms that changed since the last frame are recomputed.
+		m_Transforms.Update(m_ThreadPool);
 	}
 
 	assert(glGetError() == GL_NO_ERROR);
@@ -293,9 +472,25 @@ void DemoScene::Draw() noexcept
 	glClearBufferfv(GL_COLOR, 0, clearColor);
 	glClearBufferfv(GL_DEPTH, 0, &depthClearValue);
 
-	for (const auto& entity : m_Entities) {
-		m_Pipeline.SetMatrix4f("model", entity->GetXform(), VERTEX);
-		entity->Draw();
+	if (m_RenderMode != RenderMode::PER_DRAW) {
+		if (!m_Entities.empty() && UploadInstanceData()) {
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_InstanceXformsSsbo);
+			assert(glGetError() == GL_NO_ERROR);
+
+			// Every cube shares the mesh and the material, so one draw covers all of them.
+			if (m_RenderMode == RenderMode::INDIRECT) {
+				m_CubeMesh.DrawIndirect(m_IndirectCommands, 0, static_cast<GLsizei>(m_Entities.size()));
+			}
+			else {
+				m_CubeMesh.Draw(static_cast<GLsizei>(m_Entities.size()));
+			}
+		}
+	}
+	else {
+		for (const auto& entity : m_Entities) {
+			m_Pipeline.SetMatrix4f("model", m_Transforms.GetXform(entity->GetTransform()), VERTEX);
+			entity->Draw();
+		}
 	}
 
 	DrawUi();
@@ -306,11 +501,12 @@ void DemoScene::SaveToCsv(const std::string& fname) const
 	const auto& app = G_Application;
 	std::ofstream stream{ fname + ".csv" };
 
-	stream << "Whole Frame Time,CPU Time,GPU Time\n";
+	stream << "Whole Frame Time,CPU Time,GPU Time,Update Time,Record Time,Spawn Time\n";
 
 	for (auto i = 0u; i < app.totalFrameTimeSamples.size(); ++i) {
-		stream << app.totalFrameTimeSamples[i] << "," << app.totalCpuTimeSamples[i] << "," << app.totalGpuTimeSamples[i] <<
-				"\n";
+		stream << app.totalFrameTimeSamples[i] << "," << app.totalCpuTimeSamples[i] << "," << app.totalGpuTimeSamples[i] << ","
+				<< app.totalUpdateTimeSamples[i] << "," << app.totalRecordTimeSamples[i] << ","
+				<< app.totalSpawnTimeSamples[i] << "\n";
 	}
 
 	stream << "\nFPS,Whole Frame Time,CPU Time,GPU Time\n";
@@ -321,12 +517,28 @@ void DemoScene::SaveToCsv(const std::string& fname) const
 				"\n";
 	}
 
-	stream << "\nAverage FPS,Average Frame Time,Average CPU Time,Average GPU Time\n";
-	stream << 1000.0f / app.avgTotalFrameTime << "," << app.avgTotalFrameTime << "," << app.avgTotalCpuTime << "," << app.
-			avgTotalGpuTime;
+	stream << "\nAverage FPS,Average Frame Time,Average CPU Time,Average GPU Time,Average Update Time,Average Record Time\n";
+	stream << 1000.0f / app.avgTotalFrameTime << "," << app.avgTotalFrameTime << "," << app.avgTotalCpuTime << "," << app.avgTotalGpuTime << ","
+			<< app.avgTotalUpdateTime << "," << app.avgTotalRecordTime;
+
+	auto avgSpawnTime{ 0.0f };
+
+	for (const auto spawnTime : app.totalSpawnTimeSamples) {
+		avgSpawnTime += spawnTime;
+	}
+
+	if (!app.totalSpawnTimeSamples.empty()) {
+		avgSpawnTime /= static_cast<f32>(app.totalSpawnTimeSamples.size());
+	}
+
+	stream << "\nAverage Spawn Time\n";
+	stream << avgSpawnTime;
+
+	stream << "\nRender Mode\n";
+	stream << GetRenderModeName();
 
-	stream << "\nDraw Calls per Frame\n";
-	stream << m_Entities.size();
+	stream << "\nCubes per Frame,Draw Calls per Frame\n";
+	stream << m_Entities.size() << "," << GetDrawCallCount();
 
 	stream << "\n99th percentile\n";
 	stream << app.percentile99th;
@@ -3,13 +3,44 @@
 
 #include <memory>
 #include "demo_entity.h"
+#include "thread_pool.h"
 #include "gl_texture_sampler.h"
 #include "gl_program_pipeline.h"
 
+/**
+ * \brief How the cubes are submitted, selected with attributes.render_mode in config.cfg.
+ */
+enum class RenderMode {
+	// One model matrix uniform update and one draw per cube.
+	PER_DRAW,
+	// The world matrices go to a storage buffer and all the cubes are drawn with one instanced draw.
+	INSTANCED,
+	// Same storage buffer, plus one CPU written indirect command per cube submitted with multi draw indirect.
+	INDIRECT
+};
+
 class DemoScene final {
 private:
 	std::vector<std::unique_ptr<DemoEntity>> m_Entities;
 
+	TransformStore m_Transforms;
+
+	ThreadPool m_ThreadPool;
+
+	RenderMode m_RenderMode{ RenderMode::PER_DRAW };
+
+	/**
+	 * \brief World matrices of the entities in draw order, read by the instanced shader.
+	 */
+	GLuint m_InstanceXformsSsbo{ 0 };
+
+	/**
+	 * \brief One DrawElementsIndirectCommand per entity, rewritten every frame in indirect mode.
+	 */
+	GLuint m_IndirectCommands{ 0 };
+
+	size_t m_InstanceCapacity{ 0 };
+
 	GLMesh m_CubeMesh;
 
 	DemoMaterial m_Material;
@@ -18,7 +49,27 @@ private:
 
 	GLTextureSampler m_TextureSampler;
 
-	bool SpawnEntity() noexcept;
+	/**
+	 * \brief Spawns count entities at random positions.
+	 * \details The new entities are sorted on their own and merged into
+	 * m_Entities, which is kept sorted from back to front.
+	 */
+	bool SpawnEntities(size_t count) noexcept;
+
+	/**
+	 * \brief Grows the instance storage buffer, and the indirect command buffer, so that they fit count entities.
+	 */
+	void ReserveInstanceData(size_t count) noexcept;
+
+	/**
+	 * \brief Copies the world matrices of the entities, in draw order, to the instance storage buffer
+	 * and writes their indirect commands.
+	 */
+	bool UploadInstanceData() noexcept;
+
+	const char* GetRenderModeName() const noexcept;
+
+	size_t GetDrawCallCount() const noexcept;
 
 	void DrawUi() const noexcept;
 
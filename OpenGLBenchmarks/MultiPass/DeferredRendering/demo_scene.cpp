@@ -12,14 +12,30 @@
 #include "imgui_impl_glfw_gl3.h"
 #include "gl_application.h"
 #include "gl_texture.h"
+#include <cfg.h>
+#include <thread_pool.h>
 
 static const GLfloat clearColor[]{ 0.0f, 0.0f, 0.0f, 0.0f };
 static const GLfloat clearColor2[]{ 0.0f, 0.0f, 1.0f, 0.0f };
 static const auto depthClearValue{ 1.0f };
 
+// How many streamed textures get a level larger per frame at most.
+static constexpr ui32 s_StreamedTexturesPerFrame{ 4 };
+
 // Private functions -------------------------------------------------
 
 //Model loading --------------------------------------
+/**
+ * \brief A model imported with Assimp, and the vertices and indices its view points into.
+ */
+struct ImportedModel {
+	std::vector<std::vector<Vertex>> vertices;
+
+	std::vector<std::vector<ui32>> indices;
+
+	ModelView model;
+};
+
 static Vec3f AssVector(const aiVector3D vec) noexcept
 {
 	return Vec3f{ vec.x, vec.y, vec.z };
@@ -30,131 +46,277 @@ static Quatf AssQuat(const aiQuaternion q) noexcept
 	return Quatf{ q.w, q.x, q.y, q.z };
 }
 
-void DemoScene::LoadMeshes(const aiScene* scene) noexcept
+static std::string GetFileName(const std::string& path) noexcept
 {
-	for (auto i = 0; i < scene->mNumMeshes; ++i) {
-		auto mesh = new GLMesh;
+	auto n = path.rfind('/');
 
-		auto* aiMesh{ scene->mMeshes[i] };
+	if (n == std::string::npos) {
+		n = path.rfind('\\');
+	}
 
-		m_SceneVertexCount += aiMesh->mNumVertices;
+	if (n != std::string::npos) {
+		return path.substr(n + 1);
+	}
 
-		if (aiMesh->HasPositions()) {
-			std::vector<Vertex> vertices;
-			vertices.resize(aiMesh->mNumVertices);
+	return "";
+}
 
-			m_SceneVertexCount += aiMesh->mNumVertices;
+static void FlattenNode(const aiNode* aiNode, std::vector<ModelNode>& nodes) noexcept
+{
+	ModelNode node;
+	node.name = aiNode->mName.data;
+	node.meshIndex = aiNode->mNumMeshes > 0 ? static_cast<i32>(aiNode->mMeshes[0]) : -1;
+	node.childCount = aiNode->mNumChildren;
 
-			for (auto j = 0; j < vertices.size(); ++j) {
-				vertices[j].position = Vec3f{ aiMesh->mVertices[j].x, aiMesh->mVertices[j].y, aiMesh->mVertices[j].z };
-				vertices[j].normal = Vec3f{ aiMesh->mNormals[j].x, aiMesh->mNormals[j].y, aiMesh->mNormals[j].z };
-				vertices[j].tangent = Vec3f{ aiMesh->mTangents[j].x, aiMesh->mTangents[j].y, aiMesh->mTangents[j].z };
-				vertices[j].texcoord = Vec2f{ aiMesh->mTextureCoords[0][j].x, aiMesh->mTextureCoords[0][j].y };
-			}
+	aiVector3D aiPosition;
+	aiQuaternion aiOrientation;
+	aiVector3D aiScaling;
 
-			mesh->AddVertices(vertices);
-		}
-		else {
+	aiNode->mTransformation.Decompose(aiScaling, aiOrientation, aiPosition);
+
+	node.position = AssVector(aiPosition);
+	node.orientation = AssQuat(aiOrientation);
+	node.scale = AssVector(aiScaling);
+
+	nodes.push_back(node);
+
+	for (auto i = 0u; i < aiNode->mNumChildren; ++i) {
+		FlattenNode(aiNode->mChildren[i], nodes);
+	}
+}
+
+static bool ImportModel(const std::string& fileName, ImportedModel& imported) noexcept
+{
+	const auto scn = aiImportFile(fileName.c_str(),
+	                              aiProcess_GenSmoothNormals |
+	                              aiProcess_FixInfacingNormals |
+	                              aiProcess_Triangulate |
+	                              aiProcess_CalcTangentSpace | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices |
+	                              aiProcess_FixInfacingNormals | aiProcess_SortByPType);
+
+	if (!scn) {
+		ERROR_LOG("Failed to load scene: " + fileName);
+		return false;
+	}
+
+	if (!scn->mRootNode) {
+		ERROR_LOG("The model has no root node.");
+		aiReleaseImport(scn);
+		return false;
+	}
+
+	auto& model = imported.model;
+
+	imported.vertices.resize(scn->mNumMeshes);
+	imported.indices.resize(scn->mNumMeshes);
+	model.meshes.resize(scn->mNumMeshes);
+
+	for (auto i = 0u; i < scn->mNumMeshes; ++i) {
+		const auto* aiMesh{ scn->mMeshes[i] };
+
+		if (!aiMesh->HasPositions()) {
 			ERROR_LOG("Mesh has no vertices!");
-			delete mesh;
-			return;
+			aiReleaseImport(scn);
+			return false;
 		}
 
-		if (aiMesh->HasFaces()) {
-			std::vector<unsigned int> indices;
+		auto& vertices = imported.vertices[i];
+		vertices.resize(aiMesh->mNumVertices);
 
-			for (auto k = 0; k < aiMesh->mNumFaces; ++k) {
-				const auto& face = aiMesh->mFaces[k];
-				assert(face.mNumIndices == 3);
-				indices.push_back(face.mIndices[0]);
-				indices.push_back(face.mIndices[1]);
-				indices.push_back(face.mIndices[2]);
-			}
+		for (auto j = 0u; j < vertices.size(); ++j) {
+			vertices[j].position = AssVector(aiMesh->mVertices[j]);
+			vertices[j].normal = AssVector(aiMesh->mNormals[j]);
+			vertices[j].tangent = AssVector(aiMesh->mTangents[j]);
+			vertices[j].texcoord = Vec2f{ aiMesh->mTextureCoords[0][j].x, aiMesh->mTextureCoords[0][j].y };
+		}
+
+		// The faces are triangulated, so the index count is known up front.
+		auto& indices = imported.indices[i];
+		indices.resize(aiMesh->mNumFaces * 3);
 
-			mesh->AddIndices(indices);
+		for (auto k = 0u; k < aiMesh->mNumFaces; ++k) {
+			const auto& face = aiMesh->mFaces[k];
+			assert(face.mNumIndices == 3);
+			indices[k * 3] = face.mIndices[0];
+			indices[k * 3 + 1] = face.mIndices[1];
+			indices[k * 3 + 2] = face.mIndices[2];
 		}
 
-		mesh->CreateBuffers();
+		model.meshes[i].vertices = vertices.data();
+		model.meshes[i].vertexCount = static_cast<ui32>(vertices.size());
+		model.meshes[i].indices = indices.data();
+		model.meshes[i].indexCount = static_cast<ui32>(indices.size());
+		model.meshes[i].materialIndex = aiMesh->mMaterialIndex;
+	}
+
+	model.materials.resize(scn->mNumMaterials);
+
+	for (auto i = 0u; i < scn->mNumMaterials; ++i) {
+		const auto aiMaterial = scn->mMaterials[i];
 
-		mesh->SetMaterialIndex(aiMesh->mMaterialIndex);
+		auto& textures = model.materials[i].textures;
+
+		aiString path;
+		aiGetMaterialTexture(aiMaterial, aiTextureType_DIFFUSE, 0, &path);
+
+		textures[TEX_DIFFUSE] = GetFileName(path.data);
+
+		aiMaterial->GetTexture(aiTextureType_SPECULAR, 0, &path);
+
+		textures[TEX_SPECULAR] = GetFileName(path.data);
+
+		aiMaterial->GetTexture(aiTextureType_NORMALS, 0, &path);
+
+		textures[TEX_NORMAL] = GetFileName(path.data);
+	}
+
+	FlattenNode(scn->mRootNode, model.nodes);
+
+	aiReleaseImport(scn);
+
+	return true;
+}
+
+void DemoScene::LoadMeshes(const std::vector<ModelMesh>& meshes) noexcept
+{
+	for (const auto& modelMesh : meshes) {
+		auto mesh = new GLMesh;
+
+		m_SceneVertexCount += modelMesh.vertexCount;
+
+		// One copy each, straight out of the import or the mapped cache.
+		mesh->AddVertices(modelMesh.vertices, modelMesh.vertexCount);
+		mesh->AddIndices(modelMesh.indices, modelMesh.indexCount);
+
+		// Indirect draws come out of the merged scene mesh, the mesh only needs buffers of its own for per draw rendering.
+		if (m_RenderMode == RenderMode::INDIRECT) {
+			m_MeshRanges.push_back(m_SceneMesh.Append(*mesh));
+		}
+		else {
+			mesh->SetVertexLayout(m_VertexLayout);
+			mesh->CreateBuffers();
+		}
+
+		mesh->SetMaterialIndex(modelMesh.materialIndex);
 
 		m_Meshes.push_back(mesh);
 	}
 }
 
-void DemoScene::LoadMaterials(const aiScene* scene) noexcept
+std::string DemoScene::GetTexturePath(const std::string& fileName, const bool baked) const noexcept
 {
-	DemoMaterial material;
-	material.diffuse = Vec4f{ 1.0f };
-	material.specular = Vec4f{ 1.0f };
+	if (baked) {
+		return "../../../Assets/Baked/" + fileName.substr(0, fileName.rfind('.')) + TextureContainer::EXTENSION;
+	}
 
-	const auto GetFileName = [](std::string path) -> std::string
-	{
-		auto sepUnix = '/';
+	return "../../../Assets/" + fileName;
+}
+
+std::vector<GLTexture*> DemoScene::LoadTextures(const std::vector<std::string>& fileNames) noexcept
+{
+	std::vector<GLTexture*> textures(fileNames.size(), nullptr);
 
-		auto sepWindows = '\\';
+	// The pool only lives while the textures are decoded.
+	ThreadPool threadPool;
 
-		auto n = path.rfind(sepUnix);
+	if (m_TextureLoadMode == TextureLoadMode::PARALLEL && !threadPool.Initialize()) {
+		ERROR_LOG("Failed to initialize the texture load thread pool, falling back to serial.");
+		m_TextureLoadMode = TextureLoadMode::SERIAL;
+	}
 
-		if (n == std::string::npos) {
-			n = path.rfind(sepWindows);
+	// The baked containers first if they are selected, then the images of the textures still missing.
+	for (const auto baked : { true, false }) {
+		if (baked && !m_BakedTextures) {
+			continue;
 		}
 
-		if (n != std::string::npos) {
-			return path.substr(n + 1);
+		std::vector<ResourceHandle<GLTexture>> handles(fileNames.size());
+
+		for (size_t i = 0; i < fileNames.size(); ++i) {
+			if (textures[i]) {
+				continue;
+			}
+
+			const auto path = GetTexturePath(fileNames[i], baked);
+
+			if (m_TextureLoadMode == TextureLoadMode::SERIAL) {
+				textures[i] = G_ResourceManager.Get<GLTexture>(path, m_MipMode);
+			}
+			else {
+				handles[i] = G_ResourceManager.Request<GLTexture>(path, m_MipMode);
+			}
 		}
 
-		return "";
-	};
+		if (m_TextureLoadMode == TextureLoadMode::PARALLEL) {
+			// Decodes everything across the pool, then uploads it all on this thread, which owns the context.
+			G_ResourceManager.LoadRequested(threadPool);
 
-	for (auto i = 0; i < scene->mNumMaterials; ++i) {
-		const auto aiMaterial = scene->mMaterials[i];
+			for (size_t i = 0; i < fileNames.size(); ++i) {
+				if (!textures[i]) {
+					textures[i] = handles[i].Get();
+				}
+			}
+		}
 
-		aiString path;
-		aiGetMaterialTexture(aiMaterial, aiTextureType_DIFFUSE, 0, &path);
+		if (baked) {
+			const auto missingCount = std::count(textures.cbegin(), textures.cend(), nullptr);
 
-		material.textures[TEX_DIFFUSE] = G_ResourceManager.Get<GLTexture>("../../../Assets/" + GetFileName(path.data));
+			if (missingCount) {
+				ERROR_LOG(std::to_string(missingCount) + " material textures have no loadable baked container, falling back to the images.");
+			}
+		}
+	}
 
-		aiMaterial->GetTexture(aiTextureType_SPECULAR, 0, &path);
+	return textures;
+}
 
-		material.textures[TEX_SPECULAR] = G_ResourceManager.Get<GLTexture>("../../../Assets/" + GetFileName(path.data));
+void DemoScene::LoadMaterials(const std::vector<ModelMaterial>& materials) noexcept
+{
+	// The textures of every material are gathered first, so that they can be loaded as one batch.
+	std::vector<std::string> fileNames;
+	fileNames.reserve(materials.size() * SUPPORTED_TEX_COUNT);
 
-		aiMaterial->GetTexture(aiTextureType_NORMALS, 0, &path);
+	for (const auto& modelMaterial : materials) {
+		fileNames.insert(fileNames.cend(), modelMaterial.textures.cbegin(), modelMaterial.textures.cend());
+	}
 
-		material.textures[TEX_NORMAL] = G_ResourceManager.Get<GLTexture>("../../../Assets/" + GetFileName(path.data));
+	const auto textures = LoadTextures(fileNames);
+
+	DemoMaterial material;
+	material.diffuse = Vec4f{ 1.0f };
+	material.specular = Vec4f{ 1.0f };
+
+	for (size_t i = 0; i < materials.size(); ++i) {
+		for (auto type = 0; type < SUPPORTED_TEX_COUNT; ++type) {
+			material.textures[type] = textures[i * SUPPORTED_TEX_COUNT + type];
+		}
 
 		m_Materials.push_back(material);
 	}
 }
 
-DemoEntity* DemoScene::LoadNode(const aiNode* aiNode) noexcept
+DemoEntity* DemoScene::LoadNode(const std::vector<ModelNode>& nodes, size_t& nodeIndex) noexcept
 {
-	const std::string name = aiNode->mName.data;
+	const auto& node = nodes[nodeIndex++];
 
 	auto entity = new DemoEntity;
-	entity->SetName(name);
+	entity->SetName(node.name);
 
-	if (aiNode->mNumMeshes > 0) {
-		const auto mesh = m_Meshes[aiNode->mMeshes[0]];
+	if (node.meshIndex >= 0) {
+		const auto mesh = m_Meshes[node.meshIndex];
 
 		entity->SetMesh(mesh);
 		entity->SetMaterial(&m_Materials[mesh->GetMaterialIndex()]);
 	}
 
-	aiVector3D aiPosition;
-	aiQuaternion aiOrientation;
-	aiVector3D aiScaling;
-
-	aiNode->mTransformation.Decompose(aiScaling, aiOrientation, aiPosition);
-
-	entity->SetPosition(AssVector(aiPosition));
-	entity->SetOrientation(AssQuat(aiOrientation));
-	entity->SetScale(AssVector(aiScaling));
+	entity->SetPosition(node.position);
+	entity->SetOrientation(node.orientation);
+	entity->SetScale(node.scale);
 
 
 	// recursion for all the children
-	for (int i = 0; i < aiNode->mNumChildren; ++i) {
-		Entity* child{ LoadNode(aiNode->mChildren[i]) };
+	for (auto i = 0u; i < node.childCount; ++i) {
+		Entity* child{ LoadNode(nodes, nodeIndex) };
 
 		entity->AddChild(child);
 	}
@@ -164,76 +326,418 @@ DemoEntity* DemoScene::LoadNode(const aiNode* aiNode) noexcept
 
 std::unique_ptr<DemoEntity> DemoScene::LoadModel(const std::string& fileName) noexcept
 {
+	Timer timer;
+	timer.Start();
+
 	auto result = std::make_unique<DemoEntity>();
 
-	const auto scn = aiImportFile(fileName.c_str(),
-	                              aiProcess_GenSmoothNormals |
-	                              aiProcess_FixInfacingNormals |
-	                              aiProcess_Triangulate |
-	                              aiProcess_CalcTangentSpace | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices |
-	                              aiProcess_FixInfacingNormals | aiProcess_SortByPType);
+	const auto cacheFileName = fileName + ModelCache::EXTENSION;
+	const auto sourceStamp = ModelCache::GetSourceStamp(fileName);
 
-	if (!scn) {
-		ERROR_LOG("Failed to load scene: " + fileName);
-		return nullptr;
+	// Owns the meshes of the model when it is imported instead of mapped from the cache.
+	ImportedModel imported;
+
+	ModelCache cache;
+
+	m_ModelCacheWarm = m_ModelCacheEnabled && cache.Open(cacheFileName, sourceStamp);
+
+	if (!m_ModelCacheWarm) {
+		if (!ImportModel(fileName, imported)) {
+			return nullptr;
+		}
+
+		if (m_ModelCacheEnabled && !ModelCache::Write(cacheFileName, sourceStamp, imported.model)) {
+			ERROR_LOG("Failed to write the model cache, the model will be imported again next time.");
+		}
 	}
 
-	if (scn->HasMeshes()) {
-		LoadMeshes(scn);
+	const auto& model = m_ModelCacheWarm ? cache.GetModel() : imported.model;
+
+	LoadMeshes(model.meshes);
+
+	if (!model.materials.empty()) {
+		// Loading the materials loads their textures, which is where the mip chains are built.
+		Timer textureTimer;
+		textureTimer.Start();
+
+		LoadMaterials(model.materials);
+
+		m_TextureLoadTime = textureTimer.GetSec() * 1000.0;
 	}
 
-	if (scn->HasMaterials()) {
-		LoadMaterials(scn);
+	// The root node itself is skipped, its children are the entities of the model.
+	size_t nodeIndex{ 1 };
+
+	for (auto i = 0u; i < model.nodes[0].childCount; ++i) {
+		const auto entity = LoadNode(model.nodes, nodeIndex);
+
+		result->AddChild(entity);
 	}
 
-	const auto rootNode = scn->mRootNode;
+	// The textures are reported on their own.
+	m_ModelLoadTime = timer.GetSec() * 1000.0 - m_TextureLoadTime;
 
-	if (rootNode) {
-		for (auto i = 0; i < rootNode->mNumChildren; ++i) {
-			const auto child = rootNode->mChildren[i];
+	LOG("Model load time (" + std::string{ GetModelCacheStateName() } + "): " + std::to_string(m_ModelLoadTime) + " ms, " +
+		std::to_string(model.meshes.size()) + " meshes, " + std::to_string(m_SceneVertexCount) + " vertices.");
 
-			const auto entity = LoadNode(child);
+	return std::move(result);
+}
+
+// -------------------------------------------------
+
+void DemoScene::CollectDraws(DemoEntity* entity) noexcept
+{
+	const auto mesh = entity->GetMesh();
+
+	if (mesh && entity->GetMaterial()) {
+		const auto meshIndex = std::find(m_Meshes.cbegin(), m_Meshes.cend(), mesh) - m_Meshes.cbegin();
+
+		m_Draws.push_back(SceneDraw{ entity, static_cast<ui32>(meshIndex) });
+	}
 
-			result->AddChild(entity);
+	for (auto child : entity->GetChildren()) {
+		CollectDraws(static_cast<DemoEntity*>(child));
+	}
+}
+
+void DemoScene::BuildDrawList() noexcept
+{
+	for (auto& entity : m_Entities) {
+		CollectDraws(entity.get());
+	}
+
+	// Textures are bound per material, so the draws of each material have to be contiguous.
+	std::stable_sort(m_Draws.begin(), m_Draws.end(), [](const SceneDraw& a, const SceneDraw& b)
+	{
+		return a.entity->GetMaterial() < b.entity->GetMaterial();
+	});
+
+	for (auto i = 0u; i < m_Draws.size(); ++i) {
+		const auto material = m_Draws[i].entity->GetMaterial();
+
+		if (m_DrawBatches.empty() || m_DrawBatches.back().material != material) {
+			m_DrawBatches.push_back(DrawBatch{ material, i, 0 });
 		}
+
+		++m_DrawBatches.back().drawCount;
 	}
-	else {
-		ERROR_LOG("The model has no root node.");
-		return nullptr;
+}
+
+bool DemoScene::PrepareIndirectDraws() noexcept
+{
+	if (!m_SceneMesh.CreateBuffers()) {
+		ERROR_LOG("Failed to create the scene mesh buffers.");
+		return false;
 	}
 
-	aiReleaseImport(scn);
+	// The scene is loaded once, so the buffers are sized once.
+	const auto drawCount = std::max<size_t>(m_Draws.size(), 1);
 
-	return std::move(result);
+	glCreateBuffers(1, &m_DrawXformsSsbo);
+	glNamedBufferData(m_DrawXformsSsbo, drawCount * sizeof(Mat4f), nullptr, GL_STREAM_DRAW);
+
+	glCreateBuffers(1, &m_IndirectCommands);
+	glNamedBufferData(m_IndirectCommands, drawCount * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_DRAW);
+
+	assert(glGetError() == GL_NO_ERROR);
+
+	return true;
 }
 
-// -------------------------------------------------
+bool DemoScene::UploadIndirectDraws() noexcept
+{
+	if (m_Draws.empty()) {
+		return false;
+	}
+
+	// Invalidating the buffers lets the driver hand out fresh storage instead of
+	// waiting for the previous frame to stop reading from them.
+	const auto drawXforms = static_cast<Mat4f*>(glMapNamedBufferRange(m_DrawXformsSsbo,
+	                                                                  0,
+	                                                                  m_Draws.size() * sizeof(Mat4f),
+	                                                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+
+	if (!drawXforms) {
+		ERROR_LOG("Failed to map draw transforms storage buffer.");
+		return false;
+	}
+
+	const auto commands = static_cast<DrawElementsIndirectCommand*>(
+		glMapNamedBufferRange(m_IndirectCommands,
+		                      0,
+		                      m_Draws.size() * sizeof(DrawElementsIndirectCommand),
+		                      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+
+	if (!commands) {
+		glUnmapNamedBuffer(m_DrawXformsSsbo);
+		ERROR_LOG("Failed to map indirect command buffer.");
+		return false;
+	}
+
+	for (auto i = 0u; i < m_Draws.size(); ++i) {
+		memcpy(&drawXforms[i], &m_Draws[i].entity->GetXform(), sizeof(Mat4f));
+
+		const auto& range = m_MeshRanges[m_Draws[i].meshIndex];
+
+		// baseInstance selects the entity's world matrix in the vertex shader.
+		commands[i].count = range.indexCount;
+		commands[i].instanceCount = 1;
+		commands[i].firstIndex = range.firstIndex;
+		commands[i].baseVertex = range.vertexOffset;
+		commands[i].baseInstance = i;
+	}
+
+	glUnmapNamedBuffer(m_DrawXformsSsbo);
+	glUnmapNamedBuffer(m_IndirectCommands);
+	assert(glGetError() == GL_NO_ERROR);
+
+	return true;
+}
+
+const char* DemoScene::GetRenderModeName() const noexcept
+{
+	return m_RenderMode == RenderMode::INDIRECT ? "Multi draw indirect" : "Per draw";
+}
+
+size_t DemoScene::GetDrawCallCount() const noexcept
+{
+	return m_RenderMode == RenderMode::INDIRECT ? m_DrawBatches.size() : m_Draws.size();
+}
+
+const char* DemoScene::GetTextureLoadModeName() const noexcept
+{
+	return m_TextureLoadMode == TextureLoadMode::PARALLEL ? "parallel" : "serial";
+}
+
+const char* DemoScene::GetModelCacheStateName() const noexcept
+{
+	if (!m_ModelCacheEnabled) {
+		return "cache off";
+	}
+
+	return m_ModelCacheWarm ? "warm cache" : "cold cache";
+}
+
+const char* DemoScene::GetMipModeName() const noexcept
+{
+	switch (m_MipMode) {
+		case TextureMipMode::FULL:
+			return "Full chain";
+		case TextureMipMode::STREAMED:
+			return "Streamed";
+		default:
+			return "None";
+	}
+}
+
+const char* DemoScene::GetVertexLayoutName() const noexcept
+{
+	switch (m_VertexLayout.GetType()) {
+		case VertexLayoutType::PACKED:
+			return "packed";
+		case VertexLayoutType::OCTAHEDRAL:
+			return "octahedral";
+		default:
+			return "full";
+	}
+}
+
+void DemoScene::StreamTextures() noexcept
+{
+	// The textures with the fewest resident levels go first, a few per frame so that no frame uploads much.
+	std::stable_sort(m_StreamedTextures.begin(), m_StreamedTextures.end(), [](const GLTexture* a, const GLTexture* b)
+	{
+		return a->GetResidentLevel() > b->GetResidentLevel();
+	});
+
+	size_t residentBytes{ 0 };
+
+	for (const auto texture : m_StreamedTextures) {
+		residentBytes += texture->GetResidentBytes();
+	}
+
+	auto streamedCount = 0u;
+
+	for (const auto texture : m_StreamedTextures) {
+		if (streamedCount == s_StreamedTexturesPerFrame || !texture->GetResidentLevel()) {
+			break;
+		}
+
+		const auto nextLevelBytes = texture->GetNextLevelBytes();
+
+		if (residentBytes + nextLevelBytes > m_MipBudget || !texture->StreamNextLevel()) {
+			continue;
+		}
+
+		residentBytes += nextLevelBytes;
+		++streamedCount;
+	}
+
+	m_ResidentTextureBytes = residentBytes;
+}
+
+void DemoScene::ReadGBufferGpuTime() noexcept
+{
+	if (!m_GBufferQueriesIssued) {
+		return;
+	}
+
+	// The application waited for the previous frame, so the results are there.
+	GLuint64 start{ 0 };
+	GLuint64 end{ 0 };
+
+	glGetQueryObjectui64v(m_GBufferQueries[0], GL_QUERY_RESULT, &start);
+	glGetQueryObjectui64v(m_GBufferQueries[1], GL_QUERY_RESULT, &end);
+
+	m_GBufferGpuTime = static_cast<f32>((end - start) * 1e-6);
+
+	m_GBufferGpuTimeSum += m_GBufferGpuTime;
+	++m_GBufferGpuTimeCount;
+}
 
 // -------------------------------------------------------------------
 DemoScene::~DemoScene()
 {
+	if (m_GBufferGpuTimeCount) {
+		LOG("Average G-Buffer GPU time (mips: " + std::string{ GetMipModeName() } +
+			", vertex layout: " + GetVertexLayoutName() + ", " + std::to_string(m_VertexLayout.GetStride()) + " bytes): " +
+			std::to_string(m_GBufferGpuTimeSum / m_GBufferGpuTimeCount) + " ms.");
+	}
+
 	for (auto mesh : m_Meshes) {
 		delete mesh;
 	}
 	m_Meshes.clear();
 
+	glDeleteBuffers(1, &m_DrawXformsSsbo);
+	glDeleteBuffers(1, &m_IndirectCommands);
+
 	glDeleteVertexArrays(1, &m_FullscreenVA);
 
+	glDeleteQueries(static_cast<GLsizei>(m_GBufferQueries.size()), m_GBufferQueries.data());
+
 	ImGui_ImplGlfwGL3_Shutdown();
 }
 
 bool DemoScene::Initialize() noexcept
 {
+	Timer loadTimer;
+	loadTimer.Start();
+
 	const auto& window = G_Application.GetWindow();
 
+	ConfigFile cfg{ "config/config.cfg" };
+
+	if (!cfg.IsOpen()) {
+		ERROR_LOG("Failed to open the configuration file.");
+		return false;
+	}
+
+	const std::string renderMode{ cfg.GetString("attributes.render_mode", "per_draw") };
+
+	if (renderMode == "indirect") {
+		m_RenderMode = RenderMode::INDIRECT;
+	}
+	else if (renderMode != "per_draw") {
+		ERROR_LOG("Unknown render mode: " + renderMode + ", falling back to per_draw.");
+	}
+
+	const std::string mips{ cfg.GetString("attributes.mips", "none") };
+
+	if (mips == "full") {
+		m_MipMode = TextureMipMode::FULL;
+	}
+	else if (mips == "streamed") {
+		m_MipMode = TextureMipMode::STREAMED;
+	}
+	else if (mips != "none") {
+		ERROR_LOG("Unknown mip mode: " + mips + ", falling back to none.");
+	}
+
+	m_MipBudget = static_cast<size_t>(std::max(0, cfg.GetInteger("attributes.mip_budget", 256))) * 1024 * 1024;
+
+	const std::string textureLoad{ cfg.GetString("attributes.texture_load", "parallel") };
+
+	if (textureLoad == "serial") {
+		m_TextureLoadMode = TextureLoadMode::SERIAL;
+	}
+	else if (textureLoad != "parallel") {
+		ERROR_LOG("Unknown texture load mode: " + textureLoad + ", falling back to parallel.");
+	}
+
+	const std::string textures{ cfg.GetString("attributes.textures", "source") };
+
+	if (textures == "baked") {
+		m_BakedTextures = true;
+	}
+	else if (textures != "source") {
+		ERROR_LOG("Unknown texture source: " + textures + ", falling back to source.");
+	}
+
+	const std::string modelCache{ cfg.GetString("attributes.model_cache", "on") };
+
+	if (modelCache == "off") {
+		m_ModelCacheEnabled = false;
+	}
+	else if (modelCache != "on") {
+		ERROR_LOG("Unknown model cache mode: " + modelCache + ", falling back to on.");
+	}
+
+	const std::string vertexLayout{ cfg.GetString("attributes.vertex_layout", "full") };
+	const std::string vertexColor{ cfg.GetString("attributes.vertex_color", "off") };
+
+	if (vertexColor != "on" && vertexColor != "off") {
+		ERROR_LOG("Unknown vertex color mode: " + vertexColor + ", falling back to off.");
+	}
+
+	if (vertexLayout == "packed") {
+		m_VertexLayout = VertexLayout{ VertexLayoutType::PACKED, vertexColor == "on" };
+	}
+	else if (vertexLayout == "octahedral") {
+		m_VertexLayout = VertexLayout{ VertexLayoutType::OCTAHEDRAL, vertexColor == "on" };
+	}
+	else if (vertexLayout != "full") {
+		ERROR_LOG("Unknown vertex layout: " + vertexLayout + ", falling back to full.");
+	}
+
+	m_SceneMesh.SetVertexLayout(m_VertexLayout);
+
 	m_Entities.push_back(LoadModel("../../../Assets/scene.fbx"));
 
 	for (auto& entity : m_Entities) {
 		entity->Update(0.0f);
 	}
 
+	std::vector<GLTexture*> sceneTextures;
+
+	for (const auto& material : m_Materials) {
+		for (const auto texture : material.textures) {
+			if (texture && std::find(sceneTextures.cbegin(), sceneTextures.cend(), texture) == sceneTextures.cend()) {
+				sceneTextures.push_back(texture);
+				m_TextureMemory += texture->GetResidentBytes();
+			}
+		}
+	}
+
+	LOG("Texture load time (mips: " + std::string{ GetMipModeName() } + ", textures: " +
+		(m_BakedTextures ? "baked" : "source") + ", " + GetTextureLoadModeName() + "): " + std::to_string(m_TextureLoadTime) + " ms, " +
+		std::to_string(m_TextureMemory / (1024 * 1024)) + " MiB of texture memory.");
+
+	if (m_MipMode == TextureMipMode::STREAMED) {
+		m_StreamedTextures = std::move(sceneTextures);
+	}
+
+	glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(m_GBufferQueries.size()), m_GBufferQueries.data());
+
+	BuildDrawList();
+
+	if (m_RenderMode == RenderMode::INDIRECT && !PrepareIndirectDraws()) {
+		ERROR_LOG("Failed to prepare the scene's indirect draws.");
+		return false;
+	}
+
 	GLTextureSamplerCreateInfo samplerCreateInfo{};
-	samplerCreateInfo.minFilter = GL_LINEAR;
+	samplerCreateInfo.minFilter = m_MipMode == TextureMipMode::NONE ? GL_LINEAR : GL_LINEAR_MIPMAP_LINEAR;
 	samplerCreateInfo.magFilter = GL_LINEAR;
 	samplerCreateInfo.wrapS = GL_REPEAT;
 	samplerCreateInfo.wrapT = GL_REPEAT;
@@ -282,7 +786,10 @@ bool DemoScene::Initialize() noexcept
 	m_LightsUbo.Create();
 
 	//Initialize pipelines;
-	auto vert = G_ResourceManager.Get<GLShader>("sdr/deferred.vert.spv", VERTEX);
+	// The indirect vertex shader fetches the model matrix from the draw transforms storage buffer.
+	const auto vertexShaderFile = m_RenderMode == RenderMode::INDIRECT ? "sdr/deferred_indirect.vert.spv" : "sdr/deferred.vert.spv";
+
+	auto vert = G_ResourceManager.Get<GLShader>(vertexShaderFile, VERTEX);
 	auto frag = G_ResourceManager.Get<GLShader>("sdr/deferred.frag.spv", FRAGMENT);
 
 	m_DeferredPipeline.AddShader(vert);
@@ -293,6 +800,8 @@ bool DemoScene::Initialize() noexcept
 		return false;
 	}
 
+	m_DeferredPipeline.SetInteger("octahedralVectors", m_VertexLayout.HasOctahedralVectors() ? 1 : 0, VERTEX);
+
 	vert = G_ResourceManager.Get<GLShader>("sdr/display.vert.spv", VERTEX);
 	frag = G_ResourceManager.Get<GLShader>("sdr/display.frag.spv", FRAGMENT);
 
@@ -312,7 +821,15 @@ bool DemoScene::Initialize() noexcept
 
 	assert(glGetError() == GL_NO_ERROR);
 
-	return ImGui_ImplGlfwGL3_Init(window, true);
+	if (!ImGui_ImplGlfwGL3_Init(window, true)) {
+		return false;
+	}
+
+	m_SceneLoadTime = loadTimer.GetSec() * 1000.0;
+
+	LOG("Scene load time (" + std::string{ GetTextureLoadModeName() } + " texture load): " + std::to_string(m_SceneLoadTime) + " ms.");
+
+	return true;
 }
 
 void DemoScene::Update(i64 msec, f64 dt) noexcept
@@ -450,6 +967,23 @@ void DemoScene::DrawUi() const noexcept
 
 		ImGui::NewLine();
 		ImGui::Text("Total Vertex Count: %d", m_SceneVertexCount);
+		ImGui::Text("Render mode: %s", GetRenderModeName());
+		ImGui::Text("Draw calls: %zu", GetDrawCallCount());
+		ImGui::Text("Mips: %s", GetMipModeName());
+		ImGui::Text("Textures: %s", m_BakedTextures ? "Baked" : "Source");
+		ImGui::Text("Model load time: %f ms (%s)", m_ModelLoadTime, GetModelCacheStateName());
+		ImGui::Text("Vertex layout: %s (%u bytes)", GetVertexLayoutName(), m_VertexLayout.GetStride());
+		ImGui::Text("Scene load time: %f ms (%s texture load)", m_SceneLoadTime, GetTextureLoadModeName());
+		ImGui::Text("Texture load time: %f ms", m_TextureLoadTime);
+		ImGui::Text("Texture memory at load: %.1f MiB", static_cast<f64>(m_TextureMemory) / (1024.0 * 1024.0));
+		ImGui::Text("G-Buffer GPU time: %f ms", m_GBufferGpuTime);
+
+		if (m_MipMode == TextureMipMode::STREAMED) {
+			ImGui::Text("Resident texture memory: %.1f / %.1f MiB",
+			            static_cast<f64>(m_ResidentTextureBytes) / (1024.0 * 1024.0),
+			            static_cast<f64>(m_MipBudget) / (1024.0 * 1024.0));
+		}
+
 		ImGui::Text("Running time: %f s", application.GetTimer().GetSec());
 		ImGui::Text("Frame count: %lld", application.frameCount);
 		ImGui::End();
@@ -502,12 +1036,23 @@ void DemoScene::DrawUi() const noexcept
 		ImGui::NewLine();
 
 		ImGui::Text("Total Vertex Count: %d", m_SceneVertexCount);
+		ImGui::Text("Render mode: %s", GetRenderModeName());
+		ImGui::Text("Draw calls: %zu", GetDrawCallCount());
 		ImGui::Text("Total Frames: %lld", application.frameCount);
 		ImGui::Text("Total duration: %f s", application.totalAppDuration);
 		ImGui::Text("Average FPS: %f", 1000.0f / application.avgTotalFrameTime);
 		ImGui::Text("Average frame time: %f ms", application.avgTotalFrameTime);
 		ImGui::Text("Average CPU time: %f ms", application.avgTotalCpuTime);
 		ImGui::Text("Average GPU time: %f ms", application.avgTotalGpuTime);
+		ImGui::Text("Mips: %s", GetMipModeName());
+		ImGui::Text("Textures: %s", m_BakedTextures ? "Baked" : "Source");
+		ImGui::Text("Model load time: %f ms (%s)", m_ModelLoadTime, GetModelCacheStateName());
+		ImGui::Text("Vertex layout: %s (%u bytes)", GetVertexLayoutName(), m_VertexLayout.GetStride());
+		ImGui::Text("Scene load time: %f ms (%s texture load)", m_SceneLoadTime, GetTextureLoadModeName());
+		ImGui::Text("Texture load time: %f ms", m_TextureLoadTime);
+		ImGui::Text("Texture memory at load: %.1f MiB", static_cast<f64>(m_TextureMemory) / (1024.0 * 1024.0));
+		ImGui::Text("Average G-Buffer GPU time: %f ms",
+		            m_GBufferGpuTimeCount ? m_GBufferGpuTimeSum / m_GBufferGpuTimeCount : 0.0);
 		ImGui::Text("99th percentile (lower is better): %f ms", application.percentile99th);
 
 		ImGui::NewLine();
@@ -530,14 +1075,43 @@ void DemoScene::DrawUi() const noexcept
 
 void DemoScene::Draw() noexcept
 {
+	ReadGBufferGpuTime();
+
+	if (m_MipMode == TextureMipMode::STREAMED) {
+		StreamTextures();
+	}
+
+	glQueryCounter(m_GBufferQueries[0], GL_TIMESTAMP);
+
 	glClearBufferfv(GL_COLOR, 4, clearColor);
 	glClearBufferfv(GL_DEPTH, 0, &depthClearValue);
 
 	m_DeferredPipeline.Clear();
 
-	for (const auto& entity : m_Entities) {
-		DrawEntity(entity.get());
+	if (m_RenderMode == RenderMode::INDIRECT) {
+		if (UploadIndirectDraws()) {
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_DrawXformsSsbo);
+			assert(glGetError() == GL_NO_ERROR);
+
+			for (const auto& batch : m_DrawBatches) {
+				m_DeferredPipeline.SetTexture("diffuseSampler", batch.material->textures[TEX_DIFFUSE], m_TextureSampler, FRAGMENT);
+				m_DeferredPipeline.SetTexture("specularSampler", batch.material->textures[TEX_SPECULAR], m_TextureSampler, FRAGMENT);
+				m_DeferredPipeline.SetTexture("normalSampler", batch.material->textures[TEX_NORMAL], m_TextureSampler, FRAGMENT);
+
+				m_SceneMesh.DrawIndirect(m_IndirectCommands,
+				                         batch.firstDraw * sizeof(DrawElementsIndirectCommand),
+				                         static_cast<GLsizei>(batch.drawCount));
+			}
+		}
 	}
+	else {
+		for (const auto& entity : m_Entities) {
+			DrawEntity(entity.get());
+		}
+	}
+
+	glQueryCounter(m_GBufferQueries[1], GL_TIMESTAMP);
+	m_GBufferQueriesIssued = true;
 
 	m_DisplayPipeline.Bind();
 	m_DisplayPipeline.Clear();
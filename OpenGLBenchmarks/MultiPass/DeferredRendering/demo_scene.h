@@ -2,6 +2,7 @@
 #define DISSERTATION_DEMO_SCENE_H
 
 #include <memory>
+#include <model_cache.h>
 #include "demo_entity.h"
 #include "assimp/scene.h"
 #include "gl_render_target.h"
@@ -23,10 +24,63 @@ struct Lights {
     Vec3f eyePos;
 };
 
+/**
+ * \brief How the scene is submitted, selected with attributes.render_mode in config.cfg.
+ */
+enum class RenderMode {
+	// One model matrix uniform update, three texture binds and one draw per entity.
+	PER_DRAW,
+	// All the meshes share one vertex and index buffer, the world matrices go to a storage
+	// buffer and the entities of each material are submitted with one multi draw indirect.
+	INDIRECT
+};
+
+/**
+ * \brief How the textures are loaded at startup, selected with attributes.texture_load in config.cfg.
+ */
+enum class TextureLoadMode {
+	// Decoded and uploaded one after the other on the main thread.
+	SERIAL,
+	// Decoded across the workers of a thread pool, then uploaded together on the main thread.
+	PARALLEL
+};
+
 class DemoScene final {
 private:
 	std::vector<std::unique_ptr<DemoEntity>> m_Entities;
 
+	RenderMode m_RenderMode{ RenderMode::PER_DRAW };
+
+	/**
+	 * \brief Selected with attributes.mips in config.cfg.
+	 */
+	TextureMipMode m_MipMode{ TextureMipMode::NONE };
+
+	/**
+	 * \brief Selected with attributes.textures in config.cfg. Loads the containers
+	 * written by the texture baker instead of decoding the images.
+	 */
+	bool m_BakedTextures{ false };
+
+	TextureLoadMode m_TextureLoadMode{ TextureLoadMode::PARALLEL };
+
+	/**
+	 * \brief Selected with attributes.model_cache in config.cfg. Maps the model from the
+	 * cache written next to it after the first import, instead of importing it again.
+	 */
+	bool m_ModelCacheEnabled{ true };
+
+	/**
+	 * \brief TRUE if the model was loaded from an up to date cache.
+	 */
+	bool m_ModelCacheWarm{ false };
+
+	/**
+	 * \brief Selected with attributes.vertex_layout and attributes.vertex_color in config.cfg.
+	 * Every mesh and the vertex arrays use it.
+	 */
+	VertexLayout m_VertexLayout;
+
 	GLProgramPipeline m_DeferredPipeline;
 
 	GLProgramPipeline m_DisplayPipeline;
@@ -48,22 +102,168 @@ private:
 	std::array<const char*, 6> m_AttachmentComboItems{ "Lit", "Position", "Normals", "Albedo", "Specular", "Depth" };
 
 	i64 m_SceneVertexCount{ 0 };
+
+	/**
+	 * \brief CPU time spent loading the textures of the scene, mip chains included, in ms.
+	 */
+	f64 m_TextureLoadTime{ 0.0 };
+
+	/**
+	 * \brief CPU time spent loading the model without its textures, import or cache included, in ms.
+	 */
+	f64 m_ModelLoadTime{ 0.0 };
+
+	/**
+	 * \brief CPU time spent in Initialize(), in ms.
+	 */
+	f64 m_SceneLoadTime{ 0.0 };
+
+	/**
+	 * \brief Size of the levels of every texture that are resident once the scene is loaded.
+	 */
+	size_t m_TextureMemory{ 0 };
+
+	/**
+	 * \brief Timestamps around the G-Buffer pass. The application already times the
+	 * whole frame with a GL_TIME_ELAPSED query, which cannot be nested.
+	 */
+	std::array<GLuint, 2> m_GBufferQueries{};
+
+	bool m_GBufferQueriesIssued{ false };
+
+	f32 m_GBufferGpuTime{ 0.0f };
+
+	f64 m_GBufferGpuTimeSum{ 0.0 };
+
+	ui64 m_GBufferGpuTimeCount{ 0 };
 	// ---------------------------
 
+	// Mip streaming --------------------
+	/**
+	 * \brief Every distinct texture of m_Materials, only filled in the streamed mip mode.
+	 */
+	std::vector<GLTexture*> m_StreamedTextures;
+
+	/**
+	 * \brief Texture memory the resident levels may use, selected with attributes.mip_budget in config.cfg.
+	 */
+	size_t m_MipBudget{ 0 };
+
+	size_t m_ResidentTextureBytes{ 0 };
+	//----------------------------------
+
 	// Model Loading--------------------
 	std::vector<DemoMaterial> m_Materials;
 
 	std::vector<GLMesh*> m_Meshes;
 
-	void LoadMeshes(const aiScene* scene) noexcept;
+	// Indirect drawing -----------------
+	/**
+	 * \brief Every mesh of m_Meshes packed into a single vertex and index buffer.
+	 */
+	GLMesh m_SceneMesh;
 
-	void LoadMaterials(const aiScene* scene) noexcept;
+	/**
+	 * \brief Range of each mesh of m_Meshes in m_SceneMesh.
+	 */
+	std::vector<MeshRange> m_MeshRanges;
 
-	DemoEntity* LoadNode(const aiNode* aiNode) noexcept;
+	struct SceneDraw {
+		DemoEntity* entity{ nullptr };
+		ui32 meshIndex{ 0 };
+	};
 
+	/**
+	 * \brief A run of consecutive draws that share a material.
+	 */
+	struct DrawBatch {
+		DemoMaterial* material{ nullptr };
+		ui32 firstDraw{ 0 };
+		ui32 drawCount{ 0 };
+	};
+
+	/**
+	 * \brief Entities with a mesh and a material, sorted by material. Draw i uses indirect command i.
+	 */
+	std::vector<SceneDraw> m_Draws;
+
+	std::vector<DrawBatch> m_DrawBatches;
+
+	/**
+	 * \brief World matrices of m_Draws, read through gl_BaseInstanceARB by the indirect shader.
+	 */
+	GLuint m_DrawXformsSsbo{ 0 };
+
+	/**
+	 * \brief One DrawElementsIndirectCommand per draw of m_Draws, rewritten every frame.
+	 */
+	GLuint m_IndirectCommands{ 0 };
+	//----------------------------------
+
+	void LoadMeshes(const std::vector<ModelMesh>& meshes) noexcept;
+
+	std::string GetTexturePath(const std::string& fileName, bool baked) const noexcept;
+
+	/**
+	 * \brief Loads the textures of the materials, listed in TextureType order for each material.
+	 * \details Loads the baked containers if they are selected and the images of those
+	 * that fail to load, or of all of them otherwise.
+	 */
+	std::vector<GLTexture*> LoadTextures(const std::vector<std::string>& fileNames) noexcept;
+
+	void LoadMaterials(const std::vector<ModelMaterial>& materials) noexcept;
+
+	/**
+	 * \brief Creates the entity of the node at nodeIndex and those of its children.
+	 * \param nodeIndex Advanced past the node and its children.
+	 */
+	DemoEntity* LoadNode(const std::vector<ModelNode>& nodes, size_t& nodeIndex) noexcept;
+
+	/**
+	 * \brief Maps the model from its cache if it is up to date, or imports it and writes the cache otherwise.
+	 */
 	std::unique_ptr<DemoEntity> LoadModel(const std::string& fileName) noexcept;
 	//----------------------------------
 
+	void CollectDraws(DemoEntity* entity) noexcept;
+
+	/**
+	 * \brief Gathers the entities of the hierarchy into m_Draws and groups them into material batches.
+	 */
+	void BuildDrawList() noexcept;
+
+	/**
+	 * \brief Creates the scene mesh buffers and the storage and indirect buffers used by the indirect render mode.
+	 */
+	bool PrepareIndirectDraws() noexcept;
+
+	/**
+	 * \brief Writes the world matrix and the indirect command of every draw of m_Draws.
+	 */
+	bool UploadIndirectDraws() noexcept;
+
+	const char* GetRenderModeName() const noexcept;
+
+	const char* GetTextureLoadModeName() const noexcept;
+
+	const char* GetModelCacheStateName() const noexcept;
+
+	const char* GetMipModeName() const noexcept;
+
+	const char* GetVertexLayoutName() const noexcept;
+
+	/**
+	 * \brief Makes more levels of the streamed textures resident, as long as they fit in the mip budget.
+	 */
+	void StreamTextures() noexcept;
+
+	/**
+	 * \brief Reads the timestamps of the previous G-Buffer pass.
+	 */
+	void ReadGBufferGpuTime() noexcept;
+
+	size_t GetDrawCallCount() const noexcept;
+
 	void DrawEntity(DemoEntity* entity) noexcept;
 
 	void DrawUi() const noexcept;
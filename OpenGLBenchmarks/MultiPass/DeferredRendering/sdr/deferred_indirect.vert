@@ -0,0 +1,68 @@
+#version 450 core
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shader_draw_parameters : require
+
+//Vertex attributes
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec3 inTangent;
+// The colour at location 3 is not read, so layouts without it leave it out.
+layout(location = 4) in vec2 inTexcoord;
+
+layout(location = 5) uniform mat4 projection;
+layout(location = 6) uniform mat4 view;
+
+// World matrix of every indirect draw. Each draw sets baseInstance to its
+// index, gl_InstanceID does not include it so it is added explicitly.
+layout(std430, binding = 0) readonly buffer DrawTransforms {
+    mat4 models[];
+};
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+// Varying variables
+// prefixes: w_ -> world space
+//           v_ -> view space
+//           t_ -> tangent space
+layout(location = 0) out vec2 outTexcoord;
+layout(location = 1) out vec4 w_outPosition;
+layout(location = 2) out vec3 w_outNormal;
+layout(location = 3) out vec3 w_outTangent;
+
+// Set when the vertex layout stores the normal and tangent folded onto an octahedron.
+layout(location = 8) uniform int octahedralVectors;
+
+// Unfolds an octahedral vector, the fetch fills z with 0.
+vec3 DecodeVector(vec3 encoded)
+{
+    if (octahedralVectors == 0) {
+        return normalize(encoded);
+    }
+
+    vec3 vector = vec3(encoded.xy, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-vector.z, 0.0);
+    vector.xy += vec2(vector.x >= 0.0 ? -fold : fold, vector.y >= 0.0 ? -fold : fold);
+
+    return normalize(vector);
+}
+
+void main()
+{
+    mat4 model = models[gl_BaseInstanceARB + gl_InstanceID];
+
+    //Transform vertex to clipspace.
+    vec4 localVertexPosition = vec4(inPosition, 1.0);
+    gl_Position = projection * view * model * localVertexPosition;
+
+	w_outPosition = model * localVertexPosition;
+
+    mat3 normalMatrix = transpose(inverse(mat3(model)));
+
+	w_outNormal = normalMatrix * DecodeVector(inNormal);
+	w_outTangent = normalMatrix * DecodeVector(inTangent);
+
+    //Assign texture coorinates for output.
+    outTexcoord = inTexcoord;
+}
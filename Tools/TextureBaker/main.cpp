@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "texture_container.h"
+#include "texture_utilities.h"
+#include "types.h"
+#include "timer.h"
+#include "logger.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+
+#include "stb_image.h"
+
+/**
+ * Bakes every image of a directory to a texture container next to the others
+ * in the output directory: the full mip chain, in BC1, or BC3 if the image has
+ * transparency, or in RGBA8 for drivers without BC support. The benchmarks load
+ * the containers instead of the images when attributes.textures is baked.
+ *
+ * Usage: TOOL_TextureBaker [source directory] [output directory] [bc|rgba8]
+ */
+
+namespace fs = std::filesystem;
+
+static bool IsImage(const fs::path& path)
+{
+	auto extension = path.extension().string();
+
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+	return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+}
+
+static const char* GetFormatName(const TextureFormat format)
+{
+	switch (format) {
+		case TextureFormat::BC1:
+			return "BC1";
+		case TextureFormat::BC3:
+			return "BC3";
+		default:
+			return "RGBA8";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const fs::path sourceDirectory{ argc > 1 ? argv[1] : "../../Assets" };
+	const fs::path outputDirectory{ argc > 2 ? argv[2] : "../../Assets/Baked" };
+	const std::string format{ argc > 3 ? argv[3] : "bc" };
+
+	if (format != "bc" && format != "rgba8") {
+		ERROR_LOG("Unknown format: " + format + ", expected bc or rgba8.");
+		return 1;
+	}
+
+	std::error_code error;
+
+	if (!fs::is_directory(sourceDirectory, error)) {
+		ERROR_LOG("Source directory does not exist: " + sourceDirectory.string());
+		return 1;
+	}
+
+	fs::create_directories(outputDirectory, error);
+
+	if (error) {
+		ERROR_LOG("Failed to create output directory: " + outputDirectory.string());
+		return 1;
+	}
+
+	auto bakedCount = 0u;
+	auto failedCount = 0u;
+
+	ui64 sourceBytes{ 0 };
+	ui64 bakedBytes{ 0 };
+
+	Timer timer;
+	timer.Start();
+
+	for (const auto& entry : fs::directory_iterator{ sourceDirectory }) {
+		if (!entry.is_regular_file() || !IsImage(entry.path())) {
+			continue;
+		}
+
+		const auto sourceName = entry.path().string();
+
+		Vec2i size;
+		int colorChannels;
+
+		stbi_uc* pixels{ stbi_load(sourceName.c_str(), &size.x, &size.y, &colorChannels, STBI_rgb_alpha) };
+
+		if (!pixels) {
+			ERROR_LOG("Failed to load image: " + sourceName);
+			++failedCount;
+			continue;
+		}
+
+		const auto chain = GenerateMipChain(pixels, Vec2ui{ size.x, size.y });
+
+		stbi_image_free(pixels);
+
+		auto textureFormat = TextureFormat::RGBA8;
+
+		if (format == "bc") {
+			textureFormat = HasTransparency(chain[0]) ? TextureFormat::BC3 : TextureFormat::BC1;
+		}
+
+		const auto outputName = (outputDirectory / entry.path().stem()).string() + TextureContainer::EXTENSION;
+
+		if (!TextureContainer::Write(outputName, textureFormat, chain)) {
+			++failedCount;
+			continue;
+		}
+
+		const auto inputSize = fs::file_size(entry.path(), error);
+		const auto outputSize = fs::file_size(outputName, error);
+
+		LOG(sourceName + " -> " + outputName + " (" + GetFormatName(textureFormat) + ", " +
+			std::to_string(size.x) + "x" + std::to_string(size.y) + ", " + std::to_string(chain.size()) + " levels, " +
+			std::to_string(inputSize / 1024) + " KiB -> " + std::to_string(outputSize / 1024) + " KiB)");
+
+		sourceBytes += inputSize;
+		bakedBytes += outputSize;
+		++bakedCount;
+	}
+
+	LOG("Baked " + std::to_string(bakedCount) + " textures in " + std::to_string(timer.GetSec()) + " s, " +
+		std::to_string(sourceBytes / 1024) + " KiB of images -> " + std::to_string(bakedBytes / 1024) + " KiB of containers.");
+
+	return failedCount ? 1 : 0;
+}
@@ -1,4 +1,6 @@
 #include "demo_application.h"
+#include "heap_allocation_counter.h"
+#include "cfg.h"
 
 static int s_EntitiesPerThread{ 0 };
 
@@ -40,8 +42,10 @@ bool DemoApplication::BuildCommandBuffers() noexcept
 
 	renderPassBeginInfo.framebuffer = GetFramebuffers()[GetCurrentBufferIndex()];
 
-	// Use the 1st command buffer of the base class as the primary one.
-	const auto& primaryCmdBuffer = GetCommandBuffers()[0];
+	// Use the command buffer of the acquired image as the primary one.
+	const auto& primaryCmdBuffer = GetCommandBuffers()[GetCurrentBufferIndex()];
+
+	const auto frameIndex = GetCurrentFrameIndex();
 
 	auto result = vkBeginCommandBuffer(primaryCmdBuffer, &commandBufferBeginInfo);
 
@@ -61,24 +65,70 @@ bool DemoApplication::BuildCommandBuffers() noexcept
 	commandBufferInheritanceInfo.renderPass = GetRenderPass();
 	commandBufferInheritanceInfo.framebuffer = renderPassBeginInfo.framebuffer;
 
+	const auto heapAllocationsBefore = HeapAllocationCounter::GetAllocationCount();
+
+	TaskGroup recordingGroup;
+
 	auto entityIndex = 0;
-	for (auto i = 0u; i < m_PerThreadData.size(); ++i) {
-		for (auto j = 0u; j < m_PerThreadData[i].secondaryCommandBuffers.size(); ++j) {
-			m_ThreadPool.AddTask(i, [=]()
-			{
-				GetScene().DrawSingle(entityIndex, m_PerThreadData[i].secondaryCommandBuffers[j],
-				                      commandBufferInheritanceInfo);
-			});
-
-			++entityIndex;
+
+	if (m_CommandPoolMode == CommandPoolMode::PER_FRAME) {
+		// One vkResetCommandPool per thread replaces the implicit reset of every
+		// buffer in vkBeginCommandBuffer. It is part of the recording time.
+		if (!m_CommandBufferAllocator.Reset(frameIndex)) {
+			return false;
+		}
+
+		for (auto i = 0u; i < m_PerThreadData.size(); ++i) {
+			auto& secondaryCommandBuffers = m_PerThreadData[i].secondaryCommandBuffers[frameIndex];
+
+			for (auto& secondaryCommandBuffer : secondaryCommandBuffers) {
+				const auto commandBufferSlot = &secondaryCommandBuffer;
+
+				// The tasks are pinned, so only worker i allocates from the pools of thread i.
+				m_ThreadPool.Run(recordingGroup, i, [=]()
+				{
+					*commandBufferSlot = m_CommandBufferAllocator.Allocate(frameIndex, i, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+					GetScene().DrawSingle(entityIndex, *commandBufferSlot,
+					                      commandBufferInheritanceInfo);
+				});
+
+				++entityIndex;
+			}
 		}
 	}
+	else {
+		for (auto i = 0u; i < m_PerThreadData.size(); ++i) {
+			const auto& secondaryCommandBuffers = m_PerThreadData[i].secondaryCommandBuffers[frameIndex];
+
+			for (const auto secondaryCommandBuffer : secondaryCommandBuffers) {
+				m_ThreadPool.Run(recordingGroup, i, [=]()
+				{
+					GetScene().DrawSingle(entityIndex, secondaryCommandBuffer,
+					                      commandBufferInheritanceInfo);
+				});
+
+				++entityIndex;
+			}
+		}
+	}
+
+	// The UI has to be recorded on the main thread (ImGui and GLFW are not
+	// thread safe) so do it while the workers record the secondary buffers.
+	// Its allocations are not part of the recording, so they are not counted.
+	{
+		HeapAllocationCounter::ScopedPause pauseCounting;
+
+		DrawUi();
+	}
 
-	m_ThreadPool.Wait();
+	m_ThreadPool.Wait(recordingGroup);
+
+	m_DemoScene.SetRecordingHeapAllocations(HeapAllocationCounter::GetAllocationCount() - heapAllocationsBefore);
 
 	for (const auto& threadData : m_PerThreadData) {
-		vkCmdExecuteCommands(primaryCmdBuffer, threadData.secondaryCommandBuffers.size(),
-		                     threadData.secondaryCommandBuffers.data());
+		vkCmdExecuteCommands(primaryCmdBuffer, threadData.secondaryCommandBuffers[frameIndex].size(),
+		                     threadData.secondaryCommandBuffers[frameIndex].data());
 	}
 
 	vkCmdEndRenderPass(primaryCmdBuffer);
@@ -114,9 +164,11 @@ void DemoApplication::DrawUi() const noexcept
 
 	renderPassBeginInfo.framebuffer = GetFramebuffers()[GetCurrentBufferIndex()];
 
-	vkBeginCommandBuffer(m_UiCommandBuffer, &commandBufferBeginInfo);
+	const auto uiCommandBuffer = m_UiCommandBuffers[GetCurrentFrameIndex()];
+
+	vkBeginCommandBuffer(uiCommandBuffer, &commandBufferBeginInfo);
 
-	vkCmdBeginRenderPass(m_UiCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(uiCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 	VkViewport viewport{};
 	viewport.x = 0;
@@ -124,20 +176,20 @@ void DemoApplication::DrawUi() const noexcept
 	viewport.width = swapChainExtent.width;
 	viewport.height = swapChainExtent.height;
 
-	vkCmdSetViewport(m_UiCommandBuffer, 0, 1, &viewport);
+	vkCmdSetViewport(uiCommandBuffer, 0, 1, &viewport);
 
 	VkRect2D scissor{};
 	scissor.extent = renderPassBeginInfo.renderArea.extent;
 	scissor.offset.x = 0;
 	scissor.offset.y = 0;
 
-	vkCmdSetScissor(m_UiCommandBuffer, 0, 1, &scissor);
+	vkCmdSetScissor(uiCommandBuffer, 0, 1, &scissor);
 
-	m_DemoScene.DrawUi(m_UiCommandBuffer);
+	m_DemoScene.DrawUi(uiCommandBuffer);
 
-	vkCmdEndRenderPass(m_UiCommandBuffer);
+	vkCmdEndRenderPass(uiCommandBuffer);
 
-	vkEndCommandBuffer(m_UiCommandBuffer);
+	vkEndCommandBuffer(uiCommandBuffer);
 }
 
 bool DemoApplication::CreateRenderPasses() noexcept
@@ -255,7 +307,27 @@ bool DemoApplication::Initialize() noexcept
 		return false;
 	}
 
-	m_UiCommandBuffer = G_VulkanDevice.CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+	ConfigFile cfg{ "config/config.cfg" };
+
+	if (!cfg.IsOpen()) {
+		ERROR_LOG("Failed to open the configuration file.");
+		return false;
+	}
+
+	const std::string commandPoolMode{ cfg.GetString("attributes.command_pool_mode", "individual") };
+
+	if (commandPoolMode == "per_frame") {
+		m_CommandPoolMode = CommandPoolMode::PER_FRAME;
+	}
+	else if (commandPoolMode != "individual") {
+		ERROR_LOG("Unknown command pool mode: " + commandPoolMode + ", falling back to individual.");
+	}
+
+	m_UiCommandBuffers.resize(GetFramesInFlight());
+
+	for (auto& uiCommandBuffer : m_UiCommandBuffers) {
+		uiCommandBuffer = G_VulkanDevice.CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+	}
 
 	if (!m_UiSemaphore.Create()) {
 		ERROR_LOG("Failed to create semaphore for UI render pass.");
@@ -266,6 +338,9 @@ bool DemoApplication::Initialize() noexcept
 		return false;
 	}
 
+	m_DemoScene.SetCommandPoolModeName(m_CommandPoolMode == CommandPoolMode::PER_FRAME ? "Per frame pool reset"
+	                                                                                   : "Individual buffer reset");
+
 	if (!m_ThreadPool.Initialize()) {
 		return false;
 	}
@@ -275,14 +350,33 @@ bool DemoApplication::Initialize() noexcept
 	m_PerThreadData.resize(m_ThreadPool.GetWorkerCount());
 
 	const auto gfxQueueIndex{ G_VulkanDevice.GetQueueFamilyIndex(QueueFamily::GRAPHICS) };
+
+	if (m_CommandPoolMode == CommandPoolMode::PER_FRAME) {
+		if (!m_CommandBufferAllocator.Create(gfxQueueIndex, GetFramesInFlight(), m_ThreadPool.GetWorkerCount())) {
+			return false;
+		}
+
+		// Only the slots for the handles, the allocator fills them while recording.
+		for (auto& threadData : m_PerThreadData) {
+			threadData.secondaryCommandBuffers.resize(GetFramesInFlight(),
+			                                          std::vector<VkCommandBuffer>(s_EntitiesPerThread, VK_NULL_HANDLE));
+		}
+
+		return true;
+	}
+
 	for (auto& threadData : m_PerThreadData) {
 		// One command pool per thread
 		threadData.commandPool = G_VulkanDevice.CreateCommandPool(gfxQueueIndex);
 
-		// One secondary command buffer for each entity.
-		threadData.secondaryCommandBuffers = G_VulkanDevice.CreateCommandBuffers(s_EntitiesPerThread,
-		                                                                         threadData.commandPool,
-		                                                                         VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+		// One secondary command buffer for each entity, per frame in flight.
+		threadData.secondaryCommandBuffers.resize(GetFramesInFlight());
+
+		for (auto& secondaryCommandBuffers : threadData.secondaryCommandBuffers) {
+			secondaryCommandBuffers = G_VulkanDevice.CreateCommandBuffers(s_EntitiesPerThread,
+			                                                              threadData.commandPool,
+			                                                              VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+		}
 	}
 
 	return true;
@@ -299,12 +393,11 @@ void DemoApplication::Draw() noexcept
 {
 	PreDraw();
 
-	BuildCommandBuffers();
-	DrawUi();
+	RecordCommandBuffers();
 
 	auto& submitInfo = GetSubmitInfo();
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &GetCommandBuffers()[0];
+	submitInfo.pCommandBuffers = &GetCommandBuffers()[GetCurrentBufferIndex()];
 	submitInfo.pWaitSemaphores = GetPresentCompleteSemaphore().Get();
 	submitInfo.pSignalSemaphores = m_UiSemaphore.Get();
 
@@ -319,14 +412,14 @@ void DemoApplication::Draw() noexcept
 		return;
 	}
 
-	submitInfo.pCommandBuffers = &m_UiCommandBuffer;
+	submitInfo.pCommandBuffers = &m_UiCommandBuffers[GetCurrentFrameIndex()];
 	submitInfo.pWaitSemaphores = m_UiSemaphore.Get();
 	submitInfo.pSignalSemaphores = GetDrawCompleteSemaphore().Get();
 
 	result = vkQueueSubmit(G_VulkanDevice.GetQueue(QueueFamily::GRAPHICS),
 	                       1,
 	                       &submitInfo,
-	                       VK_NULL_HANDLE);
+	                       ResetFrameFence());
 
 	if (result != VK_SUCCESS) {
 		ERROR_LOG("Failed to submit the command buffer.");
@@ -2,17 +2,35 @@
 #define VULKAN_SINGLE_THREADED_APPLICATION_H_
 
 #include "vulkan_application.h"
+#include "vulkan_command_buffer_allocator.h"
 #include "demo_entity.h"
 #include "demo_scene.h"
 #include "thread_pool.h"
 
+/**
+ * \brief How the secondary command buffers are reset, selected with attributes.command_pool_mode in config.cfg.
+ */
+enum class CommandPoolMode {
+	// The buffers are allocated once and each one is reset when it is begun again.
+	INDIVIDUAL,
+	// The buffers come from a VulkanCommandBufferAllocator whose pools are reset as a whole every frame.
+	PER_FRAME
+};
+
 class DemoApplication final : public VulkanApplication {
 private:
 	DemoScene m_DemoScene;
 
 	ThreadPool m_ThreadPool;
 
-	VkCommandBuffer m_UiCommandBuffer{ VK_NULL_HANDLE };
+	CommandPoolMode m_CommandPoolMode{ CommandPoolMode::INDIVIDUAL };
+
+	VulkanCommandBufferAllocator m_CommandBufferAllocator;
+
+	/**
+	 * \brief The UI command buffers, re-recorded every frame. One per frame in flight.
+	 */
+	std::vector<VkCommandBuffer> m_UiCommandBuffers;
 
 	VulkanSemaphore m_UiSemaphore;
 
@@ -20,7 +38,9 @@ private:
 
 	struct ThreadData {
 		VkCommandPool commandPool{ VK_NULL_HANDLE };
-		std::vector<VkCommandBuffer> secondaryCommandBuffers;
+		// One secondary command buffer per entity, for each frame in flight. In the
+		// per frame mode these are handed out again by the allocator every frame.
+		std::vector<std::vector<VkCommandBuffer>> secondaryCommandBuffers;
 	};
 
 	std::vector<ThreadData> m_PerThreadData;
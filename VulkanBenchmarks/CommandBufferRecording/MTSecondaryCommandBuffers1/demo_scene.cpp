@@ -5,6 +5,7 @@
 #include <mesh_utilities.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <algorithm>
+#include <fstream>
 #include "demo_scene.h"
 #include "vulkan_application.h"
 #include "imgui.h"
@@ -636,7 +637,7 @@ bool DemoScene::InitializeImGui(const VkRenderPass renderPass) noexcept
 	vkEndCommandBuffer(commandBuffer);
 
 	if (!G_VulkanDevice.SubmitCommandBuffer(commandBuffer,
-		G_VulkanDevice.GetQueue(QueueFamily::TRANSFER),
+		G_VulkanDevice.GetQueue(QueueFamily::GRAPHICS),
 		fence)) {
 		ERROR_LOG("Failed to submit command buffer for Font uploading.");
 		return false;
@@ -685,7 +686,7 @@ bool DemoScene::Initialize(const VkExtent2D swapChainExtent, const VkRenderPass
         return false;
     }
 
-    if (!m_PipelineCache.Create()) {
+    if (!m_PipelineCache.Create("MTSecondaryCommandBuffers1")) {
         return false;
     }
 
@@ -726,8 +727,8 @@ void DemoScene::Draw(const VkCommandBuffer commandBuffer) noexcept
     for (const auto &entity : m_Entities) {
 
         auto &material = entity->GetMaterial();
-        std::vector<VkDescriptorSet> descriptorSets{m_SceneMatricesDescriptorSet,
-                                                    material.descriptorSet};
+        std::array<VkDescriptorSet, 2> descriptorSets{m_SceneMatricesDescriptorSet,
+                                                      material.descriptorSet};
 
         vkCmdBindDescriptorSets(commandBuffer,
                                 VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -788,8 +789,8 @@ void DemoScene::DrawSingle(int entityIndex,
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipelines.solid);
 
     auto &material = m_Entities[entityIndex]->GetMaterial();
-    std::vector<VkDescriptorSet> descriptorSets{m_SceneMatricesDescriptorSet,
-                                                material.descriptorSet};
+    std::array<VkDescriptorSet, 2> descriptorSets{m_SceneMatricesDescriptorSet,
+                                                  material.descriptorSet};
 
     vkCmdBindDescriptorSets(commandBuffer,
                             VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -895,6 +896,9 @@ void DemoScene::DrawUi(const VkCommandBuffer commandBuffer) const noexcept
 		ImGui::Text("Total Vertex Count: %d", ENTITY_COUNT * 24);
 		ImGui::Text("Running time: %f s", application.GetTimer().GetSec());
 		ImGui::Text("Frame count: %lld", application.frameCount);
+		ImGui::Text("Heap allocations while recording: %llu", m_RecordingHeapAllocations);
+		ImGui::Text("Command pool mode: %s", m_CommandPoolModeName);
+		ImGui::Text("Record time (ms): %f", application.recordTime);
 		ImGui::End();
 	}
 	else {
@@ -968,17 +972,20 @@ void DemoScene::DrawUi(const VkCommandBuffer commandBuffer) const noexcept
 		ImGui::Text("Total Vertex Count: %d", ENTITY_COUNT * 24);
 		ImGui::Text("Total Frames: %lld", application.frameCount);
 		ImGui::Text("Total duration: %f s", application.totalAppDuration);
+		ImGui::Text("Startup time: %f ms", application.startupTime);
 		ImGui::Text("Average FPS: %f", 1000.0f / application.avgTotalFrameTime);
 		ImGui::Text("Average frame time: %f ms", application.avgTotalFrameTime);
 		ImGui::Text("Average CPU time: %f ms", application.avgTotalCpuTime);
 		ImGui::Text("Average GPU time: %f ms", application.avgTotalGpuTime);
+		ImGui::Text("Average record time: %f ms", application.avgTotalRecordTime);
+		ImGui::Text("Command pool mode: %s", m_CommandPoolModeName);
 		ImGui::Text("99th percentile (lower is better): %f ms", application.percentile99th);
 
 		ImGui::NewLine();
 
 		if (ImGui::Button("Save to CSV")) {
 			LOG("Saving to CSV");
-			application.SaveToCsv("MTSecondaryCommandBuffers1_Metrics");
+			SaveToCsv("MTSecondaryCommandBuffers1_Metrics");
 		}
 
 		if (ImGui::Button("Exit Application")) {
@@ -991,3 +998,38 @@ void DemoScene::DrawUi(const VkCommandBuffer commandBuffer) const noexcept
 
 	ImGui_ImplGlfwVulkan_Render(commandBuffer);
 }
+
+void DemoScene::SaveToCsv(const std::string& fname) const
+{
+	const auto& app = G_Application;
+	std::ofstream stream{ fname + ".csv" };
+
+	stream << "Whole Frame Time,CPU Time,GPU Time,Update Time,Record Time\n";
+
+	for (auto i = 0u; i < app.totalFrameTimeSamples.size(); ++i) {
+		stream << app.totalFrameTimeSamples[i] << "," << app.totalCpuTimeSamples[i] << "," << app.totalGpuTimeSamples[i] << ","
+				<< app.totalUpdateTimeSamples[i] << "," << app.totalRecordTimeSamples[i] << "\n";
+	}
+
+	stream << "\nFPS,Whole Frame Time,CPU Time,GPU Time\n";
+
+	for (auto i = 0u; i < app.fpsAverages.size(); ++i) {
+		stream << app.fpsAverages[i] << "," << app.wholeFrameAverages[i] << "," << app.cpuTimeAverages[i] << "," << app.gpuTimeAverages[i] <<
+				"\n";
+	}
+
+	stream << "\nAverage FPS,Average Frame Time,Average CPU Time,Average GPU Time,Average Update Time,Average Record Time\n";
+	stream << 1000.0f / app.avgTotalFrameTime << "," << app.avgTotalFrameTime << "," << app.avgTotalCpuTime << "," << app.avgTotalGpuTime << ","
+			<< app.avgTotalUpdateTime << "," << app.avgTotalRecordTime;
+
+	stream << "\nCommand Pool Mode\n";
+	stream << m_CommandPoolModeName;
+
+	stream << "\n99th percentile\n";
+	stream << app.percentile99th;
+
+	stream << "\nStartup Time\n";
+	stream << app.startupTime;
+
+	stream.close();
+}
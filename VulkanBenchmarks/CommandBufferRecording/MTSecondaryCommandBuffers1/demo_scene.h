@@ -43,6 +43,11 @@ private:
 
 	VulkanMesh m_CubeMesh;
 
+	// Heap allocations made while the last frame's secondary command buffers were recorded.
+	ui64 m_RecordingHeapAllocations{ 0 };
+
+	const char* m_CommandPoolModeName{ "" };
+
 	bool SpawnEntity() noexcept;
 
 	bool CreateTextureSampler() noexcept;
@@ -67,6 +72,12 @@ public:
 	                VkCommandBufferInheritanceInfo inheritanceInfo) const noexcept;
 
 	void DrawUi(const VkCommandBuffer commandBuffer) const noexcept;
+
+	void SetRecordingHeapAllocations(ui64 allocationCount) noexcept { m_RecordingHeapAllocations = allocationCount; }
+
+	void SetCommandPoolModeName(const char* name) noexcept { m_CommandPoolModeName = name; }
+
+	void SaveToCsv(const std::string& fname) const;
 };
 
 #endif //DISSERTATION_DEMO_SCENE_H
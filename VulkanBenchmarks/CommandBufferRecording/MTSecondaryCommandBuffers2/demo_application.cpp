@@ -1,4 +1,5 @@
 #include "demo_application.h"
+#include "heap_allocation_counter.h"
 
 static int s_EntitiesPerThread{ 0 };
 
@@ -40,8 +41,10 @@ bool DemoApplication::BuildCommandBuffers() noexcept
 
 	renderPassBeginInfo.framebuffer = GetFramebuffers()[GetCurrentBufferIndex()];
 
-	// Use the 1st command buffer of the base class as the primary one.
-	const auto& primaryCmdBuffer = GetCommandBuffers()[0];
+	// Use the command buffer of the acquired image as the primary one.
+	const auto& primaryCmdBuffer = GetCommandBuffers()[GetCurrentBufferIndex()];
+
+	const auto frameIndex = GetCurrentFrameIndex();
 
 	auto result = vkBeginCommandBuffer(primaryCmdBuffer, &commandBufferBeginInfo);
 
@@ -61,20 +64,35 @@ bool DemoApplication::BuildCommandBuffers() noexcept
 	commandBufferInheritanceInfo.renderPass = GetRenderPass();
 	commandBufferInheritanceInfo.framebuffer = renderPassBeginInfo.framebuffer;
 
+	const auto heapAllocationsBefore = HeapAllocationCounter::GetAllocationCount();
+
+	TaskGroup recordingGroup;
+
 	for (auto i = 0u; i < m_PerThreadData.size(); ++i) {
 		const auto& [start, end] = m_PerThreadData[i].startEndIndices;
 
-		m_ThreadPool.AddTask(i, [=]()
+		m_ThreadPool.Run(recordingGroup, i, [=]()
 		{
-			m_DemoScene.DrawRange(start, end, m_PerThreadData[i].secondaryCommandBuffer,
+			m_DemoScene.DrawRange(start, end, m_PerThreadData[i].secondaryCommandBuffers[frameIndex],
 			                      commandBufferInheritanceInfo);
 		});
 	}
 
-	m_ThreadPool.Wait();
+	// The UI has to be recorded on the main thread (ImGui and GLFW are not
+	// thread safe) so do it while the workers record the secondary buffers.
+	// Its allocations are not part of the recording, so they are not counted.
+	{
+		HeapAllocationCounter::ScopedPause pauseCounting;
+
+		DrawUi();
+	}
+
+	m_ThreadPool.Wait(recordingGroup);
+
+	m_DemoScene.SetRecordingHeapAllocations(HeapAllocationCounter::GetAllocationCount() - heapAllocationsBefore);
 
 	for (const auto& threadData : m_PerThreadData) {
-		vkCmdExecuteCommands(primaryCmdBuffer, 1, &threadData.secondaryCommandBuffer);
+		vkCmdExecuteCommands(primaryCmdBuffer, 1, &threadData.secondaryCommandBuffers[frameIndex]);
 	}
 
 	vkCmdEndRenderPass(primaryCmdBuffer);
@@ -110,9 +128,11 @@ void DemoApplication::DrawUi() const noexcept
 
 	renderPassBeginInfo.framebuffer = GetFramebuffers()[GetCurrentBufferIndex()];
 
-	vkBeginCommandBuffer(m_UiCommandBuffer, &commandBufferBeginInfo);
+	const auto uiCommandBuffer = m_UiCommandBuffers[GetCurrentFrameIndex()];
+
+	vkBeginCommandBuffer(uiCommandBuffer, &commandBufferBeginInfo);
 
-	vkCmdBeginRenderPass(m_UiCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(uiCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 	VkViewport viewport{};
 	viewport.x = 0;
@@ -120,20 +140,20 @@ void DemoApplication::DrawUi() const noexcept
 	viewport.width = swapChainExtent.width;
 	viewport.height = swapChainExtent.height;
 
-	vkCmdSetViewport(m_UiCommandBuffer, 0, 1, &viewport);
+	vkCmdSetViewport(uiCommandBuffer, 0, 1, &viewport);
 
 	VkRect2D scissor{};
 	scissor.extent = renderPassBeginInfo.renderArea.extent;
 	scissor.offset.x = 0;
 	scissor.offset.y = 0;
 
-	vkCmdSetScissor(m_UiCommandBuffer, 0, 1, &scissor);
+	vkCmdSetScissor(uiCommandBuffer, 0, 1, &scissor);
 
-	m_DemoScene.DrawUi(m_UiCommandBuffer);
+	m_DemoScene.DrawUi(uiCommandBuffer);
 
-	vkCmdEndRenderPass(m_UiCommandBuffer);
+	vkCmdEndRenderPass(uiCommandBuffer);
 
-	vkEndCommandBuffer(m_UiCommandBuffer);
+	vkEndCommandBuffer(uiCommandBuffer);
 }
 
 bool DemoApplication::CreateRenderPasses() noexcept
@@ -251,7 +271,11 @@ bool DemoApplication::Initialize() noexcept
 		return false;
 	}
 
-	m_UiCommandBuffer = G_VulkanDevice.CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+	m_UiCommandBuffers.resize(GetFramesInFlight());
+
+	for (auto& uiCommandBuffer : m_UiCommandBuffers) {
+		uiCommandBuffer = G_VulkanDevice.CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+	}
 
 	if (!m_UiSemaphore.Create()) {
 		ERROR_LOG("Failed to create semaphore for UI render pass.");
@@ -276,9 +300,10 @@ bool DemoApplication::Initialize() noexcept
 		// One command pool per thread
 		threadData.commandPool = G_VulkanDevice.CreateCommandPool(gfxQueueIndex);
 
-		// One secondary command buffer for each entity range.
-		threadData.secondaryCommandBuffer = G_VulkanDevice.CreateCommandBuffer(threadData.commandPool,
-		                                                                       VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+		// One secondary command buffer for each entity range, per frame in flight.
+		threadData.secondaryCommandBuffers = G_VulkanDevice.CreateCommandBuffers(GetFramesInFlight(),
+		                                                                         threadData.commandPool,
+		                                                                         VK_COMMAND_BUFFER_LEVEL_SECONDARY);
 
 		const auto endIndex{ startIndex + s_EntitiesPerThread };
 		threadData.startEndIndices = std::make_tuple(startIndex, endIndex);
@@ -300,12 +325,11 @@ void DemoApplication::Draw() noexcept
 {
 	PreDraw();
 
-	BuildCommandBuffers();
-	DrawUi();
+	RecordCommandBuffers();
 
 	auto& submitInfo = GetSubmitInfo();
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &GetCommandBuffers()[0];
+	submitInfo.pCommandBuffers = &GetCommandBuffers()[GetCurrentBufferIndex()];
 	submitInfo.pWaitSemaphores = GetPresentCompleteSemaphore().Get();
 	submitInfo.pSignalSemaphores = m_UiSemaphore.Get();
 
@@ -320,14 +344,14 @@ void DemoApplication::Draw() noexcept
 		return;
 	}
 
-	submitInfo.pCommandBuffers = &m_UiCommandBuffer;
+	submitInfo.pCommandBuffers = &m_UiCommandBuffers[GetCurrentFrameIndex()];
 	submitInfo.pWaitSemaphores = m_UiSemaphore.Get();
 	submitInfo.pSignalSemaphores = GetDrawCompleteSemaphore().Get();
 
 	result = vkQueueSubmit(G_VulkanDevice.GetQueue(QueueFamily::GRAPHICS),
 	                       1,
 	                       &submitInfo,
-	                       VK_NULL_HANDLE);
+	                       ResetFrameFence());
 
 	if (result != VK_SUCCESS) {
 		ERROR_LOG("Failed to submit the command buffer.");
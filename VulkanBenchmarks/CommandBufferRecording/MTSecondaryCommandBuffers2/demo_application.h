@@ -12,7 +12,10 @@ private:
 
 	ThreadPool m_ThreadPool;
 
-	VkCommandBuffer m_UiCommandBuffer{ VK_NULL_HANDLE };
+	/**
+	 * \brief The UI command buffers, re-recorded every frame. One per frame in flight.
+	 */
+	std::vector<VkCommandBuffer> m_UiCommandBuffers;
 
 	VulkanSemaphore m_UiSemaphore;
 
@@ -20,7 +23,8 @@ private:
 
 	struct ThreadData {
 		VkCommandPool commandPool{ VK_NULL_HANDLE };
-		VkCommandBuffer secondaryCommandBuffer{ VK_NULL_HANDLE };
+		// One secondary command buffer per frame in flight.
+		std::vector<VkCommandBuffer> secondaryCommandBuffers;
 		std::tuple<int, int> startEndIndices;
 	};
 
@@ -651,7 +651,7 @@ bool DemoScene::InitializeImGui(const VkRenderPass renderPass) noexcept
 	vkEndCommandBuffer(commandBuffer);
 
 	if (!G_VulkanDevice.SubmitCommandBuffer(commandBuffer,
-		G_VulkanDevice.GetQueue(QueueFamily::TRANSFER),
+		G_VulkanDevice.GetQueue(QueueFamily::GRAPHICS),
 		fence)) {
 		ERROR_LOG("Failed to submit command buffer for Font uploading.");
 		return false;
@@ -700,7 +700,7 @@ bool DemoScene::Initialize(const VkExtent2D swapChainExtent, const VkRenderPass
 		return false;
 	}
 
-	if (!m_PipelineCache.Create()) {
+	if (!m_PipelineCache.Create("MTSecondaryCommandBuffers2")) {
 		return false;
 	}
 
@@ -741,7 +741,7 @@ void DemoScene::Draw(const VkCommandBuffer commandBuffer) noexcept
 	for (const auto& entity : m_Entities) {
 
 		auto& material = entity->GetMaterial();
-		std::vector<VkDescriptorSet> descriptorSets{
+		std::array<VkDescriptorSet, 2> descriptorSets{
 			m_SceneMatricesDescriptorSet,
 			material.descriptorSet
 		};
@@ -805,7 +805,7 @@ void DemoScene::DrawSingle(int entityIndex,
 	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipelines.solid);
 
 	auto& material = m_Entities[entityIndex]->GetMaterial();
-	std::vector<VkDescriptorSet> descriptorSets{
+	std::array<VkDescriptorSet, 2> descriptorSets{
 		m_SceneMatricesDescriptorSet,
 		material.descriptorSet
 	};
@@ -872,7 +872,7 @@ void DemoScene::DrawRange(int startIndex,
 
 	for (auto i = startIndex; i < endIndex; ++i) {
 		auto& material = m_Entities[i]->GetMaterial();
-		std::vector<VkDescriptorSet> descriptorSets{
+		std::array<VkDescriptorSet, 2> descriptorSets{
 			m_SceneMatricesDescriptorSet,
 			material.descriptorSet
 		};
@@ -981,6 +981,7 @@ void DemoScene::DrawUi(const VkCommandBuffer commandBuffer) const noexcept
 		ImGui::Text("Total Vertex Count: %d", ENTITY_COUNT * 24);
 		ImGui::Text("Running time: %f s", application.GetTimer().GetSec());
 		ImGui::Text("Frame count: %lld", application.frameCount);
+		ImGui::Text("Heap allocations while recording: %llu", m_RecordingHeapAllocations);
 		ImGui::End();
 	}
 	else {
@@ -1054,6 +1055,7 @@ void DemoScene::DrawUi(const VkCommandBuffer commandBuffer) const noexcept
 		ImGui::Text("Total Vertex Count: %d", ENTITY_COUNT * 24);
 		ImGui::Text("Total Frames: %lld", application.frameCount);
 		ImGui::Text("Total duration: %f s", application.totalAppDuration);
+		ImGui::Text("Startup time: %f ms", application.startupTime);
 		ImGui::Text("Average FPS: %f", 1000.0f / application.avgTotalFrameTime);
 		ImGui::Text("Average frame time: %f ms", application.avgTotalFrameTime);
 		ImGui::Text("Average CPU time: %f ms", application.avgTotalCpuTime);
@@ -43,6 +43,9 @@ private:
 
 	VulkanMesh m_CubeMesh;
 
+	// Heap allocations made while the last frame's secondary command buffers were recorded.
+	ui64 m_RecordingHeapAllocations{ 0 };
+
 	bool SpawnEntity() noexcept;
 
 	bool CreateTextureSampler() noexcept;
@@ -72,6 +75,8 @@ public:
 	               VkCommandBufferInheritanceInfo inheritanceInfo) const noexcept;
 
 	void DrawUi(const VkCommandBuffer commandBuffer) const noexcept;
+
+	void SetRecordingHeapAllocations(ui64 allocationCount) noexcept { m_RecordingHeapAllocations = allocationCount; }
 };
 
 #endif //DISSERTATION_DEMO_SCENE_H
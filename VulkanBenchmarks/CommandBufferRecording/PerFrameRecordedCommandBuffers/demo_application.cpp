@@ -14,6 +14,11 @@ void DemoApplication::EnableFeatures() noexcept
 	if (physicalDevice.features.fillModeNonSolid) {
 		featuresToEnable.fillModeNonSolid = VK_TRUE;
 	}
+
+	// The bindless material mode indexes the scene's texture array with a push constant.
+	if (physicalDevice.features.shaderSampledImageArrayDynamicIndexing) {
+		featuresToEnable.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+	}
 }
 
 bool DemoApplication::BuildCommandBuffers() noexcept
@@ -117,7 +122,7 @@ void DemoApplication::Draw() noexcept
 {
 	PreDraw();
 
-	BuildCommandBuffers();
+	RecordCommandBuffers();
 
 	auto& submitInfo = GetSubmitInfo();
 	submitInfo.commandBufferCount = 1;
@@ -129,7 +134,7 @@ void DemoApplication::Draw() noexcept
 		vkQueueSubmit(G_VulkanDevice.GetQueue(QueueFamily::GRAPHICS),
 		              1,
 		              &submitInfo,
-		              VK_NULL_HANDLE)
+		              ResetFrameFence())
 	};
 
 	if (result != VK_SUCCESS) {
@@ -12,6 +12,9 @@ struct DemoMaterial final {
 
 	//Each material has it's own descriptor set.
 	VkDescriptorSet descriptorSet;
+
+	//Indices of the textures in the scene's texture array, pushed per draw in the bindless mode.
+	std::array<ui32, SUPPORTED_TEX_COUNT> textureIndices{};
 };
 
 #endif //DEMO_MATERIAL_H_
@@ -6,6 +6,8 @@
 #include <vulkan_shader.h>
 #include <mutex>
 #include <algorithm>
+#include <unordered_map>
+#include <cfg.h>
 #include "demo_scene.h"
 #include "imgui_impl_glfw_vulkan.h"
 #include "imgui.h"
@@ -397,6 +399,151 @@ bool DemoScene::PrepareUniforms() noexcept
 	return true;
 }
 
+bool DemoScene::PrepareBindlessTextures() noexcept
+{
+	// Materials that use the same texture share its slot in the array.
+	std::unordered_map<VulkanTexture*, ui32> textureIndices;
+
+	for (const auto& entity : m_Entities) {
+		auto& material = entity->GetMaterial();
+
+		for (auto i = 0u; i < SUPPORTED_TEX_COUNT; ++i) {
+			const auto inserted = textureIndices.emplace(material.textures[i], static_cast<ui32>(m_BindlessTextures.size()));
+
+			if (inserted.second) {
+				m_BindlessTextures.push_back(material.textures[i]);
+			}
+
+			material.textureIndices[i] = inserted.first->second;
+		}
+	}
+
+	const auto textureCount = static_cast<ui32>(m_BindlessTextures.size());
+
+	const auto& limits = G_VulkanDevice.GetPhysicalDevice().properties.limits;
+
+	if (textureCount > limits.maxPerStageDescriptorSamplers || textureCount > limits.maxPerStageDescriptorSampledImages) {
+		ERROR_LOG("The scene has more textures than the fragment stage can access.");
+		return false;
+	}
+
+	const auto& device = G_VulkanDevice;
+
+	VkDescriptorPoolSize texturesPoolSize{};
+	texturesPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	texturesPoolSize.descriptorCount = textureCount;
+
+	VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+	descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptorPoolCreateInfo.maxSets = 1;
+	descriptorPoolCreateInfo.poolSizeCount = 1;
+	descriptorPoolCreateInfo.pPoolSizes = &texturesPoolSize;
+
+	VkResult result{ vkCreateDescriptorPool(device, &descriptorPoolCreateInfo, nullptr, &m_BindlessDescriptorPool) };
+
+	if (result != VK_SUCCESS) {
+		ERROR_LOG("Failed to create bindless descriptor pool.");
+		return false;
+	}
+
+	//Descriptor set 1 - every texture of the scene
+	VkDescriptorSetLayoutBinding texturesBinding{};
+	texturesBinding.binding = 0;
+	texturesBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	texturesBinding.descriptorCount = textureCount;
+	texturesBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+	descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptorSetLayoutCreateInfo.bindingCount = 1;
+	descriptorSetLayoutCreateInfo.pBindings = &texturesBinding;
+
+	result = vkCreateDescriptorSetLayout(device,
+	                                     &descriptorSetLayoutCreateInfo,
+	                                     nullptr,
+	                                     &m_DescriptorSetLayouts.bindlessTextures);
+
+	if (result != VK_SUCCESS) {
+		ERROR_LOG("Failed to create bindless textures descriptor set layout.");
+		return false;
+	}
+
+	// Same model matrix range as the per draw layout, the fragment range also carries the texture indices.
+	std::array<VkPushConstantRange, 2> pushConstantRanges{};
+	pushConstantRanges[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRanges[0].size = sizeof(Mat4f);
+	pushConstantRanges[0].offset = 0;
+
+	pushConstantRanges[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	pushConstantRanges[1].size = sizeof(BindlessMaterialConstants);
+	pushConstantRanges[1].offset = sizeof(Mat4f);
+
+	std::array<VkDescriptorSetLayout, 2> descriptorSetLayouts{
+		m_DescriptorSetLayouts.sceneMatrices,
+		m_DescriptorSetLayouts.bindlessTextures
+	};
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = static_cast<ui32>(descriptorSetLayouts.size());
+	pipelineLayoutCreateInfo.pSetLayouts = descriptorSetLayouts.data();
+	pipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<ui32>(pushConstantRanges.size());
+	pipelineLayoutCreateInfo.pPushConstantRanges = pushConstantRanges.data();
+
+	result = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &m_BindlessPipelineLayout);
+
+	if (result != VK_SUCCESS) {
+		ERROR_LOG("Failed to create bindless pipeline layout.");
+		return false;
+	}
+
+	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptorSetAllocateInfo.descriptorPool = m_BindlessDescriptorPool;
+	descriptorSetAllocateInfo.descriptorSetCount = 1;
+	descriptorSetAllocateInfo.pSetLayouts = &m_DescriptorSetLayouts.bindlessTextures;
+
+	result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &m_BindlessTexturesDescriptorSet);
+
+	if (result != VK_SUCCESS) {
+		ERROR_LOG("Failed to allocate bindless textures descriptor set.");
+		return false;
+	}
+
+	std::vector<VkDescriptorImageInfo> textureImageInfos;
+	textureImageInfos.reserve(textureCount);
+
+	for (const auto texture : m_BindlessTextures) {
+		VkDescriptorImageInfo textureImageInfo{};
+		textureImageInfo.imageView = texture->GetImageView();
+		textureImageInfo.imageLayout = texture->GetImageLayout();
+		textureImageInfo.sampler = m_TextureSampler;
+
+		textureImageInfos.push_back(textureImageInfo);
+	}
+
+	// The whole array is written with a single descriptor write.
+	VkWriteDescriptorSet texturesDescriptorWrite{};
+	texturesDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	texturesDescriptorWrite.dstSet = m_BindlessTexturesDescriptorSet;
+	texturesDescriptorWrite.dstBinding = 0;
+	texturesDescriptorWrite.dstArrayElement = 0;
+	texturesDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	texturesDescriptorWrite.descriptorCount = textureCount;
+	texturesDescriptorWrite.pImageInfo = textureImageInfos.data();
+
+	vkUpdateDescriptorSets(device, 1, &texturesDescriptorWrite, 0, nullptr);
+
+	LOG("Bindless texture array holds " + std::to_string(textureCount) + " textures.");
+
+	return true;
+}
+
+const char* DemoScene::GetMaterialBindingModeName() const noexcept
+{
+	return m_MaterialBindingMode == MaterialBindingMode::BINDLESS ? "Bindless" : "Per draw";
+}
+
 bool DemoScene::CreatePipelines(VkExtent2D swapChainExtent, VkRenderPass renderPass) noexcept
 {
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState{};
@@ -578,6 +725,49 @@ bool DemoScene::CreatePipelines(VkExtent2D swapChainExtent, VkRenderPass renderP
 		return false;
 	}
 
+	// Bindless pipeline, same state with a fragment shader that indexes the texture array.
+	if (m_MaterialBindingMode == MaterialBindingMode::BINDLESS) {
+		fragmentShader = G_ResourceManager.Get<VulkanShader>("sdr/bindless.frag.spv");
+
+		if (!fragmentShader) {
+			ERROR_LOG("Failed to load bindless fragment shader.");
+			return false;
+		}
+
+		// The size of the texture array is a specialization constant of the shader.
+		const auto textureCount = static_cast<ui32>(m_BindlessTextures.size());
+
+		VkSpecializationMapEntry specializationMapEntry{};
+		specializationMapEntry.constantID = 0;
+		specializationMapEntry.offset = 0;
+		specializationMapEntry.size = sizeof textureCount;
+
+		VkSpecializationInfo specializationInfo{};
+		specializationInfo.mapEntryCount = 1;
+		specializationInfo.pMapEntries = &specializationMapEntry;
+		specializationInfo.dataSize = sizeof textureCount;
+		specializationInfo.pData = &textureCount;
+
+		shaderStages[1].module = *fragmentShader;
+		shaderStages[1].pSpecializationInfo = &specializationInfo;
+
+		rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
+
+		pipelineCreateInfo.layout = m_BindlessPipelineLayout;
+
+		result = vkCreateGraphicsPipelines(G_VulkanDevice,
+		                                   m_PipelineCache,
+		                                   1,
+		                                   &pipelineCreateInfo,
+		                                   nullptr,
+		                                   &m_Pipelines.bindless);
+
+		if (result != VK_SUCCESS) {
+			ERROR_LOG("Failed to create bindless pipeline.");
+			return false;
+		}
+	}
+
 	return true;
 }
 
@@ -656,7 +846,7 @@ bool DemoScene::InitializeImGui(const VkRenderPass renderPass) noexcept
 	vkEndCommandBuffer(commandBuffer);
 
 	if (!G_VulkanDevice.SubmitCommandBuffer(commandBuffer,
-		G_VulkanDevice.GetQueue(QueueFamily::TRANSFER),
+		G_VulkanDevice.GetQueue(QueueFamily::GRAPHICS),
 		fence)) {
 		ERROR_LOG("Failed to submit command buffer for Font uploading.");
 		return false;
@@ -743,6 +933,9 @@ void DemoScene::DrawUi(const VkCommandBuffer commandBuffer) const noexcept
 
 		ImGui::NewLine();
 		ImGui::Text("Total Vertex Count: %d", ENTITY_COUNT * 24);
+		ImGui::Text("Material binding: %s", GetMaterialBindingModeName());
+		ImGui::Text("Descriptor set binds: %zu", m_DescriptorSetBinds);
+		ImGui::Text("Record time: %f ms", application.recordTime);
 		ImGui::Text("Running time: %f s", application.GetTimer().GetSec());
 		ImGui::Text("Frame count: %lld", application.frameCount);
 		ImGui::End();
@@ -816,11 +1009,15 @@ void DemoScene::DrawUi(const VkCommandBuffer commandBuffer) const noexcept
 		ImGui::NewLine();
 
 		ImGui::Text("Total Vertex Count: %d", ENTITY_COUNT * 24);
+		ImGui::Text("Material binding: %s", GetMaterialBindingModeName());
+		ImGui::Text("Descriptor set binds per frame: %zu", m_DescriptorSetBinds);
 		ImGui::Text("Total Frames: %lld", application.frameCount);
 		ImGui::Text("Total duration: %f s", application.totalAppDuration);
+		ImGui::Text("Startup time: %f ms", application.startupTime);
 		ImGui::Text("Average FPS: %f", 1000.0f / application.avgTotalFrameTime);
 		ImGui::Text("Average frame time: %f ms", application.avgTotalFrameTime);
 		ImGui::Text("Average CPU time: %f ms", application.avgTotalCpuTime);
+		ImGui::Text("Average record time: %f ms", application.avgTotalRecordTime);
 		ImGui::Text("Average GPU time: %f ms", application.avgTotalGpuTime);
 		ImGui::Text("99th percentile (lower is better): %f ms", application.percentile99th);
 
@@ -854,27 +1051,55 @@ DemoScene::~DemoScene()
 	//Just destroy the descriptor set layout and the descriptor pool.
 	vkDestroyDescriptorSetLayout(device, m_DescriptorSetLayouts.sceneMatrices, nullptr);
 	vkDestroyDescriptorSetLayout(device, m_DescriptorSetLayouts.material, nullptr);
+	vkDestroyDescriptorSetLayout(device, m_DescriptorSetLayouts.bindlessTextures, nullptr);
 
 	vkDestroyDescriptorPool(device, m_DescriptorPool, nullptr);
 	vkDestroyDescriptorPool(device, m_ImGUIDescriptorPool, nullptr);
+	vkDestroyDescriptorPool(device, m_BindlessDescriptorPool, nullptr);
 
 	vkDestroyPipeline(device, m_Pipelines.solid, nullptr);
 
 	vkDestroyPipeline(device, m_Pipelines.wireframe, nullptr);
 
+	vkDestroyPipeline(device, m_Pipelines.bindless, nullptr);
+
 	vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
 
+	vkDestroyPipelineLayout(device, m_BindlessPipelineLayout, nullptr);
+
 	ImGui_ImplGlfwVulkan_Shutdown();
 }
 
 bool DemoScene::Initialize(VkExtent2D swapChainExtent, VkRenderPass renderPass) noexcept
 {
+	ConfigFile cfg{ "config/config.cfg" };
+
+	if (!cfg.IsOpen()) {
+		ERROR_LOG("Failed to open the configuration file.");
+		return false;
+	}
+
+	const std::string materialBinding{ cfg.GetString("attributes.material_binding", "per_draw") };
+
+	if (materialBinding == "bindless") {
+		m_MaterialBindingMode = MaterialBindingMode::BINDLESS;
+	}
+	else if (materialBinding != "per_draw") {
+		ERROR_LOG("Unknown material binding: " + materialBinding + ", falling back to per_draw.");
+	}
+
+	if (m_MaterialBindingMode == MaterialBindingMode::BINDLESS &&
+		!G_VulkanDevice.GetEnabledFeatures().shaderSampledImageArrayDynamicIndexing) {
+		ERROR_LOG("The bindless material binding requires the shaderSampledImageArrayDynamicIndexing feature.");
+		return false;
+	}
+
 	if (!SpawnEntity()) {
 		ERROR_LOG("Failed to generate scene's entities.");
 		return false;
 	}
 
-	if (!m_PipelineCache.Create()) {
+	if (!m_PipelineCache.Create("PerFrameRecordedCommandBuffers")) {
 		return false;
 	}
 
@@ -887,6 +1112,11 @@ bool DemoScene::Initialize(VkExtent2D swapChainExtent, VkRenderPass renderPass)
 		return false;
 	}
 
+	if (m_MaterialBindingMode == MaterialBindingMode::BINDLESS && !PrepareBindlessTextures()) {
+		ERROR_LOG("Failed to prepare the bindless textures.");
+		return false;
+	}
+
 	if (!CreatePipelines(swapChainExtent, renderPass)) {
 		ERROR_LOG("Failed to create scene's pipelines.");
 		return false;
@@ -910,6 +1140,60 @@ void DemoScene::Update(VkExtent2D swapChainExtent, i64 msec, f64 dt) noexcept
 
 void DemoScene::Draw(VkCommandBuffer commandBuffer) noexcept
 {
+	if (m_MaterialBindingMode == MaterialBindingMode::BINDLESS) {
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipelines.bindless);
+
+		// Both sets are the same for every draw, the materials only differ in their push constants.
+		std::array<VkDescriptorSet, 2> descriptorSets{
+			m_SceneMatricesDescriptorSet,
+			m_BindlessTexturesDescriptorSet
+		};
+
+		vkCmdBindDescriptorSets(commandBuffer,
+		                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+		                        m_BindlessPipelineLayout,
+		                        0,
+		                        static_cast<ui32>(descriptorSets.size()),
+		                        descriptorSets.data(),
+		                        0,
+		                        nullptr);
+
+		m_DescriptorSetBinds = 1;
+
+		for (const auto& entity : m_Entities) {
+			const auto& material = entity->GetMaterial();
+
+			const auto& xform = entity->GetXform();
+
+			vkCmdPushConstants(commandBuffer,
+			                   m_BindlessPipelineLayout,
+			                   VK_SHADER_STAGE_VERTEX_BIT,
+			                   0,
+			                   sizeof(Mat4f),
+			                   &xform);
+
+			BindlessMaterialConstants materialConstants{};
+			materialConstants.diffuse = material.diffuse;
+			materialConstants.specular = material.specular;
+			std::copy(material.textureIndices.cbegin(), material.textureIndices.cend(), materialConstants.textureIndices);
+
+			vkCmdPushConstants(commandBuffer,
+			                   m_BindlessPipelineLayout,
+			                   VK_SHADER_STAGE_FRAGMENT_BIT,
+			                   sizeof(Mat4f),
+			                   sizeof materialConstants,
+			                   &materialConstants);
+
+			entity->Draw(commandBuffer);
+		}
+
+		DrawUi(commandBuffer);
+
+		return;
+	}
+
+	m_DescriptorSetBinds = m_Entities.size();
+
 	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipelines.solid);
 
 	for (const auto& entity : m_Entities) {
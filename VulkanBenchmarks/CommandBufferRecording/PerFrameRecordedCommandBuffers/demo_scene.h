@@ -10,32 +10,71 @@ struct UniformBufferObject {
 	Mat4f projection;
 };
 
+/**
+ * \brief Fragment push constants of the bindless pipeline, right after the model matrix.
+ */
+struct BindlessMaterialConstants {
+	Vec4f diffuse;
+	Vec4f specular;
+	ui32 textureIndices[4];
+};
+
+/**
+ * \brief How the materials are bound, selected with attributes.material_binding in config.cfg.
+ */
+enum class MaterialBindingMode {
+	// One material descriptor set bound per draw.
+	PER_DRAW,
+	// Every texture in one array bound once per frame, the draws push their texture indices.
+	BINDLESS
+};
+
 class DemoScene final {
 private:
 	std::vector<std::unique_ptr<DemoEntity>> m_Entities;
 
+	MaterialBindingMode m_MaterialBindingMode{ MaterialBindingMode::PER_DRAW };
+
+	/**
+	 * \brief The distinct textures of all the materials, in the order of the bindless texture array.
+	 */
+	std::vector<VulkanTexture*> m_BindlessTextures;
+
+	/**
+	 * \brief Descriptor sets bound while recording the last frame.
+	 */
+	size_t m_DescriptorSetBinds{ 0 };
+
 	VkDescriptorPool m_DescriptorPool{ VK_NULL_HANDLE };
 
 	VkDescriptorPool m_ImGUIDescriptorPool{ VK_NULL_HANDLE };
 
+	VkDescriptorPool m_BindlessDescriptorPool{ VK_NULL_HANDLE };
+
 	struct {
 		VkDescriptorSetLayout sceneMatrices{ VK_NULL_HANDLE };
 		VkDescriptorSetLayout material{ VK_NULL_HANDLE };
+		VkDescriptorSetLayout bindlessTextures{ VK_NULL_HANDLE };
 	} m_DescriptorSetLayouts;
 
 	VkDescriptorSet m_SceneMatricesDescriptorSet{ VK_NULL_HANDLE };
 
+	VkDescriptorSet m_BindlessTexturesDescriptorSet{ VK_NULL_HANDLE };
+
 	VulkanBuffer m_MatricesUbo;
 
 	struct {
 		VkPipeline solid{ VK_NULL_HANDLE };
 		VkPipeline wireframe{ VK_NULL_HANDLE };
+		VkPipeline bindless{ VK_NULL_HANDLE };
 	} m_Pipelines;
 
 	VulkanPipelineCache m_PipelineCache;
 
 	VkPipelineLayout m_PipelineLayout{ VK_NULL_HANDLE };
 
+	VkPipelineLayout m_BindlessPipelineLayout{ VK_NULL_HANDLE };
+
 	// All textures will be sampled with a single sampler.
 	VkSampler m_TextureSampler{ VK_NULL_HANDLE };
 
@@ -47,6 +86,14 @@ private:
 
 	bool PrepareUniforms() noexcept;
 
+	/**
+	 * \brief Gathers the distinct textures of the materials into one array, writes it to a single
+	 * descriptor set and assigns each material the indices of its textures.
+	 */
+	bool PrepareBindlessTextures() noexcept;
+
+	const char* GetMaterialBindingModeName() const noexcept;
+
 	bool CreatePipelines(VkExtent2D swapChainExtent, VkRenderPass renderPass) noexcept;
 
 	bool InitializeImGui(const VkRenderPass renderPass) noexcept;
@@ -0,0 +1,44 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec3 v_InLightDirection;
+layout(location = 1) in vec3 v_InViewDirection;
+layout(location = 2) in vec2 inTexcoord;
+layout(location = 3) in vec3 inNormal;
+layout(location = 4) in vec3 inVertexColor;
+
+layout(push_constant) uniform PushContstants {
+    layout(offset = 64) vec4 diffuse;
+    layout(offset = 80) vec4 specular;
+    // Diffuse, specular and normal texture indices into the texture array.
+    layout(offset = 96) uvec4 textureIndices;
+} pcs;
+
+// Set by the application to the number of textures in the scene.
+layout(constant_id = 0) const uint TEXTURE_COUNT = 1;
+
+// Every texture of the scene, bound once per frame. The indices come from push
+// constants so they are dynamically uniform, which only needs the
+// shaderSampledImageArrayDynamicIndexing feature.
+layout(set = 1, binding = 0) uniform sampler2D textures[TEXTURE_COUNT];
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    vec3 n = normalize(texture(textures[pcs.textureIndices.z], inTexcoord).rgb * 2.0 - 1.0);
+    vec3 v = normalize(v_InViewDirection);
+    vec3 l = normalize(v_InLightDirection);
+
+    vec3 h = normalize(l + v);
+
+    float diffLight = max(dot(n, l), 0.0);
+
+    float specLight = pow(max(dot(n, h), 0.0), 60.0);
+
+    vec4 diffTexel = texture(textures[pcs.textureIndices.x], inTexcoord);
+    vec4 specTexel = texture(textures[pcs.textureIndices.y], inTexcoord);
+
+	outColor = diffTexel * pcs.diffuse  * diffLight
+	            + specTexel * pcs.specular * specLight;
+}
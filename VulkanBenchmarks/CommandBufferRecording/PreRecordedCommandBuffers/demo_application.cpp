@@ -105,9 +105,11 @@ void DemoApplication::DrawUi() const noexcept
 
 	renderPassBeginInfo.framebuffer = GetFramebuffers()[GetCurrentBufferIndex()];
 
-	vkBeginCommandBuffer(m_UiCommandBuffer, &commandBufferBeginInfo);
+	const auto uiCommandBuffer = m_UiCommandBuffers[GetCurrentFrameIndex()];
 
-	vkCmdBeginRenderPass(m_UiCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkBeginCommandBuffer(uiCommandBuffer, &commandBufferBeginInfo);
+
+	vkCmdBeginRenderPass(uiCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 	VkViewport viewport{};
 	viewport.x = 0;
@@ -115,20 +117,20 @@ void DemoApplication::DrawUi() const noexcept
 	viewport.width = swapChainExtent.width;
 	viewport.height = swapChainExtent.height;
 
-	vkCmdSetViewport(m_UiCommandBuffer, 0, 1, &viewport);
+	vkCmdSetViewport(uiCommandBuffer, 0, 1, &viewport);
 
 	VkRect2D scissor{};
 	scissor.extent = renderPassBeginInfo.renderArea.extent;
 	scissor.offset.x = 0;
 	scissor.offset.y = 0;
 
-	vkCmdSetScissor(m_UiCommandBuffer, 0, 1, &scissor);
+	vkCmdSetScissor(uiCommandBuffer, 0, 1, &scissor);
 
-	m_DemoScene.DrawUi(m_UiCommandBuffer);
+	m_DemoScene.DrawUi(uiCommandBuffer);
 
-	vkCmdEndRenderPass(m_UiCommandBuffer);
+	vkCmdEndRenderPass(uiCommandBuffer);
 
-	vkEndCommandBuffer(m_UiCommandBuffer);
+	vkEndCommandBuffer(uiCommandBuffer);
 }
 
 bool DemoApplication::CreateRenderPasses() noexcept
@@ -245,7 +247,11 @@ bool DemoApplication::Initialize() noexcept
 		return false;
 	}
 
-	m_UiCommandBuffer = G_VulkanDevice.CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+	m_UiCommandBuffers.resize(GetFramesInFlight());
+
+	for (auto& uiCommandBuffer : m_UiCommandBuffers) {
+		uiCommandBuffer = G_VulkanDevice.CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+	}
 
 	if (!m_UiSemaphore.Create()) {
 		ERROR_LOG("Failed to create semaphore for UI render pass.");
@@ -292,14 +298,14 @@ void DemoApplication::Draw() noexcept
 		return;
 	}
 
-	submitInfo.pCommandBuffers = &m_UiCommandBuffer;
+	submitInfo.pCommandBuffers = &m_UiCommandBuffers[GetCurrentFrameIndex()];
 	submitInfo.pWaitSemaphores = m_UiSemaphore.Get();
 	submitInfo.pSignalSemaphores = GetDrawCompleteSemaphore().Get();
 
 	result = vkQueueSubmit(G_VulkanDevice.GetQueue(QueueFamily::GRAPHICS),
 	                       1,
 	                       &submitInfo,
-	                       VK_NULL_HANDLE);
+	                       ResetFrameFence());
 
 	if (result != VK_SUCCESS) {
 		ERROR_LOG("Failed to submit the command buffer.");
@@ -9,7 +9,10 @@ class DemoApplication final : public VulkanApplication {
 private:
 	DemoScene m_DemoScene;
 
-	VkCommandBuffer m_UiCommandBuffer{ VK_NULL_HANDLE };
+	/**
+	 * \brief The UI command buffers, re-recorded every frame. One per frame in flight.
+	 */
+	std::vector<VkCommandBuffer> m_UiCommandBuffers;
 
 	VulkanSemaphore m_UiSemaphore;
 
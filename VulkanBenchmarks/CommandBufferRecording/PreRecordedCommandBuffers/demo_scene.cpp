@@ -634,7 +634,7 @@ bool DemoScene::InitializeImGui(const VkRenderPass renderPass) noexcept
 	vkEndCommandBuffer(commandBuffer);
 
 	if (!G_VulkanDevice.SubmitCommandBuffer(commandBuffer,
-		G_VulkanDevice.GetQueue(QueueFamily::TRANSFER),
+		G_VulkanDevice.GetQueue(QueueFamily::GRAPHICS),
 		fence)) {
 		ERROR_LOG("Failed to submit command buffer for Font uploading.");
 		return false;
@@ -683,7 +683,7 @@ bool DemoScene::Initialize(VkExtent2D swapChainExtent, VkRenderPass renderPass,
 		return false;
 	}
 
-	if (!m_PipelineCache.Create()) {
+	if (!m_PipelineCache.Create("PreRecordedCommandBuffers")) {
 		return false;
 	}
 
@@ -902,6 +902,7 @@ void DemoScene::DrawUi(const VkCommandBuffer commandBuffer) const noexcept
 		ImGui::Text("Total Vertex Count: %d", ENTITY_COUNT * 24);
 		ImGui::Text("Total Frames: %lld", application.frameCount);
 		ImGui::Text("Total duration: %f s", application.totalAppDuration);
+		ImGui::Text("Startup time: %f ms", application.startupTime);
 		ImGui::Text("Average FPS: %f", 1000.0f / application.avgTotalFrameTime);
 		ImGui::Text("Average frame time: %f ms", application.avgTotalFrameTime);
 		ImGui::Text("Average CPU time: %f ms", application.avgTotalCpuTime);
@@ -14,6 +14,14 @@ void DemoApplication::EnableFeatures() noexcept
 	if (physicalDevice.features.fillModeNonSolid) {
 		featuresToEnable.fillModeNonSolid = VK_TRUE;
 	}
+
+	if (physicalDevice.features.multiDrawIndirect) {
+		featuresToEnable.multiDrawIndirect = VK_TRUE;
+	}
+
+	if (physicalDevice.features.drawIndirectFirstInstance) {
+		featuresToEnable.drawIndirectFirstInstance = VK_TRUE;
+	}
 }
 
 bool DemoApplication::BuildCommandBuffers() noexcept
@@ -70,7 +78,7 @@ bool DemoApplication::BuildCommandBuffers() noexcept
 	scissor.offset = VkOffset2D{ 0, 0 };
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-	m_DemoScene.Draw(commandBuffer);
+	m_DemoScene.Draw(commandBuffer, GetCurrentFrameIndex());
 
 	vkCmdEndRenderPass(commandBuffer);
 
@@ -119,7 +127,7 @@ void DemoApplication::Draw() noexcept
 {
 	PreDraw();
 
-	BuildCommandBuffers();
+	RecordCommandBuffers();
 
 	auto& submitInfo = GetSubmitInfo();
 	submitInfo.commandBufferCount = 1;
@@ -131,7 +139,7 @@ void DemoApplication::Draw() noexcept
 		vkQueueSubmit(G_VulkanDevice.GetQueue(QueueFamily::GRAPHICS),
 		              1,
 		              &submitInfo,
-		              VK_NULL_HANDLE)
+		              ResetFrameFence())
 	};
 
 	if (result != VK_SUCCESS) {
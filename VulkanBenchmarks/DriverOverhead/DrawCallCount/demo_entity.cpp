@@ -1,8 +1,14 @@
 #include "demo_entity.h"
 
-DemoEntity::DemoEntity(VulkanMesh* mesh)
+DemoEntity::DemoEntity(VulkanMesh* mesh, const TransformHandle transform)
+	: m_Mesh{ mesh },
+	  m_Transform{ transform }
 {
-	m_Mesh = mesh;
+}
+
+TransformHandle DemoEntity::GetTransform() const noexcept
+{
+	return m_Transform;
 }
 
 DemoMaterial& DemoEntity::GetMaterial() noexcept
@@ -15,10 +21,10 @@ void DemoEntity::SetMaterial(DemoMaterial* material) noexcept
 	m_Material = material;
 }
 
-void DemoEntity::Draw(VkCommandBuffer commandBuffer) noexcept
+void DemoEntity::Draw(VkCommandBuffer commandBuffer, const ui32 firstInstance) noexcept
 {
 	if (m_Mesh) {
-		m_Mesh->Draw(commandBuffer);
+		m_Mesh->Draw(commandBuffer, 1, firstInstance);
 	}
 }
 
@@ -1,24 +1,29 @@
 #ifndef DEMO_ENTITY_H_
 #define DEMO_ENTITY_H_
 
-#include "entity.h"
+#include "resource.h"
+#include "transform_store.h"
 #include "vulkan_mesh.h"
 #include "demo_material.h"
 
-class DemoEntity final : public Entity {
+class DemoEntity final : public Resource {
 private:
 	VulkanMesh* m_Mesh{ nullptr };
 
+	TransformHandle m_Transform;
+
 	DemoMaterial* m_Material;
 
 public:
-	explicit DemoEntity(VulkanMesh* mesh);
+	DemoEntity(VulkanMesh* mesh, TransformHandle transform);
+
+	TransformHandle GetTransform() const noexcept;
 
 	DemoMaterial& GetMaterial() noexcept;
 
 	void SetMaterial(DemoMaterial* material) noexcept;
 
-	void Draw(VkCommandBuffer commandBuffer) noexcept;
+	void Draw(VkCommandBuffer commandBuffer, ui32 firstInstance = 0) noexcept;
 
 	bool Load(const std::string& fileName) noexcept override;
 };
@@ -2,6 +2,7 @@
 #define DEMO_MATERIAL_H_
 
 #include <vulkan_texture.h>
+#include <vulkan_descriptor_set_cache.h>
 
 struct DemoMaterial final {
 	std::array<VulkanTexture*, SUPPORTED_TEX_COUNT> textures;
@@ -12,6 +13,9 @@ struct DemoMaterial final {
 
 	//Each material has it's own descriptor set.
 	VkDescriptorSet descriptorSet;
+
+	//The descriptors written to descriptorSet, used to write transient sets and to look up cached ones.
+	std::vector<VulkanDescriptorBinding> bindings;
 };
 
 #endif //DEMO_MATERIAL_H_
@@ -7,10 +7,13 @@
 #include <mutex>
 #include "demo_scene.h"
 #include <algorithm>
+#include "timer.h"
 #include <vulkan_application.h>
 #include "imgui_impl_glfw_vulkan.h"
 #include "imgui.h"
 #include <fstream>
+#include <cstring>
+#include <cfg.h>
 
 // Vulkan clip space has inverted Y and half Z.
 static const Mat4f s_ClipCorrectionMat{
@@ -30,30 +33,293 @@ static auto RealRangeRng(const f32 begin, const f32 end)
 }
 
 // Private functions -------------------------------------------------
-bool DemoScene::SpawnEntity() noexcept
+bool DemoScene::SpawnEntities(const size_t count) noexcept
 {
-	auto entity = std::make_unique<DemoEntity>(&m_CubeMesh);
+	if (!count) {
+		return true;
+	}
+
+	const auto spawnedCount = m_Entities.size();
+
+	for (auto i = 0u; i < count; ++i) {
+		const auto transform = m_Transforms.Create();
+
+		m_Transforms.SetPosition(transform, Vec3f{
+			RealRangeRng(-20.0f, 20.0f),
+			RealRangeRng(-20.0f, 20.0f),
+			RealRangeRng(-20.0f, 20.0f)
+		});
+
+		auto entity = std::make_unique<DemoEntity>(&m_CubeMesh, transform);
+
+		entity->SetMaterial(&m_Material);
+
+		m_Entities.push_back(std::move(entity));
+	}
+
+	// Keep the entities sorted from back to front to avoid early z optimizations.
+	// Only the new batch is sorted, then it is merged into the already sorted entities.
+	const auto backToFront = [this](const auto& a, const auto& b)
+	{
+		return m_Transforms.GetPosition(a->GetTransform()).z > m_Transforms.GetPosition(b->GetTransform()).z;
+	};
+
+	const auto firstSpawned = m_Entities.begin() + spawnedCount;
+
+	std::sort(firstSpawned, m_Entities.end(), backToFront);
+	std::inplace_merge(m_Entities.begin(), firstSpawned, m_Entities.end(), backToFront);
+
+	return true;
+}
+
+// Replaces buffer with a persistently mapped host visible buffer of size bytes.
+static bool RecreateMappedBuffer(VulkanBuffer& buffer, const VkBufferUsageFlags usageFlags, const VkDeviceSize size) noexcept
+{
+	if (buffer.buffer) {
+		buffer.Unmap();
+		buffer.CleanUp();
+	}
+
+	if (!G_VulkanDevice.CreateBuffer(usageFlags,
+	                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	                                 buffer,
+	                                 size)) {
+		return false;
+	}
+
+	return buffer.Map() == VK_SUCCESS;
+}
+
+bool DemoScene::ReserveInstanceData(FrameData& frame, const size_t count) noexcept
+{
+	if (count <= frame.instanceCapacity) {
+		return true;
+	}
+
+	auto capacity = std::max<size_t>(frame.instanceCapacity, 1024);
+
+	while (capacity < count) {
+		capacity *= 2;
+	}
 
-	entity->SetPosition(Vec3f{
-		RealRangeRng(-20.0f, 20.0f),
-		RealRangeRng(-20.0f, 20.0f),
-		RealRangeRng(-20.0f, 20.0f)
+	// The buffers are only replaced while recording, after PreDraw has waited on
+	// the fence of this frame, so the last frame that used them has completed.
+	if (!RecreateMappedBuffer(frame.instanceXformsSsbo, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, capacity * sizeof(Mat4f))) {
+		ERROR_LOG("Failed to create instance transforms storage buffer.");
+		return false;
+	}
+
+	if (m_RenderMode == RenderMode::INDIRECT &&
+		!RecreateMappedBuffer(frame.indirectCommands,
+		                      VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		                      capacity * sizeof(VkDrawIndexedIndirectCommand))) {
+		ERROR_LOG("Failed to create indirect command buffer.");
+		return false;
+	}
+
+	VkWriteDescriptorSet storageDescriptorWrite{};
+	storageDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	storageDescriptorWrite.dstSet = frame.sceneMatricesDescriptorSet;
+	storageDescriptorWrite.dstBinding = 1;
+	storageDescriptorWrite.dstArrayElement = 0;
+	storageDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	storageDescriptorWrite.descriptorCount = 1;
+	storageDescriptorWrite.pBufferInfo = &frame.instanceXformsSsbo.descriptorBufferInfo;
+
+	vkUpdateDescriptorSets(G_VulkanDevice, 1, &storageDescriptorWrite, 0, nullptr);
+
+	frame.instanceCapacity = capacity;
+
+	return true;
+}
+
+bool DemoScene::UploadInstanceData(FrameData& frame) noexcept
+{
+	if (!ReserveInstanceData(frame, m_Entities.size())) {
+		return false;
+	}
+
+	const auto instanceXforms = static_cast<Mat4f*>(frame.instanceXformsSsbo.data);
+
+	VkDrawIndexedIndirectCommand* commands{ nullptr };
+
+	if (m_RenderMode == RenderMode::INDIRECT) {
+		commands = static_cast<VkDrawIndexedIndirectCommand*>(frame.indirectCommands.data);
+	}
+
+	const auto indexCount = static_cast<ui32>(m_CubeMesh.GetIndices().size());
+
+	// The entities are sorted back to front, so they are gathered from the
+	// transform store in draw order rather than copied in creation order.
+	m_ThreadPool.ParallelFor(0, m_Entities.size(), 4096, [=](const size_t begin, const size_t end)
+	{
+		for (auto i = begin; i < end; ++i) {
+			memcpy(&instanceXforms[i], &m_Transforms.GetXform(m_Entities[i]->GetTransform()), sizeof(Mat4f));
+		}
+
+		if (!commands) {
+			return;
+		}
+
+		// One command per cube. firstInstance selects the cube's world matrix in the vertex shader.
+		for (auto i = begin; i < end; ++i) {
+			commands[i].indexCount = indexCount;
+			commands[i].instanceCount = 1;
+			commands[i].firstIndex = 0;
+			commands[i].vertexOffset = 0;
+			commands[i].firstInstance = static_cast<ui32>(i);
+		}
 	});
 
+	return true;
+}
 
-	entity->SetMaterial(&m_Material);
+static VkDescriptorType GetObjectDataDescriptorType(const ObjectDataMode mode) noexcept
+{
+	return mode == ObjectDataMode::SSBO_INDEX ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+}
+
+bool DemoScene::ReserveObjectData(FrameData& frame, const size_t count) noexcept
+{
+	if (count <= frame.objectDataCapacity) {
+		return true;
+	}
+
+	auto capacity = std::max<size_t>(frame.objectDataCapacity, 1024);
 
-	m_Entities.push_back(std::move(entity));
+	while (capacity < count) {
+		capacity *= 2;
+	}
+
+	const auto usageFlags = m_ObjectDataMode == ObjectDataMode::SSBO_INDEX
+		                        ? VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+		                        : VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+
+	// Same as the instance data, PreDraw has waited on the fence of this frame.
+	if (!RecreateMappedBuffer(frame.objectDataBuffer, usageFlags, capacity * m_ObjectDataStride)) {
+		ERROR_LOG("Failed to create object data buffer.");
+		return false;
+	}
 
-	// Sort entities from back to front to avoid early z optimizations.
-	std::sort(m_Entities.begin(), m_Entities.end(), [](auto& a, auto& b)
+	// A dynamic uniform buffer descriptor covers one element, the offset of each draw selects which.
+	VkDescriptorBufferInfo objectDataBufferInfo{};
+	objectDataBufferInfo.buffer = frame.objectDataBuffer.buffer;
+	objectDataBufferInfo.offset = 0;
+	objectDataBufferInfo.range = m_ObjectDataMode == ObjectDataMode::SSBO_INDEX ? VK_WHOLE_SIZE : sizeof(ObjectData);
+
+	VkWriteDescriptorSet objectDataDescriptorWrite{};
+	objectDataDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	objectDataDescriptorWrite.dstSet = frame.objectDataDescriptorSet;
+	objectDataDescriptorWrite.dstBinding = 0;
+	objectDataDescriptorWrite.dstArrayElement = 0;
+	objectDataDescriptorWrite.descriptorType = GetObjectDataDescriptorType(m_ObjectDataMode);
+	objectDataDescriptorWrite.descriptorCount = 1;
+	objectDataDescriptorWrite.pBufferInfo = &objectDataBufferInfo;
+
+	vkUpdateDescriptorSets(G_VulkanDevice, 1, &objectDataDescriptorWrite, 0, nullptr);
+
+	frame.objectDataCapacity = capacity;
+
+	return true;
+}
+
+bool DemoScene::UploadObjectData(FrameData& frame) noexcept
+{
+	if (!ReserveObjectData(frame, m_Entities.size())) {
+		return false;
+	}
+
+	const auto objectData = static_cast<ui8*>(frame.objectDataBuffer.data);
+
+	const auto stride = m_ObjectDataStride;
+
+	// Written straight to the mapped buffer in draw order, the draws only differ in the offset or index they use.
+	m_ThreadPool.ParallelFor(0, m_Entities.size(), 4096, [=](const size_t begin, const size_t end)
 	{
-		return a->GetPosition().z > b->GetPosition().z;
+		for (auto i = begin; i < end; ++i) {
+			auto& material = m_Entities[i]->GetMaterial();
+
+			ObjectData object;
+			object.model = m_Transforms.GetXform(m_Entities[i]->GetTransform());
+			object.diffuse = material.diffuse;
+			object.specular = material.specular;
+
+			memcpy(objectData + i * stride, &object, sizeof object);
+		}
 	});
 
 	return true;
 }
 
+const char* DemoScene::GetRenderModeName() const noexcept
+{
+	switch (m_RenderMode) {
+	case RenderMode::INSTANCED:
+		return "Instanced";
+	case RenderMode::INDIRECT:
+		return "Multi draw indirect";
+	default:
+		return "Per draw";
+	}
+}
+
+const char* DemoScene::GetDescriptorModeName() const noexcept
+{
+	switch (m_DescriptorMode) {
+	case DescriptorMode::TRANSIENT:
+		return "Transient";
+	case DescriptorMode::CACHED:
+		return "Cached";
+	default:
+		return "Static";
+	}
+}
+
+const char* DemoScene::GetObjectDataModeName() const noexcept
+{
+	switch (m_ObjectDataMode) {
+	case ObjectDataMode::DYNAMIC_UBO:
+		return "Dynamic uniform buffer offsets";
+	case ObjectDataMode::SSBO_INDEX:
+		return "Storage buffer index";
+	default:
+		return "Push constants";
+	}
+}
+
+VkDescriptorSet DemoScene::GetMaterialDescriptorSet(DemoMaterial& material, const ui32 frameIndex) noexcept
+{
+	switch (m_DescriptorMode) {
+	case DescriptorMode::TRANSIENT: {
+		const auto descriptorSet = m_DescriptorAllocator.AllocateTransient(frameIndex, m_DescriptorSetLayouts.material);
+
+		if (descriptorSet) {
+			VulkanDescriptorSetCache::Write(descriptorSet, material.bindings);
+		}
+
+		return descriptorSet;
+	}
+	case DescriptorMode::CACHED:
+		return m_DescriptorSetCache.Get(m_DescriptorSetLayouts.material, material.bindings);
+	default:
+		return material.descriptorSet;
+	}
+}
+
+size_t DemoScene::GetDrawCallCount() const noexcept
+{
+	if (m_RenderMode == RenderMode::PER_DRAW) {
+		return m_Entities.size();
+	}
+
+	// Without multi draw indirect every indirect command is recorded as a separate draw.
+	if (m_RenderMode == RenderMode::INDIRECT && !G_VulkanDevice.GetEnabledFeatures().multiDrawIndirect) {
+		return m_Entities.size();
+	}
+
+	return m_Entities.empty() ? 0 : 1;
+}
+
 bool DemoScene::CreateTextureSampler() noexcept
 {
 	// All textures will be sampled with the same sampler for this scene.
@@ -98,10 +364,18 @@ bool DemoScene::PrepareUniforms() noexcept
 	//First create a descriptor pool to allocate descriptors from.
 	//Descriptors a.k.a uniforms
 
+	// The instance storage buffer is rewritten every frame, so there is one scene matrices set per frame in flight.
+	const auto framesInFlight = G_Application.GetFramesInFlight();
+
 	// We need 1 descriptor set for the scene matrices.
 	VkDescriptorPoolSize sceneMatricesPoolSize{};
 	sceneMatricesPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	sceneMatricesPoolSize.descriptorCount = 1;
+	sceneMatricesPoolSize.descriptorCount = framesInFlight;
+
+	// The instanced pipeline also reads the world matrices from a storage buffer in the same set.
+	VkDescriptorPoolSize instanceXformsPoolSize{};
+	instanceXformsPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	instanceXformsPoolSize.descriptorCount = framesInFlight;
 
 	//and 1 descriptor set for the shared material.
 	VkDescriptorPoolSize materialPoolSize{};
@@ -113,13 +387,23 @@ bool DemoScene::PrepareUniforms() noexcept
 	// 3 textures per material of each entity.
 	materialPoolSize.descriptorCount = 3;
 
-	std::vector<VkDescriptorPoolSize> descriptorPoolSizes{ sceneMatricesPoolSize, materialPoolSize };
+	// The object data modes add one set with a single buffer per frame in flight.
+	VkDescriptorPoolSize objectDataPoolSize{};
+	objectDataPoolSize.type = GetObjectDataDescriptorType(m_ObjectDataMode);
+	objectDataPoolSize.descriptorCount = framesInFlight;
+
+	std::vector<VkDescriptorPoolSize> descriptorPoolSizes{
+		sceneMatricesPoolSize,
+		instanceXformsPoolSize,
+		materialPoolSize,
+		objectDataPoolSize
+	};
 
 	VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
 	descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 
-	//1 set for each entity's material plus one for the scene matrices
-	descriptorPoolCreateInfo.maxSets = 2;
+	//1 set for each entity's material plus one for the scene matrices and one for the object data per frame in flight
+	descriptorPoolCreateInfo.maxSets = 1 + 2 * framesInFlight;
 	descriptorPoolCreateInfo.poolSizeCount = static_cast<ui32>(descriptorPoolSizes.size());
 	descriptorPoolCreateInfo.pPoolSizes = descriptorPoolSizes.data();
 
@@ -147,7 +431,16 @@ bool DemoScene::PrepareUniforms() noexcept
 	vertexShaderUboBinding.descriptorCount = 1; //1 descriptor.
 	vertexShaderUboBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT; //bound to the vertex shader stage
 
-	std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings{ vertexShaderUboBinding };
+	VkDescriptorSetLayoutBinding instanceXformsBinding{};
+	instanceXformsBinding.binding = 1; //bind at location 1.
+	instanceXformsBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER; //World matrices of all the instances.
+	instanceXformsBinding.descriptorCount = 1;
+	instanceXformsBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+	std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings{
+		vertexShaderUboBinding,
+		instanceXformsBinding
+	};
 
 	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
 	descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -242,40 +535,46 @@ bool DemoScene::PrepareUniforms() noexcept
 	}
 
 	// Now all the layouts have been defined. It is time to allocate the descriptor sets and write to them.
-	// First, allocate the scene matrices descriptor set.
+	// Create the buffer object that will store the uniforms. The matrices are written once, so the frames share it.
+	if (!device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+	                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	                         m_MatricesUbo,
+	                         sizeof(UniformBufferObject))) {
+		ERROR_LOG("Failed to create uniform buffer.");
+		return false;
+	}
+
+	// First, allocate the scene matrices descriptor sets.
 	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
 	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 	descriptorSetAllocateInfo.descriptorPool = m_DescriptorPool; //Allocate from this pool.
 	descriptorSetAllocateInfo.descriptorSetCount = 1; //1 descriptor set.
 	descriptorSetAllocateInfo.pSetLayouts = &m_DescriptorSetLayouts.sceneMatrices; //With this layout.
 
-	result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &m_SceneMatricesDescriptorSet);
+	std::vector<VkWriteDescriptorSet> writeDescriptorSets;
 
-	if (result != VK_SUCCESS) {
-		ERROR_LOG("Failed to allocate scene matrices descriptor set.");
-		return false;
-	}
+	for (auto i = 0u; i < framesInFlight; ++i) {
+		auto& frame = m_Frames[i];
 
-	// Create the buffer object that will store the uniforms.
-	if (!device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-	                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-	                         m_MatricesUbo,
-	                         sizeof(UniformBufferObject))) {
-		ERROR_LOG("Failed to create uniform buffer.");
-		return false;
-	}
+		result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &frame.sceneMatricesDescriptorSet);
 
-	// Now that the descriptor set is allocated we have to write into it and update the uniforms.
-	VkWriteDescriptorSet uniformDescriptorWrite{};
-	uniformDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	uniformDescriptorWrite.dstSet = m_SceneMatricesDescriptorSet; //Write to this set
-	uniformDescriptorWrite.dstBinding = 0; //at this binding
-	uniformDescriptorWrite.dstArrayElement = 0; //It is not an array.
-	uniformDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; //It is a uniform buffer.
-	uniformDescriptorWrite.descriptorCount = 1; // 1 descriptor set.
-	uniformDescriptorWrite.pBufferInfo = &m_MatricesUbo.descriptorBufferInfo; // And here is the buffer description.
+		if (result != VK_SUCCESS) {
+			ERROR_LOG("Failed to allocate scene matrices descriptor set.");
+			return false;
+		}
 
-	std::vector<VkWriteDescriptorSet> writeDescriptorSets{ uniformDescriptorWrite };
+		// Now that the descriptor set is allocated we have to write into it and update the uniforms.
+		VkWriteDescriptorSet uniformDescriptorWrite{};
+		uniformDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		uniformDescriptorWrite.dstSet = frame.sceneMatricesDescriptorSet; //Write to this set
+		uniformDescriptorWrite.dstBinding = 0; //at this binding
+		uniformDescriptorWrite.dstArrayElement = 0; //It is not an array.
+		uniformDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; //It is a uniform buffer.
+		uniformDescriptorWrite.descriptorCount = 1; // 1 descriptor set.
+		uniformDescriptorWrite.pBufferInfo = &m_MatricesUbo.descriptorBufferInfo; // And here is the buffer description.
+
+		writeDescriptorSets.push_back(uniformDescriptorWrite);
+	}
 
 	// Update the descriptor set.
 	vkUpdateDescriptorSets(device,
@@ -358,12 +657,118 @@ bool DemoScene::PrepareUniforms() noexcept
 	                       0,
 	                       nullptr);
 
+	// Keep the descriptors of the material, the transient and cached descriptor modes write them to other sets.
+	m_Material.bindings.clear();
+
+	const auto addMaterialBinding = [this](const ui32 bindingIndex, const VkDescriptorImageInfo& imageInfo)
+	{
+		VulkanDescriptorBinding binding{};
+		binding.binding = bindingIndex;
+		binding.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		binding.imageInfo = imageInfo;
+
+		m_Material.bindings.push_back(binding);
+	};
+
+	addMaterialBinding(TEX_DIFFUSE, diffuseTextureImageInfo);
+	addMaterialBinding(TEX_SPECULAR, specularTextureImageInfo);
+	addMaterialBinding(TEX_NORMAL, normalTextureImageInfo);
+
+	// A material set holds 3 combined image samplers. Pools are added as the
+	// number of cubes grows and the per frame ones are reused once reset.
+	if (!m_DescriptorAllocator.Create(framesInFlight, 1024, { { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3.0f } })) {
+		ERROR_LOG("Failed to create descriptor allocator.");
+		return false;
+	}
+
+	m_DescriptorSetCache.Create(&m_DescriptorAllocator);
+
 
 	m_MatricesUbo.Map(sizeof m_MatricesUbo);
 
 	return true;
 }
 
+bool DemoScene::PrepareObjectData() noexcept
+{
+	const auto& device = G_VulkanDevice;
+
+	if (m_ObjectDataMode == ObjectDataMode::DYNAMIC_UBO) {
+		const auto alignment = device.GetPhysicalDevice().properties.limits.minUniformBufferOffsetAlignment;
+
+		m_ObjectDataStride = (sizeof(ObjectData) + alignment - 1) / alignment * alignment;
+	}
+
+	//Descriptor set 2 - object data, only read by the vertex shader which forwards the colours.
+	VkDescriptorSetLayoutBinding objectDataBinding{};
+	objectDataBinding.binding = 0;
+	objectDataBinding.descriptorType = GetObjectDataDescriptorType(m_ObjectDataMode);
+	objectDataBinding.descriptorCount = 1;
+	objectDataBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+	descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptorSetLayoutCreateInfo.bindingCount = 1;
+	descriptorSetLayoutCreateInfo.pBindings = &objectDataBinding;
+
+	VkResult result{
+		vkCreateDescriptorSetLayout(device,
+		                            &descriptorSetLayoutCreateInfo,
+		                            nullptr,
+		                            &m_DescriptorSetLayouts.objectData)
+	};
+
+	if (result != VK_SUCCESS) {
+		ERROR_LOG("Failed to create object data descriptor set layout.");
+		return false;
+	}
+
+	// The first two sets match m_PipelineLayout, so the material sets are bound the same way in every mode.
+	std::array<VkDescriptorSetLayout, 3> descriptorSetLayouts{
+		m_DescriptorSetLayouts.sceneMatrices,
+		m_DescriptorSetLayouts.material,
+		m_DescriptorSetLayouts.objectData
+	};
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.setLayoutCount = static_cast<ui32>(descriptorSetLayouts.size());
+	pipelineLayoutCreateInfo.pSetLayouts = descriptorSetLayouts.data();
+
+	result = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &m_ObjectDataPipelineLayout);
+
+	if (result != VK_SUCCESS) {
+		ERROR_LOG("Failed to create object data pipeline layout.");
+		return false;
+	}
+
+	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptorSetAllocateInfo.descriptorPool = m_DescriptorPool;
+	descriptorSetAllocateInfo.descriptorSetCount = 1;
+	descriptorSetAllocateInfo.pSetLayouts = &m_DescriptorSetLayouts.objectData;
+
+	for (auto i = 0u; i < G_Application.GetFramesInFlight(); ++i) {
+		auto& frame = m_Frames[i];
+
+		result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &frame.objectDataDescriptorSet);
+
+		if (result != VK_SUCCESS) {
+			ERROR_LOG("Failed to allocate object data descriptor set.");
+			return false;
+		}
+
+		// Create the buffers up front so the sets are valid before the first cube spawns.
+		if (!ReserveObjectData(frame, 1)) {
+			return false;
+		}
+	}
+
+	LOG("Object data stride: " + std::to_string(m_ObjectDataStride) + " bytes.");
+
+	return true;
+}
+
 bool DemoScene::CreatePipelines(VkExtent2D swapChainExtent, VkRenderPass renderPass) noexcept
 {
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState{};
@@ -545,6 +950,73 @@ bool DemoScene::CreatePipelines(VkExtent2D swapChainExtent, VkRenderPass renderP
 		return false;
 	}
 
+	// Instanced pipeline, same state as the solid one with a vertex shader
+	// that fetches the model matrix from the instance storage buffer. The
+	// indirect mode uses it as well, gl_InstanceIndex includes firstInstance.
+	if (m_RenderMode != RenderMode::PER_DRAW) {
+		VulkanShader* instancedVertexShader{ G_ResourceManager.Get<VulkanShader>("sdr/instanced.vert.spv") };
+
+		if (!instancedVertexShader) {
+			ERROR_LOG("Failed to load instanced vertex shader.");
+			return false;
+		}
+
+		rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
+		shaderStages[0].module = *instancedVertexShader;
+
+		result = vkCreateGraphicsPipelines(G_VulkanDevice,
+		                                   m_PipelineCache,
+		                                   1,
+		                                   &pipelineCreateInfo,
+		                                   nullptr,
+		                                   &m_Pipelines.instanced);
+
+		if (result != VK_SUCCESS) {
+			ERROR_LOG("Failed to create instanced pipeline.");
+			return false;
+		}
+	}
+
+	// Object data pipeline, same state as the solid one with shaders that read
+	// the world matrix and the colours from the object data buffer.
+	if (m_ObjectDataMode != ObjectDataMode::PUSH_CONSTANTS) {
+		VulkanShader* objectVertexShader{
+			G_ResourceManager.Get<VulkanShader>(m_ObjectDataMode == ObjectDataMode::SSBO_INDEX
+				                                    ? "sdr/object_ssbo.vert.spv"
+				                                    : "sdr/object_ubo.vert.spv")
+		};
+
+		if (!objectVertexShader) {
+			ERROR_LOG("Failed to load object data vertex shader.");
+			return false;
+		}
+
+		VulkanShader* objectFragmentShader{ G_ResourceManager.Get<VulkanShader>("sdr/object_data.frag.spv") };
+
+		if (!objectFragmentShader) {
+			ERROR_LOG("Failed to load object data fragment shader.");
+			return false;
+		}
+
+		rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
+		shaderStages[0].module = *objectVertexShader;
+		shaderStages[1].module = *objectFragmentShader;
+
+		pipelineCreateInfo.layout = m_ObjectDataPipelineLayout;
+
+		result = vkCreateGraphicsPipelines(G_VulkanDevice,
+		                                   m_PipelineCache,
+		                                   1,
+		                                   &pipelineCreateInfo,
+		                                   nullptr,
+		                                   &m_Pipelines.objectData);
+
+		if (result != VK_SUCCESS) {
+			ERROR_LOG("Failed to create object data pipeline.");
+			return false;
+		}
+	}
+
 	return true;
 }
 
@@ -623,7 +1095,7 @@ bool DemoScene::InitializeImGui(const VkRenderPass renderPass) noexcept
 	vkEndCommandBuffer(commandBuffer);
 
 	if (!G_VulkanDevice.SubmitCommandBuffer(commandBuffer,
-	                                        G_VulkanDevice.GetQueue(QueueFamily::TRANSFER),
+	                                        G_VulkanDevice.GetQueue(QueueFamily::GRAPHICS),
 	                                        fence)) {
 		ERROR_LOG("Failed to submit command buffer for Font uploading.");
 		return false;
@@ -713,7 +1185,20 @@ void DemoScene::DrawUi(const VkCommandBuffer commandBuffer) const noexcept
 
 		ImGui::NewLine();
 		ImGui::Text("Total Vertex Count: %d", m_Entities.size() * 24);
-		ImGui::Text("Draw calls: %u", m_Entities.size());
+		ImGui::Text("Render mode: %s", GetRenderModeName());
+		ImGui::Text("Draw calls: %zu", GetDrawCallCount());
+		ImGui::Text("Descriptor mode: %s", GetDescriptorModeName());
+		ImGui::Text("Material sets per frame: %u", m_DescriptorSetRequests);
+		ImGui::Text("Object data: %s (%llu byte stride)", GetObjectDataModeName(),
+		            static_cast<unsigned long long>(m_ObjectDataStride));
+		ImGui::Text("Descriptor pools: %zu", m_DescriptorAllocator.GetPoolCount());
+
+		if (m_DescriptorMode == DescriptorMode::CACHED) {
+			ImGui::Text("Cached sets: %zu (%zu hits, %zu misses)", m_DescriptorSetCache.GetSetCount(),
+			            m_DescriptorSetCache.GetHitCount(), m_DescriptorSetCache.GetMissCount());
+		}
+
+		ImGui::Text("Spawn time: %f ms", application.spawnTime);
 		ImGui::Text("Running time: %f s", application.GetTimer().GetSec());
 		ImGui::Text("Frame count: %lld", application.frameCount);
 		ImGui::End();
@@ -790,13 +1275,19 @@ void DemoScene::DrawUi(const VkCommandBuffer commandBuffer) const noexcept
 		ImGui::NewLine();
 
 		ImGui::Text("Total Vertex Count: %d", m_Entities.size() * 24);
-		ImGui::Text("Draw calls: %u", m_Entities.size());
+		ImGui::Text("Render mode: %s", GetRenderModeName());
+		ImGui::Text("Draw calls: %zu", GetDrawCallCount());
+		ImGui::Text("Descriptor mode: %s", GetDescriptorModeName());
+		ImGui::Text("Descriptor pools: %zu", m_DescriptorAllocator.GetPoolCount());
+		ImGui::Text("Object data: %s", GetObjectDataModeName());
 		ImGui::Text("Total Frames: %lld", application.frameCount);
 		ImGui::Text("Total duration: %f s", application.totalAppDuration);
+		ImGui::Text("Startup time: %f ms", application.startupTime);
 		ImGui::Text("Average FPS: %f", 1000.0f / application.avgTotalFrameTime);
 		ImGui::Text("Average frame time: %f ms", application.avgTotalFrameTime);
 		ImGui::Text("Average CPU time: %f ms", application.avgTotalCpuTime);
 		ImGui::Text("Average GPU time: %f ms", application.avgTotalGpuTime);
+		ImGui::Text("Average record time: %f ms", application.avgTotalRecordTime);
 		ImGui::Text("99th percentile (lower is better): %f ms", application.percentile99th);
 
 		ImGui::NewLine();
@@ -829,6 +1320,7 @@ DemoScene::~DemoScene()
 	//Just destroy the descriptor set layout and the descriptor pool.
 	vkDestroyDescriptorSetLayout(device, m_DescriptorSetLayouts.sceneMatrices, nullptr);
 	vkDestroyDescriptorSetLayout(device, m_DescriptorSetLayouts.material, nullptr);
+	vkDestroyDescriptorSetLayout(device, m_DescriptorSetLayouts.objectData, nullptr);
 
 	vkDestroyDescriptorPool(device, m_DescriptorPool, nullptr);
 	vkDestroyDescriptorPool(device, m_ImGUIDescriptorPool, nullptr);
@@ -837,8 +1329,20 @@ DemoScene::~DemoScene()
 
 	vkDestroyPipeline(device, m_Pipelines.wireframe, nullptr);
 
+	vkDestroyPipeline(device, m_Pipelines.instanced, nullptr);
+
+	vkDestroyPipeline(device, m_Pipelines.objectData, nullptr);
+
+	for (auto& frame : m_Frames) {
+		frame.instanceXformsSsbo.Unmap();
+		frame.indirectCommands.Unmap();
+		frame.objectDataBuffer.Unmap();
+	}
+
 	vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
 
+	vkDestroyPipelineLayout(device, m_ObjectDataPipelineLayout, nullptr);
+
 	ImGui_ImplGlfwVulkan_Shutdown();
 }
 
@@ -848,12 +1352,77 @@ bool DemoScene::Initialize(const VkExtent2D swapChainExtent, const VkRenderPass
 	const auto seed = high_resolution_clock::now().time_since_epoch().count();
 	s_Rng = std::mt19937(seed);
 
+	ConfigFile cfg{ "config/config.cfg" };
+
+	if (!cfg.IsOpen()) {
+		ERROR_LOG("Failed to open configuration file");
+		return false;
+	}
+
+	const std::string renderMode{ cfg.GetString("attributes.render_mode", "per_draw") };
+
+	if (renderMode == "instanced") {
+		m_RenderMode = RenderMode::INSTANCED;
+	}
+	else if (renderMode == "indirect") {
+		m_RenderMode = RenderMode::INDIRECT;
+	}
+	else if (renderMode != "per_draw") {
+		ERROR_LOG("Unknown render mode: " + renderMode + ", falling back to per_draw.");
+	}
+
+	const std::string descriptorMode{ cfg.GetString("attributes.descriptor_mode", "static") };
+
+	if (descriptorMode == "transient") {
+		m_DescriptorMode = DescriptorMode::TRANSIENT;
+	}
+	else if (descriptorMode == "cached") {
+		m_DescriptorMode = DescriptorMode::CACHED;
+	}
+	else if (descriptorMode != "static") {
+		ERROR_LOG("Unknown descriptor mode: " + descriptorMode + ", falling back to static.");
+	}
+
+	const std::string objectDataMode{ cfg.GetString("attributes.object_data", "push_constants") };
+
+	if (objectDataMode == "dynamic_ubo") {
+		m_ObjectDataMode = ObjectDataMode::DYNAMIC_UBO;
+	}
+	else if (objectDataMode == "ssbo_index") {
+		m_ObjectDataMode = ObjectDataMode::SSBO_INDEX;
+	}
+	else if (objectDataMode != "push_constants") {
+		ERROR_LOG("Unknown object data mode: " + objectDataMode + ", falling back to push_constants.");
+	}
+
+	// The instanced and indirect modes bind the material once, there is nothing to stress.
+	if (m_RenderMode != RenderMode::PER_DRAW && m_DescriptorMode != DescriptorMode::STATIC) {
+		LOG("The descriptor mode only applies to the per_draw render mode, using static.");
+		m_DescriptorMode = DescriptorMode::STATIC;
+	}
+
+	// They also have their own instance storage buffer for the world matrices.
+	if (m_RenderMode != RenderMode::PER_DRAW && m_ObjectDataMode != ObjectDataMode::PUSH_CONSTANTS) {
+		LOG("The object data mode only applies to the per_draw render mode, using push_constants.");
+		m_ObjectDataMode = ObjectDataMode::PUSH_CONSTANTS;
+	}
+
+	// The indirect commands select the world matrix of each cube through firstInstance.
+	if (m_RenderMode == RenderMode::INDIRECT && !G_VulkanDevice.GetEnabledFeatures().drawIndirectFirstInstance) {
+		ERROR_LOG("The indirect render mode requires the drawIndirectFirstInstance feature.");
+		return false;
+	}
+
+	if (!m_ThreadPool.Initialize()) {
+		return false;
+	}
+
 	if (!GenerateCube(&m_CubeMesh, 1.0f)) {
 		ERROR_LOG("Failed to generate cube mesh.");
 		return false;
 	}
 
-	if (!m_PipelineCache.Create()) {
+	if (!m_PipelineCache.Create("DrawCallCount")) {
 		return false;
 	}
 
@@ -881,6 +1450,11 @@ bool DemoScene::Initialize(const VkExtent2D swapChainExtent, const VkRenderPass
 		return false;
 	}
 
+	if (m_ObjectDataMode != ObjectDataMode::PUSH_CONSTANTS && !PrepareObjectData()) {
+		ERROR_LOG("Failed to prepare the object data.");
+		return false;
+	}
+
 	if (!CreatePipelines(swapChainExtent, renderPass)) {
 		ERROR_LOG("Failed to create scene's pipelines.");
 		return false;
@@ -905,6 +1479,9 @@ static f64 entitiesToSpawn{ 0.0f };
 
 void DemoScene::Update(VkExtent2D swapChainExtent, i64 msec, f64 dt) noexcept
 {
+	// The tasks of this frame are stored apart from the ones of the last frame.
+	m_ThreadPool.BeginEpoch();
+
 	if (!G_Application.benchmarkComplete) {
 		entitiesToSpawn += spawnRate * dt;
 
@@ -912,59 +1489,169 @@ void DemoScene::Update(VkExtent2D swapChainExtent, i64 msec, f64 dt) noexcept
 
 		entitiesToSpawn -= e;
 
-		int i = 0;
-		while (i < e) {
-			SpawnEntity();
-			++i;
-		}
+		Timer spawnTimer;
+		spawnTimer.Start();
 
-		for (auto& entity : m_Entities) {
-			entity->Update(dt);
-		}
+		SpawnEntities(e);
+
+		spawnTimer.Stop();
+
+		// Sampled by the application together with the frame time.
+		G_Application.spawnTime = spawnTimer.GetSec() * 1000.0;
+
+		// Only the transforms that changed since the last frame are recomputed.
+		m_Transforms.Update(m_ThreadPool);
 	}
 }
 
-void DemoScene::Draw(VkCommandBuffer commandBuffer) noexcept
+void DemoScene::Draw(VkCommandBuffer commandBuffer, const ui32 frameIndex) noexcept
 {
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipelines.solid);
+	auto& frame = m_Frames[frameIndex];
+
+	if (m_RenderMode != RenderMode::PER_DRAW) {
+		if (!m_Entities.empty() && UploadInstanceData(frame)) {
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipelines.instanced);
+
+			// Every cube shares the mesh and the material, so the state is bound once for all of them.
+			std::array<VkDescriptorSet, 2> descriptorSets{
+				frame.sceneMatricesDescriptorSet,
+				m_Material.descriptorSet
+			};
+
+			vkCmdBindDescriptorSets(commandBuffer,
+			                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+			                        m_PipelineLayout,
+			                        0,
+			                        static_cast<ui32>(descriptorSets.size()),
+			                        descriptorSets.data(),
+			                        0,
+			                        nullptr);
+
+			std::array<Vec4f, 2> materialProperties{ m_Material.diffuse, m_Material.specular };
+
+			vkCmdPushConstants(commandBuffer,
+			                   m_PipelineLayout,
+			                   VK_SHADER_STAGE_FRAGMENT_BIT,
+			                   sizeof(Mat4f),
+			                   2 * sizeof(Vec4f),
+			                   materialProperties.data());
+
+			if (m_RenderMode == RenderMode::INDIRECT) {
+				m_CubeMesh.DrawIndirect(commandBuffer,
+				                        frame.indirectCommands.buffer,
+				                        0,
+				                        static_cast<ui32>(m_Entities.size()));
+			}
+			else {
+				m_CubeMesh.Draw(commandBuffer, static_cast<ui32>(m_Entities.size()));
+			}
+		}
 
-	for (const auto& entity : m_Entities) {
+		DrawUi(commandBuffer);
 
-		auto& material = entity->GetMaterial();
+		return;
+	}
 
-		std::vector<VkDescriptorSet> descriptorSets{
-			m_SceneMatricesDescriptorSet,
-			material.descriptorSet
-		};
+	// PreDraw has waited on the fence of this frame, so the GPU is done with its transient sets.
+	if (m_DescriptorMode == DescriptorMode::TRANSIENT && !m_DescriptorAllocator.ResetFrame(frameIndex)) {
+		DrawUi(commandBuffer);
+
+		return;
+	}
+
+	m_DescriptorSetRequests = 0;
+
+	if (m_ObjectDataMode != ObjectDataMode::PUSH_CONSTANTS && !UploadObjectData(frame)) {
+		DrawUi(commandBuffer);
+
+		return;
+	}
 
+	const auto usePushConstants = m_ObjectDataMode == ObjectDataMode::PUSH_CONSTANTS;
+
+	const auto pipelineLayout = usePushConstants ? m_PipelineLayout : m_ObjectDataPipelineLayout;
+
+	vkCmdBindPipeline(commandBuffer,
+	                  VK_PIPELINE_BIND_POINT_GRAPHICS,
+	                  usePushConstants ? m_Pipelines.solid : m_Pipelines.objectData);
+
+	// The storage buffer holds every cube, so it is bound once and the draws only select their element.
+	if (m_ObjectDataMode == ObjectDataMode::SSBO_INDEX) {
 		vkCmdBindDescriptorSets(commandBuffer,
 		                        VK_PIPELINE_BIND_POINT_GRAPHICS,
-		                        m_PipelineLayout,
-		                        0,
-		                        static_cast<ui32>(descriptorSets.size()),
-		                        descriptorSets.data(),
+		                        pipelineLayout,
+		                        2,
+		                        1,
+		                        &frame.objectDataDescriptorSet,
 		                        0,
 		                        nullptr);
+	}
+
+	// The dynamic uniform buffer is bound along with the other sets of each draw.
+	const auto setCount = m_ObjectDataMode == ObjectDataMode::DYNAMIC_UBO ? 3u : 2u;
+
+	const auto dynamicOffsetCount = m_ObjectDataMode == ObjectDataMode::DYNAMIC_UBO ? 1u : 0u;
+
+	for (auto i = 0u; i < m_Entities.size(); ++i) {
+		const auto& entity = m_Entities[i];
+
+		auto& material = entity->GetMaterial();
 
-		const auto& xform = entity->GetXform();
+		const auto materialDescriptorSet = GetMaterialDescriptorSet(material, frameIndex);
 
-		vkCmdPushConstants(commandBuffer,
-		                   m_PipelineLayout,
-		                   VK_SHADER_STAGE_VERTEX_BIT,
-		                   0,
-		                   sizeof(Mat4f),
-		                   &xform);
+		if (!materialDescriptorSet) {
+			break;
+		}
 
-		std::array<Vec4f, 2> materialProperties{ material.diffuse, material.specular };
+		++m_DescriptorSetRequests;
+
+		std::array<VkDescriptorSet, 3> descriptorSets{
+			frame.sceneMatricesDescriptorSet,
+			materialDescriptorSet,
+			frame.objectDataDescriptorSet
+		};
 
-		vkCmdPushConstants(commandBuffer,
-		                   m_PipelineLayout,
-		                   VK_SHADER_STAGE_FRAGMENT_BIT,
-		                   sizeof(Mat4f),
-		                   2 * sizeof(Vec4f),
-		                   materialProperties.data());
+		const auto dynamicOffset = static_cast<ui32>(i * m_ObjectDataStride);
 
-		entity->Draw(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer,
+		                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+		                        pipelineLayout,
+		                        0,
+		                        setCount,
+		                        descriptorSets.data(),
+		                        dynamicOffsetCount,
+		                        &dynamicOffset);
+
+		switch (m_ObjectDataMode) {
+		case ObjectDataMode::DYNAMIC_UBO:
+			entity->Draw(commandBuffer);
+			break;
+		case ObjectDataMode::SSBO_INDEX:
+			// gl_InstanceIndex starts at firstInstance, which selects the cube's element.
+			entity->Draw(commandBuffer, i);
+			break;
+		default: {
+			const auto& xform = m_Transforms.GetXform(entity->GetTransform());
+
+			vkCmdPushConstants(commandBuffer,
+			                   m_PipelineLayout,
+			                   VK_SHADER_STAGE_VERTEX_BIT,
+			                   0,
+			                   sizeof(Mat4f),
+			                   &xform);
+
+			std::array<Vec4f, 2> materialProperties{ material.diffuse, material.specular };
+
+			vkCmdPushConstants(commandBuffer,
+			                   m_PipelineLayout,
+			                   VK_SHADER_STAGE_FRAGMENT_BIT,
+			                   sizeof(Mat4f),
+			                   2 * sizeof(Vec4f),
+			                   materialProperties.data());
+
+			entity->Draw(commandBuffer);
+		}
+		}
 	}
 
 	DrawUi(commandBuffer);
@@ -975,10 +1662,12 @@ void DemoScene::SaveToCsv(const std::string& fname) const
 	const auto& app = G_Application;
 	std::ofstream stream{ fname + ".csv" };
 
-	stream << "Whole Frame Time,CPU Time,GPU Time\n";
+	stream << "Whole Frame Time,CPU Time,GPU Time,Update Time,Record Time,Spawn Time\n";
 
 	for (auto i = 0u; i < app.totalFrameTimeSamples.size(); ++i) {
-		stream << app.totalFrameTimeSamples[i] << "," << app.totalCpuTimeSamples[i] << "," << app.totalGpuTimeSamples[i] << "\n";
+		stream << app.totalFrameTimeSamples[i] << "," << app.totalCpuTimeSamples[i] << "," << app.totalGpuTimeSamples[i] << ","
+				<< app.totalUpdateTimeSamples[i] << "," << app.totalRecordTimeSamples[i] << ","
+				<< app.totalSpawnTimeSamples[i] << "\n";
 	}
 
 	stream << "\nFPS,Whole Frame Time,CPU Time,GPU Time\n";
@@ -988,14 +1677,40 @@ void DemoScene::SaveToCsv(const std::string& fname) const
 				"\n";
 	}
 
-	stream << "\nAverage FPS,Average Frame Time,Average CPU Time,Average GPU Time\n";
-	stream << 1000.0f / app.avgTotalFrameTime << "," << app.avgTotalFrameTime << "," << app.avgTotalCpuTime << "," << app.avgTotalGpuTime;
+	stream << "\nAverage FPS,Average Frame Time,Average CPU Time,Average GPU Time,Average Update Time,Average Record Time\n";
+	stream << 1000.0f / app.avgTotalFrameTime << "," << app.avgTotalFrameTime << "," << app.avgTotalCpuTime << "," << app.avgTotalGpuTime << ","
+			<< app.avgTotalUpdateTime << "," << app.avgTotalRecordTime;
 
-	stream << "\nDraw Calls per Frame\n";
-	stream << m_Entities.size();
+	auto avgSpawnTime{ 0.0f };
+
+	for (const auto spawnTime : app.totalSpawnTimeSamples) {
+		avgSpawnTime += spawnTime;
+	}
+
+	if (!app.totalSpawnTimeSamples.empty()) {
+		avgSpawnTime /= static_cast<f32>(app.totalSpawnTimeSamples.size());
+	}
+
+	stream << "\nAverage Spawn Time\n";
+	stream << avgSpawnTime;
+
+	stream << "\nRender Mode\n";
+	stream << GetRenderModeName();
+
+	stream << "\nDescriptor Mode,Descriptor Pools\n";
+	stream << GetDescriptorModeName() << "," << m_DescriptorAllocator.GetPoolCount();
+
+	stream << "\nObject Data Mode\n";
+	stream << GetObjectDataModeName();
+
+	stream << "\nCubes per Frame,Draw Calls per Frame\n";
+	stream << m_Entities.size() << "," << GetDrawCallCount();
 
 	stream << "\n99th percentile\n";
 	stream << app.percentile99th;
 
+	stream << "\nStartup Time\n";
+	stream << app.startupTime;
+
 	stream.close();
 }
@@ -1,19 +1,94 @@
 #ifndef DISSERTATION_DEMO_SCENE_H
 #define DISSERTATION_DEMO_SCENE_H
 
+#include <array>
 #include <memory>
 #include <vulkan_pipeline_cache.h>
+#include <vulkan_descriptor_allocator.h>
+#include <vulkan_descriptor_set_cache.h>
 #include "demo_entity.h"
+#include "thread_pool.h"
+#include "vulkan_application.h"
 
 struct UniformBufferObject final {
 	Mat4f view;
 	Mat4f projection;
 };
 
+/**
+ * \brief How the cubes are submitted, selected with attributes.render_mode in config.cfg.
+ */
+enum class RenderMode {
+	// One descriptor set bind, two push constants and one draw per cube.
+	PER_DRAW,
+	// The world matrices go to a storage buffer and all the cubes are drawn with one instanced draw.
+	INSTANCED,
+	// Same storage buffer, plus one CPU written indirect command per cube submitted with multi draw indirect.
+	INDIRECT
+};
+
+/**
+ * \brief Where the per draw material sets come from, selected with attributes.descriptor_mode in config.cfg.
+ */
+enum class DescriptorMode {
+	// The material set allocated and written at startup is bound for every cube.
+	STATIC,
+	// Every cube gets a set allocated from the per frame pools and written while recording.
+	TRANSIENT,
+	// Every cube looks its set up in the descriptor set cache, identical bindings share one set.
+	CACHED
+};
+
+/**
+ * \brief Per cube data of the object data modes, the same 96 bytes the push constants carry.
+ */
+struct ObjectData final {
+	Mat4f model;
+	Vec4f diffuse;
+	Vec4f specular;
+};
+
+/**
+ * \brief How the world matrix and material colours of a cube reach the shaders, selected with attributes.object_data in config.cfg.
+ */
+enum class ObjectDataMode {
+	// Two vkCmdPushConstants calls per cube.
+	PUSH_CONSTANTS,
+	// The data of every cube is written to a uniform buffer once per frame, each draw binds its element with a dynamic offset.
+	DYNAMIC_UBO,
+	// The same data in a storage buffer bound once per frame, each draw selects its element with firstInstance.
+	SSBO_INDEX
+};
+
 class DemoScene final {
 private:
 	std::vector<std::unique_ptr<DemoEntity>> m_Entities;
 
+	TransformStore m_Transforms;
+
+	ThreadPool m_ThreadPool;
+
+	RenderMode m_RenderMode{ RenderMode::PER_DRAW };
+
+	DescriptorMode m_DescriptorMode{ DescriptorMode::STATIC };
+
+	ObjectDataMode m_ObjectDataMode{ ObjectDataMode::PUSH_CONSTANTS };
+
+	/**
+	 * \brief Distance between the elements of the object data buffers. Dynamic uniform
+	 * buffer offsets have to be multiples of minUniformBufferOffsetAlignment.
+	 */
+	VkDeviceSize m_ObjectDataStride{ sizeof(ObjectData) };
+
+	VulkanDescriptorAllocator m_DescriptorAllocator;
+
+	VulkanDescriptorSetCache m_DescriptorSetCache;
+
+	/**
+	 * \brief Material sets allocated or looked up while recording the last frame.
+	 */
+	ui32 m_DescriptorSetRequests{ 0 };
+
 	VkDescriptorPool m_DescriptorPool{ VK_NULL_HANDLE };
 
 	VkDescriptorPool m_ImGUIDescriptorPool{ VK_NULL_HANDLE };
@@ -21,21 +96,51 @@ private:
 	struct {
 		VkDescriptorSetLayout sceneMatrices{ VK_NULL_HANDLE };
 		VkDescriptorSetLayout material{ VK_NULL_HANDLE };
+		VkDescriptorSetLayout objectData{ VK_NULL_HANDLE };
 	} m_DescriptorSetLayouts;
 
-	VkDescriptorSet m_SceneMatricesDescriptorSet{ VK_NULL_HANDLE };
-
 	VulkanBuffer m_MatricesUbo;
 
+	/**
+	 * \brief The instance data written while recording a frame. There is one per frame in flight,
+	 * indexed by VulkanApplication::GetCurrentFrameIndex, so a frame never overwrites what
+	 * the GPU is still reading for the previous ones.
+	 */
+	struct FrameData {
+		VkDescriptorSet sceneMatricesDescriptorSet{ VK_NULL_HANDLE };
+
+		// World matrices of the entities in draw order, read by the instanced pipeline.
+		VulkanBuffer instanceXformsSsbo;
+
+		// One VkDrawIndexedIndirectCommand per entity, rewritten every frame in indirect mode.
+		VulkanBuffer indirectCommands;
+
+		size_t instanceCapacity{ 0 };
+
+		VkDescriptorSet objectDataDescriptorSet{ VK_NULL_HANDLE };
+
+		// One ObjectData per entity in draw order, every m_ObjectDataStride bytes.
+		VulkanBuffer objectDataBuffer;
+
+		size_t objectDataCapacity{ 0 };
+	};
+
+	std::array<FrameData, VulkanApplication::MAX_FRAMES_IN_FLIGHT> m_Frames;
+
 	struct {
 		VkPipeline solid{ VK_NULL_HANDLE };
 		VkPipeline wireframe{ VK_NULL_HANDLE };
+		VkPipeline instanced{ VK_NULL_HANDLE };
+		VkPipeline objectData{ VK_NULL_HANDLE };
 	} m_Pipelines;
 
 	VulkanPipelineCache m_PipelineCache;
 
 	VkPipelineLayout m_PipelineLayout{ VK_NULL_HANDLE };
 
+	// Scene matrices, material and object data sets, without push constants.
+	VkPipelineLayout m_ObjectDataPipelineLayout{ VK_NULL_HANDLE };
+
 	// All textures will be sampled with a single sampler.
 	VkSampler m_TextureSampler{ VK_NULL_HANDLE };
 
@@ -43,12 +148,56 @@ private:
 
 	DemoMaterial m_Material;
 
-	bool SpawnEntity() noexcept;
+	/**
+	 * \brief Spawns count entities at random positions.
+	 * \details The new entities are sorted on their own and merged into
+	 * m_Entities, which is kept sorted from back to front.
+	 */
+	bool SpawnEntities(size_t count) noexcept;
 
 	bool CreateTextureSampler() noexcept;
 
+	/**
+	 * \brief Grows the instance storage buffer, and the indirect command buffer, of the frame so that they fit count entities.
+	 */
+	bool ReserveInstanceData(FrameData& frame, size_t count) noexcept;
+
+	/**
+	 * \brief Copies the world matrices of the entities, in draw order, to the instance storage buffer
+	 * of the frame and writes their indirect commands.
+	 */
+	bool UploadInstanceData(FrameData& frame) noexcept;
+
+	/**
+	 * \brief Grows the object data buffer of the frame so that it fits count entities.
+	 */
+	bool ReserveObjectData(FrameData& frame, size_t count) noexcept;
+
+	/**
+	 * \brief Writes the object data of the entities, in draw order, to the object data buffer of the frame.
+	 */
+	bool UploadObjectData(FrameData& frame) noexcept;
+
+	const char* GetRenderModeName() const noexcept;
+
+	const char* GetDescriptorModeName() const noexcept;
+
+	const char* GetObjectDataModeName() const noexcept;
+
+	/**
+	 * \brief Returns the set to bind for a draw with the material, according to m_DescriptorMode.
+	 */
+	VkDescriptorSet GetMaterialDescriptorSet(DemoMaterial& material, ui32 frameIndex) noexcept;
+
+	size_t GetDrawCallCount() const noexcept;
+
 	bool PrepareUniforms() noexcept;
 
+	/**
+	 * \brief Creates the object data set layout, pipeline layout and per frame sets and buffers.
+	 */
+	bool PrepareObjectData() noexcept;
+
 	bool CreatePipelines(VkExtent2D swapChainExtent, VkRenderPass renderPass) noexcept;
 
 	bool InitializeImGui(const VkRenderPass renderPass) noexcept;
@@ -62,7 +211,7 @@ public:
 
 	void Update(VkExtent2D swapChainExtent, i64 msec, f64 dt) noexcept;
 
-	void Draw(VkCommandBuffer commandBuffer) noexcept;
+	void Draw(VkCommandBuffer commandBuffer, ui32 frameIndex) noexcept;
 
 	void SaveToCsv(const std::string& fname) const;
 };
@@ -14,6 +14,14 @@ void DemoApplication::EnableFeatures() noexcept
 	if (physicalDevice.features.fillModeNonSolid) {
 		featuresToEnable.fillModeNonSolid = VK_TRUE;
 	}
+
+	if (physicalDevice.features.multiDrawIndirect) {
+		featuresToEnable.multiDrawIndirect = VK_TRUE;
+	}
+
+	if (physicalDevice.features.drawIndirectFirstInstance) {
+		featuresToEnable.drawIndirectFirstInstance = VK_TRUE;
+	}
 }
 
 bool DemoApplication::BuildCommandBuffers() noexcept
@@ -21,7 +29,7 @@ bool DemoApplication::BuildCommandBuffers() noexcept
 	return true;
 }
 
-bool DemoApplication::BuildDeferredPassCommandBuffer()
+bool DemoApplication::BuildDeferredPassCommandBuffer(const ui32 frameIndex)
 {
 	std::array<VkClearValue, 5> clearValues{};
 	for (auto i = 0; i < clearValues.size(); ++i) {
@@ -46,18 +54,21 @@ bool DemoApplication::BuildDeferredPassCommandBuffer()
 	VkCommandBufferBeginInfo commandBufferBeginInfo{};
 	commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
-	VkResult result{ vkBeginCommandBuffer(m_DeferredCommandBuffer, &commandBufferBeginInfo) };
+	const auto commandBuffer = m_DeferredCommandBuffers[frameIndex];
+	const VkQueryPool queryPool{ deferredQueryPools[frameIndex] };
+
+	VkResult result{ vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo) };
 
 	if (result != VK_SUCCESS) {
 		ERROR_LOG("Failed to begin command buffer.");
 		return false;
 	}
 
-	vkCmdResetQueryPool(m_DeferredCommandBuffer, deferredQueryPool, 0, 2);
-	vkCmdWriteTimestamp(m_DeferredCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, deferredQueryPool, 0);
+	vkCmdResetQueryPool(commandBuffer, queryPool, 0, 2);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0);
 
 
-	vkCmdBeginRenderPass(m_DeferredCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 	VkViewport viewport{};
 	viewport.x = 0;
@@ -67,22 +78,22 @@ bool DemoApplication::BuildDeferredPassCommandBuffer()
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
 
-	vkCmdSetViewport(m_DeferredCommandBuffer, 0, 1, &viewport);
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
 	VkRect2D scissor{};
 	scissor.extent = renderPassBeginInfo.renderArea.extent;
 	scissor.offset.x = 0;
 	scissor.offset.y = 0;
 
-	vkCmdSetScissor(m_DeferredCommandBuffer, 0, 1, &scissor);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-	m_DemoScene.Draw(m_DeferredCommandBuffer);
+	m_DemoScene.Draw(commandBuffer, frameIndex);
 
-	vkCmdEndRenderPass(m_DeferredCommandBuffer);
+	vkCmdEndRenderPass(commandBuffer);
 
-	vkCmdWriteTimestamp(m_DeferredCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, deferredQueryPool, 1);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 1);
 
-	result = vkEndCommandBuffer(m_DeferredCommandBuffer);
+	result = vkEndCommandBuffer(commandBuffer);
 
 	if (result != VK_SUCCESS) {
 		ERROR_LOG("Failed to end command buffer.");
@@ -114,52 +125,50 @@ bool DemoApplication::BuildDisplayCommandBuffer()
 	renderPassBeginInfo.pClearValues = clearValues;
 
 
-	const auto& commandBuffers = GetCommandBuffers();
-	for (auto i = 0; i < commandBuffers.size(); ++i) {
+	// Only the command buffer of the acquired image is re-recorded, the others may still be in flight.
+	const auto imageIndex = GetCurrentBufferIndex();
+	const auto commandBuffer = GetCommandBuffers()[imageIndex];
+	renderPassBeginInfo.framebuffer = GetFramebuffers()[imageIndex];
 
-		const auto commandBuffer = commandBuffers[i];
-		renderPassBeginInfo.framebuffer = GetFramebuffers()[i];
+	VkResult result = vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
 
-		VkResult result = vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
-
-		if (result != VK_SUCCESS) {
-			ERROR_LOG("Failed to begin command buffer.");
-			return false;
-		}
+	if (result != VK_SUCCESS) {
+		ERROR_LOG("Failed to begin command buffer.");
+		return false;
+	}
 
-		vkCmdResetQueryPool(commandBuffer, queryPools[i], 0, 2);
+	vkCmdResetQueryPool(commandBuffer, queryPools[imageIndex], 0, 2);
 
-		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPools[i], 0);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPools[imageIndex], 0);
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-		VkViewport viewport{};
-		viewport.x = 0;
-		viewport.y = 0;
-		viewport.width = swapChainExtent.width;
-		viewport.height = swapChainExtent.height;
+	VkViewport viewport{};
+	viewport.x = 0;
+	viewport.y = 0;
+	viewport.width = swapChainExtent.width;
+	viewport.height = swapChainExtent.height;
 
-		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
-		VkRect2D scissor{};
-		scissor.extent = renderPassBeginInfo.renderArea.extent;
-		scissor.offset.x = 0;
-		scissor.offset.y = 0;
+	VkRect2D scissor{};
+	scissor.extent = renderPassBeginInfo.renderArea.extent;
+	scissor.offset.x = 0;
+	scissor.offset.y = 0;
 
-		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-		m_DemoScene.DrawFullscreenQuad(commandBuffer);
+	m_DemoScene.DrawFullscreenQuad(commandBuffer, GetCurrentFrameIndex());
 
-		vkCmdEndRenderPass(commandBuffer);
+	vkCmdEndRenderPass(commandBuffer);
 
-		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPools[i], 1);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPools[imageIndex], 1);
 
-		result = vkEndCommandBuffer(commandBuffer);
+	result = vkEndCommandBuffer(commandBuffer);
 
-		if (result != VK_SUCCESS) {
-			ERROR_LOG("Failed to end command buffer.");
-			return false;
-		}
+	if (result != VK_SUCCESS) {
+		ERROR_LOG("Failed to end command buffer.");
+		return false;
 	}
 
 	return true;
@@ -175,8 +184,6 @@ DemoApplication::DemoApplication(const ApplicationSettings& settings)
 DemoApplication::~DemoApplication() noexcept
 {
 	vkDeviceWaitIdle(G_VulkanDevice);
-
-    vkDestroyFence(G_VulkanDevice, m_Fence, nullptr);
 }
 
 
@@ -191,25 +198,20 @@ bool DemoApplication::Initialize() noexcept
 		return false;
 	}
 
-	m_DeferredCommandBuffer = G_VulkanDevice.CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+	m_DeferredCommandBuffers = G_VulkanDevice.CreateCommandBuffers(GetFramesInFlight(),
+	                                                               G_VulkanDevice.GetCommandPool(),
+	                                                               VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 
 	if (!m_DeferredSemaphore.Create()) {
 		ERROR_LOG("Failed to create semaphore for the deferred render pass.");
 		return false;
 	}
 
-	if (!BuildDeferredPassCommandBuffer()) {
-		ERROR_LOG("Failed to build deferred command buffer.");
-		return false;
-	}
-
-	VkFenceCreateInfo fenceCreateInfo{};
-	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-
-
-	if (vkCreateFence(G_VulkanDevice, &fenceCreateInfo, nullptr, &m_Fence) != VK_SUCCESS) {
-		ERROR_LOG("Failed to create fence");
-		return false;
+	for (auto i = 0u; i < m_DeferredCommandBuffers.size(); ++i) {
+		if (!BuildDeferredPassCommandBuffer(i)) {
+			ERROR_LOG("Failed to build deferred command buffer.");
+			return false;
+		}
 	}
 
 	return true;
@@ -226,6 +228,14 @@ void DemoApplication::Draw() noexcept
 {
 	PreDraw();
 
+	m_DemoScene.UploadFrameData(GetCurrentFrameIndex());
+
+	// The G-Buffer pass binds the material sets, it is recorded again whenever streaming rewrote them.
+	if (m_DemoScene.StreamTextures(GetCurrentFrameIndex()) && !BuildDeferredPassCommandBuffer(GetCurrentFrameIndex())) {
+		ERROR_LOG("Failed to rebuild deferred command buffer.");
+		return;
+	}
+
 	if (!BuildDisplayCommandBuffer()) { // Have to rebuild every frame only due to ImGui
 		ERROR_LOG("Failed to build display command buffer.");
 		return;
@@ -233,7 +243,7 @@ void DemoApplication::Draw() noexcept
 
 	auto& submitInfo = GetSubmitInfo();
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &m_DeferredCommandBuffer;
+	submitInfo.pCommandBuffers = &m_DeferredCommandBuffers[GetCurrentFrameIndex()];
 	submitInfo.pWaitSemaphores = GetPresentCompleteSemaphore().Get();
 	submitInfo.pSignalSemaphores = m_DeferredSemaphore.Get();
 
@@ -258,11 +268,7 @@ void DemoApplication::Draw() noexcept
 	result = vkQueueSubmit(G_VulkanDevice.GetQueue(QueueFamily::GRAPHICS),
 	                       1,
 	                       &submitInfo,
-	                       m_Fence);
-
-	vkWaitForFences(G_VulkanDevice, 1, &m_Fence, VK_TRUE, std::numeric_limits<ui32>::max());
-
-    vkResetFences(G_VulkanDevice, 1, &m_Fence);
+	                       ResetFrameFence());
 
 	if (result != VK_SUCCESS) {
 		ERROR_LOG("Failed to submit the command buffer.");
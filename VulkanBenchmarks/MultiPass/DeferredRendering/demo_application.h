@@ -9,17 +9,18 @@ class DemoApplication final : public VulkanApplication {
 private:
 	DemoScene m_DemoScene;
 
-	VkCommandBuffer m_DeferredCommandBuffer{ VK_NULL_HANDLE };
+	/**
+	 * \brief The G-Buffer pass command buffers, recorded once. One per frame in flight.
+	 */
+	std::vector<VkCommandBuffer> m_DeferredCommandBuffers;
 
 	VulkanSemaphore m_DeferredSemaphore;
 
-	VkFence m_Fence{VK_NULL_HANDLE};
-
 	void EnableFeatures() noexcept override;
 
 	bool BuildCommandBuffers() noexcept override;
 
-	bool BuildDeferredPassCommandBuffer(); // G-Buffer
+	bool BuildDeferredPassCommandBuffer(ui32 frameIndex); // G-Buffer
 
 	bool BuildDisplayCommandBuffer(); // Fullscreen quad
 
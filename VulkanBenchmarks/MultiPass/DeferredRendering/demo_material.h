@@ -2,6 +2,7 @@
 #define DEMO_MATERIAL_H_
 
 #include <vulkan_texture.h>
+#include <vulkan_application.h>
 
 struct DemoMaterial final {
 	std::array<VulkanTexture*, SUPPORTED_TEX_COUNT> textures;
@@ -10,8 +11,9 @@ struct DemoMaterial final {
 	Vec4f diffuse{ 1.0f, 1.0f, 1.0f, 1.0f};
 	Vec4f specular{ 1.0f };
 
-	//Each material has it's own descriptor set.
-	VkDescriptorSet descriptorSet;
+	//Each material has it's own descriptor set per frame in flight, so that the set
+	//of a frame that is not in flight can be rewritten when a streamed texture changes.
+	std::array<VkDescriptorSet, VulkanApplication::MAX_FRAMES_IN_FLIGHT> descriptorSets{};
 };
 
 #endif //DEMO_MATERIAL_H_
@@ -13,6 +13,8 @@
 #include <assimp/cimport.h>
 #include <assimp/postprocess.h>
 #include "imgui_internal.h"
+#include <cfg.h>
+#include <thread_pool.h>
 
 
 // Vulkan clip space has inverted Y and half Z.
@@ -23,9 +25,23 @@ static const Mat4f s_ClipCorrectionMat{
 	0.0f, 0.0f, 0.5f, 1.0f
 };
 
+// How many streamed textures get a level larger per frame at most.
+static constexpr ui32 s_StreamedTexturesPerFrame{ 4 };
+
 // Private functions -------------------------------------------------
 
 //Model loading --------------------------------------
+/**
+ * \brief A model imported with Assimp, and the vertices and indices its view points into.
+ */
+struct ImportedModel {
+	std::vector<std::vector<Vertex>> vertices;
+
+	std::vector<std::vector<ui32>> indices;
+
+	ModelView model;
+};
+
 static Vec3f AssVector(const aiVector3D vec) noexcept
 {
 	return Vec3f{ vec.x, vec.y, vec.z };
@@ -36,138 +52,288 @@ static Quatf AssQuat(const aiQuaternion q) noexcept
 	return Quatf{ q.w, q.x, q.y, q.z };
 }
 
-void DemoScene::LoadMeshes(const aiScene* scene) noexcept
+static std::string GetFileName(const std::string& path) noexcept
 {
-	for (auto i = 0; i < scene->mNumMeshes; ++i) {
-		auto mesh = new VulkanMesh;
+	auto n = path.rfind('/');
+
+	if (n == std::string::npos) {
+		n = path.rfind('\\');
+	}
 
-		auto* aiMesh{ scene->mMeshes[i] };
+	if (n != std::string::npos) {
+		return path.substr(n + 1);
+	}
 
-		if (aiMesh->HasPositions()) {
-			std::vector<Vertex> vertices;
-			vertices.resize(aiMesh->mNumVertices);
+	return "";
+}
 
-			m_SceneVertexCount += aiMesh->mNumVertices;
+static void FlattenNode(const aiNode* aiNode, std::vector<ModelNode>& nodes) noexcept
+{
+	ModelNode node;
+	node.name = aiNode->mName.data;
+	node.meshIndex = aiNode->mNumMeshes > 0 ? static_cast<i32>(aiNode->mMeshes[0]) : -1;
+	node.childCount = aiNode->mNumChildren;
 
-			for (auto j = 0; j < vertices.size(); ++j) {
-				vertices[j].position = Vec3f{ aiMesh->mVertices[j].x, aiMesh->mVertices[j].y, aiMesh->mVertices[j].z };
-				vertices[j].normal = Vec3f{ aiMesh->mNormals[j].x, aiMesh->mNormals[j].y, aiMesh->mNormals[j].z };
-				vertices[j].tangent = Vec3f{ aiMesh->mTangents[j].x, aiMesh->mTangents[j].y, aiMesh->mTangents[j].z };
-				vertices[j].texcoord = Vec2f{ aiMesh->mTextureCoords[0][j].x, aiMesh->mTextureCoords[0][j].y };
-			}
+	aiVector3D aiPosition;
+	aiQuaternion aiOrientation;
+	aiVector3D aiScaling;
 
-			mesh->AddVertices(vertices);
-		}
-		else {
+	aiNode->mTransformation.Decompose(aiScaling, aiOrientation, aiPosition);
+
+	node.position = AssVector(aiPosition);
+	node.orientation = AssQuat(aiOrientation);
+	node.scale = AssVector(aiScaling);
+
+	nodes.push_back(node);
+
+	for (auto i = 0u; i < aiNode->mNumChildren; ++i) {
+		FlattenNode(aiNode->mChildren[i], nodes);
+	}
+}
+
+static bool ImportModel(const std::string& fileName, ImportedModel& imported) noexcept
+{
+	const auto scn = aiImportFile(fileName.c_str(),
+	                              aiProcess_GenSmoothNormals |
+	                              aiProcess_FixInfacingNormals |
+	                              aiProcess_Triangulate |
+	                              aiProcess_CalcTangentSpace | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices |
+	                              aiProcess_FixInfacingNormals | aiProcess_SortByPType);
+
+	if (!scn) {
+		ERROR_LOG("Failed to load scene: " + fileName);
+		return false;
+	}
+
+	if (!scn->mRootNode) {
+		ERROR_LOG("The model has no root node.");
+		aiReleaseImport(scn);
+		return false;
+	}
+
+	auto& model = imported.model;
+
+	imported.vertices.resize(scn->mNumMeshes);
+	imported.indices.resize(scn->mNumMeshes);
+	model.meshes.resize(scn->mNumMeshes);
+
+	for (auto i = 0u; i < scn->mNumMeshes; ++i) {
+		const auto* aiMesh{ scn->mMeshes[i] };
+
+		if (!aiMesh->HasPositions()) {
 			ERROR_LOG("Mesh has no vertices!");
-			delete mesh;
-			return;
+			aiReleaseImport(scn);
+			return false;
 		}
 
-		if (aiMesh->HasFaces()) {
-			std::vector<unsigned int> indices;
+		auto& vertices = imported.vertices[i];
+		vertices.resize(aiMesh->mNumVertices);
 
-			for (auto k = 0; k < aiMesh->mNumFaces; ++k) {
-				const auto& face = aiMesh->mFaces[k];
-				assert(face.mNumIndices == 3);
-				indices.push_back(face.mIndices[0]);
-				indices.push_back(face.mIndices[1]);
-				indices.push_back(face.mIndices[2]);
-			}
+		for (auto j = 0u; j < vertices.size(); ++j) {
+			vertices[j].position = AssVector(aiMesh->mVertices[j]);
+			vertices[j].normal = AssVector(aiMesh->mNormals[j]);
+			vertices[j].tangent = AssVector(aiMesh->mTangents[j]);
+			vertices[j].texcoord = Vec2f{ aiMesh->mTextureCoords[0][j].x, aiMesh->mTextureCoords[0][j].y };
+		}
+
+		// The faces are triangulated, so the index count is known up front.
+		auto& indices = imported.indices[i];
+		indices.resize(aiMesh->mNumFaces * 3);
 
-			mesh->AddIndices(indices);
+		for (auto k = 0u; k < aiMesh->mNumFaces; ++k) {
+			const auto& face = aiMesh->mFaces[k];
+			assert(face.mNumIndices == 3);
+			indices[k * 3] = face.mIndices[0];
+			indices[k * 3 + 1] = face.mIndices[1];
+			indices[k * 3 + 2] = face.mIndices[2];
 		}
 
-		mesh->CreateBuffers();
+		model.meshes[i].vertices = vertices.data();
+		model.meshes[i].vertexCount = static_cast<ui32>(vertices.size());
+		model.meshes[i].indices = indices.data();
+		model.meshes[i].indexCount = static_cast<ui32>(indices.size());
+		model.meshes[i].materialIndex = aiMesh->mMaterialIndex;
+	}
+
+	model.materials.resize(scn->mNumMaterials);
+
+	for (auto i = 0u; i < scn->mNumMaterials; ++i) {
+		const auto aiMaterial = scn->mMaterials[i];
+
+		auto& textures = model.materials[i].textures;
+
+		aiString path;
+		aiGetMaterialTexture(aiMaterial, aiTextureType_DIFFUSE, 0, &path);
+
+		textures[TEX_DIFFUSE] = GetFileName(path.data);
+
+		aiMaterial->GetTexture(aiTextureType_SPECULAR, 0, &path);
+
+		textures[TEX_SPECULAR] = GetFileName(path.data);
+
+		aiMaterial->GetTexture(aiTextureType_NORMALS, 0, &path);
+
+		textures[TEX_NORMAL] = GetFileName(path.data);
+	}
+
+	FlattenNode(scn->mRootNode, model.nodes);
+
+	aiReleaseImport(scn);
+
+	return true;
+}
+
+void DemoScene::LoadMeshes(const std::vector<ModelMesh>& meshes) noexcept
+{
+	for (const auto& modelMesh : meshes) {
+		auto mesh = new VulkanMesh;
+
+		m_SceneVertexCount += modelMesh.vertexCount;
+
+		// One copy each, straight out of the import or the mapped cache.
+		mesh->AddVertices(modelMesh.vertices, modelMesh.vertexCount);
+		mesh->AddIndices(modelMesh.indices, modelMesh.indexCount);
+
+		// Indirect draws come out of the merged scene mesh, the mesh only needs buffers of its own for per draw rendering.
+		if (m_RenderMode == RenderMode::INDIRECT) {
+			m_MeshRanges.push_back(m_SceneMesh.Append(*mesh));
+		}
+		else {
+			mesh->SetVertexLayout(m_VertexLayout);
+			mesh->CreateBuffers();
+		}
 
-		mesh->SetMaterialIndex(aiMesh->mMaterialIndex);
+		mesh->SetMaterialIndex(modelMesh.materialIndex);
 
 		m_Meshes.push_back(mesh);
 	}
 }
 
-void DemoScene::LoadMaterials(const aiScene* scene) noexcept
+std::string DemoScene::GetTexturePath(const std::string& fileName, const bool baked) const noexcept
 {
-	DemoMaterial material;
-	material.diffuse = Vec4f{ 1.0f };
-	material.specular = Vec4f{ 1.0f };
+	if (baked) {
+		return "../../../Assets/Baked/" + fileName.substr(0, fileName.rfind('.')) + TextureContainer::EXTENSION;
+	}
 
-	const auto GetFileName = [](std::string path) -> std::string
-	{
-		auto sepUnix = '/';
+	return "../../../Assets/" + fileName;
+}
+
+std::vector<VulkanTexture*> DemoScene::LoadTextures(const std::vector<std::string>& fileNames) noexcept
+{
+	std::vector<VulkanTexture*> textures(fileNames.size(), nullptr);
 
-		auto sepWindows = '\\';
+	// The pool only lives while the textures are decoded, like the one of the pipeline builds.
+	ThreadPool threadPool;
 
-		auto n = path.rfind(sepUnix);
+	if (m_TextureLoadMode == TextureLoadMode::PARALLEL && !threadPool.Initialize()) {
+		ERROR_LOG("Failed to initialize the texture load thread pool, falling back to serial.");
+		m_TextureLoadMode = TextureLoadMode::SERIAL;
+	}
 
-		if (n == std::string::npos) {
-			n = path.rfind(sepWindows);
+	// The baked containers first if they are selected, then the images of the textures still missing.
+	for (const auto baked : { true, false }) {
+		if (baked && !m_BakedTextures) {
+			continue;
 		}
 
-		if (n != std::string::npos) {
-			return path.substr(n + 1);
+		std::vector<ResourceHandle<VulkanTexture>> handles(fileNames.size());
+
+		for (size_t i = 0; i < fileNames.size(); ++i) {
+			if (textures[i]) {
+				continue;
+			}
+
+			const auto path = GetTexturePath(fileNames[i], baked);
+
+			// Every material lists its textures in TextureType order.
+			const auto textureType = static_cast<TextureType>(i % SUPPORTED_TEX_COUNT);
+
+			if (m_TextureLoadMode == TextureLoadMode::SERIAL) {
+				textures[i] = G_ResourceManager.Get<VulkanTexture>(path,
+				                                                   textureType,
+				                                                   VK_FORMAT_R8G8B8A8_UNORM,
+				                                                   VK_IMAGE_ASPECT_COLOR_BIT,
+				                                                   m_MipMode);
+			}
+			else {
+				handles[i] = G_ResourceManager.Request<VulkanTexture>(path,
+				                                                      textureType,
+				                                                      VK_FORMAT_R8G8B8A8_UNORM,
+				                                                      VK_IMAGE_ASPECT_COLOR_BIT,
+				                                                      m_MipMode);
+			}
 		}
 
-		return "";
-	};
+		if (m_TextureLoadMode == TextureLoadMode::PARALLEL) {
+			// Decodes everything across the pool, then queues all the uploads in the uploader's open batch.
+			G_ResourceManager.LoadRequested(threadPool);
 
-	for (auto i = 0; i < scene->mNumMaterials; ++i) {
-		const auto aiMaterial = scene->mMaterials[i];
+			for (size_t i = 0; i < fileNames.size(); ++i) {
+				if (!textures[i]) {
+					textures[i] = handles[i].Get();
+				}
+			}
+		}
 
-		aiString path;
-		aiGetMaterialTexture(aiMaterial, aiTextureType_DIFFUSE, 0, &path);
+		if (baked) {
+			const auto missingCount = std::count(textures.cbegin(), textures.cend(), nullptr);
 
-		material.textures[TEX_DIFFUSE] = G_ResourceManager.Get<VulkanTexture>("../../../Assets/" + GetFileName(path.data),
-		                                                                      TEX_DIFFUSE,
-		                                                                      VK_FORMAT_R8G8B8A8_UNORM,
-		                                                                      VK_IMAGE_ASPECT_COLOR_BIT);
+			if (missingCount) {
+				ERROR_LOG(std::to_string(missingCount) + " material textures have no loadable baked container, falling back to the images.");
+			}
+		}
+	}
 
-		aiMaterial->GetTexture(aiTextureType_SPECULAR, 0, &path);
+	return textures;
+}
 
-		material.textures[TEX_SPECULAR] = G_ResourceManager.Get<VulkanTexture>("../../../Assets/" + GetFileName(path.data),
-		                                                                       TEX_SPECULAR,
-		                                                                       VK_FORMAT_R8G8B8A8_UNORM,
-		                                                                       VK_IMAGE_ASPECT_COLOR_BIT);
+void DemoScene::LoadMaterials(const std::vector<ModelMaterial>& materials) noexcept
+{
+	// The textures of every material are gathered first, so that they can be loaded as one batch.
+	std::vector<std::string> fileNames;
+	fileNames.reserve(materials.size() * SUPPORTED_TEX_COUNT);
 
-		aiMaterial->GetTexture(aiTextureType_NORMALS, 0, &path);
+	for (const auto& modelMaterial : materials) {
+		fileNames.insert(fileNames.cend(), modelMaterial.textures.cbegin(), modelMaterial.textures.cend());
+	}
 
-		material.textures[TEX_NORMAL] = G_ResourceManager.Get<VulkanTexture>("../../../Assets/" + GetFileName(path.data),
-		                                                                     TEX_NORMAL,
-		                                                                     VK_FORMAT_R8G8B8A8_UNORM,
-		                                                                     VK_IMAGE_ASPECT_COLOR_BIT);
+	const auto textures = LoadTextures(fileNames);
+
+	DemoMaterial material;
+	material.diffuse = Vec4f{ 1.0f };
+	material.specular = Vec4f{ 1.0f };
+
+	for (size_t i = 0; i < materials.size(); ++i) {
+		for (auto type = 0; type < SUPPORTED_TEX_COUNT; ++type) {
+			material.textures[type] = textures[i * SUPPORTED_TEX_COUNT + type];
+		}
 
 		m_Materials.push_back(material);
 	}
 }
 
-DemoEntity* DemoScene::LoadNode(const aiNode* aiNode) noexcept
+DemoEntity* DemoScene::LoadNode(const std::vector<ModelNode>& nodes, size_t& nodeIndex) noexcept
 {
-	const std::string name = aiNode->mName.data;
+	const auto& node = nodes[nodeIndex++];
 
 	auto entity = new DemoEntity;
-	entity->SetName(name);
+	entity->SetName(node.name);
 
-	if (aiNode->mNumMeshes > 0) {
-		const auto mesh = m_Meshes[aiNode->mMeshes[0]];
+	if (node.meshIndex >= 0) {
+		const auto mesh = m_Meshes[node.meshIndex];
 
 		entity->SetMesh(mesh);
 		entity->SetMaterial(&m_Materials[mesh->GetMaterialIndex()]);
 	}
 
-	aiVector3D aiPosition;
-	aiQuaternion aiOrientation;
-	aiVector3D aiScaling;
-
-	aiNode->mTransformation.Decompose(aiScaling, aiOrientation, aiPosition);
-
-	entity->SetPosition(AssVector(aiPosition));
-	entity->SetOrientation(AssQuat(aiOrientation));
-	entity->SetScale(AssVector(aiScaling));
+	entity->SetPosition(node.position);
+	entity->SetOrientation(node.orientation);
+	entity->SetScale(node.scale);
 
 
 	// recursion for all the children
-	for (int i = 0; i < aiNode->mNumChildren; ++i) {
-		Entity* child{ LoadNode(aiNode->mChildren[i]) };
+	for (auto i = 0u; i < node.childCount; ++i) {
+		Entity* child{ LoadNode(nodes, nodeIndex) };
 
 		entity->AddChild(child);
 	}
@@ -177,50 +343,224 @@ DemoEntity* DemoScene::LoadNode(const aiNode* aiNode) noexcept
 
 std::unique_ptr<DemoEntity> DemoScene::LoadModel(const std::string& fileName) noexcept
 {
+	Timer timer;
+	timer.Start();
+
 	auto result = std::make_unique<DemoEntity>();
 
-	const auto scn = aiImportFile(fileName.c_str(),
-	                              aiProcess_GenSmoothNormals |
-	                              aiProcess_FixInfacingNormals |
-	                              aiProcess_Triangulate |
-	                              aiProcess_CalcTangentSpace | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices |
-	                              aiProcess_FixInfacingNormals | aiProcess_SortByPType);
+	const auto cacheFileName = fileName + ModelCache::EXTENSION;
+	const auto sourceStamp = ModelCache::GetSourceStamp(fileName);
 
-	if (!scn) {
-		ERROR_LOG("Failed to load scene: " + fileName);
-		return nullptr;
+	// Owns the meshes of the model when it is imported instead of mapped from the cache.
+	ImportedModel imported;
+
+	ModelCache cache;
+
+	m_ModelCacheWarm = m_ModelCacheEnabled && cache.Open(cacheFileName, sourceStamp);
+
+	if (!m_ModelCacheWarm) {
+		if (!ImportModel(fileName, imported)) {
+			return nullptr;
+		}
+
+		if (m_ModelCacheEnabled && !ModelCache::Write(cacheFileName, sourceStamp, imported.model)) {
+			ERROR_LOG("Failed to write the model cache, the model will be imported again next time.");
+		}
 	}
 
-	if (scn->HasMeshes()) {
-		LoadMeshes(scn);
+	const auto& model = m_ModelCacheWarm ? cache.GetModel() : imported.model;
+
+	LoadMeshes(model.meshes);
+
+	if (!model.materials.empty()) {
+		// Loading the materials loads their textures, which is where the mip chains are built.
+		Timer textureTimer;
+		textureTimer.Start();
+
+		LoadMaterials(model.materials);
+
+		m_TextureLoadTime = textureTimer.GetSec() * 1000.0;
 	}
 
-	if (scn->HasMaterials()) {
-		LoadMaterials(scn);
+	// The root node itself is skipped, its children are the entities of the model.
+	size_t nodeIndex{ 1 };
+
+	for (auto i = 0u; i < model.nodes[0].childCount; ++i) {
+		const auto entity = LoadNode(model.nodes, nodeIndex);
+
+		result->AddChild(entity);
 	}
 
-	const auto rootNode = scn->mRootNode;
+	// The textures are reported on their own.
+	m_ModelLoadTime = timer.GetSec() * 1000.0 - m_TextureLoadTime;
+
+	LOG("Model load time (" + std::string{ GetModelCacheStateName() } + "): " + std::to_string(m_ModelLoadTime) + " ms, " +
+		std::to_string(model.meshes.size()) + " meshes, " + std::to_string(m_SceneVertexCount) + " vertices.");
+
+	return std::move(result);
+}
+
+// ---------------------------------------------------
+
+void DemoScene::CollectDraws(DemoEntity* entity) noexcept
+{
+	const auto mesh = entity->GetMesh();
+
+	if (mesh && entity->GetMaterial()) {
+		const auto meshIndex = std::find(m_Meshes.cbegin(), m_Meshes.cend(), mesh) - m_Meshes.cbegin();
 
-	if (rootNode) {
-		for (auto i = 0; i < rootNode->mNumChildren; ++i) {
-			const auto child = rootNode->mChildren[i];
+		m_Draws.push_back(SceneDraw{ entity, static_cast<ui32>(meshIndex) });
+	}
 
-			const auto entity = LoadNode(child);
+	for (auto child : entity->GetChildren()) {
+		CollectDraws(static_cast<DemoEntity*>(child));
+	}
+}
 
-			result->AddChild(entity);
+void DemoScene::BuildDrawList() noexcept
+{
+	for (auto& entity : m_Entities) {
+		CollectDraws(entity.get());
+	}
+
+	// Textures are bound per material, so the draws of each material have to be contiguous.
+	std::stable_sort(m_Draws.begin(), m_Draws.end(), [](const SceneDraw& a, const SceneDraw& b)
+	{
+		return a.entity->GetMaterial() < b.entity->GetMaterial();
+	});
+
+	for (auto i = 0u; i < m_Draws.size(); ++i) {
+		const auto material = m_Draws[i].entity->GetMaterial();
+
+		if (m_DrawBatches.empty() || m_DrawBatches.back().material != material) {
+			m_DrawBatches.push_back(DrawBatch{ material, i, 0 });
 		}
+
+		++m_DrawBatches.back().drawCount;
 	}
-	else {
-		ERROR_LOG("The model has no root node.");
-		return nullptr;
+}
+
+bool DemoScene::PrepareIndirectDraws() noexcept
+{
+	if (!m_SceneMesh.CreateBuffers()) {
+		ERROR_LOG("Failed to create the scene mesh buffers.");
+		return false;
 	}
 
-	aiReleaseImport(scn);
+	// The scene is loaded once, so the buffers are sized once and stay mapped.
+	const auto drawCount = std::max<size_t>(m_Draws.size(), 1);
 
-	return std::move(result);
+	const auto& device = G_VulkanDevice;
+
+	for (auto frame = 0u; frame < G_Application.GetFramesInFlight(); ++frame) {
+		auto& drawXformsSsbo = m_DrawXformsSsbos[frame];
+
+		if (!device.CreateBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		                         drawXformsSsbo,
+		                         drawCount * sizeof(Mat4f)) || drawXformsSsbo.Map() != VK_SUCCESS) {
+			ERROR_LOG("Failed to create draw transforms storage buffer.");
+			return false;
+		}
+
+		VkWriteDescriptorSet storageDescriptorWrite{};
+		storageDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		storageDescriptorWrite.dstSet = m_DescriptorSets.sceneMatrices[frame];
+		storageDescriptorWrite.dstBinding = 1;
+		storageDescriptorWrite.dstArrayElement = 0;
+		storageDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		storageDescriptorWrite.descriptorCount = 1;
+		storageDescriptorWrite.pBufferInfo = &drawXformsSsbo.descriptorBufferInfo;
+
+		vkUpdateDescriptorSets(device, 1, &storageDescriptorWrite, 0, nullptr);
+
+		UploadIndirectDraws(frame);
+	}
+
+	if (!device.CreateBuffer(VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+	                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	                         m_IndirectCommands,
+	                         drawCount * sizeof(VkDrawIndexedIndirectCommand)) || m_IndirectCommands.Map() != VK_SUCCESS) {
+		ERROR_LOG("Failed to create indirect command buffer.");
+		return false;
+	}
+
+	const auto commands = static_cast<VkDrawIndexedIndirectCommand*>(m_IndirectCommands.data);
+
+	for (auto i = 0u; i < m_Draws.size(); ++i) {
+		const auto& range = m_MeshRanges[m_Draws[i].meshIndex];
+
+		// firstInstance selects the entity's world matrix in the vertex shader.
+		commands[i].indexCount = range.indexCount;
+		commands[i].instanceCount = 1;
+		commands[i].firstIndex = range.firstIndex;
+		commands[i].vertexOffset = range.vertexOffset;
+		commands[i].firstInstance = i;
+	}
+
+	return true;
 }
 
-// ---------------------------------------------------
+void DemoScene::UploadIndirectDraws(const ui32 frameIndex) noexcept
+{
+	const auto drawXforms = static_cast<Mat4f*>(m_DrawXformsSsbos[frameIndex].data);
+
+	for (auto i = 0u; i < m_Draws.size(); ++i) {
+		memcpy(&drawXforms[i], &m_Draws[i].entity->GetXform(), sizeof(Mat4f));
+	}
+}
+
+const char* DemoScene::GetRenderModeName() const noexcept
+{
+	return m_RenderMode == RenderMode::INDIRECT ? "Multi draw indirect" : "Per draw";
+}
+
+const char* DemoScene::GetTextureLoadModeName() const noexcept
+{
+	return m_TextureLoadMode == TextureLoadMode::PARALLEL ? "parallel" : "serial";
+}
+
+const char* DemoScene::GetModelCacheStateName() const noexcept
+{
+	if (!m_ModelCacheEnabled) {
+		return "cache off";
+	}
+
+	return m_ModelCacheWarm ? "warm cache" : "cold cache";
+}
+
+const char* DemoScene::GetMipModeName() const noexcept
+{
+	switch (m_MipMode) {
+		case TextureMipMode::FULL:
+			return "Full chain";
+		case TextureMipMode::STREAMED:
+			return "Streamed";
+		default:
+			return "None";
+	}
+}
+
+const char* DemoScene::GetVertexLayoutName() const noexcept
+{
+	switch (m_VertexLayout.GetType()) {
+		case VertexLayoutType::PACKED:
+			return "packed";
+		case VertexLayoutType::OCTAHEDRAL:
+			return "octahedral";
+		default:
+			return "full";
+	}
+}
+
+size_t DemoScene::GetDrawCallCount() const noexcept
+{
+	if (m_RenderMode == RenderMode::INDIRECT && G_VulkanDevice.GetEnabledFeatures().multiDrawIndirect) {
+		return m_DrawBatches.size();
+	}
+
+	return m_Draws.size();
+}
 
 bool DemoScene::CreateTextureSampler() noexcept
 {
@@ -249,7 +589,7 @@ bool DemoScene::CreateTextureSampler() noexcept
 	samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 	samplerCreateInfo.mipLodBias = 0.0f;
 	samplerCreateInfo.minLod = 0.0f;
-	samplerCreateInfo.maxLod = 0.0f;
+	samplerCreateInfo.maxLod = m_MipMode == TextureMipMode::NONE ? 0.0f : VK_LOD_CLAMP_NONE;
 
 	VkResult result{ vkCreateSampler(G_VulkanDevice, &samplerCreateInfo, nullptr, &m_TextureSampler) };
 
@@ -266,10 +606,18 @@ bool DemoScene::PrepareUniforms() noexcept
 	//First create a descriptor pool to allocate descriptors from.
 	//Descriptors a.k.a uniforms
 
+	// The scene matrices and the display sets are rewritten every frame, so there is one of each per frame in flight.
+	const auto framesInFlight = G_Application.GetFramesInFlight();
+
 	// We need 1 descriptor set for the scene matrices.
 	VkDescriptorPoolSize sceneMatricesPoolSize{};
 	sceneMatricesPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	sceneMatricesPoolSize.descriptorCount = 1;
+	sceneMatricesPoolSize.descriptorCount = framesInFlight;
+
+	// The indirect pipeline also reads the world matrices from a storage buffer in the same set.
+	VkDescriptorPoolSize drawXformsPoolSize{};
+	drawXformsPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	drawXformsPoolSize.descriptorCount = framesInFlight;
 
 	//and 1 descriptor set for the shared material.
 	VkDescriptorPoolSize materialPoolSize{};
@@ -278,21 +626,22 @@ bool DemoScene::PrepareUniforms() noexcept
 	// the rest of the material attributes will use a push constant block.
 	materialPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 
-	// 3 textures per material of each entity.
-	materialPoolSize.descriptorCount = m_Materials.size() * 3;
+	// 3 textures per material of each entity, per frame in flight.
+	materialPoolSize.descriptorCount = m_Materials.size() * 3 * framesInFlight;
 
 	// Descriptor pool size for the deferred shading resolution pass (display pass)
 	VkDescriptorPoolSize gBufferPoolSize{};
 	gBufferPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	gBufferPoolSize.descriptorCount = 5; // x5 (position, normal, specular, albedo, depth textures)
+	gBufferPoolSize.descriptorCount = 5 * framesInFlight; // x5 (position, normal, specular, albedo, depth textures)
 
 	// 1 UBO for the light array (display pass)
 	VkDescriptorPoolSize lightsPoolSize{};
 	lightsPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	lightsPoolSize.descriptorCount = 1; // x1
+	lightsPoolSize.descriptorCount = framesInFlight; // x1
 
 	std::vector<VkDescriptorPoolSize> descriptorPoolSizes{
 		sceneMatricesPoolSize,
+		drawXformsPoolSize,
 		materialPoolSize,
 		gBufferPoolSize,
 		lightsPoolSize
@@ -302,7 +651,8 @@ bool DemoScene::PrepareUniforms() noexcept
 	descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 
 	//1 set for each entity's material plus one for the scene matrices plus one for the display pass light ubo and input textures
-	descriptorPoolCreateInfo.maxSets = m_Materials.size() + 2;
+	//per frame in flight
+	descriptorPoolCreateInfo.maxSets = (m_Materials.size() + 2) * framesInFlight;
 	descriptorPoolCreateInfo.poolSizeCount = static_cast<ui32>(descriptorPoolSizes.size());
 	descriptorPoolCreateInfo.pPoolSizes = descriptorPoolSizes.data();
 
@@ -330,7 +680,16 @@ bool DemoScene::PrepareUniforms() noexcept
 	vertexShaderUboBinding.descriptorCount = 1; //1 descriptor.
 	vertexShaderUboBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT; //bound to the vertex shader stage
 
-	std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings{ vertexShaderUboBinding };
+	VkDescriptorSetLayoutBinding drawXformsBinding{};
+	drawXformsBinding.binding = 1; //bind at location 1.
+	drawXformsBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER; //World matrices of the indirect draws.
+	drawXformsBinding.descriptorCount = 1;
+	drawXformsBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+	std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings{
+		vertexShaderUboBinding,
+		drawXformsBinding
+	};
 
 	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
 	descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -512,42 +871,49 @@ bool DemoScene::PrepareUniforms() noexcept
 	}
 
 	// Now all the layouts have been defined. It is time to allocate the descriptor sets and write to them.
-	// First, allocate the scene matrices descriptor set.
+	// First, allocate the scene matrices descriptor sets, one per frame in flight.
+	std::array<VkDescriptorSetLayout, VulkanApplication::MAX_FRAMES_IN_FLIGHT> perFrameSetLayouts{};
+	perFrameSetLayouts.fill(m_DescriptorSetLayouts.sceneMatrices);
+
 	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
 	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 	descriptorSetAllocateInfo.descriptorPool = m_DescriptorPool; //Allocate from this pool.
-	descriptorSetAllocateInfo.descriptorSetCount = 1; //1 descriptor set.
-	descriptorSetAllocateInfo.pSetLayouts = &m_DescriptorSetLayouts.sceneMatrices; //With this layout.
+	descriptorSetAllocateInfo.descriptorSetCount = framesInFlight; //1 descriptor set per frame.
+	descriptorSetAllocateInfo.pSetLayouts = perFrameSetLayouts.data(); //With this layout.
 
-	result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &m_DescriptorSets.sceneMatrices);
+	result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, m_DescriptorSets.sceneMatrices.data());
 
 	if (result != VK_SUCCESS) {
 		ERROR_LOG("Failed to allocate scene matrices descriptor set.");
 		return false;
 	}
 
-	// Create the buffer object that will store the uniforms.
-	if (!device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-	                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-	                         m_Ubos.matrices,
-	                         sizeof(MatricesUbo))) {
-		ERROR_LOG("Failed to create uniform buffer.");
-		return false;
-	}
-
-	// Now that the descriptor set is allocated we have to write into it and update the uniforms.
 	VkWriteDescriptorSet uniformDescriptorWrite{};
-	uniformDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	uniformDescriptorWrite.dstSet = m_DescriptorSets.sceneMatrices; //Write to this set
-	uniformDescriptorWrite.dstBinding = 0; //at this binding
-	uniformDescriptorWrite.dstArrayElement = 0; //It is not an array.
-	uniformDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; //It is a uniform buffer.
-	uniformDescriptorWrite.descriptorCount = 1; // 1 descriptor set.
-	uniformDescriptorWrite.pBufferInfo = &m_Ubos.matrices.descriptorBufferInfo; // And here is the buffer description.
+	std::vector<VkWriteDescriptorSet> writeDescriptorSets;
+
+	for (auto frame = 0u; frame < framesInFlight; ++frame) {
+		// Create the buffer object that will store the uniforms.
+		if (!device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		                         m_Ubos.matrices[frame],
+		                         sizeof(MatricesUbo))) {
+			ERROR_LOG("Failed to create uniform buffer.");
+			return false;
+		}
 
-	std::vector<VkWriteDescriptorSet> writeDescriptorSets{ uniformDescriptorWrite };
+		// Now that the descriptor set is allocated we have to write into it and update the uniforms.
+		uniformDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		uniformDescriptorWrite.dstSet = m_DescriptorSets.sceneMatrices[frame]; //Write to this set
+		uniformDescriptorWrite.dstBinding = 0; //at this binding
+		uniformDescriptorWrite.dstArrayElement = 0; //It is not an array.
+		uniformDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; //It is a uniform buffer.
+		uniformDescriptorWrite.descriptorCount = 1; // 1 descriptor set.
+		uniformDescriptorWrite.pBufferInfo = &m_Ubos.matrices[frame].descriptorBufferInfo; // And here is the buffer description.
+
+		writeDescriptorSets.push_back(uniformDescriptorWrite);
+	}
 
-	// Update the descriptor set.
+	// Update the descriptor sets.
 	vkUpdateDescriptorSets(device,
 	                       static_cast<ui32>(writeDescriptorSets.size()),
 	                       writeDescriptorSets.data(),
@@ -556,85 +922,33 @@ bool DemoScene::PrepareUniforms() noexcept
 
 	writeDescriptorSets.clear();
 
-	// Allocate 1 descriptor set for each entity's material
-	descriptorSetAllocateInfo.descriptorSetCount = 1; //1 descriptor set.
-	descriptorSetAllocateInfo.pSetLayouts = &m_DescriptorSetLayouts.material; //With this layout.
-
-	for (auto& mat : m_Materials) {
-		result = vkAllocateDescriptorSets(device,
-		                                  &descriptorSetAllocateInfo,
-		                                  &mat.descriptorSet);
-
-		if (result != VK_SUCCESS) {
-			ERROR_LOG("Failed to allocate material descriptor set.");
-			return false;
-		}
-
-
-		// Define the descriptor image info structures for each texture type.
-		VkDescriptorImageInfo diffuseTextureImageInfo{};
-		diffuseTextureImageInfo.imageView = mat.textures[TEX_DIFFUSE]->GetImageView();
-		diffuseTextureImageInfo.imageLayout = mat.textures[TEX_DIFFUSE]->GetImageLayout();
-		diffuseTextureImageInfo.sampler = m_TextureSampler;
-
-		VkDescriptorImageInfo specularTextureImageInfo{};
-		specularTextureImageInfo.imageView = mat.textures[TEX_SPECULAR]->GetImageView();
-		specularTextureImageInfo.imageLayout = mat.textures[TEX_SPECULAR]->GetImageLayout();
-		specularTextureImageInfo.sampler = m_TextureSampler;
-
-		VkDescriptorImageInfo normalTextureImageInfo{};
-		normalTextureImageInfo.imageView = mat.textures[TEX_NORMAL]->GetImageView();
-		normalTextureImageInfo.imageLayout = mat.textures[TEX_NORMAL]->GetImageLayout();
-		normalTextureImageInfo.sampler = m_TextureSampler;
-
-		// Define the descriptor writes for each texture type.
-		VkWriteDescriptorSet diffuseTextureDescriptorWrite{};
-		diffuseTextureDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		diffuseTextureDescriptorWrite.dstSet = mat.descriptorSet;
-		diffuseTextureDescriptorWrite.dstBinding = TEX_DIFFUSE;
-		diffuseTextureDescriptorWrite.dstArrayElement = 0;
-		diffuseTextureDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		diffuseTextureDescriptorWrite.descriptorCount = 1;
-		diffuseTextureDescriptorWrite.pImageInfo = &diffuseTextureImageInfo;
-
-		writeDescriptorSets.push_back(diffuseTextureDescriptorWrite);
-
-		VkWriteDescriptorSet specularTextureDescriptorWrite{};
-		specularTextureDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		specularTextureDescriptorWrite.dstSet = mat.descriptorSet;
-		specularTextureDescriptorWrite.dstBinding = TEX_SPECULAR;
-		specularTextureDescriptorWrite.dstArrayElement = 0;
-		specularTextureDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		specularTextureDescriptorWrite.descriptorCount = 1;
-		specularTextureDescriptorWrite.pImageInfo = &specularTextureImageInfo;
-
-		writeDescriptorSets.push_back(specularTextureDescriptorWrite);
+	// Allocate 1 descriptor set for each entity's material, per frame in flight.
+	perFrameSetLayouts.fill(m_DescriptorSetLayouts.material);
 
-		VkWriteDescriptorSet normalTextureDescriptorWrite{};
-		normalTextureDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		normalTextureDescriptorWrite.dstSet = mat.descriptorSet;
-		normalTextureDescriptorWrite.dstBinding = TEX_NORMAL;
-		normalTextureDescriptorWrite.dstArrayElement = 0;
-		normalTextureDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		normalTextureDescriptorWrite.descriptorCount = 1;
-		normalTextureDescriptorWrite.pImageInfo = &normalTextureImageInfo;
+	descriptorSetAllocateInfo.descriptorSetCount = framesInFlight; //1 descriptor set per frame.
+	descriptorSetAllocateInfo.pSetLayouts = perFrameSetLayouts.data(); //With this layout.
 
-		writeDescriptorSets.push_back(normalTextureDescriptorWrite);
+	for (auto& mat : m_Materials) {
+		result = vkAllocateDescriptorSets(device,
+		                                  &descriptorSetAllocateInfo,
+		                                  mat.descriptorSets.data());
 
-		// Finally update the material's descriptor set.
-		vkUpdateDescriptorSets(device,
-		                       static_cast<ui32>(writeDescriptorSets.size()),
-		                       writeDescriptorSets.data(),
-		                       0,
-		                       nullptr);
+		if (result != VK_SUCCESS) {
+			ERROR_LOG("Failed to allocate material descriptor set.");
+			return false;
+		}
+	}
 
-		writeDescriptorSets.clear();
+	for (auto frame = 0u; frame < framesInFlight; ++frame) {
+		WriteMaterialDescriptorSets(frame);
 	}
 
-	descriptorSetAllocateInfo.descriptorSetCount = 1; //1 descriptor set.
-	descriptorSetAllocateInfo.pSetLayouts = &m_DescriptorSetLayouts.gBufferAndLights; //With this layout.
+	perFrameSetLayouts.fill(m_DescriptorSetLayouts.gBufferAndLights);
 
-	result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &m_DescriptorSets.display);
+	descriptorSetAllocateInfo.descriptorSetCount = framesInFlight; //1 descriptor set per frame.
+	descriptorSetAllocateInfo.pSetLayouts = perFrameSetLayouts.data(); //With this layout.
+
+	result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, m_DescriptorSets.display.data());
 
 	if (result != VK_SUCCESS) {
 		ERROR_LOG("Failed to create the display/lighting resolution descriptor set.");
@@ -675,7 +989,6 @@ bool DemoScene::PrepareUniforms() noexcept
 
 	VkWriteDescriptorSet positionImageDescriptorWrite{};
 	positionImageDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	positionImageDescriptorWrite.dstSet = m_DescriptorSets.display;
 	positionImageDescriptorWrite.dstBinding = m_AttachmentIndices.position;
 	positionImageDescriptorWrite.dstArrayElement = 0;
 	positionImageDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -686,7 +999,6 @@ bool DemoScene::PrepareUniforms() noexcept
 
 	VkWriteDescriptorSet normalImageDescriptorWrite{};
 	normalImageDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	normalImageDescriptorWrite.dstSet = m_DescriptorSets.display;
 	normalImageDescriptorWrite.dstBinding = m_AttachmentIndices.normal;
 	normalImageDescriptorWrite.dstArrayElement = 0;
 	normalImageDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -697,7 +1009,6 @@ bool DemoScene::PrepareUniforms() noexcept
 
 	VkWriteDescriptorSet albedoImageDescriptorWrite{};
 	albedoImageDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	albedoImageDescriptorWrite.dstSet = m_DescriptorSets.display;
 	albedoImageDescriptorWrite.dstBinding = m_AttachmentIndices.albedo;
 	albedoImageDescriptorWrite.dstArrayElement = 0;
 	albedoImageDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -708,7 +1019,6 @@ bool DemoScene::PrepareUniforms() noexcept
 
 	VkWriteDescriptorSet specularImageDescriptorWrite{};
 	specularImageDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	specularImageDescriptorWrite.dstSet = m_DescriptorSets.display;
 	specularImageDescriptorWrite.dstBinding = m_AttachmentIndices.specular;
 	specularImageDescriptorWrite.dstArrayElement = 0;
 	specularImageDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -719,7 +1029,6 @@ bool DemoScene::PrepareUniforms() noexcept
 
 	VkWriteDescriptorSet depthImageDescriptorWrite{};
 	depthImageDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	depthImageDescriptorWrite.dstSet = m_DescriptorSets.display;
 	depthImageDescriptorWrite.dstBinding = m_AttachmentIndices.depth;
 	depthImageDescriptorWrite.dstArrayElement = 0;
 	depthImageDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -728,37 +1037,110 @@ bool DemoScene::PrepareUniforms() noexcept
 
 	writeDescriptorSets.push_back(depthImageDescriptorWrite);
 
-	if (!device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-	                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-	                         m_Ubos.lights,
-	                         sizeof(LightsUbo))) {
-		ERROR_LOG("Failed to create uniform buffer.");
-		return false;
-	}
-
 	uniformDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	uniformDescriptorWrite.dstSet = m_DescriptorSets.display;
 	uniformDescriptorWrite.dstBinding = writeDescriptorSets.size();
 	uniformDescriptorWrite.dstArrayElement = 0;
 	uniformDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	uniformDescriptorWrite.descriptorCount = 1;
-	uniformDescriptorWrite.pBufferInfo = &m_Ubos.lights.descriptorBufferInfo;
 
 	writeDescriptorSets.push_back(uniformDescriptorWrite);
 
-	//Update the display descriptor set.
-	vkUpdateDescriptorSets(device,
-	                       static_cast<ui32>(writeDescriptorSets.size()),
-	                       writeDescriptorSets.data(),
-	                       0,
-	                       nullptr);
+	// The G-Buffer attachments are the same for every frame, only the lights UBO differs.
+	for (auto frame = 0u; frame < framesInFlight; ++frame) {
+		if (!device.CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		                         m_Ubos.lights[frame],
+		                         sizeof(LightsUbo))) {
+			ERROR_LOG("Failed to create uniform buffer.");
+			return false;
+		}
+
+		for (auto& writeDescriptorSet : writeDescriptorSets) {
+			writeDescriptorSet.dstSet = m_DescriptorSets.display[frame];
+		}
+
+		writeDescriptorSets.back().pBufferInfo = &m_Ubos.lights[frame].descriptorBufferInfo;
+
+		//Update the display descriptor set.
+		vkUpdateDescriptorSets(device,
+		                       static_cast<ui32>(writeDescriptorSets.size()),
+		                       writeDescriptorSets.data(),
+		                       0,
+		                       nullptr);
 
-	m_Ubos.matrices.Map();
-	m_Ubos.lights.Map();
+		m_Ubos.matrices[frame].Map();
+		m_Ubos.lights[frame].Map();
+	}
 
 	return true;
 }
 
+void DemoScene::WriteMaterialDescriptorSets(const ui32 frameIndex) noexcept
+{
+	std::vector<VkWriteDescriptorSet> writeDescriptorSets;
+
+	for (auto& mat : m_Materials) {
+		// Define the descriptor image info structures for each texture type.
+		VkDescriptorImageInfo diffuseTextureImageInfo{};
+		diffuseTextureImageInfo.imageView = mat.textures[TEX_DIFFUSE]->GetImageView();
+		diffuseTextureImageInfo.imageLayout = mat.textures[TEX_DIFFUSE]->GetImageLayout();
+		diffuseTextureImageInfo.sampler = m_TextureSampler;
+
+		VkDescriptorImageInfo specularTextureImageInfo{};
+		specularTextureImageInfo.imageView = mat.textures[TEX_SPECULAR]->GetImageView();
+		specularTextureImageInfo.imageLayout = mat.textures[TEX_SPECULAR]->GetImageLayout();
+		specularTextureImageInfo.sampler = m_TextureSampler;
+
+		VkDescriptorImageInfo normalTextureImageInfo{};
+		normalTextureImageInfo.imageView = mat.textures[TEX_NORMAL]->GetImageView();
+		normalTextureImageInfo.imageLayout = mat.textures[TEX_NORMAL]->GetImageLayout();
+		normalTextureImageInfo.sampler = m_TextureSampler;
+
+		// Define the descriptor writes for each texture type.
+		VkWriteDescriptorSet diffuseTextureDescriptorWrite{};
+		diffuseTextureDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		diffuseTextureDescriptorWrite.dstSet = mat.descriptorSets[frameIndex];
+		diffuseTextureDescriptorWrite.dstBinding = TEX_DIFFUSE;
+		diffuseTextureDescriptorWrite.dstArrayElement = 0;
+		diffuseTextureDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		diffuseTextureDescriptorWrite.descriptorCount = 1;
+		diffuseTextureDescriptorWrite.pImageInfo = &diffuseTextureImageInfo;
+
+		writeDescriptorSets.push_back(diffuseTextureDescriptorWrite);
+
+		VkWriteDescriptorSet specularTextureDescriptorWrite{};
+		specularTextureDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		specularTextureDescriptorWrite.dstSet = mat.descriptorSets[frameIndex];
+		specularTextureDescriptorWrite.dstBinding = TEX_SPECULAR;
+		specularTextureDescriptorWrite.dstArrayElement = 0;
+		specularTextureDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		specularTextureDescriptorWrite.descriptorCount = 1;
+		specularTextureDescriptorWrite.pImageInfo = &specularTextureImageInfo;
+
+		writeDescriptorSets.push_back(specularTextureDescriptorWrite);
+
+		VkWriteDescriptorSet normalTextureDescriptorWrite{};
+		normalTextureDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		normalTextureDescriptorWrite.dstSet = mat.descriptorSets[frameIndex];
+		normalTextureDescriptorWrite.dstBinding = TEX_NORMAL;
+		normalTextureDescriptorWrite.dstArrayElement = 0;
+		normalTextureDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		normalTextureDescriptorWrite.descriptorCount = 1;
+		normalTextureDescriptorWrite.pImageInfo = &normalTextureImageInfo;
+
+		writeDescriptorSets.push_back(normalTextureDescriptorWrite);
+
+		// Finally update the material's descriptor set.
+		vkUpdateDescriptorSets(G_VulkanDevice,
+		                       static_cast<ui32>(writeDescriptorSets.size()),
+		                       writeDescriptorSets.data(),
+		                       0,
+		                       nullptr);
+
+		writeDescriptorSets.clear();
+	}
+}
+
 bool DemoScene::CreatePipelines(VkExtent2D swapChainExtent, VkRenderPass displayRenderPass) noexcept
 {
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState{};
@@ -846,7 +1228,7 @@ bool DemoScene::CreatePipelines(VkExtent2D swapChainExtent, VkRenderPass display
 	dynamicState.dynamicStateCount = static_cast<ui32>(dynamicStateToEnable.size());
 	dynamicState.flags = VK_NULL_HANDLE;
 
-	// Solid rendering pipeline
+	// Deferred pipeline
 	// Load shaders
 	VulkanShader* vertexShader{ G_ResourceManager.Get<VulkanShader>("sdr/deferred.vert.spv") };
 
@@ -874,14 +1256,30 @@ bool DemoScene::CreatePipelines(VkExtent2D swapChainExtent, VkRenderPass display
 	fragmentShaderStage.module = *fragmentShader;
 	fragmentShaderStage.pName = "main"; //Shader function entry point.
 
+	// OCTAHEDRAL_VECTORS of the vertex shaders, which unfolds the normal and the tangent.
+	const VkBool32 octahedralVectors{ m_VertexLayout.HasOctahedralVectors() ? VK_TRUE : VK_FALSE };
+
+	VkSpecializationMapEntry specializationMapEntry{};
+	specializationMapEntry.constantID = 0;
+	specializationMapEntry.offset = 0;
+	specializationMapEntry.size = sizeof(VkBool32);
+
+	VkSpecializationInfo vertexSpecializationInfo{};
+	vertexSpecializationInfo.mapEntryCount = 1;
+	vertexSpecializationInfo.pMapEntries = &specializationMapEntry;
+	vertexSpecializationInfo.dataSize = sizeof(VkBool32);
+	vertexSpecializationInfo.pData = &octahedralVectors;
+
+	vertexShaderStage.pSpecializationInfo = &vertexSpecializationInfo;
+
 	std::vector<VkPipelineShaderStageCreateInfo> shaderStages{
 		vertexShaderStage,
 		fragmentShaderStage
 	};
 
-	auto vertexInputBindingDescription = VulkanMesh::GetVertexInputBindingDescription();
+	auto vertexInputBindingDescription = VulkanMesh::GetVertexInputBindingDescription(m_VertexLayout);
 
-	auto vertexInputAttributeDescriptions = VulkanMesh::GetVertexInputAttributeDescriptions();
+	auto vertexInputAttributeDescriptions = VulkanMesh::GetVertexInputAttributeDescriptions(m_VertexLayout);
 
 	// Vertex binding information and attribute descriptions.
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
@@ -909,24 +1307,35 @@ bool DemoScene::CreatePipelines(VkExtent2D swapChainExtent, VkRenderPass display
 	pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
 	pipelineCreateInfo.pStages = shaderStages.data();
 
-	VkResult result{
-		vkCreateGraphicsPipelines(G_VulkanDevice,
-		                          m_PipelineCache,
-		                          1,
-		                          &pipelineCreateInfo,
-		                          nullptr,
-		                          &m_Pipelines.deferred)
-	};
+	// The pipelines are compiled as one batch, so every create info keeps its own
+	// copy of the state that differs instead of patching a shared one in between.
+	std::vector<VkGraphicsPipelineCreateInfo> pipelineCreateInfos{ pipelineCreateInfo };
 
-	if (result != VK_SUCCESS) {
-		ERROR_LOG("Failed to create pipeline.");
-		return false;
+	// Indirect pipeline, same state as the deferred one with a vertex shader that
+	// fetches the model matrix from the draw transforms storage buffer.
+	std::vector<VkPipelineShaderStageCreateInfo> indirectShaderStages{ shaderStages };
+
+	if (m_RenderMode == RenderMode::INDIRECT) {
+		vertexShader = G_ResourceManager.Get<VulkanShader>("sdr/deferred_indirect.vert.spv");
+
+		if (!vertexShader) {
+			ERROR_LOG("Failed to load vertex shader.");
+			return false;
+		}
+
+		indirectShaderStages[0].module = *vertexShader;
+
+		auto indirectCreateInfo = pipelineCreateInfo;
+		indirectCreateInfo.pStages = indirectShaderStages.data();
+
+		pipelineCreateInfos.push_back(indirectCreateInfo);
 	}
 
 	// Display pipeline
 	// The display pipeline only has 1 color attachment
-	colorBlendState.attachmentCount = 1;
-	colorBlendState.pAttachments = &colorBlendAttachmentState;
+	auto displayColorBlendState = colorBlendState;
+	displayColorBlendState.attachmentCount = 1;
+	displayColorBlendState.pAttachments = &colorBlendAttachmentState;
 
 	vertexShader = G_ResourceManager.Get<VulkanShader>("sdr/display.vert.spv");
 
@@ -942,17 +1351,15 @@ bool DemoScene::CreatePipelines(VkExtent2D swapChainExtent, VkRenderPass display
 		return false;
 	}
 
-	// change the shader modules
+	// change the shader modules, the display vertex shader has no specialization constants
 	vertexShaderStage.module = *vertexShader;
+	vertexShaderStage.pSpecializationInfo = nullptr;
 	fragmentShaderStage.module = *fragmentShader;
 
-	shaderStages.clear();
-	shaderStages.insert(shaderStages.cbegin(), { vertexShaderStage, fragmentShaderStage });
-
-	pipelineCreateInfo.pStages = shaderStages.data();
-
-	// Assign the correct pipeline layout
-	pipelineCreateInfo.layout = m_PipelineLayouts.display;
+	std::vector<VkPipelineShaderStageCreateInfo> displayShaderStages{
+		vertexShaderStage,
+		fragmentShaderStage
+	};
 
 	VkPipelineVertexInputStateCreateInfo emptyInputState{};
 	emptyInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -961,28 +1368,46 @@ bool DemoScene::CreatePipelines(VkExtent2D swapChainExtent, VkRenderPass display
 	emptyInputState.vertexBindingDescriptionCount = 0;
 	emptyInputState.pVertexBindingDescriptions = VK_NULL_HANDLE;
 
-	pipelineCreateInfo.pVertexInputState = &emptyInputState;
+	auto displayRasterizationState = rasterizationState;
+	displayRasterizationState.cullMode = VK_CULL_MODE_FRONT_BIT;
+	displayRasterizationState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
 
-	rasterizationState.cullMode = VK_CULL_MODE_FRONT_BIT;
-	rasterizationState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	auto displayCreateInfo = pipelineCreateInfo;
+	displayCreateInfo.stageCount = static_cast<uint32_t>(displayShaderStages.size());
+	displayCreateInfo.pStages = displayShaderStages.data();
+	displayCreateInfo.layout = m_PipelineLayouts.display;
+	displayCreateInfo.pVertexInputState = &emptyInputState;
+	displayCreateInfo.pRasterizationState = &displayRasterizationState;
+	displayCreateInfo.pColorBlendState = &displayColorBlendState;
+	displayCreateInfo.renderPass = displayRenderPass;
 
-	pipelineCreateInfo.pRasterizationState = &rasterizationState;
+	pipelineCreateInfos.push_back(displayCreateInfo);
 
-	// Assign the correct render pass.
-	pipelineCreateInfo.renderPass = displayRenderPass;
+	// The pool only lives while the pipelines compile, the scene does not use it afterwards.
+	ThreadPool threadPool;
 
-	result = vkCreateGraphicsPipelines(G_VulkanDevice,
-	                                   m_PipelineCache,
-	                                   1,
-	                                   &pipelineCreateInfo,
-	                                   nullptr,
-	                                   &m_Pipelines.display);
+	if (m_PipelineBuildMode == PipelineBuildMode::PARALLEL && !threadPool.Initialize()) {
+		ERROR_LOG("Failed to initialize the pipeline build thread pool.");
+		return false;
+	}
 
-	if (result != VK_SUCCESS) {
-		ERROR_LOG("Failed to create pipeline.");
+	std::vector<VkPipeline> pipelines;
+
+	if (!m_PipelineBuilder.Build(m_PipelineBuildMode == PipelineBuildMode::PARALLEL ? &threadPool : nullptr,
+	                             m_PipelineCache,
+	                             pipelineCreateInfos,
+	                             pipelines)) {
+		ERROR_LOG("Failed to create pipelines.");
 		return false;
 	}
 
+	m_Pipelines.deferred = pipelines.front();
+	m_Pipelines.display = pipelines.back();
+
+	if (m_RenderMode == RenderMode::INDIRECT) {
+		m_Pipelines.deferredIndirect = pipelines[1];
+	}
+
 	return true;
 }
 
@@ -1061,7 +1486,7 @@ bool DemoScene::InitializeImGui(const VkRenderPass renderPass) noexcept
 	vkEndCommandBuffer(commandBuffer);
 
 	if (!G_VulkanDevice.SubmitCommandBuffer(commandBuffer,
-	                                        G_VulkanDevice.GetQueue(QueueFamily::TRANSFER),
+	                                        G_VulkanDevice.GetQueue(QueueFamily::GRAPHICS),
 	                                        fence)) {
 		ERROR_LOG("Failed to submit command buffer for Font uploading.");
 		return false;
@@ -1082,6 +1507,12 @@ bool DemoScene::InitializeImGui(const VkRenderPass renderPass) noexcept
 // -------------------------------------------------------------------
 DemoScene::~DemoScene()
 {
+	if (m_GBufferGpuTimeCount) {
+		LOG("Average G-Buffer GPU time (mips: " + std::string{ GetMipModeName() } +
+			", vertex layout: " + GetVertexLayoutName() + ", " + std::to_string(m_VertexLayout.GetStride()) + " bytes): " +
+			std::to_string(m_GBufferGpuTimeSum / m_GBufferGpuTimeCount) + " ms.");
+	}
+
 	const auto& device = G_VulkanDevice;
 
 	for (auto mesh : m_Meshes) {
@@ -1089,6 +1520,11 @@ DemoScene::~DemoScene()
 	}
 	m_Meshes.clear();
 
+	for (auto& drawXformsSsbo : m_DrawXformsSsbos) {
+		drawXformsSsbo.Unmap();
+	}
+	m_IndirectCommands.Unmap();
+
 	vkDestroySampler(device, m_TextureSampler, nullptr);
 
 	//No need to free descriptor sets. They are taken care of by the Vulkan driver.
@@ -1104,6 +1540,7 @@ DemoScene::~DemoScene()
 	vkDestroyPipelineLayout(device, m_PipelineLayouts.display, nullptr);
 
 	vkDestroyPipeline(device, m_Pipelines.deferred, nullptr);
+	vkDestroyPipeline(device, m_Pipelines.deferredIndirect, nullptr);
 	vkDestroyPipeline(device, m_Pipelines.display, nullptr);
 
 	ImGui_ImplGlfwVulkan_Shutdown();
@@ -1111,7 +1548,107 @@ DemoScene::~DemoScene()
 
 bool DemoScene::Initialize(const VkExtent2D swapChainExtent, VkRenderPass displayRenderPass) noexcept
 {
-	if (!m_PipelineCache.Create()) {
+	Timer loadTimer;
+	loadTimer.Start();
+
+	ConfigFile cfg{ "config/config.cfg" };
+
+	if (!cfg.IsOpen()) {
+		ERROR_LOG("Failed to open the configuration file.");
+		return false;
+	}
+
+	const std::string renderMode{ cfg.GetString("attributes.render_mode", "per_draw") };
+
+	if (renderMode == "indirect") {
+		m_RenderMode = RenderMode::INDIRECT;
+	}
+	else if (renderMode != "per_draw") {
+		ERROR_LOG("Unknown render mode: " + renderMode + ", falling back to per_draw.");
+	}
+
+	const std::string pipelineBuild{ cfg.GetString("attributes.pipeline_build", "parallel") };
+
+	if (pipelineBuild == "serial") {
+		m_PipelineBuildMode = PipelineBuildMode::SERIAL;
+	}
+	else if (pipelineBuild != "parallel") {
+		ERROR_LOG("Unknown pipeline build mode: " + pipelineBuild + ", falling back to parallel.");
+	}
+
+	const std::string mips{ cfg.GetString("attributes.mips", "none") };
+
+	if (mips == "full") {
+		m_MipMode = TextureMipMode::FULL;
+	}
+	else if (mips == "streamed") {
+		m_MipMode = TextureMipMode::STREAMED;
+	}
+	else if (mips != "none") {
+		ERROR_LOG("Unknown mip mode: " + mips + ", falling back to none.");
+	}
+
+	m_MipBudget = static_cast<VkDeviceSize>(std::max(0, cfg.GetInteger("attributes.mip_budget", 256))) * 1024 * 1024;
+
+	const std::string textureLoad{ cfg.GetString("attributes.texture_load", "parallel") };
+
+	if (textureLoad == "serial") {
+		m_TextureLoadMode = TextureLoadMode::SERIAL;
+	}
+	else if (textureLoad != "parallel") {
+		ERROR_LOG("Unknown texture load mode: " + textureLoad + ", falling back to parallel.");
+	}
+
+	const std::string textures{ cfg.GetString("attributes.textures", "source") };
+
+	if (textures == "baked") {
+		m_BakedTextures = true;
+	}
+	else if (textures != "source") {
+		ERROR_LOG("Unknown texture source: " + textures + ", falling back to source.");
+	}
+
+	const std::string modelCache{ cfg.GetString("attributes.model_cache", "on") };
+
+	if (modelCache == "off") {
+		m_ModelCacheEnabled = false;
+	}
+	else if (modelCache != "on") {
+		ERROR_LOG("Unknown model cache mode: " + modelCache + ", falling back to on.");
+	}
+
+	const std::string vertexLayout{ cfg.GetString("attributes.vertex_layout", "full") };
+	const std::string vertexColor{ cfg.GetString("attributes.vertex_color", "off") };
+
+	if (vertexColor != "on" && vertexColor != "off") {
+		ERROR_LOG("Unknown vertex color mode: " + vertexColor + ", falling back to off.");
+	}
+
+	if (vertexLayout == "packed") {
+		m_VertexLayout = VertexLayout{ VertexLayoutType::PACKED, vertexColor == "on" };
+	}
+	else if (vertexLayout == "octahedral") {
+		m_VertexLayout = VertexLayout{ VertexLayoutType::OCTAHEDRAL, vertexColor == "on" };
+	}
+	else if (vertexLayout != "full") {
+		ERROR_LOG("Unknown vertex layout: " + vertexLayout + ", falling back to full.");
+	}
+
+	if (!VulkanMesh::IsVertexLayoutSupported(m_VertexLayout)) {
+		ERROR_LOG("The device cannot fetch the " + std::string{ GetVertexLayoutName() } +
+			" vertex layout, falling back to full.");
+		m_VertexLayout = VertexLayout{};
+	}
+
+	m_SceneMesh.SetVertexLayout(m_VertexLayout);
+
+	// The indirect commands select the world matrix of each entity through firstInstance.
+	if (m_RenderMode == RenderMode::INDIRECT && !G_VulkanDevice.GetEnabledFeatures().drawIndirectFirstInstance) {
+		ERROR_LOG("The indirect render mode requires the drawIndirectFirstInstance feature.");
+		return false;
+	}
+
+	if (!m_PipelineCache.Create("DeferredRendering")) {
 		return false;
 	}
 
@@ -1165,17 +1702,64 @@ bool DemoScene::Initialize(const VkExtent2D swapChainExtent, VkRenderPass displa
 		entity->Update(0.0f);
 	}
 
+	std::vector<VulkanTexture*> sceneTextures;
+
+	for (const auto& material : m_Materials) {
+		for (const auto texture : material.textures) {
+			if (texture && std::find(sceneTextures.cbegin(), sceneTextures.cend(), texture) == sceneTextures.cend()) {
+				sceneTextures.push_back(texture);
+				m_TextureMemory += texture->GetResidentBytes();
+			}
+		}
+	}
+
+	LOG("Texture load time (mips: " + std::string{ GetMipModeName() } + ", textures: " +
+		(m_BakedTextures ? "baked" : "source") + ", " + GetTextureLoadModeName() + "): " + std::to_string(m_TextureLoadTime) + " ms, " +
+		std::to_string(m_TextureMemory / (1024 * 1024)) + " MiB of texture memory.");
+
+	if (m_MipMode == TextureMipMode::STREAMED) {
+		m_StreamedTextures = std::move(sceneTextures);
+	}
+
 	if (!PrepareUniforms()) {
 		ERROR_LOG("Failed to prepare the scene's uniforms");
 		return false;
 	}
 
+	BuildDrawList();
+
+	if (m_RenderMode == RenderMode::INDIRECT && !PrepareIndirectDraws()) {
+		ERROR_LOG("Failed to prepare the scene's indirect draws.");
+		return false;
+	}
+
+	// Kick off the copies of every mesh and texture of the scene so that they
+	// run on the transfer queue while the pipelines are being compiled.
+	if (!G_VulkanDevice.GetUploader().Flush()) {
+		ERROR_LOG("Failed to submit the scene's uploads.");
+		return false;
+	}
+
+	const auto uploadStatistics = G_VulkanDevice.GetUploader().GetStatistics();
+
+	LOG("Scene uploads: " + std::to_string(uploadStatistics.copyCount) + " copies, " +
+		std::to_string(uploadStatistics.uploadedBytes / (1024 * 1024)) + " MiB in " +
+		std::to_string(uploadStatistics.batchCount) + " batches.");
+
 	if (!CreatePipelines(swapChainExtent, displayRenderPass)) {
 		ERROR_LOG("Failed to create scene's pipelines.");
 		return false;
 	}
 
-	return InitializeImGui(displayRenderPass);
+	if (!InitializeImGui(displayRenderPass)) {
+		return false;
+	}
+
+	m_SceneLoadTime = loadTimer.GetSec() * 1000.0;
+
+	LOG("Scene load time (" + std::string{ GetTextureLoadModeName() } + " texture load): " + std::to_string(m_SceneLoadTime) + " ms.");
+
+	return true;
 }
 
 void DemoScene::Update(VkExtent2D swapChainExtent, i64 msec, f64 dt) noexcept
@@ -1184,16 +1768,13 @@ void DemoScene::Update(VkExtent2D swapChainExtent, i64 msec, f64 dt) noexcept
 		entity->Update(dt);
 	}
 
-	MatricesUbo ubo{};
 	const auto radius = 20.0f;
 	const Vec3f eye{ sin(msec / 3000.0f) * radius, 3.0f, cos(msec / 3000.0f) * radius };
-	ubo.view = glm::lookAt(eye, Vec3f{ 0.0, 6.0f, 0.0f }, Vec3f{ 0.0f, 1.0f, 0.0f });
+	m_Matrices.view = glm::lookAt(eye, Vec3f{ 0.0, 6.0f, 0.0f }, Vec3f{ 0.0f, 1.0f, 0.0f });
 
 	const auto aspect = static_cast<f32>(swapChainExtent.width) / static_cast<f32>(swapChainExtent.height);
 
-	ubo.projection = s_ClipCorrectionMat * glm::perspective(glm::radians(60.0f), aspect, 0.1f, 2000.0f);
-
-	m_Ubos.matrices.Fill(&ubo, sizeof ubo);
+	m_Matrices.projection = s_ClipCorrectionMat * glm::perspective(glm::radians(60.0f), aspect, 0.1f, 2000.0f);
 
 	m_Lights.positions[0] = Vec4f{ sin(msec / 1000.0f) * 20.0f, 10.0f, cos(msec / 1000.0f) * 20.0f - 10.0f, 0.0f };
 	m_Lights.colors[0] = Vec4f{ 1.0f, 1.0f, 1.0f, 1.0 };
@@ -1212,11 +1793,96 @@ void DemoScene::Update(VkExtent2D swapChainExtent, i64 msec, f64 dt) noexcept
 	m_Lights.radi[3] = Vec4f{ 120.0f };
 
 	m_Lights.eyePos = eye;
+}
+
+void DemoScene::UploadFrameData(const ui32 frameIndex) noexcept
+{
+	// The deferred pass is recorded once per frame in flight, the indirect draws pick up the new
+	// buffer contents every frame.
+	if (m_RenderMode == RenderMode::INDIRECT) {
+		UploadIndirectDraws(frameIndex);
+	}
+
+	m_Ubos.matrices[frameIndex].Fill(&m_Matrices, sizeof m_Matrices);
+	m_Ubos.lights[frameIndex].Fill(&m_Lights, sizeof m_Lights);
+
+	// PreDraw read the timestamps of the G-Buffer pass that last ran in this frame slot.
+	if (G_Application.deferredGpuTime > 0.0f) {
+		m_GBufferGpuTimeSum += G_Application.deferredGpuTime;
+		++m_GBufferGpuTimeCount;
+	}
+}
+
+bool DemoScene::StreamTextures(const ui32 frameIndex) noexcept
+{
+	if (m_MipMode != TextureMipMode::STREAMED) {
+		return false;
+	}
+
+	const auto framesInFlight = G_Application.GetFramesInFlight();
+
+	// The fence of this frame slot was waited for, so every frame up to
+	// framesInFlight frames ago is done with the images it sampled.
+	if (m_FrameNumber >= framesInFlight) {
+		for (const auto texture : m_StreamedTextures) {
+			texture->ReleaseRetiredImages(m_FrameNumber - framesInFlight);
+		}
+	}
 
-	m_Ubos.lights.Fill(&m_Lights, sizeof m_Lights);
+	// The textures with the fewest resident levels go first, a few per frame so that no frame uploads much.
+	std::stable_sort(m_StreamedTextures.begin(), m_StreamedTextures.end(), [](const VulkanTexture* a, const VulkanTexture* b)
+	{
+		return a->GetResidentLevel() > b->GetResidentLevel();
+	});
+
+	VkDeviceSize residentBytes{ 0 };
+
+	for (const auto texture : m_StreamedTextures) {
+		residentBytes += texture->GetResidentBytes();
+	}
+
+	auto streamedCount = 0u;
+
+	for (const auto texture : m_StreamedTextures) {
+		if (streamedCount == s_StreamedTexturesPerFrame || !texture->GetResidentLevel()) {
+			break;
+		}
+
+		const auto nextLevelBytes = texture->GetNextLevelBytes();
+
+		if (residentBytes + nextLevelBytes > m_MipBudget || !texture->StreamNextLevel(m_FrameNumber)) {
+			continue;
+		}
+
+		residentBytes += nextLevelBytes;
+		++streamedCount;
+	}
+
+	m_ResidentTextureBytes = residentBytes;
+
+	++m_FrameNumber;
+
+	if (streamedCount) {
+		++m_ResidencyVersion;
+
+		// This frame already samples the new images, so their uploads go ahead of it.
+		if (!G_VulkanDevice.GetUploader().Flush()) {
+			ERROR_LOG("Failed to submit the streamed mip levels.");
+		}
+	}
+
+	if (m_FrameResidencyVersions[frameIndex] == m_ResidencyVersion) {
+		return false;
+	}
+
+	WriteMaterialDescriptorSets(frameIndex);
+
+	m_FrameResidencyVersions[frameIndex] = m_ResidencyVersion;
+
+	return true;
 }
 
-void DemoScene::DrawEntity(DemoEntity* entity, VkCommandBuffer commandBuffer) noexcept
+void DemoScene::DrawEntity(DemoEntity* entity, VkCommandBuffer commandBuffer, const ui32 frameIndex) noexcept
 {
 	const auto mesh = entity->GetMesh();
 	if (mesh) {
@@ -1228,8 +1894,8 @@ void DemoScene::DrawEntity(DemoEntity* entity, VkCommandBuffer commandBuffer) no
 		}
 
 		std::vector<VkDescriptorSet> descriptorSets{
-			m_DescriptorSets.sceneMatrices,
-			material->descriptorSet
+			m_DescriptorSets.sceneMatrices[frameIndex],
+			material->descriptorSets[frameIndex]
 		};
 
 		vkCmdBindDescriptorSets(commandBuffer,
@@ -1264,7 +1930,7 @@ void DemoScene::DrawEntity(DemoEntity* entity, VkCommandBuffer commandBuffer) no
 
 	for (auto child : entity->GetChildren()) {
 		const auto c = static_cast<DemoEntity*>(child);
-		DrawEntity(c, commandBuffer);
+		DrawEntity(c, commandBuffer, frameIndex);
 	}
 }
 
@@ -1344,6 +2010,34 @@ void DemoScene::DrawUi(const VkCommandBuffer commandBuffer) const noexcept
 
 		ImGui::NewLine();
 		ImGui::Text("Total Vertex Count: %lld", m_SceneVertexCount);
+		ImGui::Text("Render mode: %s", GetRenderModeName());
+		ImGui::Text("Draw calls: %zu", GetDrawCallCount());
+
+		const auto memoryStatistics = G_VulkanDevice.GetMemoryStatistics();
+
+		ImGui::Text("Device memory blocks: %zu (%zu dedicated)",
+		            memoryStatistics.blockCount,
+		            memoryStatistics.dedicatedBlockCount);
+		ImGui::Text("Device memory allocations: %zu", memoryStatistics.allocationCount);
+		ImGui::Text("Device memory used: %.1f / %.1f MiB",
+		            static_cast<f64>(memoryStatistics.usedBytes) / (1024.0 * 1024.0),
+		            static_cast<f64>(memoryStatistics.reservedBytes) / (1024.0 * 1024.0));
+		ImGui::Text("Device memory fragmentation: %.2f", memoryStatistics.fragmentation);
+		ImGui::Text("Mips: %s", GetMipModeName());
+		ImGui::Text("Textures: %s", m_BakedTextures ? "Baked" : "Source");
+		ImGui::Text("Model load time: %f ms (%s)", m_ModelLoadTime, GetModelCacheStateName());
+		ImGui::Text("Vertex layout: %s (%u bytes)", GetVertexLayoutName(), m_VertexLayout.GetStride());
+		ImGui::Text("Scene load time: %f ms (%s texture load)", m_SceneLoadTime, GetTextureLoadModeName());
+		ImGui::Text("Texture load time: %f ms", m_TextureLoadTime);
+		ImGui::Text("Texture memory at load: %.1f MiB", static_cast<f64>(m_TextureMemory) / (1024.0 * 1024.0));
+		ImGui::Text("G-Buffer GPU time: %f ms", application.deferredGpuTime);
+
+		if (m_MipMode == TextureMipMode::STREAMED) {
+			ImGui::Text("Resident texture memory: %.1f / %.1f MiB",
+			            static_cast<f64>(m_ResidentTextureBytes) / (1024.0 * 1024.0),
+			            static_cast<f64>(m_MipBudget) / (1024.0 * 1024.0));
+		}
+
 		ImGui::Text("Running time: %f s", application.GetTimer().GetSec());
 		ImGui::Text("Frame count: %lld", application.frameCount);
 		ImGui::End();
@@ -1417,12 +2111,26 @@ void DemoScene::DrawUi(const VkCommandBuffer commandBuffer) const noexcept
 		ImGui::NewLine();
 
 		ImGui::Text("Total Vertex Count: %lld", m_SceneVertexCount);
+		ImGui::Text("Render mode: %s", GetRenderModeName());
+		ImGui::Text("Draw calls: %zu", GetDrawCallCount());
 		ImGui::Text("Total Frames: %lld", application.frameCount);
 		ImGui::Text("Total duration: %f s", application.totalAppDuration);
+		ImGui::Text("Startup time: %f ms", application.startupTime);
+		ImGui::Text("Pipeline build time: %f ms (%zu pipelines, %s)", m_PipelineBuilder.GetBuildTime(),
+			m_PipelineBuilder.GetPipelineCount(), m_PipelineBuildMode == PipelineBuildMode::PARALLEL ? "parallel" : "serial");
 		ImGui::Text("Average FPS: %f", 1000.0f / application.avgTotalFrameTime);
 		ImGui::Text("Average frame time: %f ms", application.avgTotalFrameTime);
 		ImGui::Text("Average CPU time: %f ms", application.avgTotalCpuTime);
 		ImGui::Text("Average GPU time: %f ms", application.avgTotalGpuTime);
+		ImGui::Text("Mips: %s", GetMipModeName());
+		ImGui::Text("Textures: %s", m_BakedTextures ? "Baked" : "Source");
+		ImGui::Text("Model load time: %f ms (%s)", m_ModelLoadTime, GetModelCacheStateName());
+		ImGui::Text("Vertex layout: %s (%u bytes)", GetVertexLayoutName(), m_VertexLayout.GetStride());
+		ImGui::Text("Scene load time: %f ms (%s texture load)", m_SceneLoadTime, GetTextureLoadModeName());
+		ImGui::Text("Texture load time: %f ms", m_TextureLoadTime);
+		ImGui::Text("Texture memory at load: %.1f MiB", static_cast<f64>(m_TextureMemory) / (1024.0 * 1024.0));
+		ImGui::Text("Average G-Buffer GPU time: %f ms",
+			m_GBufferGpuTimeCount ? m_GBufferGpuTimeSum / m_GBufferGpuTimeCount : 0.0);
 		ImGui::Text("99th percentile (lower is better): %f ms", application.percentile99th);
 
 		ImGui::NewLine();
@@ -1443,16 +2151,52 @@ void DemoScene::DrawUi(const VkCommandBuffer commandBuffer) const noexcept
 	ImGui_ImplGlfwVulkan_Render(commandBuffer);
 }
 
-void DemoScene::Draw(const VkCommandBuffer commandBuffer) noexcept
+void DemoScene::Draw(const VkCommandBuffer commandBuffer, const ui32 frameIndex) noexcept
 {
+	if (m_RenderMode == RenderMode::INDIRECT) {
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipelines.deferredIndirect);
+
+		for (const auto& batch : m_DrawBatches) {
+			std::array<VkDescriptorSet, 2> descriptorSets{
+				m_DescriptorSets.sceneMatrices[frameIndex],
+				batch.material->descriptorSets[frameIndex]
+			};
+
+			vkCmdBindDescriptorSets(commandBuffer,
+			                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+			                        m_PipelineLayouts.deferred,
+			                        0,
+			                        static_cast<ui32>(descriptorSets.size()),
+			                        descriptorSets.data(),
+			                        0,
+			                        nullptr);
+
+			std::array<Vec4f, 2> materialProperties{ batch.material->diffuse, batch.material->specular };
+
+			vkCmdPushConstants(commandBuffer,
+			                   m_PipelineLayouts.deferred,
+			                   VK_SHADER_STAGE_FRAGMENT_BIT,
+			                   sizeof(Mat4f),
+			                   2 * sizeof(Vec4f),
+			                   materialProperties.data());
+
+			m_SceneMesh.DrawIndirect(commandBuffer,
+			                         m_IndirectCommands.buffer,
+			                         batch.firstDraw * sizeof(VkDrawIndexedIndirectCommand),
+			                         batch.drawCount);
+		}
+
+		return;
+	}
+
 	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipelines.deferred);
 
 	for (const auto& entity : m_Entities) {
-		DrawEntity(entity.get(), commandBuffer);
+		DrawEntity(entity.get(), commandBuffer, frameIndex);
 	}
 }
 
-void DemoScene::DrawFullscreenQuad(const VkCommandBuffer commandBuffer) const noexcept
+void DemoScene::DrawFullscreenQuad(const VkCommandBuffer commandBuffer, const ui32 frameIndex) const noexcept
 {
 	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipelines.display);
 	vkCmdBindDescriptorSets(commandBuffer,
@@ -1460,7 +2204,7 @@ void DemoScene::DrawFullscreenQuad(const VkCommandBuffer commandBuffer) const no
 	                        m_PipelineLayouts.display,
 	                        0,
 	                        1,
-	                        &m_DescriptorSets.display,
+	                        &m_DescriptorSets.display[frameIndex],
 	                        0,
 	                        nullptr);
 
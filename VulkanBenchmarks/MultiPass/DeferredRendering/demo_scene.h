@@ -3,8 +3,11 @@
 
 #include <memory>
 #include <vulkan_pipeline_cache.h>
+#include <vulkan_pipeline_builder.h>
+#include <model_cache.h>
 #include "demo_entity.h"
 #include "vulkan_render_target.h"
+#include "vulkan_application.h"
 #include "assimp/scene.h"
 
 struct MatricesUbo {
@@ -21,10 +24,75 @@ struct LightsUbo {
     Vec3f eyePos;
 };
 
+/**
+ * \brief How the scene is submitted, selected with attributes.render_mode in config.cfg.
+ */
+enum class RenderMode {
+	// One descriptor set bind, two push constants and one draw per entity.
+	PER_DRAW,
+	// All the meshes share one vertex and index buffer, the world matrices go to a storage
+	// buffer and the entities of each material are submitted with one multi draw indirect.
+	INDIRECT
+};
+
+/**
+ * \brief How the pipelines are compiled at startup, selected with attributes.pipeline_build in config.cfg.
+ */
+enum class PipelineBuildMode {
+	// One after the other on the main thread.
+	SERIAL,
+	// Across the workers of a thread pool, each with its own pipeline cache.
+	PARALLEL
+};
+
+/**
+ * \brief How the textures are loaded at startup, selected with attributes.texture_load in config.cfg.
+ */
+enum class TextureLoadMode {
+	// Decoded and uploaded one after the other on the main thread.
+	SERIAL,
+	// Decoded across the workers of a thread pool, then uploaded together.
+	PARALLEL
+};
+
 class DemoScene final {
 private:
 	std::vector<std::unique_ptr<DemoEntity>> m_Entities;
 
+	RenderMode m_RenderMode{ RenderMode::PER_DRAW };
+
+	PipelineBuildMode m_PipelineBuildMode{ PipelineBuildMode::PARALLEL };
+
+	/**
+	 * \brief Selected with attributes.mips in config.cfg.
+	 */
+	TextureMipMode m_MipMode{ TextureMipMode::NONE };
+
+	/**
+	 * \brief Selected with attributes.textures in config.cfg. Loads the containers
+	 * written by the texture baker instead of decoding the images.
+	 */
+	bool m_BakedTextures{ false };
+
+	TextureLoadMode m_TextureLoadMode{ TextureLoadMode::PARALLEL };
+
+	/**
+	 * \brief Selected with attributes.model_cache in config.cfg. Maps the model from the
+	 * cache written next to it after the first import, instead of importing it again.
+	 */
+	bool m_ModelCacheEnabled{ true };
+
+	/**
+	 * \brief TRUE if the model was loaded from an up to date cache.
+	 */
+	bool m_ModelCacheWarm{ false };
+
+	/**
+	 * \brief Selected with attributes.vertex_layout and attributes.vertex_color in config.cfg.
+	 * Every mesh and the pipelines use it.
+	 */
+	VertexLayout m_VertexLayout;
+
 	VkDescriptorPool m_DescriptorPool{ VK_NULL_HANDLE };
 
 	VkDescriptorPool m_ImGUIDescriptorPool{ VK_NULL_HANDLE };
@@ -35,23 +103,28 @@ private:
 		VkDescriptorSetLayout gBufferAndLights{ VK_NULL_HANDLE };
 	} m_DescriptorSetLayouts;
 
+	// The sets and buffers written every frame have one copy per frame in flight,
+	// indexed by VulkanApplication::GetCurrentFrameIndex.
 	struct {
-		VkDescriptorSet sceneMatrices{ VK_NULL_HANDLE };
-		VkDescriptorSet display{ VK_NULL_HANDLE };
+		std::array<VkDescriptorSet, VulkanApplication::MAX_FRAMES_IN_FLIGHT> sceneMatrices{};
+		std::array<VkDescriptorSet, VulkanApplication::MAX_FRAMES_IN_FLIGHT> display{};
 	} m_DescriptorSets;
 
 	struct {
-		VulkanBuffer matrices;
-		VulkanBuffer lights;
+		std::array<VulkanBuffer, VulkanApplication::MAX_FRAMES_IN_FLIGHT> matrices;
+		std::array<VulkanBuffer, VulkanApplication::MAX_FRAMES_IN_FLIGHT> lights;
 	} m_Ubos;
 
 	struct {
 		VkPipeline deferred{ VK_NULL_HANDLE };
+		VkPipeline deferredIndirect{ VK_NULL_HANDLE };
 		VkPipeline display{ VK_NULL_HANDLE };
 	} m_Pipelines;
 
 	VulkanPipelineCache m_PipelineCache;
 
+	VulkanPipelineBuilder m_PipelineBuilder;
+
 	struct {
 		VkPipelineLayout deferred{ VK_NULL_HANDLE };
 		VkPipelineLayout display{ VK_NULL_HANDLE };
@@ -70,6 +143,8 @@ private:
 
 	VulkanRenderTarget m_GBuffer;
 
+	MatricesUbo m_Matrices;
+
 	LightsUbo m_Lights;
 
 	//UI -------------------------------
@@ -77,31 +152,175 @@ private:
 	std::array<const char*, 6> m_AttachmentComboItems{ "Lit", "Position", "Normals", "Albedo", "Specular", "Depth" };
 
 	i64 m_SceneVertexCount{ 0 };
+
+	/**
+	 * \brief CPU time spent loading the textures of the scene, mip chains included, in ms.
+	 */
+	f64 m_TextureLoadTime{ 0.0 };
+
+	/**
+	 * \brief CPU time spent loading the model without its textures, import or cache included, in ms.
+	 */
+	f64 m_ModelLoadTime{ 0.0 };
+
+	/**
+	 * \brief CPU time spent in Initialize(), in ms.
+	 */
+	f64 m_SceneLoadTime{ 0.0 };
+
+	/**
+	 * \brief Size of the levels of every texture that are resident once the scene is loaded.
+	 */
+	VkDeviceSize m_TextureMemory{ 0 };
+
+	f64 m_GBufferGpuTimeSum{ 0.0 };
+
+	ui64 m_GBufferGpuTimeCount{ 0 };
 	// ---------------------------
 
+	// Mip streaming --------------------
+	/**
+	 * \brief Every distinct texture of m_Materials, only filled in the streamed mip mode.
+	 */
+	std::vector<VulkanTexture*> m_StreamedTextures;
+
+	/**
+	 * \brief Texture memory the resident levels may use, selected with attributes.mip_budget in config.cfg.
+	 */
+	VkDeviceSize m_MipBudget{ 0 };
+
+	VkDeviceSize m_ResidentTextureBytes{ 0 };
+
+	ui64 m_FrameNumber{ 0 };
+
+	/**
+	 * \brief Bumped every time a texture gets a new image. A frame whose version is
+	 * behind has its material sets rewritten before it is recorded.
+	 */
+	ui64 m_ResidencyVersion{ 0 };
+
+	std::array<ui64, VulkanApplication::MAX_FRAMES_IN_FLIGHT> m_FrameResidencyVersions{};
+	//----------------------------------
+
 	// Model Loading--------------------
 	std::vector<DemoMaterial> m_Materials;
 
 	std::vector<VulkanMesh*> m_Meshes;
 
-	void LoadMeshes(const aiScene* scene) noexcept;
+	// Indirect drawing -----------------
+	/**
+	 * \brief Every mesh of m_Meshes packed into a single vertex and index buffer.
+	 */
+	VulkanMesh m_SceneMesh;
+
+	/**
+	 * \brief Range of each mesh of m_Meshes in m_SceneMesh.
+	 */
+	std::vector<MeshRange> m_MeshRanges;
+
+	struct SceneDraw {
+		DemoEntity* entity{ nullptr };
+		ui32 meshIndex{ 0 };
+	};
+
+	/**
+	 * \brief A run of consecutive draws that share a material.
+	 */
+	struct DrawBatch {
+		DemoMaterial* material{ nullptr };
+		ui32 firstDraw{ 0 };
+		ui32 drawCount{ 0 };
+	};
+
+	/**
+	 * \brief Entities with a mesh and a material, sorted by material. Draw i uses indirect command i.
+	 */
+	std::vector<SceneDraw> m_Draws;
+
+	std::vector<DrawBatch> m_DrawBatches;
+
+	/**
+	 * \brief World matrices of m_Draws, read through firstInstance by the indirect pipeline.
+	 * One buffer per frame in flight.
+	 */
+	std::array<VulkanBuffer, VulkanApplication::MAX_FRAMES_IN_FLIGHT> m_DrawXformsSsbos;
+
+	/**
+	 * \brief One VkDrawIndexedIndirectCommand per draw of m_Draws. The draws never change, so
+	 * the commands are written once and shared by the frames in flight.
+	 */
+	VulkanBuffer m_IndirectCommands;
+	//----------------------------------
+
+	void LoadMeshes(const std::vector<ModelMesh>& meshes) noexcept;
+
+	std::string GetTexturePath(const std::string& fileName, bool baked) const noexcept;
 
-	void LoadMaterials(const aiScene* scene) noexcept;
+	/**
+	 * \brief Loads the textures of the materials, listed in TextureType order for each material.
+	 * \details Loads the baked containers if they are selected and the images of those
+	 * that fail to load, or of all of them otherwise.
+	 */
+	std::vector<VulkanTexture*> LoadTextures(const std::vector<std::string>& fileNames) noexcept;
 
-	DemoEntity* LoadNode(const aiNode* aiNode) noexcept;
+	void LoadMaterials(const std::vector<ModelMaterial>& materials) noexcept;
 
+	/**
+	 * \brief Creates the entity of the node at nodeIndex and those of its children.
+	 * \param nodeIndex Advanced past the node and its children.
+	 */
+	DemoEntity* LoadNode(const std::vector<ModelNode>& nodes, size_t& nodeIndex) noexcept;
+
+	/**
+	 * \brief Maps the model from its cache if it is up to date, or imports it and writes the cache otherwise.
+	 */
 	std::unique_ptr<DemoEntity> LoadModel(const std::string& fileName) noexcept;
 	//----------------------------------
 
+	void CollectDraws(DemoEntity* entity) noexcept;
+
+	/**
+	 * \brief Gathers the entities of the hierarchy into m_Draws and groups them into material batches.
+	 */
+	void BuildDrawList() noexcept;
+
+	/**
+	 * \brief Creates the scene mesh buffers and the persistently mapped storage
+	 * and indirect buffers used by the indirect render mode.
+	 */
+	bool PrepareIndirectDraws() noexcept;
+
+	/**
+	 * \brief Writes the world matrix of every draw of m_Draws to the storage buffer of the given frame.
+	 */
+	void UploadIndirectDraws(ui32 frameIndex) noexcept;
+
+	const char* GetRenderModeName() const noexcept;
+
+	const char* GetTextureLoadModeName() const noexcept;
+
+	const char* GetModelCacheStateName() const noexcept;
+
+	const char* GetMipModeName() const noexcept;
+
+	const char* GetVertexLayoutName() const noexcept;
+
+	size_t GetDrawCallCount() const noexcept;
+
 	bool CreateTextureSampler() noexcept;
 
 	bool PrepareUniforms() noexcept;
 
+	/**
+	 * \brief Writes the current image views of the textures to the material sets of the given frame in flight.
+	 */
+	void WriteMaterialDescriptorSets(ui32 frameIndex) noexcept;
+
 	bool CreatePipelines(VkExtent2D swapChainExtent, VkRenderPass displayRenderPass) noexcept;
 
 	bool InitializeImGui(VkRenderPass renderPass) noexcept;
 
-	void DrawEntity(DemoEntity* entity, VkCommandBuffer commandBuffer) noexcept;
+	void DrawEntity(DemoEntity* entity, VkCommandBuffer commandBuffer, ui32 frameIndex) noexcept;
 
 	void DrawUi(VkCommandBuffer commandBuffer) const noexcept;
 
@@ -112,9 +331,27 @@ public:
 
 	void Update(VkExtent2D swapChainExtent, i64 msec, f64 dt) noexcept;
 
-	void Draw(VkCommandBuffer commandBuffer) noexcept;
-
-	void DrawFullscreenQuad(const VkCommandBuffer commandBuffer) const noexcept;
+	/**
+	 * \brief Copies the state computed by Update to the buffers of the given frame in flight.
+	 * Called after PreDraw, once the GPU is done with the frame's buffers.
+	 */
+	void UploadFrameData(ui32 frameIndex) noexcept;
+
+	/**
+	 * \brief Makes more levels of the streamed textures resident, as long as they fit in the mip budget.
+	 * \details Called after UploadFrameData. Releases the replaced images that no
+	 * frame in flight can sample anymore and rewrites the material sets of the
+	 * given frame if a texture got a new image since they were last written.
+	 * \return TRUE if the G-Buffer pass of the frame has to be recorded again, FALSE otherwise.
+	 */
+	bool StreamTextures(ui32 frameIndex) noexcept;
+
+	/**
+	 * \brief Records the G-Buffer pass with the descriptor sets of the given frame in flight.
+	 */
+	void Draw(VkCommandBuffer commandBuffer, ui32 frameIndex) noexcept;
+
+	void DrawFullscreenQuad(const VkCommandBuffer commandBuffer, ui32 frameIndex) const noexcept;
 
 	const VulkanRenderTarget& GetGBuffer() const noexcept;
 };
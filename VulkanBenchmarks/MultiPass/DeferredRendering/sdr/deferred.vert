@@ -6,7 +6,7 @@
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec3 inTangent;
-layout(location = 3) in vec3 inColor;
+// The colour at location 3 is not read, so layouts without it leave it out.
 layout(location = 4) in vec2 inTexcoord;
 
 //Uniforms
@@ -32,6 +32,23 @@ layout(location = 1) out vec4 w_outPosition;
 layout(location = 2) out vec3 w_outNormal;
 layout(location = 3) out vec3 w_outTangent;
 
+// Set when the vertex layout stores the normal and tangent folded onto an octahedron.
+layout(constant_id = 0) const bool OCTAHEDRAL_VECTORS = false;
+
+// Unfolds an octahedral vector, the fetch fills z with 0.
+vec3 DecodeVector(vec3 encoded)
+{
+    if (!OCTAHEDRAL_VECTORS) {
+        return normalize(encoded);
+    }
+
+    vec3 vector = vec3(encoded.xy, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-vector.z, 0.0);
+    vector.xy += vec2(vector.x >= 0.0 ? -fold : fold, vector.y >= 0.0 ? -fold : fold);
+
+    return normalize(vector);
+}
+
 void main()
 {
     //Transform vertex to clipspace.
@@ -43,8 +60,8 @@ void main()
     mat3 normalMatrix = transpose(inverse(mat3(pushConstant.model)));
 
 
-	w_outNormal = normalMatrix * normalize(inNormal);
-	w_outTangent = normalMatrix * normalize(inTangent);
+	w_outNormal = normalMatrix * DecodeVector(inNormal);
+	w_outTangent = normalMatrix * DecodeVector(inTangent);
 
     //Assign texture coorinates for output.
     outTexcoord = inTexcoord;
@@ -0,0 +1,70 @@
+#version 450 core
+#extension GL_ARB_separate_shader_objects : enable
+
+//Vertex attributes
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec3 inTangent;
+// The colour at location 3 is not read, so layouts without it leave it out.
+layout(location = 4) in vec2 inTexcoord;
+
+//Uniforms
+layout(std140, set = 0, binding = 0) uniform UniformBufferObject {
+	mat4 view;
+	mat4 projection;
+} ubo;
+
+// World matrix of every indirect draw. Each draw sets firstInstance to its
+// index and gl_InstanceIndex includes firstInstance.
+layout(std430, set = 0, binding = 1) readonly buffer DrawTransforms {
+	mat4 models[];
+} drawTransforms;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+// Varying variables
+// prefixes: w_ -> world space
+//           v_ -> view space
+//           t_ -> tangent space
+layout(location = 0) out vec2 outTexcoord;
+layout(location = 1) out vec4 w_outPosition;
+layout(location = 2) out vec3 w_outNormal;
+layout(location = 3) out vec3 w_outTangent;
+
+// Set when the vertex layout stores the normal and tangent folded onto an octahedron.
+layout(constant_id = 0) const bool OCTAHEDRAL_VECTORS = false;
+
+// Unfolds an octahedral vector, the fetch fills z with 0.
+vec3 DecodeVector(vec3 encoded)
+{
+    if (!OCTAHEDRAL_VECTORS) {
+        return normalize(encoded);
+    }
+
+    vec3 vector = vec3(encoded.xy, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-vector.z, 0.0);
+    vector.xy += vec2(vector.x >= 0.0 ? -fold : fold, vector.y >= 0.0 ? -fold : fold);
+
+    return normalize(vector);
+}
+
+void main()
+{
+	mat4 model = drawTransforms.models[gl_InstanceIndex];
+
+    //Transform vertex to clipspace.
+    vec4 localVertexPosition = vec4(inPosition, 1.0);
+    gl_Position = ubo.projection * ubo.view * model * localVertexPosition;
+
+	w_outPosition = model * localVertexPosition;
+
+    mat3 normalMatrix = transpose(inverse(mat3(model)));
+
+	w_outNormal = normalMatrix * DecodeVector(inNormal);
+	w_outTangent = normalMatrix * DecodeVector(inTangent);
+
+    //Assign texture coorinates for output.
+    outTexcoord = inTexcoord;
+}